@@ -354,6 +354,7 @@ void mDelaymS(uint16_t t)
 }
 
 #ifdef DEBUG
+__attribute__((weak))
 int _write(int fd, char *buf, int size)
 {
     int i;
@@ -18,6 +18,9 @@
 #include "kbd_command.h"
 #include "kbd_rgb.h"
 #include "kbd_log.h"
+#include "kbd_blackbox.h"
+#include "kbd_boot.h"
+#include "kbd_idle.h"
 
 /* 硬件抽象层 */
 #include "key.h"
@@ -25,6 +28,7 @@
 #include "hal_utils.h"
 #include "ws2812.h"
 #include "encoder.h"
+#include "matrix.h"
 #include "debug.h"
 
 /* ============== TMOS 内存池 ============== */
@@ -38,17 +42,49 @@ const uint8_t MacAddr[6] = {0x84, 0xC2, 0xE4, 0x03, 0x02, 0x02};
 __HIGH_CODE
 __attribute__((noinline)) void Main_Circulation(void)
 {
+    KBD_Boot_Mark(KBD_BOOT_STAGE_LOOP);
+
     while (1) {
+        /* 输入 / 模式 / 日志均为 TMOS 任务，空闲时由 idleCB 进入低功耗 */
         TMOS_SystemProcess();
-        KBD_Mode_Process();
-        KBD_Core_Process();
-        KBD_Log_Flush();
+    }
+}
+
+/* ============== 异常处理 ============== */
+
+/* 异常现场落盘到黑匣子后复位，重新上电可通过 KBD_CMD_BBOX_READ 读回 */
+__INTERRUPT
+__HIGH_CODE
+void HardFault_Handler(void)
+{
+    KBD_BlackBox_Flush(KBD_BLACKBOX_REASON_FAULT);
+    Hal_Reset();
+}
+
+/* 看门狗溢出中断作为预警（仅 RB_WDOG_INT_EN 打开时触发），每次上电只落盘一次 */
+static volatile uint8_t s_wdog_flushed = 0;
+
+__INTERRUPT
+__HIGH_CODE
+void WDOG_BAT_IRQHandler(void)
+{
+    if (WWDG_GetFlowFlag()) {
+        /* 标志位受安全访问保护，需经 SDK 接口清除，否则中断会反复进入 */
+        WWDG_ClearFlag();
+        if (!s_wdog_flushed) {
+            s_wdog_flushed = 1;
+            KBD_BlackBox_Flush(KBD_BLACKBOX_REASON_WDOG);
+        }
     }
 }
 
 /* ============== 主函数 ============== */
 int main(void)
 {
+    /* 栈涂色（高水位统计），需在任何深调用之前 */
+    Hal_Mem_PaintStack();
+    KBD_Boot_Mark(KBD_BOOT_STAGE_RESET);
+
     /* 设置系统时钟 */
     SetSysClock(CLK_SOURCE_PLL_60MHz);
 
@@ -63,12 +99,19 @@ int main(void)
     /* 最早期串口探活：用于确认 UART1(PB13 TX) 链路正常 */
     Log_Output("I", "BOOT", "UART alive");
 #endif
+    KBD_Boot_Mark(KBD_BOOT_STAGE_CLOCK);
+
+    /* TMOS 堆涂色（峰值统计），需在交给协议栈之前 */
+    Hal_Mem_PaintRegion(MEM_BUF, sizeof(MEM_BUF));
 
     /* BLE 库初始化（提供 TMOS 调度器，USB/BLE 模式都需要） */
     CH59x_BLEInit();
 
-    /* HAL 初始化 */
+    /* HAL 初始化 (HAL_TimeInit 会把 RTC 计数重载为 0，启动时间线需跨过重载) */
+    KBD_Boot_RtcReloadBegin();
     HAL_Init();
+    KBD_Boot_RtcReloadEnd();
+    KBD_Boot_Mark(KBD_BOOT_STAGE_BLE_INIT);
 
     /* 按键驱动初始化 */
     Key_Init();
@@ -76,9 +119,27 @@ int main(void)
     /* 旋钮驱动初始化 */
     Encoder_Init();
 
+    /* 行列矩阵初始化（未启用 KBD_HAS_MATRIX 时为空） */
+    Matrix_Init();
+
+    /* 空闲低功耗唤醒源（按键 / 旋钮 GPIO、USB、RTC） */
+    KBD_Idle_Init();
+    KBD_Boot_Mark(KBD_BOOT_STAGE_DRIVERS);
+
     /* 存储系统初始化（需在模式判定前完成，以读取 last_mode） */
     KBD_Storage_Init();
 
+    /* 按存储配置切换去抖算法 */
+    {
+        uint8_t debounce_mode, debounce_ms;
+        KBD_GetDebounce(&debounce_mode, &debounce_ms);
+        Key_SetDebounce(debounce_mode, debounce_ms);
+    }
+
+    /* 黑匣子初始化（扫描 DataFlash 追加区） */
+    KBD_BlackBox_Init();
+    KBD_Boot_Mark(KBD_BOOT_STAGE_STORAGE);
+
     /* 读取上次模式，决定本次启动路径 */
     uint8_t last_mode = KBD_GetLastMode();
     kbd_work_mode_t initial_mode = (last_mode == 1) ? KBD_WORK_MODE_BLE : KBD_WORK_MODE_USB;
@@ -95,26 +156,25 @@ int main(void)
     /* 命令处理初始化 */
     KBD_Command_Init();
 
-    /* RGB 灯效初始化 */
+    /* RGB 驱动初始化（模式切换闪烁需要，灯效刷新延后启动） */
     KBD_RGB_Init();
 
-    /* 电池检测初始化 */
-    KBD_Battery_Init();
-
-    /* HID 日志系统初始化 */
-    KBD_Log_Init();
-
     /* 键盘核心模块初始化 */
     KBD_Core_Init();
 
     /* 宏引擎初始化 */
     KBD_Macro_Init();
+    KBD_Boot_Mark(KBD_BOOT_STAGE_PROTOCOL);
 
     /* 模式管理器初始化（根据模式执行对应协议栈初始化） */
     KBD_Mode_Init(initial_mode, KBD_Core_GetCallbacks());
+    KBD_Boot_Mark(KBD_BOOT_STAGE_READY);
 
-    /* 记录启动事件 */
-    KBD_Log_SystemEvent(KBD_LOG_SYS_BOOT);
+    /*
+     * 非关键模块延后到主循环中由 TMOS 逐个初始化：
+     * HID 日志（含启动事件）、RGB 灯效刷新、电池 ADC 校准
+     */
+    KBD_Boot_Start();
 
     /* 进入主循环 */
     Main_Circulation();
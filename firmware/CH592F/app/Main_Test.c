@@ -37,8 +37,6 @@ __attribute__((noinline)) void Main_Circulation(void)
 {
     while (1) {
         TMOS_SystemProcess();
-        KBD_Mode_Process();
-        KBD_Core_Process();
         /* 不打印任何日志 */
     }
 }
@@ -58,12 +58,12 @@
  CLK_OSC32K                                 - RTC时钟选择，如包含主机角色必须使用外部32K( 0 外部(32768Hz)，默认:1：内部(32000Hz)，2：内部(32768Hz) )
 
  【MEMORY】
- BLE_MEMHEAP_SIZE                           - 蓝牙协议栈使用的RAM大小，不小于6K ( 默认:(1024*6) )
+ BLE_MEMHEAP_SIZE                           - 蓝牙协议栈使用的RAM大小，不小于6K ( 默认:(1024*7)，控制器缓存随 BLE_BUFF_MAX_LEN 增大 )
 
  【DATA】
- BLE_BUFF_MAX_LEN                           - 单个连接最大包长度( 默认:27 (ATT_MTU=23)，取值范围[27~516] )
+ BLE_BUFF_MAX_LEN                           - 单个连接最大包长度( 默认:251 (ATT_MTU=247，数据长度扩展到 251)，取值范围[27~516] )
  BLE_BUFF_NUM                               - 控制器缓存的包数量( 默认:5 )
- BLE_TX_NUM_EVENT                           - 单个连接事件最多可以发多少个数据包( 默认:1 )
+ BLE_TX_NUM_EVENT                           - 单个连接事件最多可以发多少个数据包( 默认:4，平时由 ble_hid 限速为 1 )
  BLE_TX_POWER                               - 发射功率( 默认:LL_TX_POWEER_0_DBM (0dBm) )
 
  【MULTICONN】
@@ -124,16 +124,16 @@
 #define CLK_OSC32K 1 // 该项请勿在此修改，必须在工程配置里的预处理中修改，如包含主机角色必须使用外部32K
 #endif
 #ifndef BLE_MEMHEAP_SIZE
-#define BLE_MEMHEAP_SIZE (1024 * 6)
+#define BLE_MEMHEAP_SIZE (1024 * 7)
 #endif
 #ifndef BLE_BUFF_MAX_LEN
-#define BLE_BUFF_MAX_LEN 27
+#define BLE_BUFF_MAX_LEN 251
 #endif
 #ifndef BLE_BUFF_NUM
 #define BLE_BUFF_NUM 5
 #endif
 #ifndef BLE_TX_NUM_EVENT
-#define BLE_TX_NUM_EVENT 1
+#define BLE_TX_NUM_EVENT 4
 #endif
 #ifndef BLE_TX_POWER
 #define BLE_TX_POWER LL_TX_POWEER_0_DBM
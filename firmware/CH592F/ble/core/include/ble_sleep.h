@@ -40,6 +40,27 @@ extern void HAL_SleepInit(void);
  */
 extern uint32_t CH59x_LowPower(uint32_t time);
 
+/**
+ * @brief   RTC 计数 from 到 to 的距离（按 RTC_MAX_COUNT 回绕）
+ */
+extern uint32_t HAL_SleepDistance(uint32_t to, uint32_t from);
+
+/**
+ * @brief   CPU 暂停直到 RTC 到达 time 或有中断挂起（可在关全局中断时调用）
+ *
+ * @param   time    - 唤醒的时间点（RTC绝对值）
+ */
+extern void HAL_SleepIdle(uint32_t time);
+
+/**
+ * @brief   进入 Sleep 模式直到 RTC 到达 time 或 GPIO/USB 唤醒（可在关全局中断时调用）
+ *
+ * @param   time    - 唤醒的时间点（RTC绝对值）
+ *
+ * @return  实际停留的 RTC 周期数.
+ */
+extern uint32_t HAL_SleepUntil(uint32_t time);
+
 /*********************************************************************
 *********************************************************************/
 
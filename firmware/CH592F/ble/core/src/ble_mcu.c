@@ -13,6 +13,7 @@
 /******************************************************************************/
 /* 头文件包含 */
 #include "ble_hal.h"
+#include "kbd_idle.h"
 
 tmosTaskID halTaskID;
 uint32_t g_LLE_IRQLibHandlerLocation;
@@ -137,7 +138,7 @@ void CH59x_BLEInit (void) {
 #endif
 #endif
 #if (defined(HAL_SLEEP)) && (HAL_SLEEP == TRUE)
-    cfg.idleCB = CH59x_LowPower;  // 启用睡眠
+    cfg.idleCB = KBD_Idle_Hook;  // 启用睡眠（按键盘状态选择 CPU 暂停 / RTC Sleep，见 kbd_idle.h）
 #endif
 #if (defined(BLE_MAC)) && (BLE_MAC == TRUE)
     for (i = 0; i < 6; i++) {
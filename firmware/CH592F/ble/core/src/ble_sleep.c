@@ -26,52 +26,106 @@
 uint32_t CH59x_LowPower(uint32_t time)
 {
 #if(defined(HAL_SLEEP)) && (HAL_SLEEP == TRUE)
-    volatile uint32_t i;
     uint32_t time_sleep, time_curr;
     unsigned long irq_status;
-    
-    // 提前唤醒
-    if (time <= WAKE_UP_RTC_MAX_TIME) {
-        time = time + (RTC_MAX_COUNT - WAKE_UP_RTC_MAX_TIME);
-    } else {
-        time = time - WAKE_UP_RTC_MAX_TIME;
-    }
 
     SYS_DisableAllIrq(&irq_status);
     time_curr = RTC_GetCycle32k();
-    // 检测睡眠时间
-    if (time < time_curr) {
-        time_sleep = time + (RTC_MAX_COUNT - time_curr);
+    // 检测睡眠时间（扣除提前唤醒）
+    time_sleep = HAL_SleepDistance(time, time_curr);
+    if (time_sleep > WAKE_UP_RTC_MAX_TIME) {
+        time_sleep -= WAKE_UP_RTC_MAX_TIME;
     } else {
-        time_sleep = time - time_curr;
+        time_sleep = 0;
     }
-    
+    SYS_RecoverIrq(irq_status);
+
     // 若睡眠时间小于最小睡眠时间或大于最大睡眠时间，则不睡眠
     if ((time_sleep < SLEEP_RTC_MIN_TIME) || 
         (time_sleep > SLEEP_RTC_MAX_TIME)) {
-        SYS_RecoverIrq(irq_status);
         return 2;
     }
 
+    HAL_SleepUntil(time);
+    return 0;
+#endif
+    return 3;
+}
+
+/*******************************************************************************
+ * @fn          HAL_SleepDistance
+ *
+ * @brief       RTC 计数 from 到 to 的距离（按 RTC_MAX_COUNT 回绕）
+ *
+ * @param   to      - 目标时间点（RTC绝对值）
+ * @param   from    - 起始时间点（RTC绝对值）
+ *
+ * @return  RTC 周期数.
+ */
+__HIGH_CODE
+uint32_t HAL_SleepDistance(uint32_t to, uint32_t from)
+{
+    return (to >= from) ? (to - from) : (to + (RTC_MAX_COUNT - from));
+}
+
+/*******************************************************************************
+ * @fn          HAL_SleepIdle
+ *
+ * @brief       CPU 暂停（WFI），外设与 SysTick 继续运行，
+ *              RTC 到达 time 或任意已使能中断挂起时返回
+ *
+ * @param   time    - 唤醒的时间点（RTC绝对值）
+ *
+ * @note    可在全局中断关闭（mstatus.MIE=0）时调用：挂起的中断仍会结束 WFI，
+ *          调用方恢复中断后才进入服务函数，检查与暂停之间没有竞争窗口
+ *
+ * @return  None.
+ */
+__HIGH_CODE
+void HAL_SleepIdle(uint32_t time)
+{
+    RTC_SetTignTime(time);
+    LowPower_Idle();
+}
+
+/*******************************************************************************
+ * @fn          HAL_SleepUntil
+ *
+ * @brief       进入 Sleep 模式（HSE/PLL 关闭，RAM 保持），提前 WAKE_UP_RTC_MAX_TIME
+ *              唤醒等待 32M 晶振稳定；RTC、GPIO、USB 均可唤醒
+ *
+ * @param   time    - 唤醒的时间点（RTC绝对值）
+ *
+ * @note    中断约定同 HAL_SleepIdle；睡眠期间 HCLK 停止，SysTick 不计数
+ *
+ * @return  实际停留的 RTC 周期数（用于补偿 SysTick 时间基准）.
+ */
+__HIGH_CODE
+uint32_t HAL_SleepUntil(uint32_t time)
+{
+    volatile uint32_t i;
+    uint32_t start;
+
+    // 提前唤醒
+    if (time <= WAKE_UP_RTC_MAX_TIME) {
+        time = time + (RTC_MAX_COUNT - WAKE_UP_RTC_MAX_TIME);
+    } else {
+        time = time - WAKE_UP_RTC_MAX_TIME;
+    }
     RTC_SetTignTime(time);
-    SYS_RecoverIrq(irq_status);
   #if(DEBUG == Debug_UART1) // 使用其他串口输出打印信息需要修改这行代码
     while((R8_UART1_LSR & RB_LSR_TX_ALL_EMP) == 0)
     {
         __nop();
     }
   #endif
+    start = RTC_GetCycle32k();
     // LOW POWER-sleep模式
-    if(!RTCTigFlag)
-    {
-        LowPower_Sleep(RB_PWR_RAM2K | RB_PWR_RAM24K | RB_PWR_EXTEND | RB_XT_PRE_EN );
-        HSECFG_Current(HSE_RCur_100); // 降为额定电流(低功耗函数中提升了HSE偏置电流)
-        i = RTC_GetCycle32k();
-        while(i == RTC_GetCycle32k());
-        return 0;
-    }
-#endif
-    return 3;
+    LowPower_Sleep(RB_PWR_RAM2K | RB_PWR_RAM24K | RB_PWR_EXTEND | RB_XT_PRE_EN );
+    HSECFG_Current(HSE_RCur_100); // 降为额定电流(低功耗函数中提升了HSE偏置电流)
+    i = RTC_GetCycle32k();
+    while(i == RTC_GetCycle32k());
+    return HAL_SleepDistance(i, start);
 }
 
 /*******************************************************************************
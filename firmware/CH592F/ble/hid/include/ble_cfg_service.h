@@ -0,0 +1,82 @@
+/********************************** (C) COPYRIGHT *******************************
+ * File Name          : ble_cfg_service.h
+ * Author             : Custom Keyboard Library
+ * Version            : V1.0
+ * Date               : 2024/11/07
+ * Description        : 蓝牙配置服务（经 GATT 隧道传输 USB 配置命令帧）
+ *******************************************************************************/
+
+#ifndef BLE_CFG_SERVICE_H
+#define BLE_CFG_SERVICE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "ble_config.h"
+
+/*
+ * 厂商服务 4d656f77-0001-4b62-8c6b-42696e4b6264：
+ * - RX  (…0002) Write / Write Without Response，需加密，主机 → 设备
+ * - TX  (…0003) Notify，设备 → 主机
+ *
+ * 两个方向都是字节流，内容为紧凑命令帧 [cmd][sub][len][data:len]（与 USB 64 字节帧
+ * 相同的字段，去掉尾部填充）。一次写入 / 一条通知可以携带多帧，帧也可以跨包，
+ * 因此与协商到的 ATT MTU 无关；len > 61 视为流失步，丢弃本次写入的剩余字节。
+ */
+
+/* ==================== 事件定义 ==================== */
+
+#define BLE_CFG_PROCESS_EVT         0x0001  // 处理一帧排队的命令
+#define BLE_CFG_FLUSH_EVT           0x0002  // 把发送环中的响应按 MTU 拼包通知
+
+/* ==================== 类型定义 ==================== */
+
+/**
+ * @brief 配置服务统计快照
+ */
+typedef struct {
+    uint16_t mtu;           // 当前 ATT MTU
+    uint8_t tx_phy;         // 当前发送 PHY (GAP_PHY_VAL_TYPE)
+    uint8_t rx_phy;         // 当前接收 PHY
+    uint8_t notify;         // 主机已使能 TX 通知
+    uint8_t rx_high_water;  // 命令队列最大深度
+    uint16_t tx_high_water; // 发送环最大占用（字节）
+    uint32_t rx_frames;     // 收到的完整命令帧
+    uint32_t rx_bytes;      // 收到的字节
+    uint32_t rx_dropped;    // 队列满或失步丢弃的帧
+    uint32_t tx_frames;     // 写入发送环的响应帧
+    uint32_t tx_bytes;      // 已通知的字节
+    uint32_t tx_notifies;   // 已发出的通知条数
+    uint32_t tx_dropped;    // 发送环满或未使能通知丢弃的帧
+    uint32_t tx_retries;    // 通知缓冲不足后的重试次数
+} ble_cfg_stats_t;
+
+/* ==================== 函数声明 ==================== */
+
+/**
+ * @brief 注册配置服务与处理任务（在 HidKbdMouse_AddService 之后调用）
+ * @return 状态
+ */
+bStatus_t BLE_Cfg_AddService(void);
+
+/**
+ * @brief 断链时清空命令队列、发送环与通知使能
+ */
+void BLE_Cfg_Reset(void);
+
+/**
+ * @brief 读取统计快照，可选读取后清零计数（MTU / PHY / 使能状态不受影响）
+ */
+void BLE_Cfg_GetStats(ble_cfg_stats_t *out, uint8_t reset);
+
+/**
+ * @brief TMOS 事件处理
+ */
+uint16_t BLE_Cfg_ProcessEvent(uint8_t task_id, uint16_t events);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BLE_CFG_SERVICE_H */
@@ -16,6 +16,7 @@ extern "C" {
 #include "kbd_mode_config.h"
 #include "ble_config.h"
 #include "hiddev.h"
+#include "kbd_types.h"
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -31,14 +32,141 @@ typedef void (*ble_state_cb_t)(gapRole_States_t newState);
  */
 typedef void (*ble_led_cb_t)(uint8_t leds);
 
+/**
+ * @brief 主机槽位内容变化时回调（用于持久化）
+ *
+ * 链路加密后对端与当前槽位记录不同，或打字档协商出新的连接参数时触发。
+ * @param idx 槽位 (0 ~ KBD_BLE_HOST_COUNT-1)
+ * @param host 槽位新内容
+ */
+typedef void (*ble_host_cb_t)(uint8_t idx, const kbd_ble_host_t *host);
+
 /**
  * @brief BLE HID 回调结构
  */
 typedef struct {
     ble_state_cb_t  onStateChange;      // 状态变化回调
     ble_led_cb_t    onLedReport;        // LED 报告回调
+    ble_host_cb_t   onHostChange;       // 主机槽位变化回调
 } ble_hid_callbacks_t;
 
+/**
+ * @brief 回连广播阶段
+ */
+typedef enum {
+    BLE_HID_RECONN_NONE = 0,     // 未在回连
+    BLE_HID_RECONN_DIRECT_HIGH,  // 高占空比定向广播
+    BLE_HID_RECONN_DIRECT_LOW,   // 低占空比定向广播
+    BLE_HID_RECONN_FAST,         // 快速非定向广播
+    BLE_HID_RECONN_SLOW,         // 慢速非定向广播
+} ble_hid_reconn_phase_t;
+
+#define BLE_HID_RECONN_PHASES 4
+
+/**
+ * @brief 回连统计
+ *
+ * 一次回连从开始广播（开机、断链、手动开始）计时，到链路建立为 link，
+ * 到链路加密（报告可发）为 ready；by_phase 按连上时所处阶段计数。
+ */
+typedef struct {
+    uint8_t  phase;          // 当前阶段 (ble_hid_reconn_phase_t)
+    uint8_t  last_phase;     // 最近一次连上时的阶段，NONE 表示尚无
+    uint8_t  peer_valid;     // 当前主机槽位已记录回连主机
+    uint8_t  peer_type;      // 回连主机地址类型 0=public, 1=random
+    uint8_t  peer_addr[6];   // 回连主机地址（小端）
+    uint8_t  direct_miss;    // 定向广播连续未连上次数
+    uint32_t attempts;       // 发起的回连
+    uint32_t connected;      // 链路建立
+    uint32_t ready;          // 链路加密
+    uint32_t aborted;        // 连上前被停止（深睡 / 清绑定 / 手动停止）
+    uint32_t by_phase[BLE_HID_RECONN_PHASES]; // 各阶段连上次数
+    uint32_t last_link_ms;   // 最近一次开始到链路建立
+    uint32_t last_ready_ms;  // 最近一次开始到链路加密
+    uint32_t max_ready_ms;   // 最大开始到链路加密
+    uint32_t total_ready_ms; // 累计开始到链路加密（平均 = total / ready）
+} ble_hid_reconn_stats_t;
+
+/**
+ * @brief 多主机切换统计
+ *
+ * 切换耗时从 BLE_HID_SelectHost 到新主机链路加密，只统计目标槽位已记录主机的切换
+ * （空槽位切换即进入配对，时长取决于用户操作）。
+ */
+typedef struct {
+    uint8_t  active;         // 当前槽位
+    uint32_t switches;       // 切换次数
+    uint32_t rejected;       // 拒绝的非当前槽位主机连接
+    uint32_t last_switch_ms; // 最近一次切换到链路加密
+    uint32_t max_switch_ms;  // 最大切换到链路加密
+} ble_hid_host_stats_t;
+
+/**
+ * @brief 连接参数策略档位
+ */
+typedef enum {
+    BLE_HID_CONN_FAST = 0,  // 打字：短间隔、从机延迟 0
+    BLE_HID_CONN_IDLE,      // 空闲：长间隔、高从机延迟
+} ble_hid_conn_profile_t;
+
+/**
+ * @brief 连接参数策略统计
+ *
+ * 档位时间只在连接期间累计，按策略档位（而不是主机给出的参数）归类。
+ */
+typedef struct {
+    uint8_t  target;      // 当前档位 (ble_hid_conn_profile_t)
+    uint8_t  requested;   // 最近一次请求成功发出的档位，0xFF 表示本次连接尚未请求
+    uint16_t interval;    // 主机实际给出的连接间隔 (1.25ms)
+    uint16_t latency;     // 实际从机延迟
+    uint16_t timeout;     // 实际监督超时 (10ms)
+    uint32_t requests;    // 发出的参数更新请求
+    uint32_t updates;     // 收到的参数更新
+    uint32_t fast_ms;     // 处于打字档的时间
+    uint32_t idle_ms;     // 处于空闲档的时间
+} ble_hid_conn_stats_t;
+
+/**
+ * @brief 重连补发缓冲统计
+ *
+ * 链路未就绪（未连接或未加密）时输入报告进入缓冲，加密完成后按顺序补发；
+ * 唤醒延迟为唤醒时刻到第一个报告发出的时间。
+ */
+typedef struct {
+    uint8_t  depth;        // 当前缓冲条数
+    uint8_t  high_water;   // 历史最大条数
+    uint32_t buffered;     // 累计进入缓冲
+    uint32_t replayed;     // 加密后补发成功
+    uint32_t expired;      // 超过 KBD_BLE_REPLAY_EXPIRE_MS 丢弃
+    uint32_t dropped;      // 缓冲满丢弃（最旧）
+    uint32_t wake_count;   // 已测量的唤醒次数
+    uint32_t wake_last_ms; // 最近一次唤醒到首报告
+    uint32_t wake_max_ms;  // 最大唤醒到首报告
+} ble_hid_replay_stats_t;
+
+/**
+ * @brief 输入报告发送节奏统计
+ *
+ * 链路就绪时每个连接事件最多有 budget 个报告在控制器中等待确认，超出的进入
+ * 补发缓冲，由连接事件回调逐事件放行。宏回放或积压不少于 KBD_BLE_TX_BURST_BACKLOG
+ * 时进入突发，预算提高到 KBD_BLE_TX_BURST_BUDGET；突发期间的报告数 / 时长 / 连接
+ * 事件数用于和连接间隔给出的理论上限（budget / interval）对比。
+ */
+typedef struct {
+    uint8_t  budget;        // 当前每连接事件预算
+    uint8_t  burst;         // 当前是否处于突发
+    uint8_t  backlog;       // 当前等待放行的报告
+    uint8_t  backlog_max;   // 链路就绪时的最大积压
+    uint16_t interval;      // 当前连接间隔 (1.25ms)
+    uint32_t bursts;        // 突发次数
+    uint32_t burst_reports; // 突发期间交给协议栈的报告
+    uint32_t burst_events;  // 突发期间经过的连接事件
+    uint32_t burst_ms;      // 突发累计时长
+    uint32_t deferred;      // 链路就绪但预算用完 / 协议栈拒绝而排队的报告
+    uint32_t paced;         // 排队后按连接事件放行的报告
+    uint32_t dropped;       // 链路就绪时积压满丢弃（最旧）
+} ble_hid_tx_stats_t;
+
 /* ==================== 初始化 API ==================== */
 
 /**
@@ -48,6 +176,43 @@ typedef struct {
  */
 int BLE_HID_Init(ble_hid_callbacks_t *pCBs);
 
+/**
+ * @brief 载入主机槽位（定向广播目标与记忆的连接参数），在 BLE_HID_Init 之前调用
+ * @param idx 槽位 (0 ~ KBD_BLE_HOST_COUNT-1)
+ * @param host 槽位内容，NULL 表示空槽
+ */
+void BLE_HID_SetHost(uint8_t idx, const kbd_ble_host_t *host);
+
+/**
+ * @brief 设置当前主机槽位，在 BLE_HID_Init 之前调用
+ * @param idx 槽位 (0 ~ KBD_BLE_HOST_COUNT-1)
+ */
+void BLE_HID_SetActiveHost(uint8_t idx);
+
+/**
+ * @brief 运行时切换主机槽位
+ *
+ * 断开当前连接（或停止当前广播）后向新槽位主机定向广播；空槽位从非定向广播开始，
+ * 等待新主机配对。连接期间其他已记录槽位的主机会被拒绝。
+ * @param idx 槽位 (0 ~ KBD_BLE_HOST_COUNT-1)
+ * @return 0 成功（已连接当前槽位时不做任何事），-1 失败
+ */
+int BLE_HID_SelectHost(uint8_t idx);
+
+/**
+ * @brief 获取当前主机槽位
+ * @return 槽位 (0 ~ KBD_BLE_HOST_COUNT-1)
+ */
+uint8_t BLE_HID_GetActiveHost(void);
+
+/**
+ * @brief 读取主机槽位
+ * @param idx 槽位 (0 ~ KBD_BLE_HOST_COUNT-1)
+ * @param out 槽位内容输出
+ * @return 0 成功，-1 槽位越界
+ */
+int BLE_HID_GetHost(uint8_t idx, kbd_ble_host_t *out);
+
 /**
  * @brief BLE HID TMOS 事件处理
  * @param task_id 任务 ID
@@ -113,7 +278,8 @@ uint8_t BLE_HID_GetBondCount(void);
  * @param modifier 修饰键
  * @param keys 按键数组
  * @param key_count 按键数量
- * @return 0 成功，其他失败
+ * @return 0 已发送或已缓冲，其他失败
+ * @note  鼠标 / 多媒体报告相同：链路未加密时进入补发缓冲
  */
 int BLE_HID_SendKeyboardReport(uint8_t modifier, uint8_t *keys, uint8_t key_count);
 
@@ -123,9 +289,15 @@ int BLE_HID_SendKeyboardReport(uint8_t modifier, uint8_t *keys, uint8_t key_coun
  * @param x X 移动
  * @param y Y 移动
  * @param wheel 滚轮
+ * @param pan 水平滚动 (AC Pan)
  * @return 0 成功，其他失败
  */
-int BLE_HID_SendMouseReport(uint8_t buttons, int8_t x, int8_t y, int8_t wheel);
+int BLE_HID_SendMouseReport(uint8_t buttons, int8_t x, int8_t y, int8_t wheel, int8_t pan);
+
+/**
+ * @brief 获取主机写入的鼠标 Resolution Multiplier 特性 (KBD_HID_SCROLL_FEATURE_*)
+ */
+uint8_t BLE_HID_GetMouseFeature(void);
 
 /**
  * @brief 发送多媒体报告
@@ -134,6 +306,76 @@ int BLE_HID_SendMouseReport(uint8_t buttons, int8_t x, int8_t y, int8_t wheel);
  */
 int BLE_HID_SendConsumerReport(uint16_t key);
 
+/**
+ * @brief 记录唤醒时刻，第一个报告发出时计算唤醒延迟（可在中断中调用）
+ */
+void BLE_HID_MarkWake(void);
+
+/**
+ * @brief 读取重连补发统计，可选读取后清零（TMOS 任务上下文调用）
+ *
+ * 缓冲条数为当前 FIFO 深度，可能包含已超时、尚未丢弃的条目。
+ *
+ * @param out 统计输出
+ * @param reset 非 0 时清零计数（当前缓冲条数不变）
+ */
+void BLE_HID_GetReplayStats(ble_hid_replay_stats_t *out, uint8_t reset);
+
+/**
+ * @brief 读取连接参数策略统计（含进行中的一段），可选读取后清零（TMOS 任务上下文调用）
+ * @param out 统计输出
+ * @param reset 非 0 时清零计数与档位时间（参数与档位不变）
+ */
+void BLE_HID_GetConnStats(ble_hid_conn_stats_t *out, uint8_t reset);
+
+/**
+ * @brief 宏回放等连续输入开始 / 结束时切换发送突发
+ *
+ * 突发期间每个连接事件的发送预算提高到 KBD_BLE_TX_BURST_BUDGET；结束请求后等积压
+ * 放行完才退出突发。
+ * @param enable true=开始，false=结束
+ */
+void BLE_HID_SetTxBurst(bool enable);
+
+/**
+ * @brief 在下一个连接事件结束后投递一次 TMOS 事件
+ *
+ * 连接事件结束到下一个锚点之间射频空闲，对射频电流敏感的工作（ADC 采样、Flash 擦写）
+ * 放在这段间隙里。一次性登记，同一 (task_id, event) 重复登记只投递一次；断链时立即投递。
+ * 从机延迟生效时连接事件间隔会拉长到 (latency+1) 个连接间隔，调用方需要自备超时。
+ * @param task_id TMOS 任务 ID
+ * @param event 事件位
+ * @return true 已登记；false 当前没有连接或登记表已满，调用方应立即执行
+ */
+bool BLE_HID_PostAfterConnEvent(uint8_t task_id, uint16_t event);
+
+/**
+ * @brief 链路就绪且积压达到 KBD_BLE_TX_BACKLOG_MAX，连续输入的产生方应暂停
+ * @return true 需要等待
+ */
+bool BLE_HID_TxBusy(void);
+
+/**
+ * @brief 读取发送节奏统计，可选读取后清零
+ * @param out 统计输出
+ * @param reset 非 0 时清零计数（预算、突发状态与当前积压不变）
+ */
+void BLE_HID_GetTxStats(ble_hid_tx_stats_t *out, uint8_t reset);
+
+/**
+ * @brief 读取回连统计，可选读取后清零
+ * @param out 统计输出
+ * @param reset 非 0 时清零计数与时间（阶段与回连主机不变）
+ */
+void BLE_HID_GetReconnStats(ble_hid_reconn_stats_t *out, uint8_t reset);
+
+/**
+ * @brief 读取多主机切换统计，可选读取后清零
+ * @param out 统计输出
+ * @param reset 非 0 时清零计数与时间（当前槽位不变）
+ */
+void BLE_HID_GetHostStats(ble_hid_host_stats_t *out, uint8_t reset);
+
 /**
  * @brief 获取键盘 LED 状态
  * @return LED 状态位图
@@ -149,6 +391,9 @@ extern uint8_t bleHidTaskId;
 #define BLE_HID_PARAM_UPDATE_EVT        0x0001
 #define BLE_HID_PHY_UPDATE_EVT          0x0002
 #define BLE_HID_SECURITY_REQ_EVT        0x0004
+#define BLE_HID_REPLAY_EVT              0x0008
+#define BLE_HID_CONN_IDLE_EVT           0x0010
+#define BLE_HID_RECONN_EVT              0x0020
 
 #ifdef __cplusplus
 }
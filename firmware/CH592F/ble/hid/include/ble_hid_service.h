@@ -14,18 +14,20 @@ extern "C" {
 #endif
 
 #include "ble_config.h"
+#include "kbd_hid_report.h"
 
 /* ==================== 报告数量定义 ==================== */
 
-// HID 报告数量（键盘输入、键盘LED输出、鼠标输入、多媒体输入、Boot键盘输入/输出、电池）
-#define HID_NUM_REPORTS             7
+// HID 报告数量（键盘输入、键盘LED输出、鼠标输入/特性、多媒体输入、Boot键盘输入/输出、电池）
+#define HID_NUM_REPORTS             8
 
 /* ==================== 报告 ID 定义 ==================== */
 
-#define HID_RPT_ID_KEY_IN           1       // 键盘输入报告
-#define HID_RPT_ID_LED_OUT          1       // LED 输出报告
-#define HID_RPT_ID_MOUSE_IN         2       // 鼠标输入报告
-#define HID_RPT_ID_CONSUMER_IN      3       // 多媒体输入报告
+// 输入报告 ID 来自 kbd_hid_report.h 报告表
+#define HID_RPT_ID_KEY_IN           KBD_HID_RID_KEYBOARD    // 键盘输入报告
+#define HID_RPT_ID_LED_OUT          KBD_HID_RID_KEYBOARD    // LED 输出报告 (键盘集合内)
+#define HID_RPT_ID_MOUSE_IN         KBD_HID_RID_MOUSE       // 鼠标输入报告 (同 ID 的特性报告为 Resolution Multiplier)
+#define HID_RPT_ID_CONSUMER_IN      KBD_HID_RID_CONSUMER    // 多媒体输入报告
 #define HID_RPT_ID_FEATURE          4       // 特性报告
 
 /* ==================== HID 特性标志 ==================== */
@@ -60,6 +62,9 @@ extern uint8_t hidProtocolMode;
 // HID 报告映射长度
 extern uint16_t hidReportMapLen;
 
+// 鼠标 Resolution Multiplier 特性报告 (KBD_HID_SCROLL_FEATURE_*)
+extern uint8_t hidReportMouseFeature;
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,122 @@
+/********************************** (C) COPYRIGHT *******************************
+ * File Name          : ble_link.h
+ * Author             : Custom Keyboard Library
+ * Version            : V1.0
+ * Date               : 2024/11/07
+ * Description        : 蓝牙链路质量遥测与自适应发射功率
+ *******************************************************************************/
+
+#ifndef BLE_LINK_H
+#define BLE_LINK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "ble_config.h"
+#include <stdbool.h>
+
+/*
+ * 连接期间每 KBD_BLE_LINK_SAMPLE_MS 读一次 RSSI 并结算一个窗口：
+ * - 连接事件：LL 连接事件回调计数
+ * - 漏事件：从机延迟为 0 时按窗口时长估计的应有事件数减去实际回调数
+ * - 重传：两次连接事件之间没有新数据交给协议栈，而未确认的包数没有减少（近似，偏保守）
+ * 自适应发射功率打开时按 RSSI 均值与上述退化信号在 BLE_LINK_TX_LEVELS 档之间升降，
+ * 断链后恢复 BLE_TX_POWER。
+ */
+
+/* ==================== 事件定义 ==================== */
+
+#define BLE_LINK_SAMPLE_EVT         0x0001  // 采样周期到：读 RSSI
+
+/* ==================== 常量定义 ==================== */
+
+#define BLE_LINK_TX_LEVELS          5       // 发射功率档位：-15 / -10 / -5 / 0 / +4 dBm
+
+/* ==================== 类型定义 ==================== */
+
+/**
+ * @brief 链路遥测快照
+ */
+typedef struct {
+    int8_t   rssi_last;       // 最近一次 RSSI (dBm)，127 表示尚未读到
+    int8_t   rssi_avg;        // 本次连接的 RSSI 滑动平均
+    int8_t   rssi_min;        // 最小 RSSI
+    int8_t   rssi_max;        // 最大 RSSI
+    int8_t   tx_dbm;          // 当前发射功率
+    int8_t   tx_dbm_default;  // BLE_TX_POWER 对应的发射功率
+    uint8_t  adapt;           // 自适应发射功率已打开
+    uint8_t  last_reason;     // 最近一次断链原因 (HCI 错误码)
+    uint16_t interval;        // 当前连接间隔 (1.25ms)
+    uint32_t events;          // 连接事件
+    uint32_t missed;          // 估计的漏事件
+    uint32_t retries;         // 重传事件
+    uint32_t tx_changes;      // 发射功率调整次数
+    uint16_t disc_timeout;    // 监督超时断链 (0x08)
+    uint16_t disc_remote;     // 主机断开 (0x13)
+    uint16_t disc_local;      // 本机断开 (0x16)
+    uint16_t disc_other;      // 其他原因断链
+    uint32_t level_ms[BLE_LINK_TX_LEVELS];        // 各档位累计连接时间
+    uint16_t level_retry_pm[BLE_LINK_TX_LEVELS];  // 各档位重传事件比例 (‰)
+} ble_link_stats_t;
+
+/* ==================== 函数声明 ==================== */
+
+/**
+ * @brief 注册遥测任务，确定默认发射功率档位
+ */
+void BLE_Link_Init(void);
+
+/**
+ * @brief 链路建立：开始采样
+ * @param conn_handle 连接句柄
+ */
+void BLE_Link_Start(uint16_t conn_handle);
+
+/**
+ * @brief 链路结束：停止采样，记录断链原因并恢复默认发射功率
+ * @param reason HCI 断链原因，0 表示不是断链（如广播超时）
+ */
+void BLE_Link_Stop(uint8_t reason);
+
+/**
+ * @brief 每个连接事件结束后调用（LL 回调，中断上下文）
+ */
+void BLE_Link_OnConnEvent(void);
+
+/**
+ * @brief 一个数据包交给了协议栈（HID 报告 / 配置服务通知）
+ */
+void BLE_Link_NoteTx(void);
+
+/**
+ * @brief RSSI 读取完成
+ * @param rssi RSSI (dBm)
+ */
+void BLE_Link_OnRssi(int8_t rssi);
+
+/**
+ * @brief 连接参数已更新，当前窗口不再估计漏事件
+ */
+void BLE_Link_OnParamUpdate(void);
+
+/**
+ * @brief 运行时打开 / 关闭自适应发射功率（不保存），关闭时回到默认档位
+ */
+void BLE_Link_SetAdaptive(bool enable);
+
+/**
+ * @brief 读取遥测快照，可选读取后清零计数（RSSI 均值、当前档位与开关不变）
+ */
+void BLE_Link_GetStats(ble_link_stats_t *out, uint8_t reset);
+
+/**
+ * @brief TMOS 事件处理
+ */
+uint16_t BLE_Link_ProcessEvent(uint8_t task_id, uint16_t events);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BLE_LINK_H */
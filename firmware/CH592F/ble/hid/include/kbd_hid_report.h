@@ -0,0 +1,304 @@
+/**
+ * @file    kbd_hid_report.h
+ * @brief   MeowKeyboard HID 输入报告表 (USB / BLE 共用)
+ * @author  MeowKJ
+ * @version V1.0.0
+ * @date    2024-11-07
+ *
+ * @details
+ * 键盘 / 鼠标 / 多媒体输入报告只在这里定义一次，其余都由宏在编译期展开：
+ *
+ * - KBD_HID_REPORTS(X)：每类报告一行，给出 BLE 报告 ID 与 USB 接口 / 端点 / 子类 / 协议
+ * - KBD_HID_<NAME>_FIELDS(F, A)：报告字段，展开为 packed 结构体 kbd_hid_<name>_report_t，
+ *   报告长度即 sizeof，挂起 / 重放缓冲按 KBD_HID_REPORT_MAX_LEN 分配
+ * - KBD_HID_DESC_<NAME>(RID)：报告描述符字节；BLE 报告映射逐个拼接并带 Report ID 项
+ *   (KBD_HID_ITEM_RID)，USB 每个接口一份、不带 Report ID (KBD_HID_ITEM_NONE)，
+ *   长度用 KBD_HID_DESC_SIZE 在编译期得出
+ * - KBD_HID_Pack<Name>：按字段直接写入报告，不在运行时按长度分支
+ *
+ * 新增一类输入报告：在 KBD_HID_REPORTS 中加一行，给出 FIELDS / DESC 与打包函数。
+ * USB 配置描述符的接口段与 BLE 报告映射会随之展开；BLE HID 服务的 GATT 属性表
+ * (特征值 / CCCD / Report Reference) 仍需在 ble_hid_service.c 中按顺序补上。
+ *
+ * @copyright Copyright (c) 2024 MeowKJ. All rights reserved.
+ */
+
+#ifndef __KBD_HID_REPORT_H
+#define __KBD_HID_REPORT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "kbd_mode_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ======================= 报告表 ======================= */
+
+/*
+ * X(NAME, name, 报告 ID, USB 接口号, USB IN 端点, 接口子类, 接口协议)
+ *
+ * 报告 ID 只出现在 BLE 报告映射中 (USB 每类报告独占一个接口，不带 ID)；
+ * 键盘与鼠标接口声明 Boot 子类，描述符前 3 字节保持 Boot 协议格式。
+ */
+#define KBD_HID_REPORTS(X)                                                     \
+    X(KEYBOARD, keyboard, 1, 0, 0x81, 0x01, 0x01)                              \
+    X(MOUSE,    mouse,    2, 1, 0x82, 0x01, 0x02)                              \
+    X(CONSUMER, consumer, 3, 2, 0x83, 0x00, 0x00)
+
+#define KBD_HID_KEYBOARD_KEYS 6 /**< 键盘报告按键数组长度 (6KRO) */
+
+/* ---------------- 报告字段: F(类型, 字段名) / A(类型, 字段名, 个数) ---------------- */
+
+#define KBD_HID_KEYBOARD_FIELDS(F, A)                                          \
+    F(uint8_t, modifier)                                                       \
+    F(uint8_t, reserved)                                                       \
+    A(uint8_t, keycode, KBD_HID_KEYBOARD_KEYS)
+
+#define KBD_HID_MOUSE_FIELDS(F, A)                                             \
+    F(uint8_t, buttons)                                                        \
+    F(int8_t, x)                                                               \
+    F(int8_t, y)                                                               \
+    F(int8_t, wheel)                                                           \
+    F(int8_t, pan)
+
+#define KBD_HID_CONSUMER_FIELDS(F, A)                                          \
+    F(uint16_t, key)
+
+/* ======================= 报告描述符 ======================= */
+
+/** Report ID 项：BLE 报告映射用 KBD_HID_ITEM_RID，USB 接口用 KBD_HID_ITEM_NONE */
+#define KBD_HID_ITEM_RID(id)  0x85, (id),
+#define KBD_HID_ITEM_NONE(id)
+
+/** 描述符字节数 (编译期常量) */
+#define KBD_HID_DESC_SIZE(NAME, RID) \
+    sizeof((const uint8_t[]){KBD_HID_DESC_##NAME(RID)})
+
+/* 键盘：8 个修饰键位 + 保留字节 + 5 个 LED 输出位 + 6 键数组 */
+#define KBD_HID_DESC_KEYBOARD(RID)                                             \
+    0x05, 0x01,         /* Usage Page (Generic Desktop) */                     \
+    0x09, 0x06,         /* Usage (Keyboard) */                                 \
+    0xA1, 0x01,         /* Collection (Application) */                         \
+    RID(KBD_HID_RID_KEYBOARD)                                                  \
+    0x05, 0x07,         /*   Usage Page (Key Codes) */                         \
+    0x19, 0xE0,         /*   Usage Minimum (224) - Left Control */             \
+    0x29, 0xE7,         /*   Usage Maximum (231) - Right GUI */                \
+    0x15, 0x00,         /*   Logical Minimum (0) */                            \
+    0x25, 0x01,         /*   Logical Maximum (1) */                            \
+    0x75, 0x01,         /*   Report Size (1) */                                \
+    0x95, 0x08,         /*   Report Count (8) */                               \
+    0x81, 0x02,         /*   Input (Data, Variable, Absolute) */               \
+    0x95, 0x01,         /*   Report Count (1) */                               \
+    0x75, 0x08,         /*   Report Size (8) */                                \
+    0x81, 0x01,         /*   Input (Constant) - 保留字节 */                    \
+    0x95, 0x05,         /*   Report Count (5) */                               \
+    0x75, 0x01,         /*   Report Size (1) */                                \
+    0x05, 0x08,         /*   Usage Page (LEDs) */                              \
+    0x19, 0x01,         /*   Usage Minimum (1) */                              \
+    0x29, 0x05,         /*   Usage Maximum (5) */                              \
+    0x91, 0x02,         /*   Output (Data, Variable, Absolute) */              \
+    0x95, 0x01,         /*   Report Count (1) */                               \
+    0x75, 0x03,         /*   Report Size (3) */                                \
+    0x91, 0x01,         /*   Output (Constant) - LED 填充 */                   \
+    0x95, KBD_HID_KEYBOARD_KEYS, /* Report Count (6) */                        \
+    0x75, 0x08,         /*   Report Size (8) */                                \
+    0x15, 0x00,         /*   Logical Minimum (0) */                            \
+    0x26, 0xFF, 0x00,   /*   Logical Maximum (255) */                          \
+    0x05, 0x07,         /*   Usage Page (Key Codes) */                         \
+    0x19, 0x00,         /*   Usage Minimum (0) */                              \
+    0x29, 0xFF,         /*   Usage Maximum (255) */                            \
+    0x81, 0x00,         /*   Input (Data, Array) */                            \
+    0xC0,               /* End Collection */
+
+/*
+ * 鼠标 (前 3 字节兼容 Boot 协议)：3 键 + X/Y + 滚轮 + 水平滚动 (AC Pan)。
+ * 滚轮与水平滚动各自放在逻辑集合中，配一个 Resolution Multiplier 特性字段；
+ * 两个 2 bit 倍率 + 4 bit 填充组成 1 字节特性报告 (见 KBD_HID_SCROLL_HIRES_MULT)
+ */
+#define KBD_HID_DESC_MOUSE(RID)                                                \
+    0x05, 0x01,         /* Usage Page (Generic Desktop) */                     \
+    0x09, 0x02,         /* Usage (Mouse) */                                    \
+    0xA1, 0x01,         /* Collection (Application) */                         \
+    RID(KBD_HID_RID_MOUSE)                                                     \
+    0x09, 0x01,         /*   Usage (Pointer) */                                \
+    0xA1, 0x00,         /*   Collection (Physical) */                          \
+    0x05, 0x09,         /*     Usage Page (Buttons) */                         \
+    0x19, 0x01,         /*     Usage Minimum (1) */                            \
+    0x29, 0x03,         /*     Usage Maximum (3) */                            \
+    0x15, 0x00,         /*     Logical Minimum (0) */                          \
+    0x25, 0x01,         /*     Logical Maximum (1) */                          \
+    0x75, 0x01,         /*     Report Size (1) */                              \
+    0x95, 0x03,         /*     Report Count (3) */                             \
+    0x81, 0x02,         /*     Input (Data, Variable, Absolute) */             \
+    0x75, 0x05,         /*     Report Size (5) */                              \
+    0x95, 0x01,         /*     Report Count (1) */                             \
+    0x81, 0x01,         /*     Input (Constant) - 按键填充 */                  \
+    0x05, 0x01,         /*     Usage Page (Generic Desktop) */                 \
+    0x09, 0x30,         /*     Usage (X) */                                    \
+    0x09, 0x31,         /*     Usage (Y) */                                    \
+    0x15, 0x81,         /*     Logical Minimum (-127) */                       \
+    0x25, 0x7F,         /*     Logical Maximum (127) */                        \
+    0x75, 0x08,         /*     Report Size (8) */                              \
+    0x95, 0x02,         /*     Report Count (2) */                             \
+    0x81, 0x06,         /*     Input (Data, Variable, Relative) */             \
+    0xA1, 0x02,         /*     Collection (Logical) */                         \
+    0x09, 0x48,         /*       Usage (Resolution Multiplier) */              \
+    0x15, 0x00,         /*       Logical Minimum (0) */                        \
+    0x25, 0x01,         /*       Logical Maximum (1) */                        \
+    0x35, 0x01,         /*       Physical Minimum (1) */                       \
+    0x45, KBD_HID_SCROLL_HIRES_MULT, /* Physical Maximum */                    \
+    0x75, 0x02,         /*       Report Size (2) */                            \
+    0x95, 0x01,         /*       Report Count (1) */                           \
+    0xB1, 0x02,         /*       Feature (Data, Variable, Absolute) */         \
+    0x35, 0x00,         /*       Physical Minimum (0) */                       \
+    0x45, 0x00,         /*       Physical Maximum (0) */                       \
+    0x09, 0x38,         /*       Usage (Wheel) */                              \
+    0x15, 0x81,         /*       Logical Minimum (-127) */                     \
+    0x25, 0x7F,         /*       Logical Maximum (127) */                      \
+    0x75, 0x08,         /*       Report Size (8) */                            \
+    0x95, 0x01,         /*       Report Count (1) */                           \
+    0x81, 0x06,         /*       Input (Data, Variable, Relative) */           \
+    0xC0,               /*     End Collection (Logical) */                     \
+    0xA1, 0x02,         /*     Collection (Logical) */                         \
+    0x09, 0x48,         /*       Usage (Resolution Multiplier) */              \
+    0x15, 0x00,         /*       Logical Minimum (0) */                        \
+    0x25, 0x01,         /*       Logical Maximum (1) */                        \
+    0x35, 0x01,         /*       Physical Minimum (1) */                       \
+    0x45, KBD_HID_SCROLL_HIRES_MULT, /* Physical Maximum */                    \
+    0x75, 0x02,         /*       Report Size (2) */                            \
+    0x95, 0x01,         /*       Report Count (1) */                           \
+    0xB1, 0x02,         /*       Feature (Data, Variable, Absolute) */         \
+    0x35, 0x00,         /*       Physical Minimum (0) */                       \
+    0x45, 0x00,         /*       Physical Maximum (0) */                       \
+    0x05, 0x0C,         /*       Usage Page (Consumer) */                      \
+    0x0A, 0x38, 0x02,   /*       Usage (AC Pan) */                             \
+    0x15, 0x81,         /*       Logical Minimum (-127) */                     \
+    0x25, 0x7F,         /*       Logical Maximum (127) */                      \
+    0x75, 0x08,         /*       Report Size (8) */                            \
+    0x95, 0x01,         /*       Report Count (1) */                           \
+    0x81, 0x06,         /*       Input (Data, Variable, Relative) */           \
+    0xC0,               /*     End Collection (Logical) */                     \
+    0x75, 0x04,         /*     Report Size (4) */                              \
+    0x95, 0x01,         /*     Report Count (1) */                             \
+    0xB1, 0x01,         /*     Feature (Constant) - 特性报告填充 */            \
+    0xC0,               /*   End Collection (Physical) */                      \
+    0xC0,               /* End Collection (Application) */
+
+/* 多媒体：1 个 16 位 Consumer 用法 (数组) */
+#define KBD_HID_DESC_CONSUMER(RID)                                             \
+    0x05, 0x0C,         /* Usage Page (Consumer) */                            \
+    0x09, 0x01,         /* Usage (Consumer Control) */                         \
+    0xA1, 0x01,         /* Collection (Application) */                         \
+    RID(KBD_HID_RID_CONSUMER)                                                  \
+    0x15, 0x00,         /*   Logical Minimum (0) */                            \
+    0x26, 0xFF, 0x03,   /*   Logical Maximum (1023) */                         \
+    0x19, 0x00,         /*   Usage Minimum (0) */                              \
+    0x2A, 0xFF, 0x03,   /*   Usage Maximum (1023) */                           \
+    0x75, 0x10,         /*   Report Size (16) */                               \
+    0x95, 0x01,         /*   Report Count (1) */                               \
+    0x81, 0x00,         /*   Input (Data, Array) */                            \
+    0xC0,               /* End Collection */
+
+/** 按报告表顺序拼接全部描述符 (BLE 报告映射) */
+#define KBD_HID_DESC_ENTRY_RID(NAME, name, rid, intf, ep, sub, proto) \
+    KBD_HID_DESC_##NAME(KBD_HID_ITEM_RID)
+#define KBD_HID_DESC_ALL_WITH_RID KBD_HID_REPORTS(KBD_HID_DESC_ENTRY_RID)
+
+/* ======================= 展开：ID / 接口 / 结构体 / 长度 ======================= */
+
+#define KBD_HID_ENUM_RID(NAME, name, rid, intf, ep, sub, proto) \
+    KBD_HID_RID_##NAME = (rid),
+#define KBD_HID_ENUM_INTF(NAME, name, rid, intf, ep, sub, proto) \
+    KBD_HID_INTF_##NAME = (intf),
+#define KBD_HID_ENUM_EP(NAME, name, rid, intf, ep, sub, proto) \
+    KBD_HID_EP_##NAME = (ep),
+#define KBD_HID_ENUM_INDEX(NAME, name, rid, intf, ep, sub, proto) \
+    KBD_HID_INDEX_##NAME,
+
+/** BLE 报告 ID (KBD_HID_RID_KEYBOARD ...) */
+enum { KBD_HID_REPORTS(KBD_HID_ENUM_RID) };
+
+/** USB 接口号 (KBD_HID_INTF_KEYBOARD ...) */
+enum { KBD_HID_REPORTS(KBD_HID_ENUM_INTF) };
+
+/** USB IN 端点地址 (KBD_HID_EP_KEYBOARD ...) */
+enum { KBD_HID_REPORTS(KBD_HID_ENUM_EP) };
+
+/** 报告表中的序号，KBD_HID_REPORT_COUNT = 输入报告类数 */
+enum { KBD_HID_REPORTS(KBD_HID_ENUM_INDEX) KBD_HID_REPORT_COUNT };
+
+#define KBD_HID_FIELD_DECL(type, field)         type field;
+#define KBD_HID_ARRAY_DECL(type, field, count)  type field[count];
+#define KBD_HID_STRUCT_DECL(NAME, name, rid, intf, ep, sub, proto)      \
+    typedef struct __attribute__((packed)) {                                   \
+        KBD_HID_##NAME##_FIELDS(KBD_HID_FIELD_DECL, KBD_HID_ARRAY_DECL)        \
+    } kbd_hid_##name##_report_t;
+
+/* kbd_hid_keyboard_report_t / kbd_hid_mouse_report_t / kbd_hid_consumer_report_t */
+KBD_HID_REPORTS(KBD_HID_STRUCT_DECL)
+
+#define KBD_HID_ENUM_LEN(NAME, name, rid, intf, ep, sub, proto) \
+    KBD_HID_LEN_##NAME = sizeof(kbd_hid_##name##_report_t),
+#define KBD_HID_UNION_MEMBER(NAME, name, rid, intf, ep, sub, proto) \
+    kbd_hid_##name##_report_t name;
+
+/** 报告长度 (字节，不含 Report ID) */
+enum { KBD_HID_REPORTS(KBD_HID_ENUM_LEN) };
+
+/** 任一输入报告 */
+typedef union {
+    KBD_HID_REPORTS(KBD_HID_UNION_MEMBER)
+} kbd_hid_any_report_t;
+
+/** 最长输入报告 (挂起 / 重放缓冲单条长度) */
+#define KBD_HID_REPORT_MAX_LEN sizeof(kbd_hid_any_report_t)
+
+/* kbd_mode_config.h 中的报告长度供不含本头文件的模块使用，须与字段表一致 */
+typedef char kbd_hid_keyboard_len_check[(KBD_HID_LEN_KEYBOARD == KBD_HID_KEYBOARD_REPORT_LEN) ? 1 : -1];
+typedef char kbd_hid_mouse_len_check[(KBD_HID_LEN_MOUSE == KBD_HID_MOUSE_REPORT_LEN) ? 1 : -1];
+typedef char kbd_hid_consumer_len_check[(KBD_HID_LEN_CONSUMER == KBD_HID_CONSUMER_REPORT_LEN) ? 1 : -1];
+
+/* ======================= 打包 ======================= */
+
+/**
+ * @brief 键盘报告：修饰键 + 最多 KBD_HID_KEYBOARD_KEYS 个键码，其余清零
+ * @param keys  键码数组，count 为 0 时可为 NULL
+ */
+static inline void KBD_HID_PackKeyboard(kbd_hid_keyboard_report_t *r, uint8_t modifier,
+                                        const uint8_t *keys, uint8_t count)
+{
+    r->modifier = modifier;
+    r->reserved = 0;
+    for (uint8_t i = 0; i < KBD_HID_KEYBOARD_KEYS; i++) {
+        r->keycode[i] = (i < count) ? keys[i] : 0;
+    }
+}
+
+/**
+ * @brief 鼠标报告
+ */
+static inline void KBD_HID_PackMouse(kbd_hid_mouse_report_t *r, uint8_t buttons,
+                                     int8_t x, int8_t y, int8_t wheel, int8_t pan)
+{
+    r->buttons = buttons;
+    r->x = x;
+    r->y = y;
+    r->wheel = wheel;
+    r->pan = pan;
+}
+
+/**
+ * @brief 多媒体报告 (小端，与 CH592 字节序一致)
+ */
+static inline void KBD_HID_PackConsumer(kbd_hid_consumer_report_t *r, uint16_t key)
+{
+    r->key = key;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __KBD_HID_REPORT_H */
@@ -73,8 +73,8 @@ extern "C"
     int KBD_Mode_Init(kbd_work_mode_t initial_mode, kbd_mode_callbacks_t *pCBs);
 
     /**
-     * @brief 模式管理器主循环处理
-     * @note  需要在主循环中周期性调用
+     * @brief 模式管理器状态检查（USB 枚举、自动休眠、指示灯）
+     * @note  由模式任务在唤醒请求、连接状态变化或自身定时到达时调用
      */
     void KBD_Mode_Process(void);
 
@@ -84,7 +84,7 @@ extern "C"
     void KBD_Mode_RecordActivity(void);
 
     /**
-     * @brief 请求退出低功耗，由主循环统一执行恢复。
+     * @brief 请求退出低功耗，由模式任务统一执行恢复（可在中断中调用）。
      */
     void KBD_Mode_RequestWake(void);
 
@@ -162,6 +162,23 @@ extern "C"
      */
     uint8_t KBD_Mode_BLE_GetBondCount(void);
 
+    /**
+     * @brief 切换蓝牙主机槽位
+     *
+     * 断开当前主机后向新槽位主机定向回连；空槽位进入可配对广播，
+     * 新主机加密后记入该槽位。当前槽位异步持久化。
+     * @note  仅在 BLE 模式下执行
+     * @param idx 槽位 (0 ~ KBD_BLE_HOST_COUNT-1)
+     * @return 0 成功，其他失败
+     */
+    int KBD_Mode_BLE_SelectHost(uint8_t idx);
+
+    /**
+     * @brief 获取当前蓝牙主机槽位
+     * @return 槽位 (0 ~ KBD_BLE_HOST_COUNT-1)
+     */
+    uint8_t KBD_Mode_BLE_GetHost(void);
+
     /*============================================================================*/
     /* USB 控制 API */
     /*============================================================================*/
@@ -178,6 +195,11 @@ extern "C"
      */
     int KBD_Mode_USB_Wakeup(void);
 
+    /**
+     * @brief USB 总线从挂起恢复（USB 中断中调用），投递模式任务发出挂起期间缓冲的报告
+     */
+    void KBD_Mode_USB_NotifyResume(void);
+
     /*============================================================================*/
     /* HID 报告发送 API */
     /*============================================================================*/
@@ -210,11 +232,27 @@ extern "C"
      * @param buttons 按钮位图
      * @param x X 轴移动量
      * @param y Y 轴移动量
-     * @param wheel 滚轮移动量
+     * @param wheel 滚轮移动量 (格，主机启用高分辨率时自动换算)
      * @return 0 成功，其他失败
      */
     int KBD_Mode_SendMouseReport(uint8_t buttons, int8_t x, int8_t y, int8_t wheel);
 
+    /**
+     * @brief 获取当前连接的滚动分辨率
+     * @param[out] wheel 滚轮每格单位数 (1 或 KBD_HID_SCROLL_HIRES_MULT)
+     * @param[out] pan   水平滚动每格单位数 (1 或 KBD_HID_SCROLL_HIRES_MULT)
+     */
+    void KBD_Mode_GetScrollResolution(uint8_t *wheel, uint8_t *pan);
+
+    /**
+     * @brief 发送滚动报告 (不换算)
+     * @param buttons 按钮位图
+     * @param wheel 滚轮 (当前分辨率下的单位)
+     * @param pan 水平滚动 (当前分辨率下的单位)
+     * @return 0 成功，其他失败
+     */
+    int KBD_Mode_SendMouseScroll(uint8_t buttons, int8_t wheel, int8_t pan);
+
     /**
      * @brief 发送鼠标点击
      * @param buttons 按钮位图
@@ -236,6 +274,26 @@ extern "C"
      */
     int KBD_Mode_SendConsumerKey(uint16_t key);
 
+    /**
+     * @brief 连续输入（宏回放）开始 / 结束，蓝牙模式下提高每连接事件的发送预算
+     * @param enable true=开始，false=结束
+     */
+    void KBD_Mode_SetTxBurst(bool enable);
+
+    /**
+     * @brief 射频空闲时再执行：蓝牙已连接时在下一个连接事件结束后投递 TMOS 事件
+     * @param task_id TMOS 任务 ID
+     * @param event 事件位
+     * @return true 已登记；false 非蓝牙模式或未连接，调用方应立即执行
+     */
+    bool KBD_Mode_PostAfterRadioEvent(uint8_t task_id, uint16_t event);
+
+    /**
+     * @brief 发送积压已满，连续输入的产生方应稍后再发
+     * @return true 需要等待（仅蓝牙链路就绪时可能为 true）
+     */
+    bool KBD_Mode_TxBusy(void);
+
     /*============================================================================*/
     /* 低功耗 API */
     /*============================================================================*/
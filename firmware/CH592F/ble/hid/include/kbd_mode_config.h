@@ -75,11 +75,80 @@ extern "C"
 #define KBD_BLE_ADV_INT_MAX 80 /**< 50ms */
 #define KBD_BLE_ADV_TIMEOUT 60 /**< 60秒超时 */
 
-/** 连接参数（单位：1.25ms） */
-#define KBD_BLE_CONN_INT_MIN 8   /**< 10ms */
-#define KBD_BLE_CONN_INT_MAX 8   /**< 10ms */
-#define KBD_BLE_SLAVE_LATENCY 20 /**< 从机延迟 */
-#define KBD_BLE_CONN_TIMEOUT 500 /**< 5秒超时 */
+/**
+ * 回连广播调度（断链 / 开机 / 深睡唤醒后）
+ *
+ * 记录了上次加密连接的主机时依次尝试：高占空比定向广播 (控制器限定 1.28s)
+ * → 低占空比定向广播 → 快速非定向广播 → 慢速非定向广播；未记录主机时从快速
+ * 非定向开始。定向广播连续 KBD_BLE_RECONN_DIRECT_MAX_MISS 次未连上（主机换了
+ * 可解析私有地址或已不在附近）后跳过定向阶段，下次连上后恢复。
+ * 时长单位 ms，间隔单位 0.625ms。
+ */
+#ifndef KBD_BLE_RECONN_DIRECT_HIGH_MS
+#define KBD_BLE_RECONN_DIRECT_HIGH_MS 1280u
+#endif
+#ifndef KBD_BLE_RECONN_DIRECT_LOW_MS
+#define KBD_BLE_RECONN_DIRECT_LOW_MS 2000u
+#endif
+#define KBD_BLE_RECONN_DIRECT_LOW_INT 32 /**< 20ms */
+#ifndef KBD_BLE_RECONN_FAST_MS
+#define KBD_BLE_RECONN_FAST_MS 10000u    /**< 间隔 KBD_BLE_ADV_INT_MIN/MAX */
+#endif
+#define KBD_BLE_RECONN_SLOW_INT_MIN 338  /**< 211.25ms */
+#define KBD_BLE_RECONN_SLOW_INT_MAX 338
+#ifndef KBD_BLE_RECONN_DIRECT_MAX_MISS
+#define KBD_BLE_RECONN_DIRECT_MAX_MISS 3
+#endif
+
+/**
+ * 连接参数（单位：1.25ms）
+ *
+ * 有输入时请求打字档（短间隔、从机延迟 0），空闲 KBD_BLE_CONN_IDLE_AFTER_MS 后
+ * 请求空闲档（长间隔、从机延迟 KBD_BLE_SLAVE_LATENCY）。从机延迟不影响从机主动发送，
+ * 空闲档下第一个按键最多等一个连接间隔。
+ */
+#define KBD_BLE_CONN_INT_MIN 8        /**< 打字档 10ms */
+#define KBD_BLE_CONN_INT_MAX 8        /**< 打字档 10ms */
+#define KBD_BLE_IDLE_CONN_INT_MIN 24  /**< 空闲档 30ms */
+#define KBD_BLE_IDLE_CONN_INT_MAX 36  /**< 空闲档 45ms */
+#define KBD_BLE_SLAVE_LATENCY 20      /**< 空闲档从机延迟 */
+#define KBD_BLE_CONN_TIMEOUT 500      /**< 5秒超时 */
+
+/** 无输入多久后切到空闲档（毫秒） */
+#ifndef KBD_BLE_CONN_IDLE_AFTER_MS
+#define KBD_BLE_CONN_IDLE_AFTER_MS 3000u
+#endif
+
+/** 两次参数更新请求的最小间隔（毫秒），主机处理请求期间不再发新请求 */
+#ifndef KBD_BLE_CONN_PARAM_GAP_MS
+#define KBD_BLE_CONN_PARAM_GAP_MS 1000u
+#endif
+
+/**
+ * 多主机槽位：主机接受过的打字档参数记在槽位里，下次连上该主机时按原参数请求，
+ * 加密后 KBD_BLE_HOST_PARAM_DELAY_MS 即发出（未记住参数的主机仍按首次更新延迟）
+ */
+#ifndef KBD_BLE_HOST_PARAM_DELAY_MS
+#define KBD_BLE_HOST_PARAM_DELAY_MS 500u
+#endif
+
+/**
+ * BLE 配置服务：收到的命令帧排队后在 TMOS 任务中逐帧处理，响应帧压缩后
+ * 写入发送环，按当前 ATT MTU 拼包通知；队列 / 发送环满时丢弃并计数
+ */
+#ifndef KBD_BLE_CFG_RX_FRAMES
+#define KBD_BLE_CFG_RX_FRAMES 4
+#endif
+
+/** 发送环容量（字节，必须为 2 的幂） */
+#ifndef KBD_BLE_CFG_TX_RING
+#define KBD_BLE_CFG_TX_RING 256
+#endif
+
+/** 通知缓冲不足时的重试间隔（毫秒） */
+#ifndef KBD_BLE_CFG_RETRY_MS
+#define KBD_BLE_CFG_RETRY_MS 5u
+#endif
 
 /** 配对模式 */
 #define KBD_BLE_PAIRING_MODE GAPBOND_PAIRING_MODE_WAIT_FOR_REQ
@@ -90,6 +159,72 @@ extern "C"
 /** HID 空闲超时（毫秒），0 表示不超时 */
 #define KBD_BLE_HID_IDLE_TIMEOUT 60000
 
+/** 断链 / 重连期间缓冲的输入报告条数（链路加密后按顺序补发，满时丢弃最旧） */
+#ifndef KBD_BLE_REPLAY_DEPTH
+#define KBD_BLE_REPLAY_DEPTH 16
+#endif
+
+/** 缓冲报告的有效期（毫秒），超过后丢弃，避免重连很久之后补发过时输入 */
+#ifndef KBD_BLE_REPLAY_EXPIRE_MS
+#define KBD_BLE_REPLAY_EXPIRE_MS 3000u
+#endif
+
+/**
+ * 输入报告发送节奏：链路就绪时控制器中等待确认的报告不超过每连接事件预算，
+ * 超出的在补发缓冲中排队，每个连接事件结束后按预算放行。平时预算为 1（每个
+ * 连接事件一个报告，与原先一致）；宏回放或积压不少于 KBD_BLE_TX_BURST_BACKLOG 时
+ * 提高到 KBD_BLE_TX_BURST_BUDGET，不能超过 BLE_TX_NUM_EVENT（协议栈初始化时固定）。
+ */
+#ifndef KBD_BLE_TX_BURST_BUDGET
+#define KBD_BLE_TX_BURST_BUDGET BLE_TX_NUM_EVENT
+#endif
+
+/** 积压达到多少条时自动进入突发 */
+#ifndef KBD_BLE_TX_BURST_BACKLOG
+#define KBD_BLE_TX_BURST_BACKLOG 2
+#endif
+
+/** 积压达到多少条时宏回放暂停产生新报告（小于 KBD_BLE_REPLAY_DEPTH，避免丢最旧） */
+#ifndef KBD_BLE_TX_BACKLOG_MAX
+#define KBD_BLE_TX_BACKLOG_MAX 8
+#endif
+
+/** 连接事件后投递登记表容量（BLE_HID_PostAfterConnEvent），最大 8 */
+#ifndef KBD_BLE_CONN_EVT_HOOKS
+#define KBD_BLE_CONN_EVT_HOOKS 4
+#endif
+
+/** 链路遥测采样周期（毫秒）：连接期间每周期读一次 RSSI 并结算漏事件 / 重传计数 */
+#ifndef KBD_BLE_LINK_SAMPLE_MS
+#define KBD_BLE_LINK_SAMPLE_MS 1000u
+#endif
+
+/**
+ * 自适应发射功率（默认关闭，可经 0xAE 命令运行时开关）：RSSI 均值高于
+ * KBD_BLE_TXP_RSSI_HIGH 连续 KBD_BLE_TXP_DOWN_SAMPLES 次降一档；低于 KBD_BLE_TXP_RSSI_LOW、
+ * 估计到漏事件或重传比例达到 KBD_BLE_TXP_RETRY_PCT 时立即升一档（最高 +4 dBm）。
+ * RSSI 是主机信号的强度，按链路对称性代表距离；降功率是否伤到链路由后两个信号反馈。
+ */
+#ifndef KBD_BLE_TX_POWER_ADAPT
+#define KBD_BLE_TX_POWER_ADAPT 0
+#endif
+
+#ifndef KBD_BLE_TXP_RSSI_HIGH
+#define KBD_BLE_TXP_RSSI_HIGH (-55)
+#endif
+
+#ifndef KBD_BLE_TXP_RSSI_LOW
+#define KBD_BLE_TXP_RSSI_LOW (-75)
+#endif
+
+#ifndef KBD_BLE_TXP_DOWN_SAMPLES
+#define KBD_BLE_TXP_DOWN_SAMPLES 5
+#endif
+
+#ifndef KBD_BLE_TXP_RETRY_PCT
+#define KBD_BLE_TXP_RETRY_PCT 10u
+#endif
+
 /*============================================================================*/
 /* USB 配置 */
 /*============================================================================*/
@@ -102,6 +237,16 @@ extern "C"
 #define KBD_USB_MANUFACTURER_STRING "MeowKJ"
 #define KBD_USB_PRODUCT_STRING KBD_DEVICE_NAME
 
+/** 主机挂起期间缓冲的输入报告条数（远程唤醒、总线恢复后按顺序发出，满时丢弃最旧） */
+#ifndef KBD_USB_RESUME_DEPTH
+#define KBD_USB_RESUME_DEPTH 16
+#endif
+
+/** 挂起缓冲报告的有效期（毫秒），主机未使能远程唤醒时过期丢弃 */
+#ifndef KBD_USB_RESUME_EXPIRE_MS
+#define KBD_USB_RESUME_EXPIRE_MS 3000u
+#endif
+
 /*============================================================================*/
 /* HID 报告配置 */
 /*============================================================================*/
@@ -114,9 +259,21 @@ extern "C"
 
 /** 报告长度 */
 #define KBD_HID_KEYBOARD_REPORT_LEN 8 /**< 键盘报告长度 */
-#define KBD_HID_MOUSE_REPORT_LEN 4    /**< 鼠标报告长度 */
+#define KBD_HID_MOUSE_REPORT_LEN 5    /**< 鼠标报告长度 (按键/X/Y/滚轮/水平滚动) */
 #define KBD_HID_CONSUMER_REPORT_LEN 2 /**< 多媒体报告长度 */
 
+/**
+ * 高分辨率滚动 (鼠标 Resolution Multiplier 特性报告，USB / BLE 相同)
+ *
+ * 特性报告 1 字节: bit0-1 滚轮倍率, bit2-3 水平滚动 (AC Pan) 倍率。
+ * 主机写 1 表示启用，此后每格滚动对应 KBD_HID_SCROLL_HIRES_MULT 个单位；
+ * 复位 / 断开后回到 0 (每格 1 个单位)。倍率取旋钮每格的跳变数，
+ * 启用后旋钮每个跳变即可上报一个单位。
+ */
+#define KBD_HID_SCROLL_HIRES_MULT 4
+#define KBD_HID_SCROLL_FEATURE_WHEEL 0x01 /**< 滚轮高分辨率已启用 */
+#define KBD_HID_SCROLL_FEATURE_PAN 0x04   /**< 水平滚动高分辨率已启用 */
+
 /*============================================================================*/
 /* 低功耗配置 */
 /*============================================================================*/
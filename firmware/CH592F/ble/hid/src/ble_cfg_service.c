@@ -0,0 +1,436 @@
+/********************************** (C) COPYRIGHT *******************************
+ * File Name          : ble_cfg_service.c
+ * Author             : Custom Keyboard Library
+ * Version            : V1.0
+ * Date               : 2024/11/07
+ * Description        : 蓝牙配置服务实现（经 GATT 隧道传输 USB 配置命令帧）
+ *******************************************************************************/
+
+#include "ble_cfg_service.h"
+#include "ble_link.h"
+#include "hiddev.h"
+#include "kbd_command.h"
+#include "kbd_mode_config.h"
+#include <string.h>
+
+#define STATIC_ASSERT(cond, msg) typedef char static_assert_##msg[(cond) ? 1 : -1]
+STATIC_ASSERT((KBD_BLE_CFG_TX_RING & (KBD_BLE_CFG_TX_RING - 1)) == 0,
+              cfg_tx_ring_must_be_power_of_2);
+
+/* ==================== 常量定义 ==================== */
+
+// 紧凑帧头 [cmd][sub][len]
+#define CFG_FRAME_HDR_LEN           3
+
+// 单帧数据区上限（与 kbd_cmd_frame_t.data 相同）
+#define CFG_FRAME_DATA_MAX          61
+
+#define CFG_TX_MASK                 (KBD_BLE_CFG_TX_RING - 1u)
+
+// 属性表索引
+#define CFG_RX_VALUE_IDX            2
+#define CFG_TX_VALUE_IDX            4
+#define CFG_TX_CCCD_IDX             5
+
+/* ==================== UUID 定义 ==================== */
+
+// 配置服务 UUID 4d656f77-0001-4b62-8c6b-42696e4b6264
+static const uint8_t cfgServUUID[ATT_UUID_SIZE] = {
+    0x64, 0x62, 0x4B, 0x6E, 0x69, 0x42, 0x6B, 0x8C, 0x62, 0x4B, 0x01, 0x00, 0x77, 0x6F, 0x65, 0x4D
+};
+
+// 命令写入 UUID 4d656f77-0002-4b62-8c6b-42696e4b6264
+static const uint8_t cfgRxUUID[ATT_UUID_SIZE] = {
+    0x64, 0x62, 0x4B, 0x6E, 0x69, 0x42, 0x6B, 0x8C, 0x62, 0x4B, 0x02, 0x00, 0x77, 0x6F, 0x65, 0x4D
+};
+
+// 响应通知 UUID 4d656f77-0003-4b62-8c6b-42696e4b6264
+static const uint8_t cfgTxUUID[ATT_UUID_SIZE] = {
+    0x64, 0x62, 0x4B, 0x6E, 0x69, 0x42, 0x6B, 0x8C, 0x62, 0x4B, 0x03, 0x00, 0x77, 0x6F, 0x65, 0x4D
+};
+
+/* ==================== 属性变量 ==================== */
+
+static const gattAttrType_t cfgService = {ATT_UUID_SIZE, cfgServUUID};
+
+static uint8_t cfgRxProps = GATT_PROP_WRITE | GATT_PROP_WRITE_NO_RSP;
+static uint8_t cfgRx;
+
+static uint8_t cfgTxProps = GATT_PROP_NOTIFY;
+static uint8_t cfgTx;
+static gattCharCfg_t cfgTxClientCharCfg[GATT_MAX_NUM_CONN];
+
+/* ==================== 属性表 ==================== */
+
+static gattAttribute_t cfgAttrTbl[] = {
+    // 配置服务
+    {
+        {ATT_BT_UUID_SIZE, primaryServiceUUID},
+        GATT_PERMIT_READ,
+        0,
+        (uint8_t *)&cfgService
+    },
+
+    // 命令写入特性声明
+    {
+        {ATT_BT_UUID_SIZE, characterUUID},
+        GATT_PERMIT_READ,
+        0,
+        &cfgRxProps
+    },
+
+    // 命令写入特性值（需加密）
+    {
+        {ATT_UUID_SIZE, cfgRxUUID},
+        GATT_PERMIT_ENCRYPT_WRITE,
+        0,
+        &cfgRx
+    },
+
+    // 响应通知特性声明
+    {
+        {ATT_BT_UUID_SIZE, characterUUID},
+        GATT_PERMIT_READ,
+        0,
+        &cfgTxProps
+    },
+
+    // 响应通知特性值
+    {
+        {ATT_UUID_SIZE, cfgTxUUID},
+        0,
+        0,
+        &cfgTx
+    },
+
+    // 响应通知客户端特性配置
+    {
+        {ATT_BT_UUID_SIZE, clientCharCfgUUID},
+        GATT_PERMIT_READ | GATT_PERMIT_WRITE,
+        0,
+        (uint8_t *)&cfgTxClientCharCfg
+    },
+};
+
+/* ==================== 私有变量 ==================== */
+
+static uint8_t cfgTaskId = INVALID_TASK_ID;
+static uint16_t cfgConnHandle = GAP_CONNHANDLE_INIT;
+
+// 命令队列：写回调中拼帧入队，任务中逐帧处理
+static kbd_cmd_frame_t cfgRxQueue[KBD_BLE_CFG_RX_FRAMES];
+static kbd_cmd_frame_t cfgRxDiscard;     // 队列满时拼帧的占位，完整后丢弃
+static kbd_cmd_frame_t *cfgRxFrame = NULL;
+static uint8_t cfgRxHead = 0;
+static uint8_t cfgRxCount = 0;
+static uint8_t cfgRxPos = 0;             // 当前帧已收字节
+
+// 发送环：紧凑响应帧
+static uint8_t cfgTxRing[KBD_BLE_CFG_TX_RING];
+static uint16_t cfgTxHead = 0;
+static uint16_t cfgTxCount = 0;
+
+static ble_cfg_stats_t cfgStats;
+
+/* ==================== 私有函数声明 ==================== */
+
+static bStatus_t BLE_Cfg_ReadAttrCB(uint16_t connHandle, gattAttribute_t *pAttr,
+                                    uint8_t *pValue, uint16_t *pLen, uint16_t offset,
+                                    uint16_t maxLen, uint8_t method);
+static bStatus_t BLE_Cfg_WriteAttrCB(uint16_t connHandle, gattAttribute_t *pAttr,
+                                     uint8_t *pValue, uint16_t len, uint16_t offset,
+                                     uint8_t method);
+
+/* ==================== GATT 回调 ==================== */
+
+static gattServiceCBs_t cfgCBs = {
+    BLE_Cfg_ReadAttrCB,
+    BLE_Cfg_WriteAttrCB,
+    NULL
+};
+
+/* ==================== 私有函数实现 ==================== */
+
+static uint8_t BLE_Cfg_NotifyEnabled(void)
+{
+    if (cfgConnHandle == GAP_CONNHANDLE_INIT)
+    {
+        return FALSE;
+    }
+    return (GATTServApp_ReadCharCfg(cfgConnHandle, cfgTxClientCharCfg) & GATT_CLIENT_CFG_NOTIFY)
+               ? TRUE
+               : FALSE;
+}
+
+/**
+ * @brief 命令响应发送器：把 64 字节帧压缩为 [cmd][sub][len][data:len] 写入发送环
+ */
+static void BLE_Cfg_SendFrame(const uint8_t *frame, uint8_t len)
+{
+    uint8_t data_len = frame[2];
+    uint16_t n;
+
+    if (data_len > CFG_FRAME_DATA_MAX)
+    {
+        data_len = CFG_FRAME_DATA_MAX;
+    }
+    n = CFG_FRAME_HDR_LEN + data_len;
+    if (n > len || !BLE_Cfg_NotifyEnabled() || (KBD_BLE_CFG_TX_RING - cfgTxCount) < n)
+    {
+        cfgStats.tx_dropped++;
+        return;
+    }
+
+    for (uint16_t i = 0; i < n; i++)
+    {
+        cfgTxRing[(cfgTxHead + cfgTxCount + i) & CFG_TX_MASK] = frame[i];
+    }
+    cfgTxCount += n;
+    if (cfgTxCount > cfgStats.tx_high_water)
+    {
+        cfgStats.tx_high_water = cfgTxCount;
+    }
+    cfgStats.tx_frames++;
+    tmos_set_event(cfgTaskId, BLE_CFG_FLUSH_EVT);
+}
+
+/**
+ * @brief 把发送环按当前 MTU 拼成尽量满的通知，直到发完或协议栈缓冲用尽
+ */
+static void BLE_Cfg_Flush(void)
+{
+    while (cfgTxCount > 0)
+    {
+        attHandleValueNoti_t noti;
+        uint16_t chunk;
+
+        if (!BLE_Cfg_NotifyEnabled())
+        {
+            // 主机关闭通知：剩余响应无法送达
+            cfgTxCount = 0;
+            return;
+        }
+
+        chunk = ATT_GetMTU(cfgConnHandle) - 3;
+        if (chunk > cfgTxCount)
+        {
+            chunk = cfgTxCount;
+        }
+
+        noti.pValue = GATT_bm_alloc(cfgConnHandle, ATT_HANDLE_VALUE_NOTI, chunk, NULL, 0);
+        if (noti.pValue == NULL)
+        {
+            break;
+        }
+
+        for (uint16_t i = 0; i < chunk; i++)
+        {
+            noti.pValue[i] = cfgTxRing[(cfgTxHead + i) & CFG_TX_MASK];
+        }
+        noti.handle = cfgAttrTbl[CFG_TX_VALUE_IDX].handle;
+        noti.len = chunk;
+
+        if (GATT_Notification(cfgConnHandle, &noti, FALSE) != SUCCESS)
+        {
+            GATT_bm_free((gattMsg_t *)&noti, ATT_HANDLE_VALUE_NOTI);
+            break;
+        }
+
+        cfgTxHead = (cfgTxHead + chunk) & CFG_TX_MASK;
+        cfgTxCount -= chunk;
+        cfgStats.tx_bytes += chunk;
+        cfgStats.tx_notifies++;
+        BLE_Link_NoteTx();
+    }
+
+    if (cfgTxCount > 0)
+    {
+        // 控制器发送缓冲已满，等几个连接事件腾出空间后继续
+        cfgStats.tx_retries++;
+        tmos_start_task(cfgTaskId, BLE_CFG_FLUSH_EVT, MS1_TO_SYSTEM_TIME(KBD_BLE_CFG_RETRY_MS));
+    }
+}
+
+/**
+ * @brief 把写入的字节流拼成命令帧入队
+ */
+static void BLE_Cfg_Receive(const uint8_t *pValue, uint16_t len)
+{
+    cfgStats.rx_bytes += len;
+
+    for (uint16_t i = 0; i < len; i++)
+    {
+        if (cfgRxPos == 0)
+        {
+            // 新帧开始：队列满时拼到占位帧，完整后计为丢弃
+            cfgRxFrame = (cfgRxCount < KBD_BLE_CFG_RX_FRAMES)
+                             ? &cfgRxQueue[(cfgRxHead + cfgRxCount) % KBD_BLE_CFG_RX_FRAMES]
+                             : &cfgRxDiscard;
+            memset(cfgRxFrame, 0, sizeof(*cfgRxFrame));
+        }
+
+        ((uint8_t *)cfgRxFrame)[cfgRxPos++] = pValue[i];
+
+        if (cfgRxPos == CFG_FRAME_HDR_LEN && cfgRxFrame->len > CFG_FRAME_DATA_MAX)
+        {
+            // 流失步：丢弃本次写入的剩余字节，下一次写入从帧头重新开始
+            cfgStats.rx_dropped++;
+            cfgRxPos = 0;
+            return;
+        }
+
+        if (cfgRxPos >= CFG_FRAME_HDR_LEN && cfgRxPos == CFG_FRAME_HDR_LEN + cfgRxFrame->len)
+        {
+            cfgRxPos = 0;
+            cfgStats.rx_frames++;
+            if (cfgRxFrame == &cfgRxDiscard)
+            {
+                cfgStats.rx_dropped++;
+                continue;
+            }
+            cfgRxCount++;
+            if (cfgRxCount > cfgStats.rx_high_water)
+            {
+                cfgStats.rx_high_water = cfgRxCount;
+            }
+            tmos_set_event(cfgTaskId, BLE_CFG_PROCESS_EVT);
+        }
+    }
+}
+
+/**
+ * @brief 读回调（特性值均不可读，CCCD 由协议栈处理）
+ */
+static bStatus_t BLE_Cfg_ReadAttrCB(uint16_t connHandle, gattAttribute_t *pAttr,
+                                    uint8_t *pValue, uint16_t *pLen, uint16_t offset,
+                                    uint16_t maxLen, uint8_t method)
+{
+    *pLen = 0;
+    return ATT_ERR_ATTR_NOT_FOUND;
+}
+
+/**
+ * @brief 写回调
+ */
+static bStatus_t BLE_Cfg_WriteAttrCB(uint16_t connHandle, gattAttribute_t *pAttr,
+                                     uint8_t *pValue, uint16_t len, uint16_t offset,
+                                     uint8_t method)
+{
+    bStatus_t status = SUCCESS;
+
+    if (pAttr->type.len == ATT_BT_UUID_SIZE &&
+        BUILD_UINT16(pAttr->type.uuid[0], pAttr->type.uuid[1]) == GATT_CLIENT_CHAR_CFG_UUID)
+    {
+        status = GATTServApp_ProcessCCCWriteReq(connHandle, pAttr, pValue, len,
+                                                offset, GATT_CLIENT_CFG_NOTIFY);
+        if (status == SUCCESS)
+        {
+            cfgConnHandle = connHandle;
+        }
+    }
+    else if (pAttr->handle == cfgAttrTbl[CFG_RX_VALUE_IDX].handle)
+    {
+        if (offset > 0)
+        {
+            return ATT_ERR_ATTR_NOT_LONG;
+        }
+        cfgConnHandle = connHandle;
+        BLE_Cfg_Receive(pValue, len);
+    }
+    else
+    {
+        status = ATT_ERR_ATTR_NOT_FOUND;
+    }
+
+    return status;
+}
+
+/* ==================== 函数实现 ==================== */
+
+bStatus_t BLE_Cfg_AddService(void)
+{
+    cfgTaskId = TMOS_ProcessEventRegister(BLE_Cfg_ProcessEvent);
+    memset(&cfgStats, 0, sizeof(cfgStats));
+
+    GATTServApp_InitCharCfg(INVALID_CONNHANDLE, cfgTxClientCharCfg);
+
+    return GATTServApp_RegisterService(cfgAttrTbl, GATT_NUM_ATTRS(cfgAttrTbl),
+                                       GATT_MAX_ENCRYPT_KEY_SIZE, &cfgCBs);
+}
+
+void BLE_Cfg_Reset(void)
+{
+    if (cfgTaskId == INVALID_TASK_ID)
+    {
+        return;
+    }
+
+    GATTServApp_InitCharCfg(INVALID_CONNHANDLE, cfgTxClientCharCfg);
+    cfgConnHandle = GAP_CONNHANDLE_INIT;
+    cfgRxHead = 0;
+    cfgRxCount = 0;
+    cfgRxPos = 0;
+    cfgTxHead = 0;
+    cfgTxCount = 0;
+    tmos_stop_task(cfgTaskId, BLE_CFG_FLUSH_EVT);
+    tmos_clear_event(cfgTaskId, BLE_CFG_FLUSH_EVT | BLE_CFG_PROCESS_EVT);
+}
+
+void BLE_Cfg_GetStats(ble_cfg_stats_t *out, uint8_t reset)
+{
+    if (out == NULL)
+    {
+        return;
+    }
+
+    *out = cfgStats;
+    HidDev_GetLinkInfo(&out->mtu, &out->tx_phy, &out->rx_phy);
+    out->notify = BLE_Cfg_NotifyEnabled();
+
+    if (reset)
+    {
+        memset(&cfgStats, 0, sizeof(cfgStats));
+        cfgStats.rx_high_water = cfgRxCount;
+        cfgStats.tx_high_water = cfgTxCount;
+    }
+}
+
+uint16_t BLE_Cfg_ProcessEvent(uint8_t task_id, uint16_t events)
+{
+    if (events & SYS_EVENT_MSG)
+    {
+        uint8_t *pMsg = tmos_msg_receive(cfgTaskId);
+        if (pMsg)
+        {
+            tmos_msg_deallocate(pMsg);
+        }
+        return (events ^ SYS_EVENT_MSG);
+    }
+
+    if (events & BLE_CFG_PROCESS_EVT)
+    {
+        if (cfgRxCount > 0)
+        {
+            kbd_cmd_frame_t *frame = &cfgRxQueue[cfgRxHead];
+
+            // 每次只处理一帧，其余留给下一轮调度，不长时间占用主循环
+            (void)KBD_Command_Submit(frame, BLE_Cfg_SendFrame);
+
+            cfgRxHead = (cfgRxHead + 1) % KBD_BLE_CFG_RX_FRAMES;
+            cfgRxCount--;
+            if (cfgRxCount > 0)
+            {
+                tmos_set_event(cfgTaskId, BLE_CFG_PROCESS_EVT);
+            }
+        }
+        return (events ^ BLE_CFG_PROCESS_EVT);
+    }
+
+    if (events & BLE_CFG_FLUSH_EVT)
+    {
+        BLE_Cfg_Flush();
+        return (events ^ BLE_CFG_FLUSH_EVT);
+    }
+
+    return 0;
+}
@@ -8,28 +8,51 @@
 
 #include "ble_hid.h"
 #include "ble_hid_service.h"
+#include "ble_cfg_service.h"
+#include "ble_link.h"
 #include "kbd_mode_config.h"
 #include "battservice.h"
 #include "devinfoservice.h"
 #include "scanparamservice.h"
 #include "debug.h"
 #include "kbd_battery.h"
+#include "kbd_idle.h"
+#include "ble_hal.h"
 #include <string.h>
 
 #define TAG "BLE"
 
 /* ==================== 常量定义 ==================== */
 
-// 参数更新延迟（625us 单位）
+// 连接后首次参数更新延迟（625us 单位），之前主机在做服务发现 / 加密，不发请求
 #define PARAM_UPDATE_DELAY 12800
 
+// 尚未请求过参数的档位标记
+#define CONN_PROFILE_NONE 0xFF
+
 // 安全请求延迟（对齐 WCH 官方 HID 例程）
 #define SECURITY_REQ_DELAY 4800
 
-// PHY 更新延迟
+// 加密后请求 2M PHY 与更大 ATT MTU 的延迟（625us 单位）
 #define PHY_UPDATE_DELAY 1600
 #define BLE_SCAN_RSP_MAX_LEN 31
 
+// 补发缓冲单条报告最大长度（报告表中最长的输入报告）
+#define REPLAY_REPORT_MAX_LEN KBD_HID_REPORT_MAX_LEN
+
+// 补发时协议栈拒绝报告（未加密等）的重试间隔；预算用完时由连接事件回调放行
+#define REPLAY_RETRY_DELAY MS1_TO_SYSTEM_TIME (10)
+
+// 唤醒延迟测量状态
+#define WAKE_IDLE     0  // 未在测量
+#define WAKE_ARMED    1  // 已唤醒，等待第一个输入
+#define WAKE_PENDING  2  // 第一个输入已产生，等待发出
+
+// 回连测量状态
+#define RECONN_IDLE    0  // 未在回连
+#define RECONN_SEARCH  1  // 广播中，等待链路建立
+#define RECONN_LINKED  2  // 链路已建立，等待加密
+
 /* ==================== 全局变量 ==================== */
 
 uint8_t bleHidTaskId = INVALID_TASK_ID;
@@ -41,6 +64,65 @@ static uint16_t g_conn_handle = GAP_CONNHANDLE_INIT;
 static ble_hid_callbacks_t *g_pCallbacks = NULL;
 static uint8_t g_keyboard_leds = 0;
 static bool g_auto_resume_advertising = true;
+
+// 重连补发 / 限速缓冲（FIFO），只在 TMOS 任务上下文访问
+typedef struct {
+    uint8_t  id;
+    uint8_t  len;
+    uint8_t  data[REPLAY_REPORT_MAX_LEN];
+    uint8_t  replay;  // 链路未就绪时进入（重连补发），否则为预算用完排队
+    uint32_t rtc;     // 进入缓冲的 RTC 时刻
+} ble_hid_pending_t;
+
+static ble_hid_pending_t g_pending[KBD_BLE_REPLAY_DEPTH];
+static uint8_t g_pending_head = 0;
+static uint8_t g_pending_count = 0;
+static ble_hid_replay_stats_t g_replay_stats;
+
+// 发送节奏：连接事件计数在 LL 回调（中断）中递增
+static volatile uint32_t g_conn_events = 0;
+static bool g_tx_burst_req = false;      // 上层请求突发（宏回放中）
+static bool g_tx_burst = false;          // 当前处于突发
+static uint32_t g_tx_burst_rtc = 0;      // 本次突发开始时刻
+static uint32_t g_tx_burst_event0 = 0;   // 本次突发开始时的连接事件计数
+static ble_hid_tx_stats_t g_tx_stats;
+
+// 连接事件后一次性投递的 TMOS 事件：任务上下文登记，LL 回调（中断）中投递并清除
+typedef struct {
+    uint8_t  task_id;
+    uint16_t event;
+} ble_hid_conn_hook_t;
+
+static ble_hid_conn_hook_t g_conn_hooks[KBD_BLE_CONN_EVT_HOOKS];
+static volatile uint8_t g_conn_hook_mask = 0;
+
+// 唤醒时刻可能在按键中断中记录
+static volatile uint8_t g_wake_state = WAKE_IDLE;
+static volatile uint32_t g_wake_rtc = 0;
+
+// 连接参数策略
+static bool g_conn_active = false;       // 链路已建立，累计档位时间
+static bool g_conn_policy_ready = false; // 首次参数更新延迟已过
+static bool g_conn_param_busy = false;   // 距上次请求不足 KBD_BLE_CONN_PARAM_GAP_MS
+static bool g_link_upgraded = false;     // 本次连接已请求过 2M PHY / MTU 交换
+static uint32_t g_conn_seg_rtc = 0;      // 当前档位计时起点
+static ble_hid_conn_stats_t g_conn_stats;
+
+// 回连调度：g_hosts[g_host_active] 为定向广播目标，g_link_* 为当前链路对端
+static kbd_ble_host_t g_hosts[KBD_BLE_HOST_COUNT];
+static uint8_t g_host_active = 0;
+static uint8_t g_link_type = ADDRTYPE_PUBLIC;
+static uint8_t g_link_addr[B_ADDR_LEN];
+static uint8_t g_reconn_state = RECONN_IDLE;
+static uint32_t g_reconn_rtc = 0;        // 本次回连开始时刻
+static ble_hid_reconn_stats_t g_reconn_stats;
+
+// 多主机切换
+static bool g_host_switching = false;    // 切换后等待新主机加密
+static bool g_link_rejected = false;     // 刚断开的是被拒绝的其他槽位主机
+static bool g_link_host = false;         // 链路已加密且对端即当前槽位主机
+static uint32_t g_host_switch_rtc = 0;   // 切换开始时刻
+static ble_hid_host_stats_t g_host_stats;
 // HID 配置
 static hidDevCfg_t g_hidDevCfg = {
     BLE_HID_IDLE_TIMEOUT,  // 空闲超时
@@ -77,7 +159,25 @@ static void BLE_HID_EvtCallback (uint8_t evt);
 static void BLE_HID_StateCallback (gapRole_States_t newState, gapRoleEvent_t *pEvent);
 static void BLE_HID_BuildDeviceNameData (void);
 static uint8_t BLE_HID_ReadBatteryLevel (void);
-static void BLE_HID_ApplyAdvertisingParams (void);
+static uint32_t BLE_HID_ElapsedMs (uint32_t from);
+static bool BLE_HID_LinkReady (void);
+static void BLE_HID_ReportSent (void);
+static uint8_t BLE_HID_TxRoom (void);
+static void BLE_HID_TxUpdateBurst (void);
+static void BLE_HID_FireConnHooks (void);
+static void BLE_HID_ConnEventCB (uint32_t timeUs);
+static void BLE_HID_ExpirePending (void);
+static int BLE_HID_SubmitReport (uint8_t id, uint8_t len, uint8_t *pData);
+static void BLE_HID_Replay (void);
+static void BLE_HID_ConnAccount (void);
+static void BLE_HID_ConnSetTarget (uint8_t profile);
+static void BLE_HID_ConnApply (void);
+static void BLE_HID_ConnActivity (void);
+static bStatus_t BLE_HID_ReconnEnter (uint8_t phase);
+static bStatus_t BLE_HID_ReconnStart (void);
+static void BLE_HID_ReconnAdvance (void);
+static void BLE_HID_ReconnLinked (gapEstLinkReqEvent_t *event);
+static void BLE_HID_ReconnSecure (void);
 
 // HID 设备回调
 static hidDevCB_t g_hidDevCallbacks = {
@@ -140,10 +240,738 @@ static uint8_t BLE_HID_ReadBatteryLevel (void) {
     return KBD_Battery_GetLevel();
 }
 
-static void BLE_HID_ApplyAdvertisingParams (void) {
-    GAP_SetParamValue (TGAP_DISC_ADV_INT_MIN, BLE_ADV_INT_MIN);
-    GAP_SetParamValue (TGAP_DISC_ADV_INT_MAX, BLE_ADV_INT_MAX);
-    GAP_SetParamValue (TGAP_LIM_ADV_TIMEOUT, BLE_ADV_TIMEOUT);
+/* ==================== 重连补发实现 ==================== */
+
+static uint32_t BLE_HID_ElapsedMs (uint32_t from) {
+    uint32_t ticks = HAL_SleepDistance (RTC_GetCycle32k(), from);
+    return (uint32_t)(((uint64_t)ticks * 1000u) / CAB_LSIFQ);
+}
+
+// 报告只有在链路加密后才会被主机接受，未加密时 HidDev_Report 会排队并触发安全请求
+static bool BLE_HID_LinkReady (void) {
+    return BLE_HID_IsConnected() && HidDev_IsSecure();
+}
+
+// 报告成功交给协议栈：计入突发，完成一次唤醒延迟测量
+static void BLE_HID_ReportSent (void) {
+    BLE_Link_NoteTx();
+    if (g_tx_burst) {
+        g_tx_stats.burst_reports++;
+    }
+
+    if (g_wake_state != WAKE_PENDING) {
+        return;
+    }
+
+    uint32_t ms = BLE_HID_ElapsedMs (g_wake_rtc);
+    g_wake_state = WAKE_IDLE;
+    g_replay_stats.wake_count++;
+    g_replay_stats.wake_last_ms = ms;
+    if (ms > g_replay_stats.wake_max_ms) {
+        g_replay_stats.wake_max_ms = ms;
+    }
+    LOG_D (TAG, "Wake to first report %lu ms", (unsigned long)ms);
+}
+
+// 本连接事件还能交给控制器的报告数：预算减去尚未被主机确认的包
+// （配置服务的通知也占预算，保证控制器缓冲不会被报告挤满）
+static uint8_t BLE_HID_TxRoom (void) {
+    uint8_t budget = g_tx_burst ? KBD_BLE_TX_BURST_BUDGET : 1;
+    uint32_t unack = LL_GetNumberOfUnAckPacket (g_conn_handle);
+
+    if (unack >= budget) {
+        return 0;  // 含 0xFFFFFFFF（句柄无效）
+    }
+    return (uint8_t)(budget - unack);
+}
+
+// 突发：上层请求或链路就绪时积压达到阈值即开始，请求撤销且积压放行完后结束
+static void BLE_HID_TxUpdateBurst (void) {
+    bool active = g_tx_burst_req ||
+                  (g_tx_burst ? g_pending_count > 0 : g_pending_count >= KBD_BLE_TX_BURST_BACKLOG);
+
+    if (!BLE_HID_LinkReady()) {
+        active = g_tx_burst_req;
+    }
+
+    if (active == g_tx_burst) {
+        return;
+    }
+
+    if (active) {
+        g_tx_burst = true;
+        g_tx_burst_rtc = RTC_GetCycle32k();
+        g_tx_burst_event0 = g_conn_events;
+        g_tx_stats.bursts++;
+    } else {
+        g_tx_burst = false;
+        g_tx_stats.burst_ms += BLE_HID_ElapsedMs (g_tx_burst_rtc);
+        g_tx_stats.burst_events += g_conn_events - g_tx_burst_event0;
+    }
+}
+
+// 投递并清除全部登记的连接事件后任务（LL 回调，或断链后不再有回调时）
+__HIGH_CODE
+static void BLE_HID_FireConnHooks (void) {
+    uint8_t mask = g_conn_hook_mask;
+
+    g_conn_hook_mask = 0;
+    for (uint8_t i = 0; i < KBD_BLE_CONN_EVT_HOOKS && mask; i++) {
+        if (mask & (1u << i)) {
+            mask &= (uint8_t)~(1u << i);
+            KBD_Idle_SetEvent (g_conn_hooks[i].task_id, g_conn_hooks[i].event);
+        }
+    }
+}
+
+// 每个连接事件结束后由 LL 调用（中断上下文）：有积压时放行下一批
+__HIGH_CODE
+static void BLE_HID_ConnEventCB (uint32_t timeUs) {
+    (void)timeUs;
+    g_conn_events++;
+    BLE_Link_OnConnEvent();
+    if (g_conn_hook_mask) {
+        BLE_HID_FireConnHooks();
+    }
+    if (g_pending_count > 0) {
+        KBD_Idle_SetEvent (bleHidTaskId, BLE_HID_REPLAY_EVT);
+    }
+}
+
+// 丢弃超过有效期的缓冲报告（缓冲按时间排序，只需检查队头）
+static void BLE_HID_ExpirePending (void) {
+    while (g_pending_count > 0 &&
+           BLE_HID_ElapsedMs (g_pending[g_pending_head].rtc) > KBD_BLE_REPLAY_EXPIRE_MS) {
+        g_pending_head = (g_pending_head + 1) % KBD_BLE_REPLAY_DEPTH;
+        g_pending_count--;
+        g_replay_stats.expired++;
+    }
+}
+
+static int BLE_HID_SubmitReport (uint8_t id, uint8_t len, uint8_t *pData) {
+    BLE_HID_ExpirePending();
+    BLE_HID_ConnActivity();
+
+    if (g_wake_state == WAKE_ARMED) {
+        // 唤醒后很久才有输入不算唤醒延迟
+        g_wake_state = (BLE_HID_ElapsedMs (g_wake_rtc) <= KBD_BLE_REPLAY_EXPIRE_MS) ?
+                       WAKE_PENDING : WAKE_IDLE;
+    }
+
+    bool ready = BLE_HID_LinkReady();
+
+    // 有缓冲未放行时必须排在后面，保持顺序；本连接事件预算用完也排队
+    if (g_pending_count == 0 && ready && BLE_HID_TxRoom() > 0 &&
+        HidDev_Report (id, HID_REPORT_TYPE_INPUT, len, pData) == SUCCESS) {
+        BLE_HID_ReportSent();
+        return 0;
+    }
+
+    // 链路未就绪且缓冲为空时的全零（释放）报告没有需要保留的状态变化；
+    // 链路就绪时释放报告必须保留，否则主机会看到按键卡住
+    if (g_pending_count == 0 && !ready) {
+        uint8_t i;
+        for (i = 0; i < len && pData[i] == 0; i++) {
+        }
+        if (i == len) {
+            return -1;
+        }
+    }
+
+    if (g_pending_count == KBD_BLE_REPLAY_DEPTH) {
+        g_pending_head = (g_pending_head + 1) % KBD_BLE_REPLAY_DEPTH;
+        g_pending_count--;
+        if (ready) {
+            g_tx_stats.dropped++;
+        } else {
+            g_replay_stats.dropped++;
+        }
+    }
+
+    ble_hid_pending_t *p = &g_pending[(g_pending_head + g_pending_count) % KBD_BLE_REPLAY_DEPTH];
+    p->id = id;
+    p->len = (len > REPLAY_REPORT_MAX_LEN) ? REPLAY_REPORT_MAX_LEN : len;
+    memcpy (p->data, pData, p->len);
+    p->replay = !ready;
+    p->rtc = RTC_GetCycle32k();
+    g_pending_count++;
+
+    if (g_pending_count > g_replay_stats.high_water) {
+        g_replay_stats.high_water = g_pending_count;
+    }
+    if (ready) {
+        g_tx_stats.deferred++;
+        if (g_pending_count > g_tx_stats.backlog_max) {
+            g_tx_stats.backlog_max = g_pending_count;
+        }
+        // 放行由连接事件回调驱动，积压变多时提高预算
+        BLE_HID_TxUpdateBurst();
+    } else {
+        g_replay_stats.buffered++;
+    }
+    return 0;
+}
+
+// 按本连接事件的剩余预算放行缓冲报告；预算用完等下一个连接事件回调
+static void BLE_HID_Replay (void) {
+    BLE_HID_ExpirePending();
+    BLE_HID_TxUpdateBurst();
+
+    uint8_t room = BLE_HID_LinkReady() ? BLE_HID_TxRoom() : 0;
+
+    while (g_pending_count > 0 && room > 0) {
+        ble_hid_pending_t *p = &g_pending[g_pending_head];
+
+        if (HidDev_Report (p->id, HID_REPORT_TYPE_INPUT, p->len, p->data) != SUCCESS) {
+            // 协议栈暂不接受，稍后继续
+            tmos_start_task (bleHidTaskId, BLE_HID_REPLAY_EVT, REPLAY_RETRY_DELAY);
+            LOG_D (TAG, "Replay paused, %d pending", g_pending_count);
+            return;
+        }
+
+        if (p->replay) {
+            g_replay_stats.replayed++;
+        } else {
+            g_tx_stats.paced++;
+        }
+        g_pending_head = (g_pending_head + 1) % KBD_BLE_REPLAY_DEPTH;
+        g_pending_count--;
+        room--;
+        BLE_HID_ReportSent();
+    }
+
+    BLE_HID_TxUpdateBurst();
+}
+
+void BLE_HID_SetTxBurst (bool enable) {
+    g_tx_burst_req = enable;
+    BLE_HID_TxUpdateBurst();
+}
+
+bool BLE_HID_PostAfterConnEvent (uint8_t task_id, uint16_t event) {
+    uint32_t irq_status;
+    uint8_t slot = KBD_BLE_CONN_EVT_HOOKS;
+
+    if (task_id == TASK_NO_TASK || !BLE_HID_IsConnected()) {
+        return false;
+    }
+
+    SYS_DisableAllIrq (&irq_status);
+    for (uint8_t i = 0; i < KBD_BLE_CONN_EVT_HOOKS; i++) {
+        if (!(g_conn_hook_mask & (1u << i))) {
+            if (slot == KBD_BLE_CONN_EVT_HOOKS) {
+                slot = i;
+            }
+        } else if (g_conn_hooks[i].task_id == task_id && g_conn_hooks[i].event == event) {
+            slot = i;  // 已登记，下一个连接事件只投递一次
+            break;
+        }
+    }
+    if (slot < KBD_BLE_CONN_EVT_HOOKS) {
+        g_conn_hooks[slot].task_id = task_id;
+        g_conn_hooks[slot].event = event;
+        g_conn_hook_mask |= (uint8_t)(1u << slot);
+    }
+    SYS_RecoverIrq (irq_status);
+
+    return slot < KBD_BLE_CONN_EVT_HOOKS;
+}
+
+bool BLE_HID_TxBusy (void) {
+    return BLE_HID_LinkReady() && g_pending_count >= KBD_BLE_TX_BACKLOG_MAX;
+}
+
+void BLE_HID_GetTxStats (ble_hid_tx_stats_t *out, uint8_t reset) {
+    if (out == NULL) {
+        return;
+    }
+
+    // 进行中的突发按当前时刻结算一次，再从此刻重新计时
+    if (g_tx_burst) {
+        uint32_t events = g_conn_events;
+        g_tx_stats.burst_ms += BLE_HID_ElapsedMs (g_tx_burst_rtc);
+        g_tx_stats.burst_events += events - g_tx_burst_event0;
+        g_tx_burst_rtc = RTC_GetCycle32k();
+        g_tx_burst_event0 = events;
+    }
+
+    g_tx_stats.budget = g_tx_burst ? KBD_BLE_TX_BURST_BUDGET : 1;
+    g_tx_stats.burst = g_tx_burst;
+    g_tx_stats.backlog = g_pending_count;
+    g_tx_stats.interval = g_conn_stats.interval;
+    *out = g_tx_stats;
+    if (reset) {
+        memset (&g_tx_stats, 0, sizeof (g_tx_stats));
+    }
+}
+
+/* ==================== 连接参数策略实现 ==================== */
+
+// 把当前档位从 g_conn_seg_rtc 起的时间计入统计
+static uint32_t BLE_HID_SatAdd (uint32_t a, uint32_t b) {
+    return (a > 0xFFFFFFFFu - b) ? 0xFFFFFFFFu : a + b;
+}
+
+// 当前档位从 g_conn_seg_rtc 到 now 的时长（未连接为 0），不修改状态
+static uint32_t BLE_HID_ConnSegmentMs (uint32_t now) {
+    if (!g_conn_active) {
+        return 0;
+    }
+    return (uint32_t)(((uint64_t)HAL_SleepDistance (now, g_conn_seg_rtc) * 1000u) / CAB_LSIFQ);
+}
+
+static void BLE_HID_ConnAccount (void) {
+    uint32_t now = RTC_GetCycle32k();
+    uint32_t ms = BLE_HID_ConnSegmentMs (now);
+    uint32_t *acc = (g_conn_stats.target == BLE_HID_CONN_FAST) ? &g_conn_stats.fast_ms
+                                                                : &g_conn_stats.idle_ms;
+
+    *acc = BLE_HID_SatAdd (*acc, ms);
+    g_conn_seg_rtc = now;
+}
+
+static void BLE_HID_ConnSetTarget (uint8_t profile) {
+    if (g_conn_stats.target == profile) {
+        return;
+    }
+
+    BLE_HID_ConnAccount();
+    g_conn_stats.target = profile;
+    BLE_HID_ConnApply();
+}
+
+// 档位与已请求的不同时发出参数更新请求（每次连接的首次请求在 PARAM_UPDATE_DELAY 之后）
+static void BLE_HID_ConnApply (void) {
+    bStatus_t status;
+
+    if (!g_conn_active || !g_conn_policy_ready || g_conn_param_busy ||
+        g_conn_stats.requested == g_conn_stats.target) {
+        return;
+    }
+
+    if (g_conn_stats.target == BLE_HID_CONN_FAST) {
+        const kbd_ble_host_t *host = &g_hosts[g_host_active];
+
+        if (g_link_host && host->interval != 0) {
+            // 当前主机接受过的打字档参数原样请求，省去一轮协商
+            status = GAPRole_PeripheralConnParamUpdateReq (g_conn_handle,
+                                                           host->interval,
+                                                           host->interval,
+                                                           host->latency,
+                                                           host->timeout,
+                                                           bleHidTaskId);
+        } else {
+            status = GAPRole_PeripheralConnParamUpdateReq (g_conn_handle,
+                                                           KBD_BLE_CONN_INT_MIN,
+                                                           KBD_BLE_CONN_INT_MAX,
+                                                           0,
+                                                           BLE_CONN_TIMEOUT,
+                                                           bleHidTaskId);
+        }
+    } else {
+        status = GAPRole_PeripheralConnParamUpdateReq (g_conn_handle,
+                                                       KBD_BLE_IDLE_CONN_INT_MIN,
+                                                       KBD_BLE_IDLE_CONN_INT_MAX,
+                                                       KBD_BLE_SLAVE_LATENCY,
+                                                       BLE_CONN_TIMEOUT,
+                                                       bleHidTaskId);
+    }
+
+    if (status == SUCCESS) {
+        g_conn_stats.requested = g_conn_stats.target;
+        g_conn_stats.requests++;
+        LOG_D (TAG, "Conn param req %s",
+               (g_conn_stats.target == BLE_HID_CONN_FAST) ? "fast" : "idle");
+    } else {
+        LOG_W (TAG, "Conn param req failed: %02X", status);
+    }
+
+    // 请求间隔保护到期后按当时档位重新判断（失败时即为重试）
+    g_conn_param_busy = true;
+    tmos_start_task (bleHidTaskId, BLE_HID_PARAM_UPDATE_EVT,
+                     MS1_TO_SYSTEM_TIME (KBD_BLE_CONN_PARAM_GAP_MS));
+}
+
+// 有输入：切到打字档，并重新开始空闲计时
+static void BLE_HID_ConnActivity (void) {
+    if (!g_conn_active) {
+        return;
+    }
+
+    BLE_HID_ConnSetTarget (BLE_HID_CONN_FAST);
+    tmos_start_task (bleHidTaskId, BLE_HID_CONN_IDLE_EVT,
+                     MS1_TO_SYSTEM_TIME (KBD_BLE_CONN_IDLE_AFTER_MS));
+}
+
+void BLE_HID_GetConnStats (ble_hid_conn_stats_t *out, uint8_t reset) {
+    if (out == NULL) {
+        return;
+    }
+
+    uint32_t now = RTC_GetCycle32k();
+    uint32_t ms = BLE_HID_ConnSegmentMs (now);
+
+    // 进行中的一段只计入输出副本，累计值仍由 TMOS 侧切换档位时结算
+    *out = g_conn_stats;
+    if (out->target == BLE_HID_CONN_FAST) {
+        out->fast_ms = BLE_HID_SatAdd (out->fast_ms, ms);
+    } else {
+        out->idle_ms = BLE_HID_SatAdd (out->idle_ms, ms);
+    }
+    if (reset) {
+        // 清零后从现在重新计时，已读出的部分不再重复累计
+        g_conn_stats.requests = 0;
+        g_conn_stats.updates = 0;
+        g_conn_stats.fast_ms = 0;
+        g_conn_stats.idle_ms = 0;
+        g_conn_seg_rtc = now;
+    }
+}
+
+/* ==================== 回连调度实现 ==================== */
+
+// 按阶段设置广播类型 / 间隔并开始广播；阶段时长由 BLE_HID_RECONN_EVT 兜底，
+// 协议栈先超时也一样，都在 GAPROLE_WAITING 中进入下一阶段
+static bStatus_t BLE_HID_ReconnEnter (uint8_t phase) {
+    uint8_t enable = TRUE;
+    bStatus_t status;
+    uint8_t advType = GAP_ADTYPE_ADV_IND;
+    uint32_t ms = 0;
+
+    switch (phase) {
+    case BLE_HID_RECONN_DIRECT_HIGH:
+        // 高占空比定向广播不使用广播间隔，控制器 1.28s 后自行结束
+        advType = GAP_ADTYPE_ADV_HDC_DIRECT_IND;
+        ms = KBD_BLE_RECONN_DIRECT_HIGH_MS;
+        break;
+
+    case BLE_HID_RECONN_DIRECT_LOW:
+        advType = GAP_ADTYPE_ADV_LDC_DIRECT_IND;
+        GAP_SetParamValue (TGAP_DISC_ADV_INT_MIN, KBD_BLE_RECONN_DIRECT_LOW_INT);
+        GAP_SetParamValue (TGAP_DISC_ADV_INT_MAX, KBD_BLE_RECONN_DIRECT_LOW_INT);
+        ms = KBD_BLE_RECONN_DIRECT_LOW_MS;
+        break;
+
+    case BLE_HID_RECONN_FAST:
+        GAP_SetParamValue (TGAP_DISC_ADV_INT_MIN, BLE_ADV_INT_MIN);
+        GAP_SetParamValue (TGAP_DISC_ADV_INT_MAX, BLE_ADV_INT_MAX);
+        ms = KBD_BLE_RECONN_FAST_MS;
+        break;
+
+    default:
+        phase = BLE_HID_RECONN_SLOW;
+        GAP_SetParamValue (TGAP_DISC_ADV_INT_MIN, KBD_BLE_RECONN_SLOW_INT_MIN);
+        GAP_SetParamValue (TGAP_DISC_ADV_INT_MAX, KBD_BLE_RECONN_SLOW_INT_MAX);
+        break;
+    }
+
+    GAP_SetParamValue (TGAP_LIM_ADV_TIMEOUT, ms ? (ms + 999u) / 1000u : BLE_ADV_TIMEOUT);
+    GAPRole_SetParameter (GAPROLE_ADV_EVENT_TYPE, sizeof (uint8_t), &advType);
+    if (advType != GAP_ADTYPE_ADV_IND) {
+        GAPRole_SetParameter (GAPROLE_ADV_DIRECT_TYPE, sizeof (uint8_t),
+                              &g_hosts[g_host_active].addr_type);
+        GAPRole_SetParameter (GAPROLE_ADV_DIRECT_ADDR, B_ADDR_LEN,
+                              g_hosts[g_host_active].addr);
+    }
+
+    g_reconn_stats.phase = phase;
+    tmos_stop_task (bleHidTaskId, BLE_HID_RECONN_EVT);
+    tmos_clear_event (bleHidTaskId, BLE_HID_RECONN_EVT);
+    if (ms) {
+        tmos_start_task (bleHidTaskId, BLE_HID_RECONN_EVT, MS1_TO_SYSTEM_TIME (ms));
+    }
+
+    status = GAPRole_SetParameter (GAPROLE_ADVERT_ENABLED, sizeof (uint8_t), &enable);
+    LOG_D (TAG, "Reconnect phase %d", phase);
+    return status;
+}
+
+// 开始一次回连：当前槽位有主机且定向广播近期有效时先定向，否则从快速非定向开始
+static bStatus_t BLE_HID_ReconnStart (void) {
+    if (g_reconn_state != RECONN_SEARCH) {
+        g_reconn_state = RECONN_SEARCH;
+        g_reconn_rtc = RTC_GetCycle32k();
+        g_reconn_stats.attempts++;
+    }
+
+    if (g_hosts[g_host_active].valid &&
+        g_reconn_stats.direct_miss < KBD_BLE_RECONN_DIRECT_MAX_MISS) {
+        return BLE_HID_ReconnEnter (BLE_HID_RECONN_DIRECT_HIGH);
+    }
+    return BLE_HID_ReconnEnter (BLE_HID_RECONN_FAST);
+}
+
+// 当前阶段广播结束仍未连上：进入下一阶段，慢速阶段到时后原样重启
+static void BLE_HID_ReconnAdvance (void) {
+    if (g_reconn_state != RECONN_SEARCH) {
+        (void)BLE_HID_ReconnStart();
+        return;
+    }
+
+    switch (g_reconn_stats.phase) {
+    case BLE_HID_RECONN_DIRECT_HIGH:
+        (void)BLE_HID_ReconnEnter (BLE_HID_RECONN_DIRECT_LOW);
+        break;
+
+    case BLE_HID_RECONN_DIRECT_LOW:
+        if (g_reconn_stats.direct_miss < 0xFF) {
+            g_reconn_stats.direct_miss++;
+        }
+        (void)BLE_HID_ReconnEnter (BLE_HID_RECONN_FAST);
+        break;
+
+    default:
+        (void)BLE_HID_ReconnEnter (BLE_HID_RECONN_SLOW);
+        break;
+    }
+}
+
+// 链路建立：记录对端、结束调度，并把广播类型恢复为非定向
+static void BLE_HID_ReconnLinked (gapEstLinkReqEvent_t *event) {
+    uint8_t advType = GAP_ADTYPE_ADV_IND;
+    uint8_t phase = g_reconn_stats.phase;
+
+    tmos_stop_task (bleHidTaskId, BLE_HID_RECONN_EVT);
+    tmos_clear_event (bleHidTaskId, BLE_HID_RECONN_EVT);
+    GAPRole_SetParameter (GAPROLE_ADV_EVENT_TYPE, sizeof (uint8_t), &advType);
+
+    // HCI 对端类型 2/3 为已解析的身份地址，定向广播只区分 public / random
+    g_link_type = event->devAddrType & 0x01;
+    memcpy (g_link_addr, event->devAddr, B_ADDR_LEN);
+    g_reconn_stats.phase = BLE_HID_RECONN_NONE;
+
+    if (g_reconn_state != RECONN_SEARCH || phase == BLE_HID_RECONN_NONE) {
+        g_reconn_state = RECONN_IDLE;
+        return;
+    }
+
+    g_reconn_state = RECONN_LINKED;
+    g_reconn_stats.connected++;
+    g_reconn_stats.by_phase[phase - 1]++;
+    g_reconn_stats.last_phase = phase;
+    g_reconn_stats.last_link_ms = BLE_HID_ElapsedMs (g_reconn_rtc);
+    if (phase == BLE_HID_RECONN_DIRECT_HIGH || phase == BLE_HID_RECONN_DIRECT_LOW) {
+        g_reconn_stats.direct_miss = 0;
+    }
+}
+
+// 链路建立时对端是其他已记录槽位的主机：连接期间只服务当前槽位
+static int8_t BLE_HID_HostOwner (gapEstLinkReqEvent_t *event) {
+    for (uint8_t i = 0; i < KBD_BLE_HOST_COUNT; i++) {
+        if (i != g_host_active && g_hosts[i].valid &&
+            g_hosts[i].addr_type == (event->devAddrType & 0x01) &&
+            memcmp (g_hosts[i].addr, event->devAddr, B_ADDR_LEN) == 0) {
+            return (int8_t)i;
+        }
+    }
+    return -1;
+}
+
+static void BLE_HID_HostNotify (void) {
+    if (g_pCallbacks && g_pCallbacks->onHostChange) {
+        g_pCallbacks->onHostChange (g_host_active, &g_hosts[g_host_active]);
+    }
+}
+
+// 链路加密：完成一次回连 / 切换测量；对端变化时写入当前槽位并通知上层持久化
+static void BLE_HID_ReconnSecure (void) {
+    kbd_ble_host_t *host = &g_hosts[g_host_active];
+    bool same = host->valid && host->addr_type == g_link_type &&
+                memcmp (host->addr, g_link_addr, B_ADDR_LEN) == 0;
+
+    if (g_reconn_state == RECONN_LINKED) {
+        uint32_t ms = BLE_HID_ElapsedMs (g_reconn_rtc);
+
+        g_reconn_state = RECONN_IDLE;
+        g_reconn_stats.ready++;
+        g_reconn_stats.last_ready_ms = ms;
+        if (ms > g_reconn_stats.max_ready_ms) {
+            g_reconn_stats.max_ready_ms = ms;
+        }
+        g_reconn_stats.total_ready_ms = (g_reconn_stats.total_ready_ms > 0xFFFFFFFFu - ms)
+                                            ? 0xFFFFFFFFu
+                                            : g_reconn_stats.total_ready_ms + ms;
+        // 同一地址从非定向阶段连上：主机只是当时不在，定向广播仍然有效
+        if (same) {
+            g_reconn_stats.direct_miss = 0;
+        }
+        LOG_I (TAG, "Reconnect phase=%d link=%lums ready=%lums",
+               g_reconn_stats.last_phase, (unsigned long)g_reconn_stats.last_link_ms,
+               (unsigned long)ms);
+    }
+
+    if (g_host_switching) {
+        uint32_t ms = BLE_HID_ElapsedMs (g_host_switch_rtc);
+
+        g_host_switching = false;
+        g_host_stats.last_switch_ms = ms;
+        if (ms > g_host_stats.max_switch_ms) {
+            g_host_stats.max_switch_ms = ms;
+        }
+        LOG_I (TAG, "Host %d switch ready=%lums", g_host_active, (unsigned long)ms);
+    }
+
+    g_link_host = true;
+    if (same) {
+        // 记住的打字档参数提前请求，不等首次更新延迟
+        if (host->interval != 0 && !g_conn_policy_ready) {
+            tmos_start_task (bleHidTaskId, BLE_HID_PARAM_UPDATE_EVT,
+                             MS1_TO_SYSTEM_TIME (KBD_BLE_HOST_PARAM_DELAY_MS));
+        }
+        return;
+    }
+
+    // 新主机占用当前槽位，连接参数重新学习
+    memset (host, 0, sizeof (*host));
+    host->valid = 1;
+    host->addr_type = g_link_type;
+    memcpy (host->addr, g_link_addr, B_ADDR_LEN);
+    BLE_HID_HostNotify();
+}
+
+// 打字档参数更新完成：主机按请求给出（从机延迟 0）时记入当前槽位
+static void BLE_HID_HostLearnParams (void) {
+    kbd_ble_host_t *host = &g_hosts[g_host_active];
+
+    if (!g_link_host || g_conn_stats.target != BLE_HID_CONN_FAST ||
+        g_conn_stats.requested != BLE_HID_CONN_FAST || g_conn_stats.latency != 0) {
+        return;
+    }
+    if (host->interval == g_conn_stats.interval && host->latency == g_conn_stats.latency &&
+        host->timeout == g_conn_stats.timeout) {
+        return;
+    }
+
+    host->interval = g_conn_stats.interval;
+    host->latency = g_conn_stats.latency;
+    host->timeout = g_conn_stats.timeout;
+    BLE_HID_HostNotify();
+}
+
+void BLE_HID_SetHost (uint8_t idx, const kbd_ble_host_t *host) {
+    if (idx >= KBD_BLE_HOST_COUNT) {
+        return;
+    }
+
+    memset (&g_hosts[idx], 0, sizeof (g_hosts[idx]));
+    if (host != NULL && host->valid) {
+        g_hosts[idx] = *host;
+        g_hosts[idx].valid = 1;
+        g_hosts[idx].addr_type &= 0x01;
+    }
+}
+
+void BLE_HID_SetActiveHost (uint8_t idx) {
+    if (idx < KBD_BLE_HOST_COUNT) {
+        g_host_active = idx;
+    }
+}
+
+int BLE_HID_SelectHost (uint8_t idx) {
+    uint8_t state = (g_ble_state & GAPROLE_STATE_ADV_MASK);
+
+    if (idx >= KBD_BLE_HOST_COUNT) {
+        return -1;
+    }
+    if (idx == g_host_active && BLE_HID_IsConnected()) {
+        return 0;
+    }
+
+    g_host_active = idx;
+    g_host_stats.switches++;
+    g_host_switching = (g_hosts[idx].valid != 0);
+    g_host_switch_rtc = RTC_GetCycle32k();
+    g_reconn_stats.direct_miss = 0;
+    g_auto_resume_advertising = true;
+    LOG_I (TAG, "Select host %d", idx);
+
+    if (g_conn_handle != GAP_CONNHANDLE_INIT) {
+        // GAPROLE_WAITING 中从新槽位重新开始回连
+        GAPRole_TerminateLink (g_conn_handle);
+        return 0;
+    }
+
+    if (g_reconn_state == RECONN_SEARCH) {
+        g_reconn_stats.aborted++;
+    }
+    g_reconn_state = RECONN_IDLE;
+    if (state == GAPROLE_ADVERTISING) {
+        // 广播中不能改广播参数：先停止，GAPROLE_WAITING 中从新槽位开始
+        uint8_t enable = FALSE;
+
+        tmos_stop_task (bleHidTaskId, BLE_HID_RECONN_EVT);
+        GAPRole_SetParameter (GAPROLE_ADVERT_ENABLED, sizeof (uint8_t), &enable);
+        return 0;
+    }
+
+    return (BLE_HID_ReconnStart() == SUCCESS) ? 0 : -1;
+}
+
+uint8_t BLE_HID_GetActiveHost (void) {
+    return g_host_active;
+}
+
+int BLE_HID_GetHost (uint8_t idx, kbd_ble_host_t *out) {
+    if (idx >= KBD_BLE_HOST_COUNT || out == NULL) {
+        return -1;
+    }
+
+    *out = g_hosts[idx];
+    return 0;
+}
+
+void BLE_HID_GetHostStats (ble_hid_host_stats_t *out, uint8_t reset) {
+    if (out == NULL) {
+        return;
+    }
+
+    *out = g_host_stats;
+    out->active = g_host_active;
+    if (reset) {
+        memset (&g_host_stats, 0, sizeof (g_host_stats));
+    }
+}
+
+void BLE_HID_GetReconnStats (ble_hid_reconn_stats_t *out, uint8_t reset) {
+    if (out == NULL) {
+        return;
+    }
+
+    *out = g_reconn_stats;
+    out->peer_valid = g_hosts[g_host_active].valid;
+    out->peer_type = g_hosts[g_host_active].addr_type;
+    memcpy (out->peer_addr, g_hosts[g_host_active].addr, B_ADDR_LEN);
+    if (reset) {
+        g_reconn_stats.attempts = 0;
+        g_reconn_stats.connected = 0;
+        g_reconn_stats.ready = 0;
+        g_reconn_stats.aborted = 0;
+        memset (g_reconn_stats.by_phase, 0, sizeof (g_reconn_stats.by_phase));
+        g_reconn_stats.last_link_ms = 0;
+        g_reconn_stats.last_ready_ms = 0;
+        g_reconn_stats.max_ready_ms = 0;
+        g_reconn_stats.total_ready_ms = 0;
+    }
+}
+
+__HIGH_CODE
+void BLE_HID_MarkWake (void) {
+    g_wake_rtc = RTC_GetCycle32k();
+    g_wake_state = WAKE_ARMED;
+}
+
+void BLE_HID_GetReplayStats (ble_hid_replay_stats_t *out, uint8_t reset) {
+    if (out == NULL) {
+        return;
+    }
+
+    // 只读：过期条目留给下一次提交 / 补发时丢弃，不在这里改动 FIFO
+    *out = g_replay_stats;
+    out->depth = g_pending_count;
+    if (reset) {
+        memset (&g_replay_stats, 0, sizeof (g_replay_stats));
+        g_replay_stats.high_water = g_pending_count;
+    }
 }
 
 /* ==================== 初始化实现 ==================== */
@@ -153,17 +981,35 @@ int BLE_HID_Init (ble_hid_callbacks_t *pCBs) {
     g_auto_resume_advertising = true;
     BLE_HID_BuildDeviceNameData();
 
+    // 上电 / 深睡唤醒都会走到这里，按唤醒计时
+    g_pending_head = 0;
+    g_pending_count = 0;
+    memset (&g_replay_stats, 0, sizeof (g_replay_stats));
+    BLE_HID_MarkWake();
+
+    g_tx_burst_req = false;
+    g_tx_burst = false;
+    memset (&g_tx_stats, 0, sizeof (g_tx_stats));
+
+    memset (&g_conn_stats, 0, sizeof (g_conn_stats));
+    g_conn_stats.requested = CONN_PROFILE_NONE;
+
+    // 主机槽位由上层在 Init 之前载入（BLE_HID_SetHost / SetActiveHost），这里不清
+    g_reconn_state = RECONN_IDLE;
+    memset (&g_reconn_stats, 0, sizeof (g_reconn_stats));
+    g_host_switching = false;
+    g_link_rejected = false;
+    g_link_host = false;
+    memset (&g_host_stats, 0, sizeof (g_host_stats));
+
     // 注册 TMOS 任务
     bleHidTaskId = TMOS_ProcessEventRegister (BLE_HID_ProcessEvent);
 
-    // 设置 GAP 角色参数
-    {
-        uint8_t enable = TRUE;  // BLE 模式自动开始广播（WCH Application 示例方式）
-        BLE_HID_ApplyAdvertisingParams();
-        GAPRole_SetParameter (GAPROLE_ADVERT_ENABLED, sizeof (uint8_t), &enable);
-        GAPRole_SetParameter (GAPROLE_ADVERT_DATA, sizeof (g_advertData), g_advertData);
-        GAPRole_SetParameter (GAPROLE_SCAN_RSP_DATA, g_scanRspDataLen, g_scanRspData);
-    }
+    // 设置 GAP 角色参数，BLE 模式自动开始广播（WCH Application 示例方式），
+    // 上电 / 深睡唤醒按回连调度从定向广播开始
+    GAPRole_SetParameter (GAPROLE_ADVERT_DATA, sizeof (g_advertData), g_advertData);
+    GAPRole_SetParameter (GAPROLE_SCAN_RSP_DATA, g_scanRspDataLen, g_scanRspData);
+    (void)BLE_HID_ReconnStart();
 
     // 设置 GAP 特性
     GGS_SetParameter (GGS_DEVICE_NAME_ATT, GAP_DEVICE_NAME_LEN, (void *)g_attDeviceName);
@@ -212,6 +1058,16 @@ int BLE_HID_Init (ble_hid_callbacks_t *pCBs) {
     // 添加 HID 服务（必须在 HidDev_Init 之后，因为需要电池服务句柄）
     HidKbdMouse_AddService();
 
+    // 配置服务：经 GATT 隧道传输配置命令帧；MTU 交换需要 GATT 客户端
+    GATT_InitClient();
+    BLE_Cfg_AddService();
+
+    // 链路遥测：RSSI / 漏事件 / 重传 / 断链原因，可选自适应发射功率
+    BLE_Link_Init();
+
+    // 连接事件结束回调：按连接事件放行积压的报告、统计链路事件（仅单连接有效）
+    LL_ConnectEventRegister (BLE_HID_ConnEventCB);
+
     LOG_I (TAG, "Init done");
 
     return 0;
@@ -230,16 +1086,18 @@ uint16_t BLE_HID_ProcessEvent (uint8_t task_id, uint16_t events) {
     }
 
     if (events & BLE_HID_PARAM_UPDATE_EVT) {
-        // 请求连接参数更新（latency=0 对齐官方示例，避免主机拒绝更新请求）
-        GAPRole_PeripheralConnParamUpdateReq (g_conn_handle,
-                                              BLE_CONN_INT_MIN,
-                                              BLE_CONN_INT_MAX,
-                                              0,
-                                              BLE_CONN_TIMEOUT,
-                                              bleHidTaskId);
+        // 首次更新延迟或请求间隔保护到期：按当前档位请求
+        g_conn_policy_ready = true;
+        g_conn_param_busy = false;
+        BLE_HID_ConnApply();
         return (events ^ BLE_HID_PARAM_UPDATE_EVT);
     }
 
+    if (events & BLE_HID_CONN_IDLE_EVT) {
+        BLE_HID_ConnSetTarget (BLE_HID_CONN_IDLE);
+        return (events ^ BLE_HID_CONN_IDLE_EVT);
+    }
+
     if (events & BLE_HID_SECURITY_REQ_EVT) {
         uint8_t state = (g_ble_state & GAPROLE_STATE_ADV_MASK);
 
@@ -259,17 +1117,52 @@ uint16_t BLE_HID_ProcessEvent (uint8_t task_id, uint16_t events) {
     }
 
     if (events & BLE_HID_PHY_UPDATE_EVT) {
-        // 请求 PHY 更新到 2M
-        GAPRole_UpdatePHY (g_conn_handle, 0,
-                           GAP_PHY_BIT_LE_2M, GAP_PHY_BIT_LE_2M, 0);
+        // 请求 PHY 更新到 2M，并按 BLE_BUFF_MAX_LEN 交换 ATT MTU（数据长度随之扩展）
+        if (g_conn_handle != GAP_CONNHANDLE_INIT) {
+            attExchangeMTUReq_t req;
+            bStatus_t status;
+
+            GAPRole_UpdatePHY (g_conn_handle, 0,
+                               GAP_PHY_BIT_LE_2M, GAP_PHY_BIT_LE_2M, 0);
+            req.clientRxMTU = BLE_BUFF_MAX_LEN - 4;
+            status = GATT_ExchangeMTU (g_conn_handle, &req, bleHidTaskId);
+            if (status != SUCCESS) {
+                LOG_W (TAG, "MTU exchange failed: %02X", status);
+            }
+        }
         return (events ^ BLE_HID_PHY_UPDATE_EVT);
     }
 
+    if (events & BLE_HID_REPLAY_EVT) {
+        BLE_HID_Replay();
+        return (events ^ BLE_HID_REPLAY_EVT);
+    }
+
+    if (events & BLE_HID_RECONN_EVT) {
+        // 阶段时长到：停止广播，GAPROLE_WAITING 中进入下一阶段
+        if ((g_ble_state & GAPROLE_STATE_ADV_MASK) == GAPROLE_ADVERTISING) {
+            uint8_t enable = FALSE;
+            GAPRole_SetParameter (GAPROLE_ADVERT_ENABLED, sizeof (uint8_t), &enable);
+        }
+        return (events ^ BLE_HID_RECONN_EVT);
+    }
+
     return 0;
 }
 
 static void BLE_HID_ProcessTMOSMsg (tmos_event_hdr_t *pMsg) {
     switch (pMsg->event) {
+    case GATT_MSG_EVENT: {
+        // MTU 交换响应：新 MTU 另由 ATT_MTU_UPDATED_EVENT 经 hiddev 通知
+        gattMsgEvent_t *msg = (gattMsgEvent_t *)pMsg;
+
+        if (msg->method == ATT_ERROR_RSP) {
+            LOG_W (TAG, "GATT error rsp req=%02X err=%02X",
+                   msg->msg.errorRsp.reqOpcode, msg->msg.errorRsp.errCode);
+        }
+        GATT_bm_free (&msg->msg, msg->method);
+    } break;
+
     default:
         break;
     }
@@ -279,11 +1172,9 @@ static void BLE_HID_ProcessTMOSMsg (tmos_event_hdr_t *pMsg) {
 
 int BLE_HID_StartAdvertising (void) {
     g_auto_resume_advertising = true;
-    BLE_HID_ApplyAdvertisingParams();
 
-    // 开始广播
-    uint8_t enable = TRUE;
-    bStatus_t status = GAPRole_SetParameter (GAPROLE_ADVERT_ENABLED, sizeof (uint8_t), &enable);
+    // 开始广播（从回连调度第一阶段开始）
+    bStatus_t status = BLE_HID_ReconnStart();
 
     if (status != SUCCESS) {
         LOG_W (TAG, "Start advertising failed: %02X", status);
@@ -296,6 +1187,14 @@ int BLE_HID_StartAdvertising (void) {
 
 int BLE_HID_StopAdvertising (void) {
     uint8_t enable = FALSE;
+
+    if (g_reconn_state == RECONN_SEARCH) {
+        g_reconn_stats.aborted++;
+    }
+    g_reconn_state = RECONN_IDLE;
+    g_reconn_stats.phase = BLE_HID_RECONN_NONE;
+    g_host_switching = false;
+    tmos_stop_task (bleHidTaskId, BLE_HID_RECONN_EVT);
     GAPRole_SetParameter (GAPROLE_ADVERT_ENABLED, sizeof (uint8_t), &enable);
 
     LOG_I (TAG, "Stop advertising");
@@ -330,6 +1229,9 @@ int BLE_HID_ClearBonds (void) {
         LOG_W (TAG, "Clear bonds failed: %02X", status);
         return -1;
     }
+    memset (g_hosts, 0, sizeof (g_hosts));
+    g_host_active = 0;
+    g_reconn_stats.direct_miss = 0;
     LOG_I (TAG, "Clear bonds");
     return 0;
 }
@@ -343,46 +1245,28 @@ uint8_t BLE_HID_GetBondCount (void) {
 /* ==================== HID 报告发送实现 ==================== */
 
 int BLE_HID_SendKeyboardReport (uint8_t modifier, uint8_t *keys, uint8_t key_count) {
-    if (!BLE_HID_IsConnected()) {
-        return -1;
-    }
-
-    uint8_t buf[8] = {0};
-    buf[0] = modifier;
-    buf[1] = 0;  // Reserved
+    kbd_hid_keyboard_report_t report;
 
-    uint8_t count = (key_count > 6) ? 6 : key_count;
-    if (keys && count > 0) {
-        memcpy (&buf[2], keys, count);
-    }
-
-    return HidDev_Report (HID_RPT_ID_KEY_IN, HID_REPORT_TYPE_INPUT, 8, buf);
+    KBD_HID_PackKeyboard (&report, modifier, keys, keys ? key_count : 0);
+    return BLE_HID_SubmitReport (HID_RPT_ID_KEY_IN, KBD_HID_LEN_KEYBOARD, (uint8_t *)&report);
 }
 
-int BLE_HID_SendMouseReport (uint8_t buttons, int8_t x, int8_t y, int8_t wheel) {
-    if (!BLE_HID_IsConnected()) {
-        return -1;
-    }
-
-    uint8_t buf[4];
-    buf[0] = buttons;
-    buf[1] = (uint8_t)x;
-    buf[2] = (uint8_t)y;
-    buf[3] = (uint8_t)wheel;
+int BLE_HID_SendMouseReport (uint8_t buttons, int8_t x, int8_t y, int8_t wheel, int8_t pan) {
+    kbd_hid_mouse_report_t report;
 
-    return HidDev_Report (HID_RPT_ID_MOUSE_IN, HID_REPORT_TYPE_INPUT, 4, buf);
+    KBD_HID_PackMouse (&report, buttons, x, y, wheel, pan);
+    return BLE_HID_SubmitReport (HID_RPT_ID_MOUSE_IN, KBD_HID_LEN_MOUSE, (uint8_t *)&report);
 }
 
 int BLE_HID_SendConsumerReport (uint16_t key) {
-    if (!BLE_HID_IsConnected()) {
-        return -1;
-    }
+    kbd_hid_consumer_report_t report;
 
-    uint8_t buf[2];
-    buf[0] = LO_UINT16 (key);
-    buf[1] = HI_UINT16 (key);
+    KBD_HID_PackConsumer (&report, key);
+    return BLE_HID_SubmitReport (HID_RPT_ID_CONSUMER_IN, KBD_HID_LEN_CONSUMER, (uint8_t *)&report);
+}
 
-    return HidDev_Report (HID_RPT_ID_CONSUMER_IN, HID_REPORT_TYPE_INPUT, 2, buf);
+uint8_t BLE_HID_GetMouseFeature (void) {
+    return hidReportMouseFeature;
 }
 
 uint8_t BLE_HID_GetKeyboardLEDs (void) {
@@ -442,6 +1326,39 @@ static void BLE_HID_EvtCallback (uint8_t evt) {
         LOG_I (TAG, "Report mode");
         break;
 
+    case HID_DEV_CONN_SECURE_EVT:
+        LOG_I (TAG, "Secure, %d pending", g_pending_count);
+        BLE_HID_ReconnSecure();
+        tmos_set_event (bleHidTaskId, BLE_HID_REPLAY_EVT);
+        // 重新加密（如重新配对）不重复请求
+        if (!g_link_upgraded) {
+            g_link_upgraded = true;
+            tmos_start_task (bleHidTaskId, BLE_HID_PHY_UPDATE_EVT, PHY_UPDATE_DELAY);
+        }
+        break;
+
+    case HID_DEV_CONN_PARAM_EVT:
+        HidDev_GetConnParams (&g_conn_stats.interval, &g_conn_stats.latency, &g_conn_stats.timeout);
+        g_conn_stats.updates++;
+        LOG_I (TAG, "Conn param int=%d lat=%d to=%d",
+               g_conn_stats.interval, g_conn_stats.latency, g_conn_stats.timeout);
+        BLE_HID_HostLearnParams();
+        BLE_Link_OnParamUpdate();
+        break;
+
+    case HID_DEV_RSSI_EVT:
+        BLE_Link_OnRssi (HidDev_GetRssi());
+        break;
+
+    case HID_DEV_LINK_UPDATE_EVT: {
+        uint16_t mtu;
+        uint8_t tx_phy;
+        uint8_t rx_phy;
+
+        HidDev_GetLinkInfo (&mtu, &tx_phy, &rx_phy);
+        LOG_I (TAG, "Link mtu=%d phy tx=%d rx=%d", mtu, tx_phy, rx_phy);
+    } break;
+
     default:
         break;
     }
@@ -470,11 +1387,36 @@ static void BLE_HID_StateCallback (gapRole_States_t newState, gapRoleEvent_t *pE
     case GAPROLE_CONNECTED_ADV:
         if (pEvent->gap.opcode == GAP_LINK_ESTABLISHED_EVENT) {
             gapEstLinkReqEvent_t *event = (gapEstLinkReqEvent_t *)pEvent;
+            int8_t owner = BLE_HID_HostOwner (event);
+
+            if (owner >= 0) {
+                // 其他槽位的主机（非定向阶段）连上：断开，GAPROLE_WAITING 中继续当前阶段
+                g_link_rejected = true;
+                g_host_stats.rejected++;
+                GAPRole_TerminateLink (event->connectionHandle);
+                LOG_I (TAG, "Reject host %d", owner);
+                return;
+            }
+
             g_conn_handle = event->connectionHandle;
+            g_link_host = false;
+            g_link_upgraded = false;
+            BLE_HID_ReconnLinked (event);
 
             tmos_start_task (bleHidTaskId, BLE_HID_SECURITY_REQ_EVT, SECURITY_REQ_DELAY);
-            // 延迟请求参数更新
+            BLE_Link_Start (g_conn_handle);
+
+            // 连接参数策略从打字档开始，延迟后才发出首次请求
+            HidDev_GetConnParams (&g_conn_stats.interval, &g_conn_stats.latency, &g_conn_stats.timeout);
+            g_conn_active = true;
+            g_conn_policy_ready = false;
+            g_conn_param_busy = false;
+            g_conn_seg_rtc = RTC_GetCycle32k();
+            g_conn_stats.target = BLE_HID_CONN_FAST;
+            g_conn_stats.requested = CONN_PROFILE_NONE;
             tmos_start_task (bleHidTaskId, BLE_HID_PARAM_UPDATE_EVT, PARAM_UPDATE_DELAY);
+            tmos_start_task (bleHidTaskId, BLE_HID_CONN_IDLE_EVT,
+                             MS1_TO_SYSTEM_TIME (KBD_BLE_CONN_IDLE_AFTER_MS));
 
             LOG_I (TAG, "Connected, handle=%d", g_conn_handle);
         } else if ((newState & GAPROLE_STATE_ADV_MASK) == GAPROLE_CONNECTED_ADV &&
@@ -485,7 +1427,23 @@ static void BLE_HID_StateCallback (gapRole_States_t newState, gapRoleEvent_t *pE
 
     case GAPROLE_WAITING:
         tmos_stop_task (bleHidTaskId, BLE_HID_SECURITY_REQ_EVT);
+        tmos_stop_task (bleHidTaskId, BLE_HID_PARAM_UPDATE_EVT);
+        tmos_stop_task (bleHidTaskId, BLE_HID_CONN_IDLE_EVT);
+        tmos_stop_task (bleHidTaskId, BLE_HID_PHY_UPDATE_EVT);
+        BLE_Cfg_Reset();
+        BLE_Link_Stop ((pEvent->gap.opcode == GAP_LINK_TERMINATED_EVENT) ?
+                       pEvent->linkTerminate.reason : 0);
+        BLE_HID_FireConnHooks();  // 不会再有连接事件：登记的任务立即执行
+        BLE_HID_ConnAccount();
+        g_conn_active = false;
         g_conn_handle = GAP_CONNHANDLE_INIT;
+        for (uint8_t i = 0; i < g_pending_count; i++) {
+            // 链路断开：未放行的积压转为重连补发
+            g_pending[(g_pending_head + i) % KBD_BLE_REPLAY_DEPTH].replay = 1;
+        }
+        BLE_HID_TxUpdateBurst();
+        g_link_host = false;
+        hidReportMouseFeature = 0; /* 高分辨率滚动由下一次连接的主机重新启用 */
 
         if (pEvent->gap.opcode == GAP_END_DISCOVERABLE_DONE_EVENT) {
             LOG_I (TAG, "Advertising timeout");
@@ -494,10 +1452,22 @@ static void BLE_HID_StateCallback (gapRole_States_t newState, gapRoleEvent_t *pE
                    pEvent->linkTerminate.reason);
         }
 
-        if (g_auto_resume_advertising) {
-            uint8_t enable = TRUE;
-            GAPRole_SetParameter (GAPROLE_ADVERT_ENABLED, sizeof (uint8_t), &enable);
+        if (g_link_rejected && g_auto_resume_advertising &&
+            g_reconn_state == RECONN_SEARCH) {
+            // 拒绝其他槽位主机不算断链，当前阶段继续
+            g_link_rejected = false;
+            (void)BLE_HID_ReconnEnter (g_reconn_stats.phase);
+        } else if (g_auto_resume_advertising) {
+            // 断链后重新开始回连；广播阶段结束则进入下一阶段
+            g_link_rejected = false;
+            if (pEvent->gap.opcode == GAP_LINK_TERMINATED_EVENT) {
+                g_reconn_state = RECONN_IDLE;
+            }
+            BLE_HID_ReconnAdvance();
         } else {
+            g_link_rejected = false;
+            g_reconn_state = RECONN_IDLE;
+            g_reconn_stats.phase = BLE_HID_RECONN_NONE;
             LOG_I (TAG, "Advertising restart suppressed");
         }
         break;
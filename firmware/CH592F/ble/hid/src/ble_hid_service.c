@@ -9,6 +9,7 @@
 #include "ble_hid_service.h"
 #include "hiddev.h"
 #include "battservice.h"
+#include "kbd_mode_config.h"
 #include <string.h>
 
 /* ==================== UUID 定义 ==================== */
@@ -63,106 +64,9 @@ static const uint8_t hidInfo[HID_INFORMATION_LEN] = {
 
 /* ==================== HID 报告描述符 ==================== */
 
-// 复合 HID 报告描述符：键盘 + 鼠标 + 多媒体
+// 复合 HID 报告描述符：按 kbd_hid_report.h 报告表拼接键盘 + 鼠标 + 多媒体，各自带 Report ID
 static const uint8_t hidReportMap[] = {
-    /* ========== 键盘报告 (Report ID 1) ========== */
-    0x05, 0x01,         // Usage Page (Generic Desktop)
-    0x09, 0x06,         // Usage (Keyboard)
-    0xA1, 0x01,         // Collection (Application)
-    0x85, HID_RPT_ID_KEY_IN, // Report ID (1)
-    
-    // 修饰键 (8 bits)
-    0x05, 0x07,         //   Usage Page (Key Codes)
-    0x19, 0xE0,         //   Usage Minimum (224) - Left Control
-    0x29, 0xE7,         //   Usage Maximum (231) - Right GUI
-    0x15, 0x00,         //   Logical Minimum (0)
-    0x25, 0x01,         //   Logical Maximum (1)
-    0x75, 0x01,         //   Report Size (1)
-    0x95, 0x08,         //   Report Count (8)
-    0x81, 0x02,         //   Input (Data, Variable, Absolute)
-    
-    // 保留字节
-    0x95, 0x01,         //   Report Count (1)
-    0x75, 0x08,         //   Report Size (8)
-    0x81, 0x01,         //   Input (Constant)
-    
-    // LED 输出报告
-    0x95, 0x05,         //   Report Count (5)
-    0x75, 0x01,         //   Report Size (1)
-    0x05, 0x08,         //   Usage Page (LEDs)
-    0x19, 0x01,         //   Usage Minimum (1)
-    0x29, 0x05,         //   Usage Maximum (5)
-    0x91, 0x02,         //   Output (Data, Variable, Absolute)
-    
-    // LED 填充
-    0x95, 0x01,         //   Report Count (1)
-    0x75, 0x03,         //   Report Size (3)
-    0x91, 0x01,         //   Output (Constant)
-    
-    // 按键数组 (6 bytes)
-    0x95, 0x06,         //   Report Count (6)
-    0x75, 0x08,         //   Report Size (8)
-    0x15, 0x00,         //   Logical Minimum (0)
-    0x25, 0x65,         //   Logical Maximum (101)
-    0x05, 0x07,         //   Usage Page (Key Codes)
-    0x19, 0x00,         //   Usage Minimum (0)
-    0x29, 0x65,         //   Usage Maximum (101)
-    0x81, 0x00,         //   Input (Data, Array)
-    
-    0xC0,               // End Collection
-    
-    /* ========== 鼠标报告 (Report ID 2) ========== */
-    0x05, 0x01,         // Usage Page (Generic Desktop)
-    0x09, 0x02,         // Usage (Mouse)
-    0xA1, 0x01,         // Collection (Application)
-    0x85, HID_RPT_ID_MOUSE_IN, // Report ID (2)
-    0x09, 0x01,         //   Usage (Pointer)
-    0xA1, 0x00,         //   Collection (Physical)
-    
-    // 按钮 (3 bits)
-    0x05, 0x09,         //     Usage Page (Buttons)
-    0x19, 0x01,         //     Usage Minimum (1)
-    0x29, 0x03,         //     Usage Maximum (3)
-    0x15, 0x00,         //     Logical Minimum (0)
-    0x25, 0x01,         //     Logical Maximum (1)
-    0x75, 0x01,         //     Report Size (1)
-    0x95, 0x03,         //     Report Count (3)
-    0x81, 0x02,         //     Input (Data, Variable, Absolute)
-    
-    // 填充 (5 bits)
-    0x75, 0x05,         //     Report Size (5)
-    0x95, 0x01,         //     Report Count (1)
-    0x81, 0x01,         //     Input (Constant)
-    
-    // X, Y, Wheel
-    0x05, 0x01,         //     Usage Page (Generic Desktop)
-    0x09, 0x30,         //     Usage (X)
-    0x09, 0x31,         //     Usage (Y)
-    0x09, 0x38,         //     Usage (Wheel)
-    0x15, 0x81,         //     Logical Minimum (-127)
-    0x25, 0x7F,         //     Logical Maximum (127)
-    0x75, 0x08,         //     Report Size (8)
-    0x95, 0x03,         //     Report Count (3)
-    0x81, 0x06,         //     Input (Data, Variable, Relative)
-    
-    0xC0,               //   End Collection (Physical)
-    0xC0,               // End Collection (Application)
-    
-    /* ========== 多媒体报告 (Report ID 3) ========== */
-    0x05, 0x0C,         // Usage Page (Consumer)
-    0x09, 0x01,         // Usage (Consumer Control)
-    0xA1, 0x01,         // Collection (Application)
-    0x85, HID_RPT_ID_CONSUMER_IN, // Report ID (3)
-    
-    0x15, 0x00,         //   Logical Minimum (0)
-    0x26, 0xFF, 0x03,   //   Logical Maximum (1023)
-    0x19, 0x00,         //   Usage Minimum (0)
-    0x2A, 0xFF, 0x03,   //   Usage Maximum (1023)
-    0x75, 0x10,         //   Report Size (16)
-    0x95, 0x01,         //   Report Count (1)
-    0x81, 0x00,         //   Input (Data, Array)
-    
-    0xC0                // End Collection
+    KBD_HID_DESC_ALL_WITH_RID
 };
 
 uint16_t hidReportMapLen = sizeof(hidReportMap);
@@ -221,6 +125,13 @@ static uint8_t hidReportRefMouseIn[HID_REPORT_REF_LEN] = {
     HID_RPT_ID_MOUSE_IN, HID_REPORT_TYPE_INPUT
 };
 
+/* ===== 鼠标 Resolution Multiplier 特性报告 ===== */
+static uint8_t hidReportMouseFeatureProps = GATT_PROP_READ | GATT_PROP_WRITE;
+uint8_t hidReportMouseFeature;
+static uint8_t hidReportRefMouseFeature[HID_REPORT_REF_LEN] = {
+    HID_RPT_ID_MOUSE_IN, HID_REPORT_TYPE_FEATURE
+};
+
 /* ===== 多媒体输入报告 ===== */
 static uint8_t hidReportConsumerInProps = GATT_PROP_READ | GATT_PROP_NOTIFY;
 static uint8_t hidReportConsumerIn;
@@ -286,6 +197,11 @@ static gattAttribute_t hidAttrTbl[] = {
     {{ATT_BT_UUID_SIZE, clientCharCfgUUID}, GATT_PERMIT_READ | GATT_PERMIT_ENCRYPT_WRITE, 0, (uint8_t *)&hidReportMouseInClientCharCfg},
     {{ATT_BT_UUID_SIZE, reportRefUUID}, GATT_PERMIT_READ, 0, hidReportRefMouseIn},
     
+    /* ===== 鼠标特性报告 ===== */
+    {{ATT_BT_UUID_SIZE, characterUUID}, GATT_PERMIT_READ, 0, &hidReportMouseFeatureProps},
+    {{ATT_BT_UUID_SIZE, hidReportUUID}, GATT_PERMIT_ENCRYPT_READ | GATT_PERMIT_ENCRYPT_WRITE, 0, &hidReportMouseFeature},
+    {{ATT_BT_UUID_SIZE, reportRefUUID}, GATT_PERMIT_READ, 0, hidReportRefMouseFeature},
+    
     /* ===== 多媒体输入报告 ===== */
     {{ATT_BT_UUID_SIZE, characterUUID}, GATT_PERMIT_READ, 0, &hidReportConsumerInProps},
     {{ATT_BT_UUID_SIZE, hidReportUUID}, GATT_PERMIT_ENCRYPT_READ, 0, &hidReportConsumerIn},
@@ -335,6 +251,11 @@ enum {
     HID_REPORT_MOUSE_IN_CCCD_IDX,
     HID_REPORT_REF_MOUSE_IN_IDX,
     
+    // 鼠标特性
+    HID_REPORT_MOUSE_FEATURE_DECL_IDX,
+    HID_REPORT_MOUSE_FEATURE_IDX,
+    HID_REPORT_REF_MOUSE_FEATURE_IDX,
+    
     // 多媒体输入
     HID_REPORT_CONSUMER_IN_DECL_IDX,
     HID_REPORT_CONSUMER_IN_IDX,
@@ -407,6 +328,14 @@ bStatus_t HidKbdMouse_AddService(void)
     hidRptMap[idx].mode = HID_PROTOCOL_MODE_REPORT;
     idx++;
     
+    // 鼠标特性报告
+    hidRptMap[idx].id = hidReportRefMouseFeature[0];
+    hidRptMap[idx].type = hidReportRefMouseFeature[1];
+    hidRptMap[idx].handle = hidAttrTbl[HID_REPORT_MOUSE_FEATURE_IDX].handle;
+    hidRptMap[idx].cccdHandle = 0;
+    hidRptMap[idx].mode = HID_PROTOCOL_MODE_REPORT;
+    idx++;
+    
     // 多媒体输入报告
     hidRptMap[idx].id = hidReportRefConsumerIn[0];
     hidRptMap[idx].type = hidReportRefConsumerIn[1];
@@ -455,6 +384,14 @@ uint8_t HidKbdMouse_SetParameter(uint8_t id, uint8_t type, uint16_t uuid,
                     ret = ATT_ERR_INVALID_VALUE_SIZE;
                 }
             }
+            else if (type == HID_REPORT_TYPE_FEATURE && id == HID_RPT_ID_MOUSE_IN) {
+                if (len == 1) {
+                    hidReportMouseFeature = *((uint8_t *)pValue) &
+                        (KBD_HID_SCROLL_FEATURE_WHEEL | KBD_HID_SCROLL_FEATURE_PAN);
+                } else {
+                    ret = ATT_ERR_INVALID_VALUE_SIZE;
+                }
+            }
             else {
                 ret = ATT_ERR_ATTR_NOT_FOUND;
             }
@@ -484,6 +421,10 @@ uint8_t HidKbdMouse_GetParameter(uint8_t id, uint8_t type, uint16_t uuid,
                 *((uint8_t *)pValue) = hidReportLedOut;
                 *pLen = 1;
             }
+            else if (type == HID_REPORT_TYPE_FEATURE && id == HID_RPT_ID_MOUSE_IN) {
+                *((uint8_t *)pValue) = hidReportMouseFeature;
+                *pLen = 1;
+            }
             else {
                 *pLen = 0;
             }
@@ -0,0 +1,449 @@
+/********************************** (C) COPYRIGHT *******************************
+ * File Name          : ble_link.c
+ * Author             : Custom Keyboard Library
+ * Version            : V1.0
+ * Date               : 2024/11/07
+ * Description        : 蓝牙链路质量遥测与自适应发射功率实现
+ *******************************************************************************/
+
+#include "ble_link.h"
+#include "hiddev.h"
+#include "kbd_mode_config.h"
+#include "ble_hal.h"
+#include "debug.h"
+#include <string.h>
+
+#define TAG "LINK"
+
+/* ==================== 常量定义 ==================== */
+
+// HCI 断链原因
+#define LINK_REASON_TIMEOUT         0x08    // 监督超时
+#define LINK_REASON_REMOTE          0x13    // 对端主动断开
+#define LINK_REASON_LOCAL           0x16    // 本机主动断开
+
+// RSSI 不可用（HCI 约定）
+#define LINK_RSSI_NONE              127
+
+// 窗口内连接事件少于此数时不按重传比例判定退化
+#define LINK_RETRY_MIN_EVENTS       20
+
+/* ==================== 发射功率档位 ==================== */
+
+static const struct
+{
+    uint8_t reg;
+    int8_t  dbm;
+} linkTxLevels[BLE_LINK_TX_LEVELS] = {
+    {LL_TX_POWEER_MINUS_15_DBM, -15},
+    {LL_TX_POWEER_MINUS_10_DBM, -10},
+    {LL_TX_POWEER_MINUS_5_DBM,  -5},
+    {LL_TX_POWEER_0_DBM,        0},
+    {LL_TX_POWEER_4_DBM,        4},
+};
+
+/* ==================== 私有变量 ==================== */
+
+static uint8_t linkTaskId = INVALID_TASK_ID;
+static uint16_t linkConnHandle = GAP_CONNHANDLE_INIT;
+static volatile bool linkActive = false;
+static bool linkAdapt = (KBD_BLE_TX_POWER_ADAPT != 0);
+
+// 发射功率档位
+static uint8_t linkDefaultLevel = 3;
+static volatile uint8_t linkLevel = 3;
+static uint32_t linkLevelRtc = 0;           // 当前档位计时起点
+static uint8_t linkGoodSamples = 0;         // 连续信号良好的采样数
+
+// RSSI 滑动平均（×4，本次连接）
+static int16_t linkRssiAcc = 0;
+static bool linkRssiValid = false;
+
+// 连接事件回调（中断）中更新
+static volatile uint32_t linkEvents = 0;
+static volatile uint32_t linkRetries = 0;
+static volatile uint32_t linkLevelEvents[BLE_LINK_TX_LEVELS];
+static volatile uint32_t linkLevelRetries[BLE_LINK_TX_LEVELS];
+static volatile uint32_t linkTxCount = 0;   // 交给协议栈的包数（主循环递增）
+static uint32_t linkTxPrev = 0;
+static uint32_t linkUnackPrev = 0;
+
+// 采样窗口
+static uint32_t linkWinEvents = 0;
+static uint32_t linkWinRetries = 0;
+static uint32_t linkWinRtc = 0;
+static bool linkWinValid = false;           // 窗口内连接参数未变化
+
+static ble_link_stats_t linkStats;
+
+/* ==================== 私有函数实现 ==================== */
+
+static uint32_t BLE_Link_ElapsedMs(uint32_t from)
+{
+    uint32_t ticks = HAL_SleepDistance(RTC_GetCycle32k(), from);
+    return (uint32_t)(((uint64_t)ticks * 1000u) / CAB_LSIFQ);
+}
+
+static void BLE_Link_ResetCounters(void)
+{
+    memset(&linkStats, 0, sizeof(linkStats));
+    linkStats.rssi_last = LINK_RSSI_NONE;
+    linkStats.rssi_min = LINK_RSSI_NONE;
+    linkStats.rssi_max = -128;
+    linkEvents = 0;
+    linkRetries = 0;
+    memset((void *)linkLevelEvents, 0, sizeof(linkLevelEvents));
+    memset((void *)linkLevelRetries, 0, sizeof(linkLevelRetries));
+    linkWinEvents = 0;
+    linkWinRetries = 0;
+    linkWinValid = false;
+}
+
+// 累计当前档位的连接时间，从此刻重新计时
+static void BLE_Link_AccountLevel(void)
+{
+    if (linkActive)
+    {
+        linkStats.level_ms[linkLevel] += BLE_Link_ElapsedMs(linkLevelRtc);
+    }
+    linkLevelRtc = RTC_GetCycle32k();
+}
+
+static void BLE_Link_SetLevel(uint8_t level)
+{
+    if (level == linkLevel)
+    {
+        return;
+    }
+
+    BLE_Link_AccountLevel();
+    if (LL_SetTxPowerLevel(linkTxLevels[level].reg) != SUCCESS)
+    {
+        LOG_W(TAG, "Set TX power %d dBm failed", linkTxLevels[level].dbm);
+        return;
+    }
+    linkLevel = level;
+    linkStats.tx_changes++;
+}
+
+// 按一个窗口的 RSSI 均值与退化信号调整档位：退化立即升一档，良好连续若干次才降一档
+static void BLE_Link_Adapt(uint32_t missed, uint32_t events, uint32_t retries)
+{
+    int16_t rssi = linkRssiAcc / 4;
+    uint8_t from = linkLevel;
+    bool degraded = (missed > 0) ||
+                    (events >= LINK_RETRY_MIN_EVENTS &&
+                     retries * 100u >= events * KBD_BLE_TXP_RETRY_PCT) ||
+                    (linkRssiValid && rssi < KBD_BLE_TXP_RSSI_LOW);
+
+    if (degraded)
+    {
+        linkGoodSamples = 0;
+        if (linkLevel + 1 < BLE_LINK_TX_LEVELS)
+        {
+            BLE_Link_SetLevel(linkLevel + 1);
+        }
+    }
+    else if (linkRssiValid && rssi > KBD_BLE_TXP_RSSI_HIGH)
+    {
+        if (++linkGoodSamples >= KBD_BLE_TXP_DOWN_SAMPLES)
+        {
+            linkGoodSamples = 0;
+            if (linkLevel > 0)
+            {
+                BLE_Link_SetLevel(linkLevel - 1);
+            }
+        }
+    }
+    else
+    {
+        linkGoodSamples = 0;
+    }
+
+    if (linkLevel != from)
+    {
+        // 上一档的重传比例即该档位对时延的影响（每次重传推迟一个连接间隔）
+        LOG_I(TAG, "TX %d -> %d dBm, rssi %d, missed %lu, retry %lu/%lu",
+              linkTxLevels[from].dbm, linkTxLevels[linkLevel].dbm, rssi,
+              (unsigned long)missed, (unsigned long)retries, (unsigned long)events);
+    }
+}
+
+// 结算一个采样窗口：估计漏事件，按需调整发射功率
+static void BLE_Link_Evaluate(void)
+{
+    uint32_t events = linkEvents;
+    uint32_t retries = linkRetries;
+    uint32_t win_events = events - linkWinEvents;
+    uint32_t win_retries = retries - linkWinRetries;
+    uint32_t win_ms = BLE_Link_ElapsedMs(linkWinRtc);
+    uint32_t missed = 0;
+    uint16_t interval;
+    uint16_t latency;
+    uint16_t timeout;
+
+    HidDev_GetConnParams(&interval, &latency, &timeout);
+
+    // 从机延迟为 0 时每个连接事件都应参加；容忍窗口边界上的 1 个事件
+    if (linkWinValid && latency == 0 && interval > 0)
+    {
+        uint32_t expected = (win_ms * 4u) / ((uint32_t)interval * 5u);
+
+        if (expected > win_events + 1)
+        {
+            missed = expected - win_events - 1;
+        }
+    }
+    linkStats.missed += missed;
+
+    linkWinEvents = events;
+    linkWinRetries = retries;
+    linkWinRtc = RTC_GetCycle32k();
+    linkWinValid = true;
+
+    if (linkAdapt)
+    {
+        BLE_Link_Adapt(missed, win_events, win_retries);
+    }
+}
+
+/* ==================== 函数实现 ==================== */
+
+void BLE_Link_Init(void)
+{
+    linkTaskId = TMOS_ProcessEventRegister(BLE_Link_ProcessEvent);
+
+    // 默认档位为 BLE_TX_POWER 所在档（不在表中时按 0 dBm）
+    linkDefaultLevel = 3;
+    for (uint8_t i = 0; i < BLE_LINK_TX_LEVELS; i++)
+    {
+        if (linkTxLevels[i].reg == BLE_TX_POWER)
+        {
+            linkDefaultLevel = i;
+        }
+    }
+    linkLevel = linkDefaultLevel;
+    linkActive = false;
+    BLE_Link_ResetCounters();
+}
+
+void BLE_Link_Start(uint16_t conn_handle)
+{
+    linkConnHandle = conn_handle;
+    linkGoodSamples = 0;
+    linkRssiValid = false;
+    linkUnackPrev = 0;
+    linkTxPrev = linkTxCount;
+    linkWinEvents = linkEvents;
+    linkWinRetries = linkRetries;
+    linkWinRtc = RTC_GetCycle32k();
+    linkWinValid = true;
+    linkLevelRtc = RTC_GetCycle32k();
+    linkActive = true;
+
+    tmos_start_task(linkTaskId, BLE_LINK_SAMPLE_EVT, MS1_TO_SYSTEM_TIME(KBD_BLE_LINK_SAMPLE_MS));
+}
+
+void BLE_Link_Stop(uint8_t reason)
+{
+    if (!linkActive)
+    {
+        return;
+    }
+
+    BLE_Link_AccountLevel();
+    linkActive = false;
+    linkConnHandle = GAP_CONNHANDLE_INIT;
+    tmos_stop_task(linkTaskId, BLE_LINK_SAMPLE_EVT);
+
+    if (reason != 0)
+    {
+        linkStats.last_reason = reason;
+        if (reason == LINK_REASON_TIMEOUT)
+        {
+            linkStats.disc_timeout++;
+        }
+        else if (reason == LINK_REASON_REMOTE)
+        {
+            linkStats.disc_remote++;
+        }
+        else if (reason == LINK_REASON_LOCAL)
+        {
+            linkStats.disc_local++;
+        }
+        else
+        {
+            linkStats.disc_other++;
+        }
+    }
+
+    // 广播 / 回连按默认功率进行
+    if (linkLevel != linkDefaultLevel)
+    {
+        LL_SetTxPowerLevel(linkTxLevels[linkDefaultLevel].reg);
+        linkLevel = linkDefaultLevel;
+    }
+
+    // 时间加权的平均发射功率（自清零以来），与默认功率之差即节省
+    {
+        uint32_t total = 0;
+        int32_t weighted = 0;
+
+        for (uint8_t i = 0; i < BLE_LINK_TX_LEVELS; i++)
+        {
+            total += linkStats.level_ms[i];
+            weighted += (int32_t)(linkStats.level_ms[i] / 100u) * linkTxLevels[i].dbm;
+        }
+        if (total >= 100u)
+        {
+            LOG_I(TAG, "Mean TX %ld dBm over %lu ms (default %d), missed %lu, retry %lu/%lu",
+                  (long)(weighted / (int32_t)(total / 100u)), (unsigned long)total,
+                  linkTxLevels[linkDefaultLevel].dbm, (unsigned long)linkStats.missed,
+                  (unsigned long)linkRetries, (unsigned long)linkEvents);
+        }
+    }
+}
+
+__HIGH_CODE
+void BLE_Link_OnConnEvent(void)
+{
+    uint32_t unack;
+    uint32_t tx;
+    uint8_t level = linkLevel;
+
+    if (!linkActive)
+    {
+        return;
+    }
+
+    unack = LL_GetNumberOfUnAckPacket(linkConnHandle);
+    if (unack == 0xFFFFFFFFu)
+    {
+        return;
+    }
+
+    tx = linkTxCount;
+    linkEvents++;
+    linkLevelEvents[level]++;
+
+    // 期间没有新包，未确认的包却没有减少：上一事件发出的包没被确认，本事件在重传
+    if (tx == linkTxPrev && linkUnackPrev > 0 && unack >= linkUnackPrev)
+    {
+        linkRetries++;
+        linkLevelRetries[level]++;
+    }
+    linkUnackPrev = unack;
+    linkTxPrev = tx;
+}
+
+void BLE_Link_NoteTx(void)
+{
+    linkTxCount++;
+}
+
+void BLE_Link_OnRssi(int8_t rssi)
+{
+    if (!linkActive || rssi == LINK_RSSI_NONE)
+    {
+        return;
+    }
+
+    linkStats.rssi_last = rssi;
+    if (linkStats.rssi_min == LINK_RSSI_NONE || rssi < linkStats.rssi_min)
+    {
+        linkStats.rssi_min = rssi;
+    }
+    if (rssi > linkStats.rssi_max)
+    {
+        linkStats.rssi_max = rssi;
+    }
+
+    if (linkRssiValid)
+    {
+        linkRssiAcc = (int16_t)(linkRssiAcc - linkRssiAcc / 4 + rssi);
+    }
+    else
+    {
+        linkRssiAcc = (int16_t)(rssi * 4);
+        linkRssiValid = true;
+    }
+
+    BLE_Link_Evaluate();
+}
+
+void BLE_Link_OnParamUpdate(void)
+{
+    linkWinValid = false;
+}
+
+void BLE_Link_SetAdaptive(bool enable)
+{
+    linkAdapt = enable;
+    linkGoodSamples = 0;
+    if (!enable && linkActive)
+    {
+        BLE_Link_SetLevel(linkDefaultLevel);
+    }
+}
+
+void BLE_Link_GetStats(ble_link_stats_t *out, uint8_t reset)
+{
+    uint16_t latency;
+    uint16_t timeout;
+
+    if (out == NULL)
+    {
+        return;
+    }
+
+    BLE_Link_AccountLevel();
+
+    *out = linkStats;
+    out->rssi_avg = linkRssiValid ? (int8_t)(linkRssiAcc / 4) : LINK_RSSI_NONE;
+    out->tx_dbm = linkTxLevels[linkLevel].dbm;
+    out->tx_dbm_default = linkTxLevels[linkDefaultLevel].dbm;
+    out->adapt = linkAdapt;
+    out->events = linkEvents;
+    out->retries = linkRetries;
+    HidDev_GetConnParams(&out->interval, &latency, &timeout);
+    for (uint8_t i = 0; i < BLE_LINK_TX_LEVELS; i++)
+    {
+        uint32_t events = linkLevelEvents[i];
+
+        out->level_retry_pm[i] = events ? (uint16_t)(((uint64_t)linkLevelRetries[i] * 1000u) / events) : 0;
+    }
+
+    if (reset)
+    {
+        BLE_Link_ResetCounters();
+    }
+}
+
+uint16_t BLE_Link_ProcessEvent(uint8_t task_id, uint16_t events)
+{
+    if (events & SYS_EVENT_MSG)
+    {
+        uint8_t *pMsg = tmos_msg_receive(linkTaskId);
+        if (pMsg)
+        {
+            tmos_msg_deallocate(pMsg);
+        }
+        return (events ^ SYS_EVENT_MSG);
+    }
+
+    if (events & BLE_LINK_SAMPLE_EVT)
+    {
+        if (linkActive)
+        {
+            // RSSI 经 HID_DEV_RSSI_EVT 回到 BLE_Link_OnRssi 再结算；读取失败直接结算
+            if (GAPRole_ReadRssiCmd(linkConnHandle) != SUCCESS)
+            {
+                BLE_Link_Evaluate();
+            }
+            tmos_start_task(linkTaskId, BLE_LINK_SAMPLE_EVT, MS1_TO_SYSTEM_TIME(KBD_BLE_LINK_SAMPLE_MS));
+        }
+        return (events ^ BLE_LINK_SAMPLE_EVT);
+    }
+
+    return 0;
+}
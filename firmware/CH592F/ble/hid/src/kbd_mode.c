@@ -16,6 +16,10 @@
 #include "usb_device.h"
 #include "usb_hid.h"
 #include "kbd_storage.h"
+#include "kbd_log.h"
+#include "kbd_blackbox.h"
+#include "kbd_boot.h"
+#include "kbd_idle.h"
 #include "key.h"
 #include "debug.h"
 #include "ws2812.h"
@@ -30,6 +34,13 @@
 #define KBD_SLEEP_ENTRY_FLASH_ON_MS 90u
 #define KBD_SLEEP_ENTRY_FLASH_OFF_MS 70u
 
+/** 模式任务事件与自检周期 */
+#define MODE_PROCESS_EVT 0x0001
+#define MODE_USB_RESUME_EVT 0x0002   /**< USB 总线恢复：发出挂起期间缓冲的报告 */
+#define KBD_MODE_USB_POLL_MS 20u     /**< USB 模式：枚举状态 */
+#define KBD_MODE_ACTIVE_POLL_MS 250u /**< BLE 活跃：指示灯 / 自动休眠 */
+#define KBD_MODE_LIGHT_POLL_MS 1000u /**< LIGHT：USB 插入 / 充电退出，DEEP 超时 */
+
 #if defined(CLK_OSC32K) && (CLK_OSC32K == 1)
 #define KBD_RTC_FREQ_HZ 32000u
 #else
@@ -48,6 +59,7 @@ static kbd_pm_state_t g_pm_state = KBD_PM_ACTIVE;
 static bool g_mode_switching = false;
 static uint32_t g_last_activity_tick = 0;
 static bool g_wake_requested = false;
+static uint8_t g_mode_task_id = TASK_NO_TASK;
 
 /** 报告缓冲区 */
 static uint8_t g_kbd_report[KBD_HID_KEYBOARD_REPORT_LEN];
@@ -61,14 +73,14 @@ static uint16_t g_consumer_report;
 static void KBD_Mode_UpdateConnState(kbd_conn_state_t state);
 static void KBD_Mode_BLE_StateCallback(gapRole_States_t newState);
 static void KBD_Mode_BLE_LedCallback(uint8_t leds);
+static void KBD_Mode_BLE_HostCallback(uint8_t idx, const kbd_ble_host_t *host);
 static uint32_t KBD_Mode_GetNow(void);
 static void KBD_Mode_RecordActivityInternal(void);
 static uint32_t KBD_Mode_GetIdleMs(void);
 static uint32_t KBD_Mode_GetLightSleepTimeoutMs(void);
 static uint32_t KBD_Mode_GetDeepSleepTimeoutMs(void);
-static void KBD_Mode_CancelDeepSleepCheck(void);
-static void KBD_Mode_ArmDeepSleepCheck(void);
-static bool KBD_Mode_IsDeepSleepCheckDue(void);
+static uint16_t KBD_Mode_ProcessEvent(uint8_t task_id, uint16_t events);
+static void KBD_Mode_ScheduleProcess(uint8_t task_id);
 static bool KBD_Mode_USB_HasProtocolHandshake(void);
 static void KBD_Mode_PlaySleepEntryAnimation(void);
 static kbd_state_t KBD_Mode_ResolveIndicatorState(void);
@@ -77,6 +89,7 @@ static void KBD_Mode_EnterLightSleep(void);
 static void KBD_Mode_ExitLightSleep(void);
 static void KBD_Mode_EnterDeepSleep(void);
 static bool KBD_Mode_CanEnterDeepSleep(void);
+static bool KBD_Mode_CanSend(void);
 
 /*============================================================================*/
 /* BLE 回调 */
@@ -85,6 +98,7 @@ static bool KBD_Mode_CanEnterDeepSleep(void);
 static ble_hid_callbacks_t g_ble_callbacks = {
     .onStateChange = KBD_Mode_BLE_StateCallback,
     .onLedReport = KBD_Mode_BLE_LedCallback,
+    .onHostChange = KBD_Mode_BLE_HostCallback,
 };
 
 /*============================================================================*/
@@ -102,8 +116,6 @@ int KBD_Mode_Init(kbd_work_mode_t initial_mode, kbd_mode_callbacks_t *pCBs)
     g_mode_switching = false;
     g_last_activity_tick = KBD_Mode_GetNow();
     g_wake_requested = false;
-    KBD_Mode_CancelDeepSleepCheck();
-    PFIC_EnableIRQ(RTC_IRQn);
 
     /* 清空报告缓冲区 */
     memset(g_kbd_report, 0, sizeof(g_kbd_report));
@@ -120,9 +132,20 @@ int KBD_Mode_Init(kbd_work_mode_t initial_mode, kbd_mode_callbacks_t *pCBs)
      * BLE 模式也初始化 USB Device。这样无线使用时插上 USB，Studio 仍可通过
      * USB HID 配置接口读写当前键盘配置，不需要先切换到 USB 工作模式。
      */
+    g_mode_task_id = TMOS_ProcessEventRegister(KBD_Mode_ProcessEvent);
+    KBD_Idle_SetEvent(g_mode_task_id, MODE_PROCESS_EVT);
+
     if (initial_mode == KBD_WORK_MODE_BLE)
     {
-        /* BLE 模式：初始化 BLE HID，广播由 GAPROLE_STARTED 回调自动触发 */
+        /* BLE 模式：初始化 BLE HID，广播由 GAPROLE_STARTED 回调自动触发，
+         * 当前主机槽位记录过主机时先向它定向广播 */
+        kbd_ble_host_t host;
+
+        for (uint8_t i = 0; i < KBD_BLE_HOST_COUNT; i++)
+        {
+            BLE_HID_SetHost(i, (KBD_GetBleHost(i, &host) == 0) ? &host : NULL);
+        }
+        BLE_HID_SetActiveHost(KBD_GetBleHostActive());
         ret = BLE_HID_Init(&g_ble_callbacks);
         if (ret != 0)
         {
@@ -145,7 +168,8 @@ void KBD_Mode_Process(void)
     /* USB 模式：轮询枚举状态，枚举完成后才置 CONNECTED */
     if (g_current_mode == KBD_WORK_MODE_USB)
     {
-        bool usb_configured = (g_USB_DeviceState == USB_STATE_CONFIGURED);
+        /* 主机挂起不算断开：挂起期间的报告由 usb_hid 缓冲，恢复后发出 */
+        bool usb_configured = USB_Device_IsConfigured();
         bool is_connected = (g_conn_state == KBD_CONN_CONNECTED);
 
         if (usb_configured && !is_connected)
@@ -156,6 +180,9 @@ void KBD_Mode_Process(void)
         {
             KBD_Mode_UpdateConnState(KBD_CONN_DISCONNECTED);
         }
+
+        /* 恢复事件之外的兜底：总线复位后重新枚举、端点忙超时 */
+        USB_HID_FlushPending();
     }
 
     if (g_pm_state == KBD_PM_LIGHT)
@@ -163,9 +190,9 @@ void KBD_Mode_Process(void)
         uint32_t deep_timeout_ms = KBD_Mode_GetDeepSleepTimeoutMs();
 
         /*
-         * LIGHT 期间由我们主动执行 CPU idle。
-         * 这里不能依赖 BLE idleCB 自动 Sleep，否则会在 RGB 活跃期打断 TMR1/DMA，
-         * 导致 WS2812 上电阶段闪烁。
+         * LIGHT 期间 CPU 暂停 / RTC Sleep 由 TMOS idleCB (kbd_idle) 执行；
+         * 它在 RGB 供电时只做 CPU 暂停，不会打断 TMR1/DMA。
+         * 本函数只在唤醒请求或模式任务定时 (含 DEEP 超时时刻) 到达时运行。
          */
         if (g_wake_requested || !KBD_Mode_CanEnterLowPower())
         {
@@ -181,14 +208,6 @@ void KBD_Mode_Process(void)
             /* 不返回（Shutdown 后唤醒等价复位） */
         }
 
-        if ((deep_timeout_ms > 0u) &&
-            KBD_Mode_IsDeepSleepCheckDue() &&
-            KBD_Mode_CanEnterDeepSleep())
-        {
-            KBD_Mode_EnterDeepSleep();
-        }
-
-        LowPower_Idle();
         return;
     }
 
@@ -215,7 +234,17 @@ void KBD_Mode_RecordActivity(void)
 
 void KBD_Mode_RequestWake(void)
 {
+    /* 在唤醒中断里打点: 模式任务退出 LIGHT 时唤醒键可能已被核心任务处理 */
+    if (g_pm_state == KBD_PM_LIGHT && !g_wake_requested)
+    {
+        KBD_Boot_OnWake();
+    }
     g_wake_requested = true;
+    if (g_current_mode == KBD_WORK_MODE_BLE)
+    {
+        BLE_HID_MarkWake();
+    }
+    KBD_Idle_SetEvent(g_mode_task_id, MODE_PROCESS_EVT);
 }
 
 /*============================================================================*/
@@ -279,6 +308,16 @@ bool KBD_Mode_IsConnected(void)
     return (g_conn_state == KBD_CONN_CONNECTED);
 }
 
+/**
+ * @brief 是否把报告交给当前通道
+ *
+ * BLE 未连接 / 未加密时报告由 ble_hid 缓冲，重连加密后补发；USB 未就绪时直接丢弃。
+ */
+static bool KBD_Mode_CanSend(void)
+{
+    return (g_current_mode == KBD_WORK_MODE_BLE) || KBD_Mode_IsConnected();
+}
+
 static void KBD_Mode_UpdateConnState(kbd_conn_state_t state)
 {
     if (state == g_conn_state)
@@ -290,10 +329,8 @@ static void KBD_Mode_UpdateConnState(kbd_conn_state_t state)
     g_last_activity_tick = KBD_Mode_GetNow();
     LOG_D(TAG, "conn state=%d", state);
 
-    if (g_pm_state == KBD_PM_LIGHT)
-    {
-        KBD_Mode_ArmDeepSleepCheck();
-    }
+    /* 立即刷新指示灯，并按新的空闲起点重排 DEEP 超时 */
+    KBD_Idle_SetEvent(g_mode_task_id, MODE_PROCESS_EVT);
 
     if (g_pCallbacks && g_pCallbacks->onConnStateChange)
     {
@@ -354,6 +391,7 @@ int KBD_Mode_BLE_ClearBonds(void)
      */
     KBD_Mode_UpdateConnState(KBD_CONN_DISCONNECTED);
     KBD_SetLastMode(1);
+    KBD_ClearBleHosts();
     KBD_Storage_FlushRuntime();
     mDelaymS(BLE_BOND_CLEAR_SETTLE_MS);
     SYS_ResetExecute();
@@ -366,6 +404,27 @@ uint8_t KBD_Mode_BLE_GetBondCount(void)
     return BLE_HID_GetBondCount();
 }
 
+int KBD_Mode_BLE_SelectHost(uint8_t idx)
+{
+    if (g_mode_switching || g_current_mode != KBD_WORK_MODE_BLE)
+    {
+        return -1;
+    }
+
+    if (BLE_HID_SelectHost(idx) != 0)
+    {
+        return -1;
+    }
+
+    KBD_SetBleHostActive(idx);
+    return 0;
+}
+
+uint8_t KBD_Mode_BLE_GetHost(void)
+{
+    return KBD_GetBleHostActive();
+}
+
 /*============================================================================*/
 /* USB 控制实现 */
 /*============================================================================*/
@@ -385,6 +444,11 @@ int KBD_Mode_USB_Wakeup(void)
     return 0;
 }
 
+void KBD_Mode_USB_NotifyResume(void)
+{
+    KBD_Idle_SetEvent(g_mode_task_id, MODE_USB_RESUME_EVT);
+}
+
 /*============================================================================*/
 /* HID 报告发送实现 */
 /*============================================================================*/
@@ -407,7 +471,7 @@ static uint8_t KBD_Mode_ApplyOsModeModifier(uint8_t modifier)
 
 int KBD_Mode_SendKeyboardReport(uint8_t modifier, uint8_t *keys, uint8_t key_count)
 {
-    if (!KBD_Mode_IsConnected())
+    if (!KBD_Mode_CanSend())
     {
         return -1;
     }
@@ -464,9 +528,12 @@ int KBD_Mode_ReleaseAllKeys(void)
     }
 }
 
-int KBD_Mode_SendMouseReport(uint8_t buttons, int8_t x, int8_t y, int8_t wheel)
+/**
+ * @brief 发送鼠标报告 (wheel / pan 为主机端滚动单位)
+ */
+static int KBD_Mode_SendMouseRaw(uint8_t buttons, int8_t x, int8_t y, int8_t wheel, int8_t pan)
 {
-    if (!KBD_Mode_IsConnected())
+    if (!KBD_Mode_CanSend())
     {
         return -1;
     }
@@ -479,19 +546,55 @@ int KBD_Mode_SendMouseReport(uint8_t buttons, int8_t x, int8_t y, int8_t wheel)
         {
             USB_Mouse_Press(buttons);
         }
-        if (x != 0 || y != 0 || wheel != 0)
+        if (x != 0 || y != 0 || wheel != 0 || pan != 0)
         {
-            USB_Mouse_Move(x, y, wheel);
+            USB_Mouse_Move(x, y, wheel, pan);
         }
         g_mouse_report[0] = buttons;
         return 0;
     }
     else
     {
-        return BLE_HID_SendMouseReport(buttons, x, y, wheel);
+        return BLE_HID_SendMouseReport(buttons, x, y, wheel, pan);
     }
 }
 
+/**
+ * @brief 按格数换算为当前分辨率下的滚动单位 (饱和到 int8)
+ */
+static int8_t KBD_Mode_ScaleNotches(int8_t notches, uint8_t mult)
+{
+    int16_t units = (int16_t)notches * mult;
+
+    if (units > 127)
+        return 127;
+    if (units < -127)
+        return -127;
+    return (int8_t)units;
+}
+
+void KBD_Mode_GetScrollResolution(uint8_t *wheel, uint8_t *pan)
+{
+    uint8_t feature = (g_current_mode == KBD_WORK_MODE_USB) ? g_MouseFeature : BLE_HID_GetMouseFeature();
+
+    *wheel = (feature & KBD_HID_SCROLL_FEATURE_WHEEL) ? KBD_HID_SCROLL_HIRES_MULT : 1;
+    *pan = (feature & KBD_HID_SCROLL_FEATURE_PAN) ? KBD_HID_SCROLL_HIRES_MULT : 1;
+}
+
+int KBD_Mode_SendMouseReport(uint8_t buttons, int8_t x, int8_t y, int8_t wheel)
+{
+    uint8_t wheel_mult, pan_mult;
+
+    /* 按格数的滚轮在高分辨率下换算，保持每格滚动距离不变 */
+    KBD_Mode_GetScrollResolution(&wheel_mult, &pan_mult);
+    return KBD_Mode_SendMouseRaw(buttons, x, y, KBD_Mode_ScaleNotches(wheel, wheel_mult), 0);
+}
+
+int KBD_Mode_SendMouseScroll(uint8_t buttons, int8_t wheel, int8_t pan)
+{
+    return KBD_Mode_SendMouseRaw(buttons, 0, 0, wheel, pan);
+}
+
 int KBD_Mode_SendMouseClick(uint8_t buttons)
 {
     int ret;
@@ -507,7 +610,7 @@ int KBD_Mode_SendMouseClick(uint8_t buttons)
 
 int KBD_Mode_SendConsumerReport(uint16_t key)
 {
-    if (!KBD_Mode_IsConnected())
+    if (!KBD_Mode_CanSend())
     {
         return -1;
     }
@@ -545,6 +648,30 @@ int KBD_Mode_SendConsumerKey(uint16_t key)
     return KBD_Mode_SendConsumerReport(0);
 }
 
+void KBD_Mode_SetTxBurst(bool enable)
+{
+    /* 不区分模式：回放途中切到 USB 也要撤销请求 */
+    BLE_HID_SetTxBurst(enable);
+}
+
+bool KBD_Mode_PostAfterRadioEvent(uint8_t task_id, uint16_t event)
+{
+    if (g_current_mode != KBD_WORK_MODE_BLE)
+    {
+        return false;
+    }
+    return BLE_HID_PostAfterConnEvent(task_id, event);
+}
+
+bool KBD_Mode_TxBusy(void)
+{
+    if (g_current_mode != KBD_WORK_MODE_BLE)
+    {
+        return false;
+    }
+    return BLE_HID_TxBusy();
+}
+
 /*============================================================================*/
 /* 低功耗实现 */
 /*============================================================================*/
@@ -628,11 +755,12 @@ static void KBD_Mode_EnterLightSleep(void)
 
     KBD_Mode_ReleaseAllKeys();
     KBD_Storage_FlushRuntime(); /* 强制落盘 runtime 热数据，防断电丢失 */
+    KBD_Log_SystemEvent(KBD_LOG_SYS_SLEEP);
+    KBD_BlackBox_Flush(KBD_BLACKBOX_REASON_SLEEP);
     KBD_RGB_SetSchedulerEnabled(false);
     KBD_RGB_SetLowPower(true); /* 内部 WS2812_Sleep() 切断 LED 电源 + 数据脚高阻 */
     KBD_Battery_Suspend();     /* 关闭 VBAT 分压 + 停止周期性采样 */
     Key_EnterSleep();          /* 停 TMR0，保留 GPIO 中断作为按键唤醒源 */
-    KBD_Mode_ArmDeepSleepCheck();
 }
 
 static void KBD_Mode_ExitLightSleep(void)
@@ -643,8 +771,8 @@ static void KBD_Mode_ExitLightSleep(void)
     g_pm_state = KBD_PM_ACTIVE;
     g_wake_requested = false;
     LOG_I(TAG, "exit LIGHT");
+    KBD_Log_SystemEvent(KBD_LOG_SYS_WAKEUP);
 
-    KBD_Mode_CancelDeepSleepCheck();
     Key_ExitSleep();
     KBD_Battery_Resume();
     KBD_RGB_SetLowPower(false);
@@ -669,7 +797,6 @@ static void KBD_Mode_EnterDeepSleep(void)
     LOG_I(TAG, "enter DEEP (shutdown)");
     g_pm_state = KBD_PM_DEEP;
     g_wake_requested = false;
-    KBD_Mode_CancelDeepSleepCheck();
 
     /* BLE 模式下先主动断开并抑制自动恢复广播，再执行深睡。 */
     if (g_current_mode == KBD_WORK_MODE_BLE)
@@ -682,11 +809,14 @@ static void KBD_Mode_EnterDeepSleep(void)
 
     /* 持久化（Shutdown 之后 RAM 不保留） */
     KBD_Storage_FlushRuntime();
+    KBD_Log_SystemEvent(KBD_LOG_SYS_SLEEP);
+    KBD_BlackBox_Flush(KBD_BLACKBOX_REASON_SHUTDOWN);
 
     /* 配置按键低电平作为 GPIO 唤醒源 */
     Key_ConfigDeepSleepWakeup();
 
     /* 确保 Flash / 日志等写操作落盘 */
+    Debug_Flush();
     mDelaymS(5);
 
     LowPower_Shutdown(0);
@@ -744,6 +874,12 @@ static void KBD_Mode_BLE_StateCallback(gapRole_States_t newState)
     }
 }
 
+static void KBD_Mode_BLE_HostCallback(uint8_t idx, const kbd_ble_host_t *host)
+{
+    KBD_SetBleHost(idx, host);
+    KBD_Storage_DeferRuntimeSave(5000); /* 加密后主机还在做服务发现，推迟 Flash 写入 */
+}
+
 static void KBD_Mode_BLE_LedCallback(uint8_t leds)
 {
     g_keyboard_leds = leds;
@@ -807,54 +943,59 @@ static uint32_t KBD_Mode_GetDeepSleepTimeoutMs(void)
     return ((uint32_t)sys->auto_sleep_min + (uint32_t)sys->deep_sleep_min) * 60000u;
 }
 
-static void KBD_Mode_CancelDeepSleepCheck(void)
-{
-    RTC_ModeFunDisable(RTC_TRIG_MODE);
-    RTC_ClearITFlag(RTC_TRIG_EVENT);
-    RTCTigFlag = 0;
-    PWR_PeriphWakeUpCfg(DISABLE, RB_SLP_RTC_WAKE, Long_Delay);
-}
-
-static void KBD_Mode_ArmDeepSleepCheck(void)
+static uint16_t KBD_Mode_ProcessEvent(uint8_t task_id, uint16_t events)
 {
-    uint32_t deep_timeout_ms = KBD_Mode_GetDeepSleepTimeoutMs();
-    uint32_t idle_ms = KBD_Mode_GetIdleMs();
-    uint32_t remain_ms;
-    uint32_t rtc_cycles;
-
-    if (deep_timeout_ms == 0u)
+    if (events & MODE_PROCESS_EVT)
     {
-        KBD_Mode_CancelDeepSleepCheck();
-        return;
+        KBD_Mode_Process();
+        KBD_Mode_ScheduleProcess(task_id);
+        return (events ^ MODE_PROCESS_EVT);
     }
 
-    remain_ms = (idle_ms >= deep_timeout_ms)
-                    ? 1u
-                    : (deep_timeout_ms - idle_ms);
-    rtc_cycles = (uint32_t)(((uint64_t)remain_ms * KBD_RTC_FREQ_HZ + 999u) / 1000u);
-
-    if (rtc_cycles == 0u)
+    if (events & MODE_USB_RESUME_EVT)
     {
-        rtc_cycles = 1u;
+        USB_HID_FlushPending();
+        return (events ^ MODE_USB_RESUME_EVT);
     }
 
-    KBD_Mode_CancelDeepSleepCheck();
-    PWR_PeriphWakeUpCfg(ENABLE, RB_SLP_RTC_WAKE, Long_Delay);
-    PFIC_EnableIRQ(RTC_IRQn);
-    RTCTigFlag = 0;
-    RTC_TRIGFunCfg(rtc_cycles);
+    return 0;
 }
 
-static bool KBD_Mode_IsDeepSleepCheckDue(void)
+/**
+ * @brief 按当前状态安排下一次自检
+ *
+ * LIGHT 期间取轮询周期与 DEEP 超时剩余时间的较小值，
+ * TMOS 定时器本身就是 idle 钩子的唤醒时刻。
+ */
+static void KBD_Mode_ScheduleProcess(uint8_t task_id)
 {
-    if (RTCTigFlag == 0)
+    uint32_t delay_ms;
+
+    if (g_pm_state == KBD_PM_LIGHT)
     {
-        return false;
+        uint32_t deep_timeout_ms = KBD_Mode_GetDeepSleepTimeoutMs();
+        uint32_t idle_ms = KBD_Mode_GetIdleMs();
+
+        delay_ms = KBD_MODE_LIGHT_POLL_MS;
+        if (deep_timeout_ms > 0u)
+        {
+            uint32_t remain_ms = (idle_ms >= deep_timeout_ms) ? 1u : (deep_timeout_ms - idle_ms);
+            if (remain_ms < delay_ms)
+            {
+                delay_ms = remain_ms;
+            }
+        }
+    }
+    else if (g_current_mode == KBD_WORK_MODE_USB)
+    {
+        delay_ms = KBD_MODE_USB_POLL_MS;
+    }
+    else
+    {
+        delay_ms = KBD_MODE_ACTIVE_POLL_MS;
     }
 
-    RTCTigFlag = 0;
-    RTC_ClearITFlag(RTC_TRIG_EVENT);
-    return true;
+    tmos_start_task(task_id, MODE_PROCESS_EVT, MS1_TO_SYSTEM_TIME(delay_ms));
 }
 
 static bool KBD_Mode_USB_HasProtocolHandshake(void)
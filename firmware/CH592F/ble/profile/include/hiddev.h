@@ -43,6 +43,10 @@ extern "C" {
 #define HID_DEV_EXIT_SUSPEND_EVT          1     // HID exit suspend
 #define HID_DEV_SET_BOOT_EVT              2     // HID set boot mode
 #define HID_DEV_SET_REPORT_EVT            3     // HID set report mode
+#define HID_DEV_CONN_SECURE_EVT           4     // Link encrypted, reports can be sent
+#define HID_DEV_CONN_PARAM_EVT            5     // Connection parameters updated
+#define HID_DEV_LINK_UPDATE_EVT           6     // ATT MTU or PHY updated
+#define HID_DEV_RSSI_EVT                  7     // RSSI read complete
 
 /* HID Report type */
 #define HID_REPORT_TYPE_INPUT             1
@@ -345,6 +349,50 @@ extern void HidDev_RegisterReports(uint8_t numReports, hidRptMap_t *pRpt);
  */
 extern uint8_t HidDev_Report(uint8_t id, uint8_t type, uint8_t len, uint8_t *pData);
 
+/*********************************************************************
+ * @fn      HidDev_IsSecure
+ *
+ * @brief   Whether the current connection is encrypted.
+ *
+ * @return  TRUE if connected and secure, FALSE otherwise.
+ */
+extern uint8_t HidDev_IsSecure(void);
+
+/*********************************************************************
+ * @fn      HidDev_GetConnParams
+ *
+ * @brief   Get the connection parameters currently in effect.
+ *
+ * @param   pInterval - connection interval (1.25ms units)
+ *          pLatency - slave latency
+ *          pTimeout - supervision timeout (10ms units)
+ *
+ * @return  none
+ */
+extern void HidDev_GetConnParams(uint16_t *pInterval, uint16_t *pLatency, uint16_t *pTimeout);
+
+/*********************************************************************
+ * @fn      HidDev_GetLinkInfo
+ *
+ * @brief   Get the ATT MTU and PHY of the current connection.
+ *
+ * @param   pMtu - ATT MTU (ATT_MTU_SIZE when not connected)
+ *          pTxPhy - TX PHY (GAP_PHY_VAL_TYPE)
+ *          pRxPhy - RX PHY (GAP_PHY_VAL_TYPE)
+ *
+ * @return  none
+ */
+extern void HidDev_GetLinkInfo(uint16_t *pMtu, uint8_t *pTxPhy, uint8_t *pRxPhy);
+
+/*********************************************************************
+ * @fn      HidDev_GetRssi
+ *
+ * @brief   Get the RSSI of the last GAPRole_ReadRssiCmd() on this link.
+ *
+ * @return  RSSI in dBm, 127 if none has been read yet.
+ */
+extern int8_t HidDev_GetRssi(void);
+
 /*********************************************************************
  * @fn      HidDev_Close
  *
@@ -84,6 +84,18 @@ static uint8_t hidDevConnSecure = FALSE;
 // GAP connection handle
 static uint16_t gapConnHandle;
 
+// Connection parameters in effect (from link establishment or last update)
+static uint16_t hidDevConnInterval = 0;
+static uint16_t hidDevConnLatency = 0;
+static uint16_t hidDevConnTimeout = 0;
+
+// PHY in effect (1M until a PHY update completes)
+static uint8_t hidDevTxPhy = GAP_PHY_VAL_LE_1M;
+static uint8_t hidDevRxPhy = GAP_PHY_VAL_LE_1M;
+
+// Last RSSI read from the controller (127 = not available)
+static int8_t hidDevRssi = 127;
+
 // Status of last pairing
 static uint8_t pairingStatus = SUCCESS;
 
@@ -106,6 +118,7 @@ static void hidDevDisconnected(void);
 static void hidDevGapStateCB(gapRole_States_t newState, gapRoleEvent_t *pEvent);
 static void hidDevParamUpdateCB(uint16_t connHandle, uint16_t connInterval,
                                 uint16_t connSlaveLatency, uint16_t connTimeout);
+static void hidDevRssiReadCB(uint16_t connHandle, int8_t newRSSI);
 static void hidDevPairStateCB(uint16_t connHandle, uint8_t state, uint8_t status);
 static void hidDevPasscodeCB(uint8_t *deviceAddr, uint16_t connectionHandle,
                              uint8_t uiInputs, uint8_t uiOutputs);
@@ -124,6 +137,7 @@ static void    hidDevInitialAdvertising(void);
 static uint8_t hidDevBondCount(void);
 static uint8_t HidDev_sendNoti(uint16_t handle, uint8_t len, uint8_t *pData);
 static uint8_t hidDevIsConnectedState(gapRole_States_t state);
+static void    hidDevSecureNotify(void);
 /*********************************************************************
  * PROFILE CALLBACKS
  */
@@ -131,7 +145,7 @@ static uint8_t hidDevIsConnectedState(gapRole_States_t state);
 // GAP Role Callbacks
 static gapRolesCBs_t hidDev_PeripheralCBs = {
     hidDevGapStateCB, // Profile State Change Callbacks
-    NULL,             // When a valid RSSI is read from controller
+    hidDevRssiReadCB, // When a valid RSSI is read from controller
     hidDevParamUpdateCB
 };
 
@@ -318,6 +332,66 @@ uint8_t HidDev_Report(uint8_t id, uint8_t type, uint8_t len, uint8_t *pData)
     return bleNotReady;
 }
 
+/*********************************************************************
+ * @fn      HidDev_IsSecure
+ *
+ * @brief   Whether the current connection is encrypted.
+ *
+ * @return  TRUE if connected and secure, FALSE otherwise.
+ */
+uint8_t HidDev_IsSecure(void)
+{
+    return (hidDevIsConnectedState(hidDevGapState) && hidDevConnSecure) ? TRUE : FALSE;
+}
+
+/*********************************************************************
+ * @fn      HidDev_GetConnParams
+ *
+ * @brief   Get the connection parameters currently in effect.
+ *
+ * @param   pInterval - connection interval (1.25ms units)
+ *          pLatency - slave latency
+ *          pTimeout - supervision timeout (10ms units)
+ *
+ * @return  none
+ */
+void HidDev_GetConnParams(uint16_t *pInterval, uint16_t *pLatency, uint16_t *pTimeout)
+{
+    *pInterval = hidDevConnInterval;
+    *pLatency = hidDevConnLatency;
+    *pTimeout = hidDevConnTimeout;
+}
+
+/*********************************************************************
+ * @fn      HidDev_GetLinkInfo
+ *
+ * @brief   Get the ATT MTU and PHY of the current connection.
+ *
+ * @param   pMtu - ATT MTU (ATT_MTU_SIZE when not connected)
+ *          pTxPhy - TX PHY (GAP_PHY_VAL_TYPE)
+ *          pRxPhy - RX PHY (GAP_PHY_VAL_TYPE)
+ *
+ * @return  none
+ */
+void HidDev_GetLinkInfo(uint16_t *pMtu, uint8_t *pTxPhy, uint8_t *pRxPhy)
+{
+    *pMtu = hidDevIsConnectedState(hidDevGapState) ? ATT_GetMTU(gapConnHandle) : ATT_MTU_SIZE;
+    *pTxPhy = hidDevTxPhy;
+    *pRxPhy = hidDevRxPhy;
+}
+
+/*********************************************************************
+ * @fn      HidDev_GetRssi
+ *
+ * @brief   Get the RSSI of the last GAPRole_ReadRssiCmd() on this link.
+ *
+ * @return  RSSI in dBm, 127 if none has been read yet.
+ */
+int8_t HidDev_GetRssi(void)
+{
+    return hidDevRssi;
+}
+
 /*********************************************************************
  * @fn      HidDev_Close
  *
@@ -659,6 +733,17 @@ static void hidDev_ProcessTMOSMsg(tmos_event_hdr_t *pMsg)
  */
 static void hidDevProcessGattMsg(gattMsgEvent_t *pMsg)
 {
+    if(pMsg->method == ATT_MTU_UPDATED_EVENT)
+    {
+        PRINT("MTU update %d\n", pMsg->msg.mtuEvt.MTU);
+
+        if(pHidDevCB && pHidDevCB->evtCB)
+        {
+            (*pHidDevCB->evtCB)(HID_DEV_LINK_UPDATE_EVT);
+        }
+    }
+
+    GATT_bm_free(&pMsg->msg, pMsg->method);
 }
 
 /*********************************************************************
@@ -686,6 +771,13 @@ static void hidDevProcessGAPMsg(gapRoleEvent_t *pEvent)
         case GAP_PHY_UPDATE_EVENT:
         {
             PRINT("Phy update Rx:%x Tx:%x ..\n", pEvent->linkPhyUpdate.connRxPHYS, pEvent->linkPhyUpdate.connTxPHYS);
+            hidDevTxPhy = pEvent->linkPhyUpdate.connTxPHYS;
+            hidDevRxPhy = pEvent->linkPhyUpdate.connRxPHYS;
+
+            if(pHidDevCB && pHidDevCB->evtCB)
+            {
+                (*pHidDevCB->evtCB)(HID_DEV_LINK_UPDATE_EVT);
+            }
             break;
         }
         default:
@@ -781,8 +873,17 @@ static void hidDevGapStateCB(gapRole_States_t newState, gapRoleEvent_t *pEvent)
 
             // get connection handle
             gapConnHandle = event->connectionHandle;
+
+            hidDevConnInterval = event->connInterval;
+            hidDevConnLatency = event->connLatency;
+            hidDevConnTimeout = event->connTimeout;
         }
 
+        // new links always start on 1M
+        hidDevTxPhy = GAP_PHY_VAL_LE_1M;
+        hidDevRxPhy = GAP_PHY_VAL_LE_1M;
+        hidDevRssi = 127;
+
         // connection not secure yet
         hidDevConnSecure = FALSE;
 
@@ -824,6 +925,21 @@ static uint8_t hidDevIsConnectedState(gapRole_States_t state)
     return ((roleState == GAPROLE_CONNECTED) || (roleState == GAPROLE_CONNECTED_ADV));
 }
 
+/*********************************************************************
+ * @fn      hidDevSecureNotify
+ *
+ * @brief   Tell the application the link is now encrypted.
+ *
+ * @return  none
+ */
+static void hidDevSecureNotify(void)
+{
+    if(pHidDevCB && pHidDevCB->evtCB)
+    {
+        (*pHidDevCB->evtCB)(HID_DEV_CONN_SECURE_EVT);
+    }
+}
+
 /*********************************************************************
  * @fn      hidDevParamUpdateCB
  *
@@ -840,6 +956,35 @@ static void hidDevParamUpdateCB(uint16_t connHandle, uint16_t connInterval,
                                 uint16_t connSlaveLatency, uint16_t connTimeout)
 {
     PRINT("Update %d - Int 0x%x - Latency %d\n", connHandle, connInterval, connSlaveLatency);
+
+    hidDevConnInterval = connInterval;
+    hidDevConnLatency = connSlaveLatency;
+    hidDevConnTimeout = connTimeout;
+
+    if(pHidDevCB && pHidDevCB->evtCB)
+    {
+        (*pHidDevCB->evtCB)(HID_DEV_CONN_PARAM_EVT);
+    }
+}
+
+/*********************************************************************
+ * @fn      hidDevRssiReadCB
+ *
+ * @brief   RSSI read complete callback
+ *
+ * @param   connHandle - connect handle
+ *          newRSSI - RSSI in dBm
+ *
+ * @return  none
+ */
+static void hidDevRssiReadCB(uint16_t connHandle, int8_t newRSSI)
+{
+    hidDevRssi = newRSSI;
+
+    if(pHidDevCB && pHidDevCB->evtCB)
+    {
+        (*pHidDevCB->evtCB)(HID_DEV_RSSI_EVT);
+    }
 }
 
 /*********************************************************************
@@ -858,6 +1003,7 @@ static void hidDevPairStateCB(uint16_t connHandle, uint8_t state, uint8_t status
         if(status == SUCCESS)
         {
             hidDevConnSecure = TRUE;
+            hidDevSecureNotify();
         }
 
         pairingStatus = status;
@@ -867,6 +1013,7 @@ static void hidDevPairStateCB(uint16_t connHandle, uint8_t state, uint8_t status
         if(status == SUCCESS)
         {
             hidDevConnSecure = TRUE;
+            hidDevSecureNotify();
 
 #if DEFAULT_SCAN_PARAM_NOTIFY_TEST == TRUE
             ScanParam_RefreshNotify(gapConnHandle);
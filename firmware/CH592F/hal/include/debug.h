@@ -29,6 +29,54 @@ extern "C" {
 
 #define DEBUG_UART1_BAUDRATE    115200
 
+/**
+ * UART 日志异步发送
+ *
+ * LOG_x 只把整条日志 (文本行或令牌帧) 放进发送环形缓冲区，由 UART1 发送空中断
+ * 逐字节填入硬件 FIFO，调用方不等串口。缓冲区放不下时整条丢弃并计数，
+ * 下一条能放下的日志之前插入 "N messages dropped" 提示。
+ * 复位 / 异常 / 掉电前用 Debug_Flush 同步发完；缓冲区非空时空闲只做 CPU 暂停，
+ * 不进入 RTC Sleep。
+ * debug.c 覆盖 SDK 的 _write，printf / PRINT (含 BLE 库) 同样经发送环输出。
+ */
+#ifndef KBD_LOG_LINE_MAX
+#define KBD_LOG_LINE_MAX        80      /**< 文本日志单行最大长度 (含换行) */
+#endif
+
+/*
+ * 行缓冲在 Log_Output 调用方的栈上，中断里的 LOG_x 也走这条路径，与主循环共用
+ * 2KB 栈 (链接脚本 __stack_size)。调大前先用 console.py mem 确认栈高水位余量。
+ */
+#if KBD_LOG_LINE_MAX > 128
+#error "KBD_LOG_LINE_MAX lives on the shared 2KB stack; keep it at 128 or below."
+#endif
+
+/**
+ * 令牌化日志 (Tokenized Logging)
+ *
+ * 开启后 LOG_x 不再在设备端格式化字符串：格式串被放入不加载的 ELF 段
+ * .kbd_logstr，设备只发送 "段内偏移 (token) + 原始 32 位参数"，
+ * 与文本日志共用发送环形缓冲区。
+ * 构建后由 tools/scripts/log_tokens.py 从 ELF 提取字典并在主机端解码。
+ *
+ * @note 参数按 32 位整数传递：%s 只能得到指针值，不支持 double / 64 位参数。
+ */
+#ifndef KBD_LOG_TOKENIZED
+#define KBD_LOG_TOKENIZED       0
+#endif
+
+#define KBD_LOG_TOKEN_SYNC      0xA5    /**< 帧同步字节 (UTF-8 文本中也可能出现，靠 CRC 区分) */
+#define KBD_LOG_TOKEN_MAX_ARGS  6       /**< 单条日志最大参数个数 */
+#define KBD_LOG_TOKEN_FRAME_MAX (5 + KBD_LOG_TOKEN_MAX_ARGS * 4) /**< 令牌帧最大长度 */
+
+#ifndef KBD_LOG_TX_RING_SIZE
+#if KBD_LOG_TOKENIZED
+#define KBD_LOG_TX_RING_SIZE    256     /**< UART 发送环形缓冲区大小 (2 的幂) */
+#else
+#define KBD_LOG_TX_RING_SIZE    1024    /**< 文本日志约 100ms 的输出量 (115200bps) */
+#endif
+#endif
+
 /* 日志级别 */
 #define LOG_LEVEL_NONE    0
 #define LOG_LEVEL_ERROR   1
@@ -49,34 +97,84 @@ extern "C" {
 void Debug_Init(void);
 
 /**
- * @brief  底层日志输出
+ * @brief  同步发完发送缓冲区与硬件 FIFO (关中断忙等)
+ * @note   用于 HardFault、软复位、掉电前；中断上下文可调用
+ */
+void Debug_Flush(void);
+
+/**
+ * @brief  发送缓冲区是否还有数据 (空闲钩子据此不进入 RTC Sleep)
+ */
+uint8_t Debug_TxBusy(void);
+
+/**
+ * @brief  缓冲区满被整条丢弃的日志累计数
+ */
+uint32_t Debug_GetDropped(void);
+
+/**
+ * @brief  底层日志输出 (格式化后整行入队，不等串口)
  */
 void Log_Output(const char *level, const char *tag, const char *fmt, ...);
 
+/**
+ * @brief  令牌化日志输出 (仅 KBD_LOG_TOKENIZED 使用，由 LOG_x 宏调用)
+ *
+ * 帧格式: [0xA5][token_lo][token_hi][nargs][arg0 LE32]...[argN LE32][crc8]
+ * crc8 为 CRC-8 (多项式 0x07，初值 0)，覆盖 token 至最后一个参数；
+ * 主机端同时校验 nargs 与 CRC，文本 (Log_Output / printf) 中的 0xA5 不会被误认成帧头。
+ * 环形缓冲区空间不足时整帧丢弃，不阻塞调用方。
+ *
+ * @param token  格式串在 .kbd_logstr 段内的偏移
+ * @param nargs  参数个数 (<= KBD_LOG_TOKEN_MAX_ARGS)
+ */
+void Log_Token(uint16_t token, uint8_t nargs, ...);
+
 /* ======================= 日志宏 ======================= */
 
 #ifdef DEBUG
 
+#if KBD_LOG_TOKENIZED
+
+/* 参数计数 (0 ~ KBD_LOG_TOKEN_MAX_ARGS)，依赖 GNU ##__VA_ARGS__ */
+#define LOG_NARGS(...)  LOG_NARGS_(0, ##__VA_ARGS__, 6, 5, 4, 3, 2, 1, 0)
+#define LOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, N, ...)  N
+
+/* 字典条目: "L|TAG|fmt"，tag 必须是字符串字面量 (各模块的 TAG 宏) */
+#define LOG_TOKEN(level, tag, fmt, ...)                                        \
+    do {                                                                       \
+        static const char _log_fmt[]                                           \
+            __attribute__((section(".kbd_logstr"), used)) =                    \
+                level "|" tag "|" fmt;                                         \
+        Log_Token((uint16_t)(uintptr_t)_log_fmt, LOG_NARGS(__VA_ARGS__),       \
+                  ##__VA_ARGS__);                                              \
+    } while (0)
+
+#define LOG_EMIT(level, tag, fmt, ...)  LOG_TOKEN(level, tag, fmt, ##__VA_ARGS__)
+#else
+#define LOG_EMIT(level, tag, fmt, ...)  Log_Output(level, tag, fmt, ##__VA_ARGS__)
+#endif /* KBD_LOG_TOKENIZED */
+
 #if LOG_LEVEL >= LOG_LEVEL_ERROR
-#define LOG_E(tag, fmt, ...)  Log_Output("E", tag, fmt, ##__VA_ARGS__)
+#define LOG_E(tag, fmt, ...)  LOG_EMIT("E", tag, fmt, ##__VA_ARGS__)
 #else
 #define LOG_E(tag, fmt, ...)
 #endif
 
 #if LOG_LEVEL >= LOG_LEVEL_WARN
-#define LOG_W(tag, fmt, ...)  Log_Output("W", tag, fmt, ##__VA_ARGS__)
+#define LOG_W(tag, fmt, ...)  LOG_EMIT("W", tag, fmt, ##__VA_ARGS__)
 #else
 #define LOG_W(tag, fmt, ...)
 #endif
 
 #if LOG_LEVEL >= LOG_LEVEL_INFO
-#define LOG_I(tag, fmt, ...)  Log_Output("I", tag, fmt, ##__VA_ARGS__)
+#define LOG_I(tag, fmt, ...)  LOG_EMIT("I", tag, fmt, ##__VA_ARGS__)
 #else
 #define LOG_I(tag, fmt, ...)
 #endif
 
 #if LOG_LEVEL >= LOG_LEVEL_DEBUG
-#define LOG_D(tag, fmt, ...)  Log_Output("D", tag, fmt, ##__VA_ARGS__)
+#define LOG_D(tag, fmt, ...)  LOG_EMIT("D", tag, fmt, ##__VA_ARGS__)
 #else
 #define LOG_D(tag, fmt, ...)
 #endif
@@ -7,13 +7,48 @@
 extern "C" {
 #endif
 
+/**
+ * 旋转编码器 (KBD_HAS_ENCODER)
+ *
+ * - A/B 双沿中断 + 状态表解码，每 ENCODER_EDGES_PER_DETENT 个有效跳变为一个定位 (detent)
+ * - 定位与跳变按方向累加为带符号计数，不逐个入队；主机启用高分辨率滚轮时
+ *   按跳变 (1/4 格) 上报。主机端每格单位数 KBD_HID_SCROLL_HIRES_MULT 与此相同
+ * - 有跳变时经 KBD_Input_Notify 唤醒核心任务，核心任务按上报周期调用
+ *   Encoder_TakeMotion() 取走累计量，速度与加速曲线由 kbd_core 计算
+ * - 旋钮按键仍走普通按键路径 (KBD_KNOB_CLICK_IDX)
+ */
+
+#define ENCODER_EDGES_PER_DETENT 4
+
+/**
+ * @brief 自上次取走以来的累计旋转
+ */
+typedef struct {
+  int16_t detents;  /**< 净定位数 (正=顺时针) */
+  int16_t edges;    /**< 净跳变数 (1/ENCODER_EDGES_PER_DETENT 格) */
+  uint16_t count;   /**< 跳变总数 (含换向抵消的部分，用于计算速度) */
+  uint32_t last_ms; /**< 最后一个跳变的时刻 (Key_GetTickMs) */
+} encoder_motion_t;
+
 void Encoder_Init(void);
-uint8_t Encoder_GetEvent(key_event_t *evt);
 void Encoder_HandlePortIrq(gpio_port_t port);
-void Encoder_TimerTick1ms(void);
 void Encoder_EnterSleep(void);
 void Encoder_ExitSleep(void);
 
+/**
+ * @brief 取走累计旋转并清零 (核心任务调用)
+ *
+ * @param[out] out 累计旋转
+ * @return 1 有跳变
+ * @return 0 无跳变 (out 不变)
+ */
+uint8_t Encoder_TakeMotion(encoder_motion_t *out);
+
+/**
+ * @brief 是否有尚未取走的跳变 (上报周期未到时核心任务据此安排下一次上报)
+ */
+uint8_t Encoder_HasMotion(void);
+
 #ifdef __cplusplus
 }
 #endif
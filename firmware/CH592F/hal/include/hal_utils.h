@@ -1,6 +1,8 @@
 #ifndef HAL_UTILS_H_
 #define HAL_UTILS_H_
 
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -17,6 +19,36 @@ void Hal_JumpToBootloader(void) __attribute__((noreturn));
  */
 void Hal_Reset(void) __attribute__((noreturn));
 
+/**
+ * @brief  栈涂色：用固定图案填充栈底到当前 SP 之间的未用空间
+ * @note   在 main() 最早期调用一次，之后用 Hal_Mem_GetStackPeak 查询高水位
+ */
+void Hal_Mem_PaintStack(void);
+
+/**
+ * @brief  获取栈总大小 (链接脚本 __stack_size)
+ */
+uint32_t Hal_Mem_GetStackSize(void);
+
+/**
+ * @brief  获取栈历史最大使用量 (字节)，从栈底向上扫描第一个被改写的字
+ */
+uint32_t Hal_Mem_GetStackPeak(void);
+
+/**
+ * @brief  用固定图案填充一块内存 (如 TMOS 堆 MEM_BUF，须在交给协议栈前调用)
+ * @param  buf  4 字节对齐的起始地址
+ * @param  len  字节数
+ */
+void Hal_Mem_PaintRegion(void *buf, uint32_t len);
+
+/**
+ * @brief  获取涂色区域的高水位 (从尾部向前扫描第一个被改写的字)
+ * @return 从起始地址算起曾被使用过的字节数
+ * @note   分配器若在初始化时整块清零，结果即为区域大小 (上界)
+ */
+uint32_t Hal_Mem_GetRegionPeak(const void *buf, uint32_t len);
+
 #ifdef __cplusplus
 }
 #endif
@@ -2,6 +2,7 @@
 #define KBD_BATTERY_H
 
 #include "CH59x_common.h"
+#include "kbd_config.h"
 
 /**
  * @file    kbd_battery.h
@@ -18,6 +19,9 @@
  *
  * 软件:
  * - 采样采用 TMOS 非阻塞状态机
+ * - 周期随电压斜率与充电状态在 15 秒到 4 分钟之间调整
+ * - 蓝牙连接中 ADC 转换放在连接事件结束后的射频空闲间隙
+ * - CHRG 稳定时由边沿中断唤醒，只在变化后轮询去抖
  * - 单次采样去掉极值，周期结果采用低通滤波，并复核异常大跳变
  * - 电量按单节 LiPo 电压曲线估算；充电时补偿端电压抬升且不直接报 100%
  * - 高压区经连续采样确认后锁定 100%，并通过回差避免满电百分比抖动
@@ -44,6 +48,22 @@ typedef enum {
 
 /** @} */
 
+/**
+ * @brief 采样调度统计 (KBD_CMD_BAT_STATS)
+ */
+typedef struct {
+  uint32_t period_ms;       /**< 当前周期采样间隔 */
+  int16_t slope_mv_min;     /**< 最近估算的电压斜率 (mV/min, 下降为负) */
+  uint8_t charge_irq_armed; /**< CHRG 边沿中断已打开 (未在轮询去抖) */
+  uint32_t wakeups;         /**< 电池任务事件处理次数 */
+  uint32_t samples;         /**< 接受的采样 */
+  uint32_t rejected;        /**< 丢弃的采样 */
+  uint32_t aligned;         /**< 在连接事件结束后转换的采样 */
+  uint32_t radio_timeouts;  /**< 等不到连接事件、超时后转换的采样 */
+  uint32_t charge_irqs;     /**< CHRG 边沿中断 */
+  uint32_t charge_polls;    /**< CHRG 去抖轮询 */
+} kbd_battery_stats_t;
+
 /*============================================================================*/
 /**
  * @defgroup BAT_API 电池接口
@@ -82,7 +102,7 @@ uint16_t KBD_Battery_GetAdcRaw(void);
 
 /**
  * @brief 获取滤波后的充电状态
- * @note 进入充电约延迟 300ms，退出充电约延迟 10s
+ * @note 进入充电约延迟 300ms，退出充电约延迟 10s (CHRG 边沿触发后开始计时)
  * @return kbd_charge_state_t
  */
 kbd_charge_state_t KBD_Battery_GetChargeState(void);
@@ -110,6 +130,20 @@ void KBD_Battery_Suspend(void);
  */
 void KBD_Battery_Resume(void);
 
+/**
+ * @brief GPIO 端口中断分发入口：处理 CHRG 边沿
+ * @param port 触发中断的端口
+ * @note 中断上下文调用
+ */
+void KBD_Battery_HandlePortIrq(gpio_port_t port);
+
+/**
+ * @brief 读取采样调度统计，可选读取后清零计数
+ * @param out 统计输出
+ * @param reset 非 0 时清零计数（周期与斜率不变）
+ */
+void KBD_Battery_GetStats(kbd_battery_stats_t *out, uint8_t reset);
+
 /** @} */
 
 #endif /* KBD_BATTERY_H */
@@ -214,6 +214,136 @@ typedef struct
 
 /** @} */
 
+/*============================================================================*/
+/**
+ * @defgroup KBD_Matrix 行列矩阵 (可选)
+ * @brief 大键盘使用行列矩阵扫描，直连键与矩阵键可共存
+ * @details
+ * - 行为推挽输出，列为上拉输入 (二极管方向 COL2ROW，按下时列被拉低)
+ * - 矩阵键逻辑索引 = KBD_MATRIX_KEY_BASE + row * KBD_MATRIX_COLS + col
+ * - 空闲时所有行拉低、列下降沿中断待命；有键按下时才由 TMOS 定时扫描
+ * - DataFlash 按键映射每层只有 KBD_MAX_KEYS 个位置；逻辑索引超出的矩阵键使用
+ *   KBD_MATRIX_DEFAULT_KEYMAP 给出的固定映射 (按 row * COLS + col 排列，覆盖全部矩阵位置，
+ *   只有超出部分生效)，不随层切换，上位机不能修改
+ *
+ * 启用示例 (4 × 16 = 64 键)，在机型分支中定义：
+ * @code
+ * #define KBD_HAS_MATRIX 1
+ * #define KBD_MATRIX_ROWS 4
+ * #define KBD_MATRIX_COLS 16
+ * #define KBD_MATRIX_ROW_PINS { {GPIO_PORT_B, GPIO_Pin_0}, ... }
+ * #define KBD_MATRIX_COL_PINS { {GPIO_PORT_A, GPIO_Pin_0}, ... }
+ * #define KBD_MATRIX_DEFAULT_KEYMAP { {KBD_ACTION_KEYBOARD, 0, 0x29, 0}, ... }
+ * @endcode
+ * @{
+ */
+
+/* 构建检查 (CMake 选项 KBD_MATRIX_BUILD_CHECK)：挂一个 2 × 4 测试矩阵，
+ * 让矩阵扫描和超出 KBD_MAX_KEYS 的固定映射分支参与编译；引脚不对应实际硬件 */
+#if defined(KBD_MATRIX_BUILD_CHECK) && !defined(KBD_HAS_MATRIX)
+#define KBD_HAS_MATRIX 1
+#define KBD_MATRIX_ROWS 2
+#define KBD_MATRIX_COLS 4
+#define KBD_MATRIX_ROW_PINS {{GPIO_PORT_B, GPIO_Pin_0}, {GPIO_PORT_B, GPIO_Pin_1}}
+#define KBD_MATRIX_COL_PINS \
+    {{GPIO_PORT_B, GPIO_Pin_2}, {GPIO_PORT_B, GPIO_Pin_3}, {GPIO_PORT_B, GPIO_Pin_5}, {GPIO_PORT_B, GPIO_Pin_6}}
+#define KBD_MATRIX_DEFAULT_KEYMAP                                                                  \
+    {{KBD_ACTION_KEYBOARD, 0, 0x1E, 0}, {KBD_ACTION_KEYBOARD, 0, 0x1F, 0},                         \
+     {KBD_ACTION_KEYBOARD, 0, 0x20, 0}, {KBD_ACTION_KEYBOARD, 0, 0x21, 0},                         \
+     {KBD_ACTION_KEYBOARD, 0, 0x22, 0}, {KBD_ACTION_KEYBOARD, 0, 0x23, 0},                         \
+     {KBD_ACTION_KEYBOARD, 0, 0x24, 0}, {KBD_ACTION_KEYBOARD, 0, 0x25, 0}}
+#endif
+
+#if defined(KBD_HAS_MATRIX)
+
+#include "kbd_types.h" /* KBD_MAX_KEYS */
+
+#if !defined(KBD_MATRIX_ROWS) || !defined(KBD_MATRIX_COLS) || \
+    !defined(KBD_MATRIX_ROW_PINS) || !defined(KBD_MATRIX_COL_PINS)
+#error "KBD_HAS_MATRIX requires KBD_MATRIX_ROWS/COLS and KBD_MATRIX_ROW_PINS/COL_PINS."
+#endif
+
+/* 矩阵键逻辑索引起点 (默认接在直连键 / 旋钮之后) */
+#ifndef KBD_MATRIX_KEY_BASE
+#define KBD_MATRIX_KEY_BASE KBD_TOTAL_KEYS
+#endif
+
+/* 超出 DataFlash 按键映射的矩阵键必须给出固定映射，否则这些键没有动作 */
+#if (KBD_MATRIX_KEY_BASE + KBD_MATRIX_ROWS * KBD_MATRIX_COLS) > KBD_MAX_KEYS && \
+    !defined(KBD_MATRIX_DEFAULT_KEYMAP)
+#error "Matrix keys beyond the stored keymap need KBD_MATRIX_DEFAULT_KEYMAP."
+#endif
+
+/* 1: 空闲时中断待命，仅有键活动时扫描；0: 始终定时扫描 */
+#ifndef KBD_MATRIX_IDLE_IRQ
+#define KBD_MATRIX_IDLE_IRQ 1
+#endif
+
+#endif /* KBD_HAS_MATRIX */
+
+/* 核心按键状态容量 (kbd_core 每键状态数组大小)：直连键 + 矩阵键 */
+#ifndef KBD_CORE_MAX_KEYS
+#if defined(KBD_HAS_MATRIX)
+#define KBD_CORE_MAX_KEYS (KBD_MATRIX_KEY_BASE + KBD_MATRIX_ROWS * KBD_MATRIX_COLS)
+#else
+#define KBD_CORE_MAX_KEYS 8u
+#endif
+#endif
+
+/** @} */
+
+/*============================================================================*/
+/**
+ * @defgroup KBD_Encoder 旋钮加速
+ * @brief 旋钮定位 (detent) 在 ISR 中按方向累加，主循环每个上报周期合并为一次输出
+ * @details
+ * - 速度 = 本周期跳变数 / 4 / 距上一次跳变的时间 (定位/秒)
+ * - 倍率 (1/16 单位) = 16 + (速度 - MIN_RATE) × SLOPE_Q4，上限 MAX_MULT × 16
+ * - 小数部分累积到下一周期，换向时清零
+ * - 滚轮动作合并为一个鼠标报告 (主机启用高分辨率时按 1/4 格计量)；
+ *   媒体键按加速后的步数点击，其他动作不加速
+ * - 非滚轮动作每周期最多 MAX_TAPS 次点击，多出的顺延到后续周期补发；
+ *   积压最多 PENDING_TAPS_MAX 次 (超出部分丢弃)，换向时清空
+ * @{
+ */
+
+/* 合并上报周期 (ms)，同时也是首个定位之后的最短上报间隔 */
+#ifndef KBD_ENCODER_REPORT_MS
+#define KBD_ENCODER_REPORT_MS 10u
+#endif
+
+/* 加速起点 (定位/秒)，不高于此速度按 1:1 输出 */
+#ifndef KBD_ENCODER_ACCEL_MIN_RATE
+#define KBD_ENCODER_ACCEL_MIN_RATE 10u
+#endif
+
+/* 超过起点后每 1 定位/秒增加的倍率 (1/16 单位)，设为 0 关闭加速 */
+#ifndef KBD_ENCODER_ACCEL_SLOPE_Q4
+#define KBD_ENCODER_ACCEL_SLOPE_Q4 4u
+#endif
+
+/* 最大倍率 (整数倍) */
+#ifndef KBD_ENCODER_ACCEL_MAX_MULT
+#define KBD_ENCODER_ACCEL_MAX_MULT 8u
+#endif
+
+/* 相邻定位间隔超过此值视为重新起转，速度按起点计算 (ms) */
+#ifndef KBD_ENCODER_ACCEL_IDLE_MS
+#define KBD_ENCODER_ACCEL_IDLE_MS 200u
+#endif
+
+/* 非滚轮动作 (音量等媒体键 / 键盘键) 每个上报周期最多点击次数，余下的顺延到后续周期 */
+#ifndef KBD_ENCODER_MAX_TAPS
+#define KBD_ENCODER_MAX_TAPS 4u
+#endif
+
+/* 顺延点击的积压上限 (快速连转时最多再补发 PENDING_TAPS_MAX / MAX_TAPS 个周期) */
+#ifndef KBD_ENCODER_PENDING_TAPS_MAX
+#define KBD_ENCODER_PENDING_TAPS_MAX 32u
+#endif
+
+/** @} */
+
 /*============================================================================*/
 /**
  * @defgroup KBD_RGB_Map RGB LED 映射配置
@@ -0,0 +1,124 @@
+#ifndef KBD_INPUT_H
+#define KBD_INPUT_H
+
+#include <stdint.h>
+
+/**
+ * @file    kbd_input.h
+ * @brief   统一输入事件队列 (普通键 / FN 键)
+ *
+ * 队列模型:
+ * - 所有输入 ISR (GPIOA / GPIOB / TMR0) 写入同一个环形队列，
+ *   核心任务 KBD_Core_Process 按入队顺序出队，跨来源的先后关系得以保留
+ * - 入队后向 KBD_Input_SetNotify 登记的 TMOS 任务投递事件，核心任务只在有输入时运行
+ * - 读端 (主循环) 无锁；写端来自不同优先级的 ISR，可能互相抢占，
+ *   入队用极短的关中断区串行化，等价于单生产者
+ * - 队列满时丢弃新事件并计数，历史最大深度记为高水位
+ * - 旋钮旋转不入队，由 encoder.c 累加后按上报周期合并 (Encoder_TakeMotion)，
+ *   只调用 KBD_Input_Notify 唤醒核心任务
+ *
+ * 时间戳:
+ * - tick_ms: 事件发生时刻 (Key_GetTickMs)，供长按判定等业务逻辑使用
+ * - stamp:   入队时 cycle 计数 (SysTick 低 32 位)，出队时计算排队延迟
+ *
+ * 统计通过 KBD_CMD_INPUT_STATS 读取并可选清零。
+ */
+
+#ifndef KBD_INPUT_QUEUE_SIZE
+#define KBD_INPUT_QUEUE_SIZE 32 /**< 队列容量 (必须为 2 的幂，≤128) */
+#endif
+
+/*============================================================================*/
+/**
+ * @defgroup INPUT_Type 类型
+ * @{
+ */
+
+/**
+ * @brief 事件来源
+ */
+typedef enum {
+  KBD_INPUT_SRC_KEY = 0,  /**< 普通按键: code=逻辑键索引, type=key_evt_type_t */
+  KBD_INPUT_SRC_FN,       /**< FN 键: code=FN id, type=fnkey_evt_type_t */
+} kbd_input_src_t;
+
+/**
+ * @brief 输入事件
+ */
+typedef struct {
+  uint8_t src;      /**< 来源 (kbd_input_src_t) */
+  uint8_t code;     /**< 键索引 / FN id */
+  uint8_t type;     /**< 事件类型 (随来源而定) */
+  uint8_t reserved;
+  uint32_t tick_ms; /**< 事件发生时刻 (ms) */
+  uint32_t stamp;   /**< 入队 cycle 计数 */
+} kbd_input_event_t;
+
+/**
+ * @brief 队列统计快照
+ */
+typedef struct {
+  uint8_t size;       /**< 队列容量 (可用槽位 = size - 1) */
+  uint8_t depth;      /**< 当前深度 */
+  uint8_t high_water; /**< 历史最大深度 */
+  uint32_t pushed;    /**< 累计入队 */
+  uint32_t dropped;   /**< 队列满丢弃 */
+  uint32_t lat_count; /**< 已统计的出队数 */
+  uint32_t lat_total; /**< 排队延迟累计 cycles (饱和) */
+  uint32_t lat_max;   /**< 最大排队延迟 cycles */
+} kbd_input_stats_t;
+
+/** @} */
+
+/*============================================================================*/
+/**
+ * @defgroup INPUT_API 接口
+ * @{
+ */
+
+/**
+ * @brief 清空队列与统计 (在使能输入中断前调用)
+ */
+void KBD_Input_Init(void);
+
+/**
+ * @brief 登记入队通知的 TMOS 任务与事件
+ *
+ * @param task_id TMOS 任务 ID (TASK_NO_TASK 关闭通知)
+ * @param event   事件位
+ */
+void KBD_Input_SetNotify(uint8_t task_id, uint16_t event);
+
+/**
+ * @brief 向登记的任务投递输入事件 (ISR 中调用，入队成功时自动调用)
+ */
+void KBD_Input_Notify(void);
+
+/**
+ * @brief 入队一个事件 (ISR 中调用)
+ *
+ * @return 1 成功
+ * @return 0 队列满，已丢弃
+ */
+uint8_t KBD_Input_Push(uint8_t src, uint8_t code, uint8_t type, uint32_t tick_ms);
+
+/**
+ * @brief 出队一个事件 (主循环调用)，同时记录排队延迟
+ *
+ * @param[out] evt 事件输出
+ * @return 1 成功读到事件
+ * @return 0 队列为空或参数无效
+ */
+uint8_t KBD_Input_Pop(kbd_input_event_t *evt);
+
+/**
+ * @brief 读取统计快照，可选读取后清零 (原子)
+ *
+ * @param[out] out 统计输出
+ * @param reset    非 0 时清零高水位 / 计数 / 延迟统计 (当前深度不变)
+ */
+void KBD_Input_GetStats(kbd_input_stats_t *out, uint8_t reset);
+
+/** @} */
+
+#endif /* KBD_INPUT_H */
@@ -0,0 +1,125 @@
+#ifndef KBD_PROF_H
+#define KBD_PROF_H
+
+#include "CH59x_common.h"
+
+/**
+ * @file    kbd_prof.h
+ * @brief   命名 profiling 区段 (cycle 计数)
+ *
+ * 计时源:
+ * - SysTick 在 CH59x_BLEInit 中以 HCLK 自由运行 (不开中断)，
+ *   低 32 位即 CPU cycle 计数，60MHz 下约 71s 回绕，单段差值不受影响
+ *
+ * 用法:
+ * - ISR / 普通代码: PROF_ZONE_BEGIN(zone) ... PROF_ZONE_END(zone)
+ * - TMOS 任务: PROF_DEFINE_TASK(zone, fn) 生成包装函数，
+ *   注册时用 PROF_TASK(fn) 替换原函数指针
+ * - KBD_PROF_ENABLE=0 时以上宏全部展开为空，零开销
+ *
+ * 统计:
+ * - 每个区段记录 count / total / min / max (cycles)，
+ *   通过 KBD_CMD_PROF_READ 读取并可选清零
+ */
+
+#ifndef KBD_PROF_ENABLE
+#define KBD_PROF_ENABLE 0
+#endif
+
+/*============================================================================*/
+/**
+ * @defgroup PROF_Zone 区段定义
+ * @{
+ */
+
+typedef enum {
+  PROF_ZONE_RGB_TASK = 0,   /**< KBD_RGB_ProcessEvent */
+  PROF_ZONE_MACRO_TASK,     /**< KBD_Macro_ProcessEvent */
+  PROF_ZONE_STORAGE_TASK,   /**< KBD_Storage_ProcessEvent */
+  PROF_ZONE_BATTERY_TASK,   /**< KBD_Battery_ProcessEvent */
+  PROF_ZONE_GPIOA_IRQ,      /**< GPIOA_IRQHandler */
+  PROF_ZONE_GPIOB_IRQ,      /**< GPIOB_IRQHandler */
+  PROF_ZONE_TMR0_IRQ,       /**< TMR0_IRQHandler */
+  PROF_ZONE_CORE_TASK,      /**< KBD_Core_ProcessEvent */
+  PROF_ZONE_COUNT
+} kbd_prof_zone_t;
+
+/**
+ * @brief 单个区段统计
+ */
+typedef struct {
+  uint32_t count; /**< 进入次数 */
+  uint32_t total; /**< 累计 cycles (饱和) */
+  uint32_t min;   /**< 最短 cycles (count=0 时为 0xFFFFFFFF) */
+  uint32_t max;   /**< 最长 cycles */
+} kbd_prof_stat_t;
+
+/** @} */
+
+/*============================================================================*/
+/**
+ * @defgroup PROF_API 接口
+ * @{
+ */
+
+/**
+ * @brief 读取当前 cycle 计数 (SysTick 低 32 位)
+ */
+__attribute__((always_inline)) static inline uint32_t KBD_Prof_Now(void) {
+  return *(volatile uint32_t *)&SysTick->CNT;
+}
+
+/**
+ * @brief 记录一次区段耗时
+ *
+ * @param zone   区段 (kbd_prof_zone_t)
+ * @param cycles 耗时 cycles
+ */
+void KBD_Prof_Record(uint8_t zone, uint32_t cycles);
+
+/**
+ * @brief 读取区段统计快照，可选读取后清零 (原子)
+ *
+ * @param zone   区段 (kbd_prof_zone_t)
+ * @param[out] out   统计输出
+ * @param reset  非 0 时读取后清零
+ * @return 0 成功
+ * @return -1 区段无效
+ */
+int KBD_Prof_Read(uint8_t zone, kbd_prof_stat_t *out, uint8_t reset);
+
+/** @} */
+
+/*============================================================================*/
+/**
+ * @defgroup PROF_Macro 区段宏
+ * @{
+ */
+
+#if KBD_PROF_ENABLE
+
+#define PROF_ZONE_BEGIN(zone) uint32_t _prof_t0_##zone = KBD_Prof_Now()
+#define PROF_ZONE_END(zone) \
+  KBD_Prof_Record((zone), KBD_Prof_Now() - _prof_t0_##zone)
+
+#define PROF_DEFINE_TASK(zone, fn)                                   \
+  static uint16_t fn##_Prof(uint8_t task_id, uint16_t events) {      \
+    uint32_t t0 = KBD_Prof_Now();                                    \
+    uint16_t ret = fn(task_id, events);                              \
+    KBD_Prof_Record((zone), KBD_Prof_Now() - t0);                    \
+    return ret;                                                      \
+  }
+#define PROF_TASK(fn) fn##_Prof
+
+#else
+
+#define PROF_ZONE_BEGIN(zone)
+#define PROF_ZONE_END(zone)
+#define PROF_DEFINE_TASK(zone, fn)
+#define PROF_TASK(fn) fn
+
+#endif /* KBD_PROF_ENABLE */
+
+/** @} */
+
+#endif /* KBD_PROF_H */
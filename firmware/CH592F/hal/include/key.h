@@ -1,8 +1,8 @@
 /**
  * @file    key.h
- * @brief   键盘按键驱动接口（GPIO 边沿中断 + 1ms 定时器锁定去抖 + 事件队列）
+ * @brief   键盘按键驱动接口（GPIO 边沿中断 + 单次截止定时器去抖 + 事件队列）
  * @details
- * 本模块将按键输入抽象为“事件队列”：
+ * 本模块将按键输入抽象为事件，写入统一输入队列（kbd_input.h）：
  * - 普通按键（K1..Kn）：产生 PRESS / RELEASE 事件（是否上报 RELEASE 可配置）
  * - FN 按键（FN1..FNn）：按下只记录起始时间，松开时根据持续时间产生 CLICK / LONG 事件
  * - BOOT 键：仅提供原始电平读取（不使用中断）
@@ -11,14 +11,9 @@
  * @code
  * Key_Init();
  * while (1) {
- *     key_event_t e;
- *     if (Key_GetEvent(&e)) {
- *         // 处理普通按键事件
- *     }
- *
- *     fnkey_event_t fe;
- *     if (FnKey_GetEvent(&fe)) {
- *         // 处理 FN CLICK/LONG
+ *     kbd_input_event_t e;
+ *     while (KBD_Input_Pop(&e)) {
+ *         // e.src: KBD_INPUT_SRC_KEY / ENCODER / FN
  *     }
  * }
  * @endcode
@@ -40,7 +35,7 @@ extern "C" {
 
 /**
  * @defgroup KBD_KEY 键盘按键驱动（key）
- * @brief GPIO 边沿中断 + 1ms 定时器锁定去抖 + 环形队列上报事件
+ * @brief GPIO 边沿中断 + 单次截止定时器去抖 + 环形队列上报事件
  * @{
  */
 
@@ -51,17 +46,25 @@ extern "C" {
 
 /**
  * @def KEY_LOCKOUT_MS
- * @brief 普通按键锁定去抖时间（毫秒）。
+ * @brief 普通按键默认去抖时间（毫秒），运行时可由 Key_SetDebounce() 覆盖。
  * @details
- * 每次边沿中断触发后，该按键会进入 lockout 状态：
+ * EAGER 模式下每次边沿中断触发后，该按键会进入 lockout 状态：
  * - 禁用该引脚中断
- * - 由 1ms 定时器递减 lock_ms
- * - lock_ms 归零后清中断标志并重新使能引脚中断
+ * - 记录解锁截止时刻，TMR0 按最早截止时刻单次定时
+ * - 到期后清中断标志并重新使能引脚中断
  */
 #ifndef KEY_LOCKOUT_MS
 #define KEY_LOCKOUT_MS 10
 #endif
 
+/**
+ * @def KEY_DEBOUNCE_MAX_MS
+ * @brief 普通按键去抖时间上限（毫秒）。
+ */
+#ifndef KEY_DEBOUNCE_MAX_MS
+#define KEY_DEBOUNCE_MAX_MS 50
+#endif
+
 /**
  * @def FN_LOCKOUT_MS
  * @brief FN 按键锁定去抖时间（毫秒）。
@@ -89,22 +92,6 @@ extern "C" {
 #define KEY_ENABLE_RELEASE_EVENT 1
 #endif
 
-/**
- * @def KEY_QUEUE_SIZE
- * @brief 普通按键事件队列容量（必须为 2 的幂）。
- */
-#ifndef KEY_QUEUE_SIZE
-#define KEY_QUEUE_SIZE 16
-#endif
-
-/**
- * @def FNKEY_QUEUE_SIZE
- * @brief FN 按键事件队列容量（必须为 2 的幂）。
- */
-#ifndef FNKEY_QUEUE_SIZE
-#define FNKEY_QUEUE_SIZE 8
-#endif
-
 /**
  * @def KEY_IRQ_PRIORITY
  * @brief GPIO 中断优先级（平台相关）。
@@ -115,7 +102,7 @@ extern "C" {
 
 /**
  * @def TIMER_IRQ_PRIORITY
- * @brief 1ms 定时器中断优先级（平台相关）。
+ * @brief TMR0 单次截止定时器中断优先级（平台相关）。
  */
 #ifndef TIMER_IRQ_PRIORITY
 #define TIMER_IRQ_PRIORITY 2
@@ -126,6 +113,17 @@ extern "C" {
  * ============================================================================
  */
 
+/**
+ * @enum key_debounce_mode_t
+ * @brief 普通按键去抖算法（FN 键固定使用 EAGER + FN_LOCKOUT_MS）。
+ */
+typedef enum {
+    KEY_DEBOUNCE_EAGER = 0,      /**< 边沿立即上报，随后锁定 N ms（延迟最低，默认） */
+    KEY_DEBOUNCE_DEFER = 1,      /**< 电平稳定 N ms 后才上报，按下/松开对称（抗毛刺） */
+    KEY_DEBOUNCE_ASYMMETRIC = 2, /**< 按下立即上报 + 锁定，松开稳定 N ms 后上报 */
+    KEY_DEBOUNCE_COUNT
+} key_debounce_mode_t;
+
 /**
  * @enum key_evt_type_t
  * @brief 普通按键事件类型。
@@ -142,7 +140,7 @@ typedef enum {
 typedef struct {
   uint8_t  key;      /**< 逻辑按键索引（0..KBD_TOTAL_KEYS-1） */
   uint8_t  type;     /**< 事件类型，见 @ref key_evt_type_t */
-  uint32_t tick_ms;  /**< 事件产生时的毫秒计数（自 Key_Init() 起） */
+  uint32_t tick_ms;  /**< 事件产生时的毫秒计数（Key_GetTickMs()） */
 } key_event_t;
 
 /**
@@ -171,7 +169,7 @@ typedef enum {
 typedef struct {
   uint8_t  id;       /**< FN 键 ID（0..KBD_FN_NUM_KEYS-1），对应 g_fn_pins[] */
   uint8_t  type;     /**< 事件类型，见 @ref fnkey_evt_type_t */
-  uint32_t tick_ms;  /**< 事件产生时的毫秒计数（自 Key_Init() 起） */
+  uint32_t tick_ms;  /**< 事件产生时的毫秒计数（Key_GetTickMs()） */
 } fnkey_event_t;
 
 /* ============================================================================
@@ -185,21 +183,31 @@ typedef struct {
  * - 配置 BOOT / 普通键 / FN 键为上拉输入
  * - 配置 GPIO 边沿中断（普通键根据当前电平决定先等下降沿还是上升沿；FN 键强制先等下降沿）
  * - 初始化队列和上下文（ctx）
- * - 启动 1ms 定时器，用于：
- *   - 提供 tick_ms 时间戳
- *   - lockout 倒计时到 0 时重新打开引脚中断
+ * - 使能 TMR0 中断但不启动计数：仅在有 lockout / 确认窗口待到期时单次定时，
+ *   空闲时没有周期中断
  */
 void Key_Init(void);
 
 /**
- * @brief 读取一个普通按键事件（出队）。
- * @param[out] evt 事件输出指针（不可为 NULL）。
- * @return 1 表示成功读到一个事件；0 表示队列为空或参数无效。
- * @note
- * - 队列为环形队列：ISR 侧 Push，主循环侧 Pop
- * - 队列满时 ISR 会丢弃新事件（不覆盖旧事件）
+ * @brief 读取毫秒时间戳（事件 tick_ms 的时间基准）。
+ * @return 由 64 位 SysTick 自由计数换算的毫秒数（32 位回绕）；
+ *         内部按上次调用的基准增量换算，只用 32 位除法
+ * @note 可在 ISR 与主循环中调用；SysTick 由 CH59x_BLEInit() 启动。
+ */
+uint32_t Key_GetTickMs(void);
+
+/**
+ * @brief RTC Sleep 后补偿毫秒时间基准（SysTick 在 Sleep 期间停止计数）。
+ * @param rtc_cycles 实际睡眠的 RTC 周期数
+ * @note 由 kbd_idle 在关中断状态下调用。
+ */
+void Key_CompensateSleep(uint32_t rtc_cycles);
+
+/**
+ * @brief 是否有 lockout / 确认窗口待到期（TMR0 单次定时已编程）。
+ * @return 1=有（不能进入 Sleep），0=无
  */
-uint8_t Key_GetEvent(key_event_t *evt);
+uint8_t Key_IsTimerPending(void);
 
 /**
  * @brief 查询普通按键当前是否处于按下状态。
@@ -211,15 +219,6 @@ uint8_t Key_GetEvent(key_event_t *evt);
  */
 int8_t  Key_IsDown(uint8_t key_index);
 
-/**
- * @brief 读取一个 FN 按键事件（出队）。
- * @param[out] evt 事件输出指针（不可为 NULL）。
- * @return 1 表示成功读到一个事件；0 表示队列为空或参数无效。
- * @details
- * FN 键事件在“松开边沿”产生：根据按下持续时间判定 CLICK / LONG。
- */
-uint8_t FnKey_GetEvent(fnkey_event_t *evt);
-
 /**
  * @brief 查询 FN 按键当前是否处于按下状态。
  * @param id FN 键索引（0..KBD_FN_NUM_KEYS-1）
@@ -234,15 +233,23 @@ int8_t  FnKey_IsDown(uint8_t id);
  */
 int8_t BootKey_IsPressed(void);
 
+/**
+ * @brief 设置普通按键去抖算法与时间。
+ * @param mode 去抖算法（key_debounce_mode_t），非法值回退为 EAGER
+ * @param ms   去抖时间（毫秒），限制在 1..KEY_DEBOUNCE_MAX_MS
+ * @note 对之后的边沿生效，正在锁定/确认中的按键按旧参数完成。
+ */
+void Key_SetDebounce(uint8_t mode, uint8_t ms);
+
 /**
  * @brief 进入低功耗前的钩子（可选）。
- * @details 当前实现为：停止 1ms 定时器，以降低功耗/避免不必要中断。
+ * @details 当前实现为：强制结束所有 lockout / 确认窗口并停止 TMR0，避免休眠中被定时器唤醒。
  */
 void Key_EnterSleep(void);
 
 /**
  * @brief 退出低功耗后的钩子（可选）。
- * @details 当前实现为：重新启动 1ms 定时器。
+ * @details 当前实现为：恢复旋钮状态、矩阵补扫一遍；TMR0 在下一次边沿时按需启动。
  */
 void Key_ExitSleep(void);
 
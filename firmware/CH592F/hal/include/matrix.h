@@ -0,0 +1,34 @@
+#ifndef KBD_MATRIX_H_
+#define KBD_MATRIX_H_
+
+#include "key.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * 行列矩阵扫描 (KBD_HAS_MATRIX，配置见 kbd_config.h KBD_Matrix)
+ *
+ * - 每行一次端口寄存器读取 (PA / PB 各一次) 得到整行列状态
+ * - 空闲时所有行拉低、列下降沿中断待命，任意列边沿启动扫描
+ * - 扫描由 TMOS 定时事件驱动，全部松开且去抖完成后停止并重新待命
+ * - 去抖算法与时间跟随 Key_SetDebounce()
+ * - 事件写入统一输入队列 (KBD_INPUT_SRC_KEY)
+ *
+ * 未定义 KBD_HAS_MATRIX 时所有接口为空实现。
+ */
+
+void Matrix_Init(void);
+void Matrix_SetDebounce(uint8_t mode, uint8_t ms);
+void Matrix_HandlePortIrq(gpio_port_t port);
+int8_t Matrix_IsDown(uint8_t key_index);
+void Matrix_EnterSleep(void);
+void Matrix_ExitSleep(void);
+void Matrix_ConfigDeepSleepWakeup(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KBD_MATRIX_H_ */
@@ -147,4 +147,10 @@ void WS2812_Sleep(void);
  */
 void WS2812_Wakeup(void);
 
+/**
+ * @brief LED 是否供电中（有点亮像素，TMR1 PWM / DMA 可能在输出）
+ * @note  供电期间不进入 RTC Sleep，避免 HCLK 停止打断数据帧
+ */
+uint8_t WS2812_IsPowered(void);
+
 #endif /* __WS2812_H */
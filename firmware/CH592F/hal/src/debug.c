@@ -3,6 +3,158 @@
 #include <stdio.h>
 #include <string.h>
 
+#if UART_LOG_ENABLE
+
+#define LOG_TX_RING_MASK (KBD_LOG_TX_RING_SIZE - 1)
+
+/* UART1 发送环形缓冲区: 生产者为 Log_Output / Log_Token (任意上下文)，消费者为 UART1 中断 */
+static uint8_t s_tx_ring[KBD_LOG_TX_RING_SIZE];
+static volatile uint16_t s_tx_wr = 0;
+static volatile uint16_t s_tx_rd = 0;
+
+/* 空间不足被整条丢弃的日志数；s_tx_reported 为已在输出流中报告过的数目 */
+static volatile uint32_t s_tx_dropped = 0;
+static uint32_t s_tx_reported = 0;
+
+#if KBD_LOG_TOKENIZED
+static const char s_drop_fmt[] __attribute__((section(".kbd_logstr"), used)) =
+    "W|LOG|%u messages dropped";
+#endif
+
+/* 把环形缓冲区中的数据填入 UART1 硬件 FIFO；缓冲区清空时关闭 THR 空中断 */
+__HIGH_CODE
+static void LogTx_FillFifo(void)
+{
+    while (s_tx_rd != s_tx_wr && R8_UART1_TFC < UART_FIFO_SIZE) {
+        R8_UART1_THR = s_tx_ring[s_tx_rd & LOG_TX_RING_MASK];
+        s_tx_rd++;
+    }
+
+    if (s_tx_rd == s_tx_wr) {
+        R8_UART1_IER &= ~RB_IER_THR_EMPTY;
+    } else {
+        R8_UART1_IER |= RB_IER_THR_EMPTY;
+    }
+}
+
+static inline uint16_t LogTx_Free(void)
+{
+    return (uint16_t)(KBD_LOG_TX_RING_SIZE - (uint16_t)(s_tx_wr - s_tx_rd));
+}
+
+static inline void LogTx_Copy(const uint8_t *data, uint16_t len)
+{
+    for (uint16_t i = 0; i < len; i++) {
+        s_tx_ring[s_tx_wr & LOG_TX_RING_MASK] = data[i];
+        s_tx_wr++;
+    }
+}
+
+#if KBD_LOG_TOKENIZED
+/* CRC-8 (多项式 0x07)，覆盖帧中同步字节之后的部分 */
+static uint8_t LogTx_Crc8(const uint8_t *data, uint8_t len)
+{
+    uint8_t crc = 0;
+
+    while (len--) {
+        crc ^= *data++;
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+/* 组装令牌帧，返回长度 (最长 KBD_LOG_TOKEN_FRAME_MAX) */
+static uint8_t LogTx_TokenFrame(uint8_t *out, uint16_t token, uint8_t nargs,
+                                const uint32_t *args)
+{
+    uint8_t len = 0;
+
+    out[len++] = KBD_LOG_TOKEN_SYNC;
+    out[len++] = (uint8_t)(token & 0xFF);
+    out[len++] = (uint8_t)(token >> 8);
+    out[len++] = nargs;
+    for (uint8_t i = 0; i < nargs; i++) {
+        out[len++] = (uint8_t)(args[i] & 0xFF);
+        out[len++] = (uint8_t)((args[i] >> 8) & 0xFF);
+        out[len++] = (uint8_t)((args[i] >> 16) & 0xFF);
+        out[len++] = (uint8_t)((args[i] >> 24) & 0xFF);
+    }
+    out[len] = LogTx_Crc8(&out[1], (uint8_t)(len - 1));
+    return (uint8_t)(len + 1);
+}
+#endif
+
+/* 生成丢弃提示 (关中断状态下调用)，返回长度 */
+static uint8_t LogTx_DropNotice(uint8_t *out, uint32_t count)
+{
+#if KBD_LOG_TOKENIZED
+    return LogTx_TokenFrame(out, (uint16_t)(uintptr_t)s_drop_fmt, 1, &count);
+#else
+    return (uint8_t)snprintf((char *)out, 32, "[W/LOG] %lu messages dropped\n",
+                             (unsigned long)count);
+#endif
+}
+
+/*
+ * 整条日志入队：空间不足整条丢弃并计数，不阻塞调用方。
+ * 上一次报告之后有丢弃时，先插入一条丢弃提示 (放不下就连同本条一起丢弃)。
+ */
+static void LogTx_Push(const uint8_t *data, uint16_t len)
+{
+    uint8_t notice[32];
+    uint8_t notice_len = 0;
+    uint32_t irq_status;
+
+    SYS_DisableAllIrq(&irq_status);
+    if (s_tx_dropped != s_tx_reported) {
+        notice_len = LogTx_DropNotice(notice, s_tx_dropped - s_tx_reported);
+    }
+    if (LogTx_Free() >= (uint16_t)(notice_len + len)) {
+        if (notice_len) {
+            LogTx_Copy(notice, notice_len);
+            s_tx_reported = s_tx_dropped;
+        }
+        LogTx_Copy(data, len);
+        LogTx_FillFifo();
+    } else {
+        s_tx_dropped++;
+    }
+    SYS_RecoverIrq(irq_status);
+}
+
+/*
+ * 覆盖 SDK 中直接写 THR 的 _write (弱符号)：printf / PRINT (含 BLE 库内部打印)
+ * 也进入发送环，按调用整段入队，不会插进日志行或令牌帧中间
+ */
+int _write(int fd, char *buf, int size)
+{
+    int pos = 0;
+
+    (void)fd;
+    while (pos < size) {
+        uint16_t chunk = (uint16_t)(size - pos);
+        if (chunk > KBD_LOG_LINE_MAX) {
+            chunk = KBD_LOG_LINE_MAX;
+        }
+        LogTx_Push((const uint8_t *)buf + pos, chunk);
+        pos += chunk;
+    }
+    return size;
+}
+
+__INTERRUPT
+__HIGH_CODE
+void UART1_IRQHandler(void)
+{
+    if ((R8_UART1_IIR & RB_IIR_INT_MASK) == UART_II_THR_EMPTY) {
+        LogTx_FillFifo();
+    }
+}
+
+#endif /* UART_LOG_ENABLE */
+
 void Debug_Init(void)
 {
 #if UART_LOG_ENABLE
@@ -16,36 +168,112 @@ void Debug_Init(void)
     // 初始化 UART1
     UART1_DefInit();
     UART1_BaudRateCfg(DEBUG_UART1_BAUDRATE);
+
+    // 日志走中断发送: 允许中断输出，THR 空中断在有数据时再打开
+    R8_UART1_MCR |= RB_MCR_INT_OE;
+    PFIC_EnableIRQ(UART1_IRQn);
+#endif
+}
+
+__HIGH_CODE
+void Debug_Flush(void)
+{
+#if UART_LOG_ENABLE
+    uint32_t irq_status;
+
+    SYS_DisableAllIrq(&irq_status);
+    R8_UART1_IER &= ~RB_IER_THR_EMPTY;
+    while (s_tx_rd != s_tx_wr) {
+        while (R8_UART1_TFC == UART_FIFO_SIZE);
+        R8_UART1_THR = s_tx_ring[s_tx_rd & LOG_TX_RING_MASK];
+        s_tx_rd++;
+    }
+    while ((R8_UART1_LSR & RB_LSR_TX_ALL_EMP) == 0);
+    SYS_RecoverIrq(irq_status);
+#endif
+}
+
+__HIGH_CODE
+uint8_t Debug_TxBusy(void)
+{
+#if UART_LOG_ENABLE
+    return (s_tx_rd != s_tx_wr) ? 1 : 0;
+#else
+    return 0;
+#endif
+}
+
+uint32_t Debug_GetDropped(void)
+{
+#if UART_LOG_ENABLE
+    return s_tx_dropped;
+#else
+    return 0;
 #endif
 }
 
 void Log_Output(const char *level, const char *tag, const char *fmt, ...)
 {
 #if UART_LOG_ENABLE
-    static char buf[80];
+    char buf[KBD_LOG_LINE_MAX];
     va_list args;
+    int len;
 
     // 格式: [L/TAG] message\n
-    int len = snprintf(buf, sizeof(buf), "[%s/%s] ", level, tag);
-
-    va_start(args, fmt);
-    len += vsnprintf(buf + len, sizeof(buf) - len, fmt, args);
-    va_end(args);
+    len = snprintf(buf, sizeof(buf), "[%s/%s] ", level, tag);
+    if (len < 0) {
+        return;
+    }
+    if (len < (int)sizeof(buf)) {
+        int body;
 
-    // 添加换行
-    if (len < (int)sizeof(buf) - 1) {
-        buf[len++] = '\n';
-        buf[len] = '\0';
+        va_start(args, fmt);
+        body = vsnprintf(buf + len, sizeof(buf) - len, fmt, args);
+        va_end(args);
+        if (body < 0) {
+            return;
+        }
+        len += body;
     }
 
-    // 直接输出到 UART1，输出 len 字节（不以 null 提前结束）
-    for (int i = 0; i < len; i++) {
-        while (R8_UART1_TFC == UART_FIFO_SIZE);
-        R8_UART1_THR = (uint8_t)buf[i];
+    // 截断后保留换行
+    if (len > (int)sizeof(buf) - 2) {
+        len = (int)sizeof(buf) - 2;
     }
+    buf[len++] = '\n';
+
+    LogTx_Push((const uint8_t *)buf, (uint16_t)len);
 #else
     (void)level;
     (void)tag;
     (void)fmt;
 #endif
 }
+
+void Log_Token(uint16_t token, uint8_t nargs, ...)
+{
+#if UART_LOG_ENABLE && KBD_LOG_TOKENIZED
+    uint8_t frame[KBD_LOG_TOKEN_FRAME_MAX];
+    uint32_t argv[KBD_LOG_TOKEN_MAX_ARGS];
+    uint8_t len;
+    va_list args;
+
+    if (nargs > KBD_LOG_TOKEN_MAX_ARGS) {
+        nargs = KBD_LOG_TOKEN_MAX_ARGS;
+    }
+
+    va_start(args, nargs);
+    for (uint8_t i = 0; i < nargs; i++) {
+        argv[i] = va_arg(args, uint32_t);
+    }
+    va_end(args);
+
+    len = LogTx_TokenFrame(frame, token, nargs, argv);
+
+    // 空间不足整帧丢弃，避免主机端解出半帧
+    LogTx_Push(frame, len);
+#else
+    (void)token;
+    (void)nargs;
+#endif
+}
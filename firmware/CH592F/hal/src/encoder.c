@@ -2,28 +2,22 @@
 
 #if defined(KBD_LAYOUT_KNOB) && defined(KBD_HAS_ENCODER)
 
-#include <string.h>
-
-#ifndef ENCODER_QUEUE_SIZE
-#define ENCODER_QUEUE_SIZE 16
-#endif
+#include "kbd_input.h"
 
-#define STATIC_ASSERT(cond, msg) typedef char static_assert_##msg[(cond) ? 1 : -1]
-STATIC_ASSERT((ENCODER_QUEUE_SIZE & (ENCODER_QUEUE_SIZE - 1)) == 0,
-              encoder_queue_must_be_power_of_2);
+#include <string.h>
 
 typedef struct {
-  volatile uint32_t tick_ms;
   uint8_t prev_ab;
   int8_t accum;
+  int16_t detents;  /* 待取走的净定位数 */
+  int16_t edges;    /* 待取走的净跳变数 */
+  uint16_t count;   /* 待取走的跳变总数 */
+  uint32_t last_ms; /* 最后一个跳变的时刻 */
 } encoder_ctx_t;
 
 static const kbd_key_pin_t g_encoder_a_pin = {KBD_ENCODER_A_PORT, KBD_ENCODER_A_PIN};
 static const kbd_key_pin_t g_encoder_b_pin = {KBD_ENCODER_B_PORT, KBD_ENCODER_B_PIN};
 
-static volatile key_event_t s_encoder_queue[ENCODER_QUEUE_SIZE];
-static volatile uint8_t s_encoder_wr = 0;
-static volatile uint8_t s_encoder_rd = 0;
 static volatile encoder_ctx_t s_encoder_ctx;
 
 static inline void ConfigPinInputPullup(const kbd_key_pin_t *pin) {
@@ -95,26 +89,12 @@ static void ConfigEncoderEdgesFromCurrentLevel(void) {
   }
 }
 
-static inline uint8_t EncoderQueueFreeSlots(void) {
-  return (uint8_t)((s_encoder_rd - s_encoder_wr - 1u) & (ENCODER_QUEUE_SIZE - 1u));
-}
-
-static inline void PushEncoderEventUnchecked(uint8_t key,
-                                             uint8_t type,
-                                             uint32_t tick_ms) {
-  s_encoder_queue[s_encoder_wr].key = key;
-  s_encoder_queue[s_encoder_wr].type = type;
-  s_encoder_queue[s_encoder_wr].tick_ms = tick_ms;
-  s_encoder_wr = (uint8_t)((s_encoder_wr + 1u) & (ENCODER_QUEUE_SIZE - 1u));
-}
-
-static void PushEncoderTap(uint8_t key, uint32_t tick_ms) {
-  if (EncoderQueueFreeSlots() < 2u) {
-    return;
+/* 只在 GPIO ISR 中写入；饱和而不是回绕，快速旋转不会反向 */
+static inline int16_t SatAdd(int16_t v, int8_t dir) {
+  if ((dir > 0 && v < INT16_MAX) || (dir < 0 && v > INT16_MIN)) {
+    return (int16_t)(v + dir);
   }
-
-  PushEncoderEventUnchecked(key, KEY_EVT_PRESS, tick_ms);
-  PushEncoderEventUnchecked(key, KEY_EVT_RELEASE, tick_ms);
+  return v;
 }
 
 static void ProcessEncoderTransition(uint32_t tick_ms) {
@@ -135,20 +115,24 @@ static void ProcessEncoderTransition(uint32_t tick_ms) {
     return;
   }
 
+  s_encoder_ctx.edges = SatAdd(s_encoder_ctx.edges, delta);
+  if (s_encoder_ctx.count < UINT16_MAX) {
+    s_encoder_ctx.count++;
+  }
+  s_encoder_ctx.last_ms = tick_ms;
+
   s_encoder_ctx.accum += delta;
-  if (s_encoder_ctx.accum >= 4) {
-    PushEncoderTap(KBD_KNOB_CW_IDX, tick_ms);
+  if (s_encoder_ctx.accum >= ENCODER_EDGES_PER_DETENT) {
+    s_encoder_ctx.detents = SatAdd(s_encoder_ctx.detents, 1);
     s_encoder_ctx.accum = 0;
-  } else if (s_encoder_ctx.accum <= -4) {
-    PushEncoderTap(KBD_KNOB_CCW_IDX, tick_ms);
+  } else if (s_encoder_ctx.accum <= -ENCODER_EDGES_PER_DETENT) {
+    s_encoder_ctx.detents = SatAdd(s_encoder_ctx.detents, -1);
     s_encoder_ctx.accum = 0;
   }
 }
 
 void Encoder_Init(void) {
   memset((void *)&s_encoder_ctx, 0, sizeof(s_encoder_ctx));
-  s_encoder_rd = 0;
-  s_encoder_wr = 0;
 
   ConfigPinInputPullup(&g_encoder_a_pin);
   ConfigPinInputPullup(&g_encoder_b_pin);
@@ -162,18 +146,6 @@ void Encoder_Init(void) {
   EnablePinIrq(g_encoder_b_pin.port, g_encoder_b_pin.pin);
 }
 
-uint8_t Encoder_GetEvent(key_event_t *evt) {
-  if (evt == NULL) {
-    return 0;
-  }
-  if (s_encoder_rd == s_encoder_wr) {
-    return 0;
-  }
-  *evt = s_encoder_queue[s_encoder_rd];
-  s_encoder_rd = (uint8_t)((s_encoder_rd + 1) & (ENCODER_QUEUE_SIZE - 1));
-  return 1;
-}
-
 void Encoder_HandlePortIrq(gpio_port_t port) {
   if (port != g_encoder_a_pin.port && port != g_encoder_b_pin.port) {
     return;
@@ -200,19 +172,26 @@ void Encoder_HandlePortIrq(gpio_port_t port) {
     ClearPinItFlag(g_encoder_b_pin.port, g_encoder_b_pin.pin);
   }
 
-  ProcessEncoderTransition(s_encoder_ctx.tick_ms);
+  ProcessEncoderTransition(Key_GetTickMs());
   ConfigEncoderEdgesFromCurrentLevel();
-}
 
-void Encoder_TimerTick1ms(void) {
-  s_encoder_ctx.tick_ms++;
+  if (s_encoder_ctx.count != 0) {
+    KBD_Input_Notify();
+  }
 }
 
 void Encoder_EnterSleep(void) {}
 
 void Encoder_ExitSleep(void) {
+  uint32_t irq_status;
+
+  SYS_DisableAllIrq(&irq_status);
   s_encoder_ctx.prev_ab = ReadEncoderState();
   s_encoder_ctx.accum = 0;
+  s_encoder_ctx.detents = 0;
+  s_encoder_ctx.edges = 0;
+  s_encoder_ctx.count = 0;
+  SYS_RecoverIrq(irq_status);
   ConfigEncoderEdgesFromCurrentLevel();
   ClearPinItFlag(g_encoder_a_pin.port, g_encoder_a_pin.pin);
   ClearPinItFlag(g_encoder_b_pin.port, g_encoder_b_pin.pin);
@@ -220,16 +199,41 @@ void Encoder_ExitSleep(void) {
   EnablePinIrq(g_encoder_b_pin.port, g_encoder_b_pin.pin);
 }
 
+uint8_t Encoder_TakeMotion(encoder_motion_t *out) {
+  uint32_t irq_status;
+  uint8_t ok = 0;
+
+  if (out == NULL) {
+    return 0;
+  }
+
+  SYS_DisableAllIrq(&irq_status);
+  if (s_encoder_ctx.count != 0) {
+    out->detents = s_encoder_ctx.detents;
+    out->edges = s_encoder_ctx.edges;
+    out->count = s_encoder_ctx.count;
+    out->last_ms = s_encoder_ctx.last_ms;
+    s_encoder_ctx.detents = 0;
+    s_encoder_ctx.edges = 0;
+    s_encoder_ctx.count = 0;
+    ok = 1;
+  }
+  SYS_RecoverIrq(irq_status);
+  return ok;
+}
+
+uint8_t Encoder_HasMotion(void) { return (s_encoder_ctx.count != 0) ? 1 : 0; }
+
 #else
 
 void Encoder_Init(void) {}
-uint8_t Encoder_GetEvent(key_event_t *evt) {
-  (void)evt;
-  return 0;
-}
 void Encoder_HandlePortIrq(gpio_port_t port) { (void)port; }
-void Encoder_TimerTick1ms(void) {}
 void Encoder_EnterSleep(void) {}
 void Encoder_ExitSleep(void) {}
+uint8_t Encoder_TakeMotion(encoder_motion_t *out) {
+  (void)out;
+  return 0;
+}
+uint8_t Encoder_HasMotion(void) { return 0; }
 
 #endif
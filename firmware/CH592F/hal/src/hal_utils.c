@@ -1,6 +1,7 @@
 #include "hal_utils.h"
 
 #include "CH59x_common.h"
+#include "debug.h"
 #include "iap_config.h"
 
 __HIGH_CODE
@@ -14,12 +15,62 @@ void Hal_JumpToBootloader(void) {
         EEPROM_WRITE(IAP_DATAFLASH_ADD, (uint32_t *)buf, 4);
     }
 
+    Debug_Flush();
     SYS_ResetExecute();
     while (1);
 }
 
 __HIGH_CODE
 void Hal_Reset(void) {
+    Debug_Flush();
     SYS_ResetExecute();
     while (1);
 }
+
+/* 栈 / 堆涂色图案 */
+#define HAL_MEM_PAINT 0xA5C3A5C3u
+
+/* Link.ld 中 .stack 段边界 */
+extern uint32_t _susrstack[];
+extern uint32_t _eusrstack[];
+
+void Hal_Mem_PaintStack(void) {
+    uint32_t sp;
+    __asm volatile("mv %0, sp" : "=r"(sp));
+
+    /* 留出当前帧下方 64B，避免改写正在使用的栈 */
+    for (uint32_t *p = _susrstack; (uintptr_t)p < sp - 64u; p++) {
+        *p = HAL_MEM_PAINT;
+    }
+}
+
+uint32_t Hal_Mem_GetStackSize(void) {
+    return (uint32_t)((uint8_t *)_eusrstack - (uint8_t *)_susrstack);
+}
+
+uint32_t Hal_Mem_GetStackPeak(void) {
+    const uint32_t *p = _susrstack;
+
+    while (p < _eusrstack && *p == HAL_MEM_PAINT) {
+        p++;
+    }
+    return (uint32_t)((uint8_t *)_eusrstack - (uint8_t *)p);
+}
+
+void Hal_Mem_PaintRegion(void *buf, uint32_t len) {
+    uint32_t *p = (uint32_t *)buf;
+
+    for (uint32_t i = 0; i < len / 4u; i++) {
+        p[i] = HAL_MEM_PAINT;
+    }
+}
+
+uint32_t Hal_Mem_GetRegionPeak(const void *buf, uint32_t len) {
+    const uint32_t *p = (const uint32_t *)buf;
+    uint32_t n = len / 4u;
+
+    while (n > 0 && p[n - 1] == HAL_MEM_PAINT) {
+        n--;
+    }
+    return n * 4u;
+}
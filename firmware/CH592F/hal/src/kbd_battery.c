@@ -13,12 +13,25 @@
  * 充电检测:
  * - PA13 (TP4054 CHRG): 开漏输出, 内部上拉
  *   读高 = 未充电, 读低 = 充电中
+ * - 稳定时只开边沿中断 (下一次变化的方向)，边沿到来后才按 100ms 轮询去抖，
+ *   状态重新稳定后停止轮询
+ *
+ * 采样节奏:
+ * - 周期随电压斜率与充电状态调整：充电或电压快速变化时 15 秒，平稳时逐次加倍到 4 分钟
+ * - 蓝牙已连接时分压稳定后再等下一个连接事件结束，在射频空闲间隙里转换，
+ *   避免发射电流拉低读数；等不到连接事件 (从机延迟) 时超时后直接转换
  */
 
 #include "kbd_battery.h"
 #include "kbd_config.h"
 #include "ble_config.h"
 #include "debug.h"
+#include "kbd_prof.h"
+#include "kbd_idle.h"
+#include "kbd_mode.h"
+#include "ble_hal.h"
+
+#include <string.h>
 
 #define TAG "BAT"
 
@@ -26,10 +39,15 @@
 #define BAT_SAMPLE_EVT 0x0001
 #define BAT_PERIODIC_EVT 0x0002
 #define BAT_CHARGE_POLL_EVT 0x0004
+#define BAT_RADIO_IDLE_EVT 0x0008
+
+/* 采样阶段：分压稳定中 / 等待连接事件结束 */
+#define BAT_PHASE_SETTLE 0u
+#define BAT_PHASE_RADIO 1u
 
 /* 采样时序 */
 #define BAT_SETTLE_MS 30u
-#define BAT_PERIODIC_MS (30u * 1000u)
+#define BAT_RADIO_WAIT_MS 1000u
 #define BAT_ADC_SAMPLE_COUNT 10u
 #define BAT_ADC_CALIB_LIMIT 256
 #define BAT_VALID_MIN_MV 2500u
@@ -42,6 +60,20 @@
 #define BAT_CHARGE_ASSERT_SAMPLES 3u
 #define BAT_CHARGE_RELEASE_SAMPLES 100u
 
+/*
+ * 自适应周期：滤波后电压相对参考点变化不超过噪声带，或斜率不超过 SLOW，
+ * 周期加倍直到 MAX；斜率达到 FAST 或正在充电时回到 MIN；其余回到 BASE。
+ * 低电量时不放宽到 BASE 以上，避免错过末段快速下跌。
+ */
+#define BAT_PERIOD_MIN_MS (15u * 1000u)
+#define BAT_PERIOD_BASE_MS (30u * 1000u)
+#define BAT_PERIOD_MAX_MS (240u * 1000u)
+#define BAT_PERIOD_LOW_LEVEL_PCT 10u
+#define BAT_SLOPE_NOISE_MV 6u
+#define BAT_SLOPE_WINDOW_MS (20u * 60u * 1000u)
+#define BAT_SLOPE_SLOW_MV_MIN 2u
+#define BAT_SLOPE_FAST_MV_MIN 10u
+
 /*
  * TP4054 充电时端电压会高于静置电压。没有电流采样和库仑计时，只能做
  * 电压估算；减去一个保守偏移可避免充电中明显高估，CHRG 释放后再允许 100%。
@@ -74,6 +106,13 @@ static kbd_charge_state_t s_last_charge_state = BAT_CHG_NONE;
 static uint8_t s_full_assert_samples = 0;
 static uint8_t s_full_release_samples = 0;
 static uint8_t s_full_latched = FALSE;
+static uint8_t s_sample_phase = BAT_PHASE_SETTLE;
+static uint8_t s_charge_polling = FALSE;
+static uint32_t s_period_ms = BAT_PERIOD_BASE_MS;
+static uint16_t s_slope_ref_mv = 0;
+static uint32_t s_slope_ref_rtc = 0;
+static uint8_t s_slope_ref_ready = FALSE;
+static kbd_battery_stats_t s_stats;
 
 /*============================================================================*/
 /*                              LiPo 电压 → 百分比                            */
@@ -209,6 +248,7 @@ static void battery_update_level(uint16_t mv, kbd_charge_state_t charge_state)
 }
 
 static uint16_t KBD_Battery_ProcessEvent(uint8_t task_id, uint16_t events);
+PROF_DEFINE_TASK(PROF_ZONE_BATTERY_TASK, KBD_Battery_ProcessEvent)
 
 /*============================================================================*/
 /*                              ADC 采样                                       */
@@ -268,26 +308,140 @@ static uint16_t abs_diff_u16(uint16_t a, uint16_t b)
   return (a > b) ? (a - b) : (b - a);
 }
 
+static uint32_t battery_elapsed_ms(uint32_t from)
+{
+  uint32_t ticks = HAL_SleepDistance(RTC_GetCycle32k(), from);
+  return (uint32_t)(((uint64_t)ticks * 1000u) / CAB_LSIFQ);
+}
+
 static void battery_schedule_periodic_refresh(void)
 {
   if (s_task_id != TASK_NO_TASK)
   {
-    tmos_start_task(s_task_id, BAT_PERIODIC_EVT, MS1_TO_SYSTEM_TIME(BAT_PERIODIC_MS));
+    tmos_start_task(s_task_id, BAT_PERIODIC_EVT, MS1_TO_SYSTEM_TIME(s_period_ms));
   }
 }
 
-static void battery_schedule_charge_poll(void)
+/**
+ * @brief 按最新滤波电压更新斜率估计并重新选择采样周期
+ */
+static void battery_update_period(void)
 {
+  uint32_t period = s_period_ms;
+  uint32_t elapsed_ms;
+  uint16_t delta_mv;
+  uint16_t rate = 0;
+  int32_t slope;
+
+  if (!s_slope_ref_ready)
+  {
+    s_slope_ref_mv = s_cached_voltage_mv;
+    s_slope_ref_rtc = RTC_GetCycle32k();
+    s_slope_ref_ready = TRUE;
+    return;
+  }
+
+  /*
+   * 相邻两次采样的差值多半在噪声里。参考点保持不动，直到电压变化超出
+   * 噪声带或窗口到期，再按整段时长折算斜率，慢速放电也能得到非零斜率。
+   */
+  elapsed_ms = battery_elapsed_ms(s_slope_ref_rtc);
+  delta_mv = abs_diff_u16(s_cached_voltage_mv, s_slope_ref_mv);
+  if (delta_mv > BAT_SLOPE_NOISE_MV || elapsed_ms >= BAT_SLOPE_WINDOW_MS)
+  {
+    if (elapsed_ms > 0u)
+    {
+      slope = (int32_t)((uint32_t)delta_mv * 60000u / elapsed_ms);
+      if (slope > INT16_MAX)
+      {
+        slope = INT16_MAX;
+      }
+      s_stats.slope_mv_min = (int16_t)((s_cached_voltage_mv < s_slope_ref_mv)
+                                           ? -slope
+                                           : slope);
+    }
+    s_slope_ref_mv = s_cached_voltage_mv;
+    s_slope_ref_rtc = RTC_GetCycle32k();
+  }
+  if (delta_mv > BAT_SLOPE_NOISE_MV)
+  {
+    rate = (uint16_t)((s_stats.slope_mv_min < 0) ? -s_stats.slope_mv_min
+                                                 : s_stats.slope_mv_min);
+  }
+
+  if (s_charge_state == BAT_CHG_CHARGING || rate >= BAT_SLOPE_FAST_MV_MIN)
+  {
+    period = BAT_PERIOD_MIN_MS;
+  }
+  else if (rate <= BAT_SLOPE_SLOW_MV_MIN &&
+           s_cached_level > BAT_PERIOD_LOW_LEVEL_PCT)
+  {
+    period = (s_period_ms < BAT_PERIOD_BASE_MS) ? BAT_PERIOD_BASE_MS
+                                                : s_period_ms * 2u;
+    if (period > BAT_PERIOD_MAX_MS)
+    {
+      period = BAT_PERIOD_MAX_MS;
+    }
+  }
+  else
+  {
+    period = BAT_PERIOD_BASE_MS;
+  }
+
+  if (period != s_period_ms)
+  {
+    LOG_I(TAG, "Sample period %lums slope=%dmV/min", (unsigned long)period,
+          s_stats.slope_mv_min);
+    s_period_ms = period;
+  }
+}
+
 #if KBD_HAS_CHARGE_DET
+static void battery_schedule_charge_poll(void)
+{
   if (s_task_id != TASK_NO_TASK)
   {
     tmos_start_task(s_task_id, BAT_CHARGE_POLL_EVT,
                     MS1_TO_SYSTEM_TIME(BAT_CHARGE_POLL_MS));
   }
-#endif
 }
 
-static void battery_poll_charge_state(void)
+static void battery_disable_charge_irq(void)
+{
+  R16_PA_INT_EN &= (uint16_t)~KBD_CHG_PIN;
+  GPIOA_ClearITFlagBit(KBD_CHG_PIN);
+}
+
+/**
+ * @brief CHRG 电平与当前状态一致时停止轮询，只等下一次反向边沿
+ *
+ * 中断只支持单边沿，按当前电平选择方向；配置后再读一次电平，
+ * 期间已经翻转则继续轮询，不会漏掉边沿。
+ */
+static void battery_arm_charge_irq(void)
+{
+  uint8_t raw = KBD_Battery_GetChargePinRaw();
+
+  GPIOA_ITModeCfg(KBD_CHG_PIN, raw ? GPIO_ITMode_FallEdge
+                                   : GPIO_ITMode_RiseEdge);
+  if (KBD_Battery_GetChargePinRaw() != raw)
+  {
+    battery_disable_charge_irq();
+    s_charge_polling = TRUE;
+    battery_schedule_charge_poll();
+    return;
+  }
+  s_charge_polling = FALSE;
+}
+#endif
+
+static void battery_start_sample(void);
+
+/**
+ * @brief CHRG 去抖一次
+ * @return TRUE 电平与滤波状态一致且没有候选计数，可以停止轮询
+ */
+static uint8_t battery_poll_charge_state(void)
 {
 #if KBD_HAS_CHARGE_DET
   uint8_t raw = KBD_Battery_GetChargePinRaw();
@@ -340,6 +494,7 @@ static void battery_poll_charge_state(void)
     }
   }
 
+  s_stats.charge_polls++;
   if (next_state != s_charge_state)
   {
     s_charge_state = next_state;
@@ -349,7 +504,18 @@ static void battery_poll_charge_state(void)
       battery_update_level(s_cached_voltage_mv, s_charge_state);
     }
     LOG_I(TAG, "Charge state=%d raw=%u", s_charge_state, raw);
+
+    /* 充电状态改变后端电压会跳变：立即补采一次并回到最短周期 */
+    s_period_ms = BAT_PERIOD_MIN_MS;
+    s_slope_ref_ready = FALSE;
+    battery_start_sample();
+    battery_schedule_periodic_refresh();
   }
+
+  return (s_charge_candidate_samples == 0u &&
+          (raw == 0u) == (s_charge_state == BAT_CHG_CHARGING));
+#else
+  return TRUE;
 #endif
 }
 
@@ -363,9 +529,28 @@ static void battery_start_sample(void)
   /* 常开诊断版中该引脚已保持高电平；保留此操作便于恢复脉冲采样。 */
   GPIOA_SetBits(KBD_VBAT_EN_PIN);
   s_sample_pending = TRUE;
+  s_sample_phase = BAT_PHASE_SETTLE;
   tmos_start_task(s_task_id, BAT_SAMPLE_EVT, MS1_TO_SYSTEM_TIME(BAT_SETTLE_MS));
 }
 
+/**
+ * @brief 分压已稳定：蓝牙连接中则等到下一个连接事件结束再转换
+ * @return TRUE 已登记等待，FALSE 应立即转换
+ */
+static uint8_t battery_wait_radio_idle(void)
+{
+  if (s_sample_phase != BAT_PHASE_SETTLE ||
+      !KBD_Mode_PostAfterRadioEvent(s_task_id, BAT_RADIO_IDLE_EVT))
+  {
+    return FALSE;
+  }
+
+  s_sample_phase = BAT_PHASE_RADIO;
+  tmos_start_task(s_task_id, BAT_SAMPLE_EVT,
+                  MS1_TO_SYSTEM_TIME(BAT_RADIO_WAIT_MS));
+  return TRUE;
+}
+
 static void battery_finish_sample(void)
 {
   uint16_t adc_raw;
@@ -450,6 +635,7 @@ static void battery_finish_sample(void)
   {
     LOG_W(TAG, "Reject battery sample: raw=%u mv=%u cached=%u", adc_raw,
           measured_mv, s_cached_voltage_mv);
+    s_stats.rejected++;
     s_sample_pending = FALSE;
     return;
   }
@@ -470,6 +656,11 @@ static void battery_finish_sample(void)
   battery_update_level(s_cached_voltage_mv, KBD_Battery_GetChargeState());
   s_cache_ready = TRUE;
   s_sample_pending = FALSE;
+  s_stats.samples++;
+
+  /* 周期从本次采样完成算起，手动刷新也会顺延下一次周期采样 */
+  battery_update_period();
+  battery_schedule_periodic_refresh();
 }
 
 /*============================================================================*/
@@ -505,7 +696,7 @@ void KBD_Battery_Init(void)
     s_adc_calib = -BAT_ADC_CALIB_LIMIT;
   }
 
-  s_task_id = TMOS_ProcessEventRegister(KBD_Battery_ProcessEvent);
+  s_task_id = TMOS_ProcessEventRegister(PROF_TASK(KBD_Battery_ProcessEvent));
   if (s_task_id == TASK_NO_TASK)
   {
     LOG_W(TAG, "Battery TMOS task register failed");
@@ -516,11 +707,13 @@ void KBD_Battery_Init(void)
   GPIOA_ModeCfg(KBD_CHG_PIN, GPIO_ModeIN_PU);
   s_charge_state = KBD_Battery_GetChargePinRaw() ? BAT_CHG_NONE
                                                  : BAT_CHG_CHARGING;
+  battery_arm_charge_irq();
 #endif
 
+  s_period_ms = (s_charge_state == BAT_CHG_CHARGING) ? BAT_PERIOD_MIN_MS
+                                                     : BAT_PERIOD_BASE_MS;
   KBD_Battery_RequestRefresh();
   battery_schedule_periodic_refresh();
-  battery_schedule_charge_poll();
   LOG_I(TAG, "Battery init: cached=%dmV calib=%d", s_cached_voltage_mv,
         s_adc_calib);
 }
@@ -587,6 +780,11 @@ void KBD_Battery_Suspend(void)
     tmos_stop_task(s_task_id, BAT_PERIODIC_EVT);
     tmos_stop_task(s_task_id, BAT_CHARGE_POLL_EVT);
   }
+#if KBD_HAS_CHARGE_DET
+  /* 休眠期间 CHRG 变化不唤醒键盘，恢复后按当前电平重新去抖 */
+  battery_disable_charge_irq();
+  s_charge_polling = FALSE;
+#endif
 #if !KBD_VBAT_DIVIDER_ALWAYS_ON
   /* 低功耗版在休眠时关闭分压。 */
   GPIOA_ResetBits(KBD_VBAT_EN_PIN);
@@ -601,16 +799,82 @@ void KBD_Battery_Resume(void)
 #endif
   KBD_Battery_RequestRefresh();
   battery_schedule_periodic_refresh();
+#if KBD_HAS_CHARGE_DET
+  s_charge_candidate_samples = 0;
+  s_charge_polling = TRUE;
   battery_schedule_charge_poll();
+#endif
+}
+
+void KBD_Battery_HandlePortIrq(gpio_port_t port)
+{
+#if KBD_HAS_CHARGE_DET
+  if (port != KBD_CHG_PORT || !(R16_PA_INT_EN & KBD_CHG_PIN) ||
+      !(GPIOA_ReadITFlagBit(KBD_CHG_PIN)))
+  {
+    return;
+  }
+
+  /* 关掉边沿中断，交给 TMOS 轮询去抖；稳定后重新打开 */
+  battery_disable_charge_irq();
+  s_charge_polling = TRUE;
+  s_stats.charge_irqs++;
+  KBD_Idle_SetEvent(s_task_id, BAT_CHARGE_POLL_EVT);
+#else
+  (void)port;
+#endif
+}
+
+void KBD_Battery_GetStats(kbd_battery_stats_t *out, uint8_t reset)
+{
+  *out = s_stats;
+  out->period_ms = s_period_ms;
+#if KBD_HAS_CHARGE_DET
+  out->charge_irq_armed = (uint8_t)(!s_charge_polling &&
+                                    (R16_PA_INT_EN & KBD_CHG_PIN) != 0);
+#else
+  out->charge_irq_armed = 0;
+#endif
+  if (reset)
+  {
+    int16_t slope = s_stats.slope_mv_min;
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_stats.slope_mv_min = slope;
+  }
 }
 
 static uint16_t KBD_Battery_ProcessEvent(uint8_t task_id, uint16_t events)
 {
   (void)task_id;
 
+  s_stats.wakeups++;
+
+  if (events & BAT_RADIO_IDLE_EVT)
+  {
+    /* 连接事件刚结束；断链时同样投递，此时直接转换 */
+    if (s_sample_pending && s_sample_phase == BAT_PHASE_RADIO)
+    {
+      tmos_stop_task(s_task_id, BAT_SAMPLE_EVT);
+      s_stats.aligned++;
+      battery_finish_sample();
+    }
+    return (events ^ BAT_RADIO_IDLE_EVT);
+  }
+
   if (events & BAT_SAMPLE_EVT)
   {
-    battery_finish_sample();
+    if (!s_sample_pending)
+    {
+      return (events ^ BAT_SAMPLE_EVT);
+    }
+    if (s_sample_phase == BAT_PHASE_RADIO)
+    {
+      s_stats.radio_timeouts++;
+    }
+    if (!battery_wait_radio_idle())
+    {
+      battery_finish_sample();
+    }
     return (events ^ BAT_SAMPLE_EVT);
   }
 
@@ -620,14 +884,23 @@ static uint16_t KBD_Battery_ProcessEvent(uint8_t task_id, uint16_t events)
     {
       battery_start_sample();
     }
+    /* 采样完成后按新周期重排；这里先按当前周期兜底 */
     battery_schedule_periodic_refresh();
     return (events ^ BAT_PERIODIC_EVT);
   }
 
   if (events & BAT_CHARGE_POLL_EVT)
   {
-    battery_poll_charge_state();
-    battery_schedule_charge_poll();
+#if KBD_HAS_CHARGE_DET
+    if (battery_poll_charge_state())
+    {
+      battery_arm_charge_irq();
+    }
+    else
+    {
+      battery_schedule_charge_poll();
+    }
+#endif
     return (events ^ BAT_CHARGE_POLL_EVT);
   }
 
@@ -0,0 +1,158 @@
+/**
+ * @file    kbd_input.c
+ * @brief   统一输入事件队列实现
+ */
+
+#include "kbd_input.h"
+#include "kbd_prof.h"
+#include "kbd_idle.h"
+#include "key.h"
+#include "ble_config.h"
+
+#include <string.h>
+
+#define STATIC_ASSERT(cond, msg) typedef char static_assert_##msg[(cond) ? 1 : -1]
+STATIC_ASSERT((KBD_INPUT_QUEUE_SIZE & (KBD_INPUT_QUEUE_SIZE - 1)) == 0,
+              input_queue_must_be_power_of_2);
+STATIC_ASSERT(KBD_INPUT_QUEUE_SIZE <= 128, input_queue_index_fits_uint8);
+
+#define INPUT_MASK (KBD_INPUT_QUEUE_SIZE - 1u)
+
+static volatile kbd_input_event_t s_queue[KBD_INPUT_QUEUE_SIZE];
+static volatile uint8_t s_wr = 0;
+static volatile uint8_t s_rd = 0;
+
+/* 入队通知目标 (初始化阶段登记，之后只读) */
+static uint8_t s_notify_task = TASK_NO_TASK;
+static uint16_t s_notify_event = 0;
+
+static volatile uint8_t s_high_water = 0;
+static volatile uint32_t s_pushed = 0;
+static volatile uint32_t s_dropped = 0;
+
+/* 延迟统计只在主循环 (出队) 和命令处理中访问 */
+static uint32_t s_lat_count = 0;
+static uint32_t s_lat_total = 0;
+static uint32_t s_lat_max = 0;
+
+static inline uint8_t Depth(void) {
+  return (uint8_t)((s_wr - s_rd) & INPUT_MASK);
+}
+
+/**
+ * @brief 写入一个槽位并推进写指针 (调用方已关中断并确认有空间)
+ */
+static inline void WriteSlot(uint8_t src, uint8_t code, uint8_t type,
+                             uint32_t tick_ms, uint32_t stamp) {
+  volatile kbd_input_event_t *e = &s_queue[s_wr];
+  e->src = src;
+  e->code = code;
+  e->type = type;
+  e->tick_ms = tick_ms;
+  e->stamp = stamp;
+  s_wr = (uint8_t)((s_wr + 1u) & INPUT_MASK);
+  s_pushed++;
+}
+
+__HIGH_CODE
+uint8_t KBD_Input_Push(uint8_t src, uint8_t code, uint8_t type, uint32_t tick_ms) {
+  uint32_t irq_status;
+  uint8_t ok = 0;
+
+  SYS_DisableAllIrq(&irq_status);
+  uint32_t stamp = KBD_Prof_Now();
+  if (Depth() < INPUT_MASK) {
+    WriteSlot(src, code, type, tick_ms, stamp);
+    uint8_t depth = Depth();
+    if (depth > s_high_water) {
+      s_high_water = depth;
+    }
+    ok = 1;
+  } else {
+    s_dropped++;
+  }
+  SYS_RecoverIrq(irq_status);
+
+  if (ok) {
+    KBD_Input_Notify();
+  }
+  return ok;
+}
+
+void KBD_Input_SetNotify(uint8_t task_id, uint16_t event) {
+  s_notify_task = task_id;
+  s_notify_event = event;
+}
+
+__HIGH_CODE
+void KBD_Input_Notify(void) { KBD_Idle_SetEvent(s_notify_task, s_notify_event); }
+
+void KBD_Input_Init(void) {
+  uint32_t irq_status;
+
+  SYS_DisableAllIrq(&irq_status);
+  s_wr = s_rd = 0;
+  s_high_water = 0;
+  s_pushed = 0;
+  s_dropped = 0;
+  SYS_RecoverIrq(irq_status);
+
+  s_lat_count = 0;
+  s_lat_total = 0;
+  s_lat_max = 0;
+}
+
+uint8_t KBD_Input_Pop(kbd_input_event_t *evt) {
+  uint8_t rd = s_rd;
+
+  if (evt == NULL || rd == s_wr) {
+    return 0;
+  }
+
+  /* 先拷贝再推进读指针，写端看到空位时槽位已读完 */
+  evt->src = s_queue[rd].src;
+  evt->code = s_queue[rd].code;
+  evt->type = s_queue[rd].type;
+  evt->reserved = 0;
+  evt->tick_ms = s_queue[rd].tick_ms;
+  evt->stamp = s_queue[rd].stamp;
+  s_rd = (uint8_t)((rd + 1u) & INPUT_MASK);
+
+  uint32_t lat = KBD_Prof_Now() - evt->stamp;
+  s_lat_count++;
+  s_lat_total = (s_lat_total > 0xFFFFFFFFu - lat) ? 0xFFFFFFFFu : s_lat_total + lat;
+  if (lat > s_lat_max) {
+    s_lat_max = lat;
+  }
+  return 1;
+}
+
+void KBD_Input_GetStats(kbd_input_stats_t *out, uint8_t reset) {
+  uint32_t irq_status;
+
+  if (out == NULL) {
+    return;
+  }
+
+  SYS_DisableAllIrq(&irq_status);
+  out->size = KBD_INPUT_QUEUE_SIZE;
+  out->depth = Depth();
+  out->high_water = s_high_water;
+  out->pushed = s_pushed;
+  out->dropped = s_dropped;
+  if (reset) {
+    s_high_water = out->depth;
+    s_pushed = 0;
+    s_dropped = 0;
+  }
+  SYS_RecoverIrq(irq_status);
+
+  out->lat_count = s_lat_count;
+  out->lat_total = s_lat_total;
+  out->lat_max = s_lat_max;
+  if (reset) {
+    s_lat_count = 0;
+    s_lat_total = 0;
+    s_lat_max = 0;
+  }
+}
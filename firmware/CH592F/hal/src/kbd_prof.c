@@ -0,0 +1,75 @@
+/**
+ * @file    kbd_prof.c
+ * @brief   命名 profiling 区段统计表
+ */
+
+#include "kbd_prof.h"
+
+#include <string.h>
+
+#if KBD_PROF_ENABLE
+
+static kbd_prof_stat_t s_prof[PROF_ZONE_COUNT] = {
+  [0 ... PROF_ZONE_COUNT - 1] = { 0, 0, 0xFFFFFFFFu, 0 },
+};
+
+__HIGH_CODE
+void KBD_Prof_Record(uint8_t zone, uint32_t cycles) {
+  kbd_prof_stat_t *s;
+  uint32_t irq_status;
+
+  if (zone >= PROF_ZONE_COUNT) {
+    return;
+  }
+
+  /* ISR 之间可嵌套抢占，同一区段的读改写需关中断保护 */
+  SYS_DisableAllIrq(&irq_status);
+  s = &s_prof[zone];
+  s->count++;
+  s->total = (s->total > 0xFFFFFFFFu - cycles) ? 0xFFFFFFFFu : s->total + cycles;
+  if (cycles < s->min) {
+    s->min = cycles;
+  }
+  if (cycles > s->max) {
+    s->max = cycles;
+  }
+  SYS_RecoverIrq(irq_status);
+}
+
+int KBD_Prof_Read(uint8_t zone, kbd_prof_stat_t *out, uint8_t reset) {
+  uint32_t irq_status;
+
+  if (zone >= PROF_ZONE_COUNT || out == NULL) {
+    return -1;
+  }
+
+  SYS_DisableAllIrq(&irq_status);
+  *out = s_prof[zone];
+  if (reset) {
+    s_prof[zone].count = 0;
+    s_prof[zone].total = 0;
+    s_prof[zone].min = 0xFFFFFFFFu;
+    s_prof[zone].max = 0;
+  }
+  SYS_RecoverIrq(irq_status);
+  return 0;
+}
+
+#else
+
+void KBD_Prof_Record(uint8_t zone, uint32_t cycles) {
+  (void)zone;
+  (void)cycles;
+}
+
+int KBD_Prof_Read(uint8_t zone, kbd_prof_stat_t *out, uint8_t reset) {
+  (void)reset;
+  if (zone >= PROF_ZONE_COUNT || out == NULL) {
+    return -1;
+  }
+  memset(out, 0, sizeof(*out));
+  out->min = 0xFFFFFFFFu;
+  return 0;
+}
+
+#endif /* KBD_PROF_ENABLE */
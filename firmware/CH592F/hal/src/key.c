@@ -1,11 +1,12 @@
 /**
  * @file    key.c
- * @brief   键盘按键驱动实现（GPIO 边沿中断 + 1ms 定时器锁定去抖 + 事件队列）
+ * @brief   键盘按键驱动实现（GPIO 边沿中断 + 单次截止定时器去抖 + 事件队列）
  *
  * @details
  * 一个“**中断驱动**”的按键模块，核心目标：
- * 1) 低 CPU 占用：按键变化由 GPIO 边沿中断触发，无需周期扫描；
- * 2) 去抖可靠：采用“锁定去抖（lockout）”——每次边沿后禁用该引脚中断一段时间；
+ * 1) 低 CPU 占用：按键变化由 GPIO 边沿中断触发，无需周期扫描，也没有周期定时中断；
+ * 2) 去抖可靠：默认“锁定去抖（lockout）”——每次边沿后禁用该引脚中断一段时间；
+ *    另可运行时切换为“延迟确认（defer）”或“按下锁定 + 松开延迟”（见第 6 节）；
  * 3) 上层易用：ISR 中只做轻量处理并将事件写入环形队列，上层轮询出队消费。
  *
  * ---------------------------------------------------------------------------
@@ -35,11 +36,11 @@
  *                                             | call
  *                      +----------------------v---------------------+
  *                      | HandleNormalKeyEdge(idx)                    |
- *                      |  - check lock_ms                            |
+ *                      |  - check wait (LOCK / DEFER)                |
  *                      |  - decide press/release by expect edge      |
- *                      |  - PushKeyEvent() into ring queue           |
+ *                      |  - PushKeyEvent() into input queue          |
  *                      |  - configure next edge                      |
- *                      |  - set lock_ms and DisablePinIrq()          |
+ *                      |  - set deadline and DisablePinIrq()         |
  *                      +----------------------+---------------------+
  *                                             |
  *                                             | OR (FN key)
@@ -48,25 +49,27 @@
  *                      |  - press  : store press_tick                |
  *                      |  - release: dur = now - press_tick          |
  *                      |             -> enqueue CLICK / LONG         |
- *                      |  - set lock_ms and DisablePinIrq()          |
+ *                      |  - set deadline and DisablePinIrq()         |
+ *                      |  - ScheduleTimer(): TMR0 one-shot for the   |
+ *                      |    earliest pending deadline               |
  *                      +----------------------+---------------------+
  *                                             |
- *                           (debounce unlock handled by 1ms timer)
+ *                           (fires only when a deadline is due)
  *                                             |
  *                      +----------------------v---------------------+
- *                      | TMR0_IRQHandler() (1ms)                     |
- *                      |  - s_tick_ms++                              |
- *                      |  - iterate all key/fn ctx                   |
- *                      |      lock_ms-- -> when reaches 0:           |
+ *                      | TMR0_IRQHandler() (one-shot)                |
+ *                      |  - stop TMR0                                |
+ *                      |  - for every expired key/fn deadline:       |
  *                      |        ClearPinIntFlag()                    |
  *                      |        EnablePinIrq()                       |
+ *                      |  - ScheduleTimer() for the next deadline    |
  *                      +----------------------+---------------------+
  *                                             |
- *                                             | polled by application
+ *                                             | KBD_Input_Notify() -> TMOS event
  *                                             v
  *                      +--------------------------------------------+
- *                      | Key_GetEvent() / FnKey_GetEvent()           |
- *                      |  - dequeue from ring buffer                 |
+ *                      | KBD_Input_Pop() in KBD_Core_Process()       |
+ *                      |  - dequeue in arrival order (all sources)   |
  *                      +--------------------------------------------+
  *
  * @endverbatim
@@ -86,10 +89,10 @@
  *              │                                           rise
  *              └────────────── 记录RELEASE, is_down=0, expect=0, 配置下降沿 ◀──
  *
- * 每次进入边沿处理都会：
- *   - lock_ms = KEY_LOCKOUT_MS
+ * 每次进入边沿处理都会（EAGER）：
+ *   - deadline = now + debounce_ms（SysTick 周期数）
  *   - DisablePinIrq() 进入锁定
- *   - 1ms 定时器递减 lock_ms，归零后再 EnablePinIrq()
+ *   - TMR0 单次定时到期后再 EnablePinIrq()
  * @endverbatim
  *
  * FN 键（点击/长按）：
@@ -105,42 +108,52 @@
  * @endverbatim
  *
  * ---------------------------------------------------------------------------
- * 4. 环形队列（ring buffer）与丢弃策略
+ * 4. 事件队列
  * ---------------------------------------------------------------------------
- * - KEY_QUEUE_SIZE / FNKEY_QUEUE_SIZE 必须为 2 的幂（用 & 掩码实现回绕）
- * - 写指针 next == 读指针 表示队列满：当前实现“直接丢弃新事件”
+ * - 普通键 / FN 键 / 旋钮共用 kbd_input.h 中的统一输入队列，按入队顺序出队
+ * - 队列满时丢弃新事件（不覆盖旧事件），丢弃数与高水位可通过 HID 读取
  *
  * ---------------------------------------------------------------------------
  * 5. 并发与时序注意事项
  * ---------------------------------------------------------------------------
- * - Push 在 ISR 中执行；GetEvent 在主循环执行（单写者/单读者模型）
- * - 索引与队列元素声明为 volatile，避免编译器优化导致的可见性问题
- * - 若平台对 8-bit 读写并非原子，需在 GetEvent 时临界区保护（此处保持你的原实现不改）
+ * - Push 在 ISR 中执行并投递核心任务事件；出队在核心任务 KBD_Core_Process 中执行
+ * - GPIO 与 TMR0 ISR 优先级不同可能互相抢占，入队在极短临界区内完成
+ *
+ * ---------------------------------------------------------------------------
+ * 6. 去抖算法（Key_SetDebounce，仅普通键）
+ * ---------------------------------------------------------------------------
+ * - EAGER     ：边沿立即上报，锁定 N ms，期间屏蔽该引脚（原实现）
+ * - DEFER     ：边沿进入确认窗口，引脚改为监听“回弹”方向的边沿，每次回弹都把
+ *               截止时刻推后 N ms；到期时电平已稳定 N ms，为新状态则上报，
+ *               回到原状态视为毛刺丢弃
+ * - ASYMMETRIC：按下走 EAGER，松开走 DEFER（兼顾首键延迟与松开抖动）
+ * 事件时间戳为确认时刻，DEFER 的附加延迟即最后一次抖动后的 N ms。
+ *
+ * ---------------------------------------------------------------------------
+ * 7. 时间基准（tickless）
+ * ---------------------------------------------------------------------------
+ * - 毫秒时间戳由 SysTick 64 位自由计数换算（CH59x_BLEInit 中启动，HCLK 计数），
+ *   不再由定时中断累加；CPU 暂停 (WFI) 时 SysTick 持续运行
+ * - RTC Sleep 期间 HCLK 停止、SysTick 不计数，唤醒后 kbd_idle 以实际睡眠的
+ *   RTC 周期调用 Key_CompensateSleep()，毫秒时间戳随之补偿
+ * - 有待处理窗口时 Key_IsTimerPending() 为真，kbd_idle 不进入 Sleep（TMR0 需要 HCLK）
+ * - 锁定 / 确认窗口记录绝对截止时刻（SysTick 低 32 位，约 71s 回绕，差值比较）
+ * - TMR0 只作为单次定时器，按最早的截止时刻编程；没有待处理窗口时停止，
+ *   CPU 只在确实需要解锁时被唤醒
+ * 各算法在合成抖动波形下的延迟 / 毛刺抑制率见 tools/scripts/debounce_sim.py。
  */
 
 #include "key.h"
 #include "kbd_config.h"
 #include "kbd_mode.h"
 #include "encoder.h"
+#include "matrix.h"
+#include "kbd_prof.h"
+#include "kbd_input.h"
+#include "kbd_battery.h"
 
 #include <string.h>
 
-/* ============================================================================
- * Compile-time checks
- * ============================================================================
- */
-
-/**
- * @brief 编译期静态断言（用于约束队列长度必须为 2 的幂等）。
- * @note 触发断言时会产生负数组长度导致编译失败。
- */
-#define STATIC_ASSERT(cond, msg) typedef char static_assert_##msg[(cond) ? 1 : -1]
-
-/** @brief 普通按键队列大小必须为 2 的幂。 */
-STATIC_ASSERT((KEY_QUEUE_SIZE & (KEY_QUEUE_SIZE - 1)) == 0, key_queue_must_be_power_of_2);
-/** @brief FN 按键队列大小必须为 2 的幂。 */
-STATIC_ASSERT((FNKEY_QUEUE_SIZE & (FNKEY_QUEUE_SIZE - 1)) == 0, fn_queue_must_be_power_of_2);
-
 /* ============================================================================
  * Pin mapping
  * ============================================================================
@@ -198,51 +211,107 @@ static const kbd_key_pin_t g_fn_pins[KBD_FN_NUM_KEYS] = {
 static const kbd_key_pin_t g_boot_pin = {KBD_FN_BOOT_PORT, KBD_FN_BOOT_PIN};
 
 /* ============================================================================
- * Queues (ring buffers)
+ * Time base (SysTick free-running) and deadlines
  * ============================================================================
  */
 
+/** @brief 每毫秒的 SysTick 计数（HCLK）。 */
+#define KEY_CYCLES_PER_MS (FREQ_SYS / 1000u)
+
+/** @brief 截止时刻已过时的最小单次定时（约 1us），保证到期项尽快处理。 */
+#define KEY_TIMER_MIN_CYCLES (FREQ_SYS / 1000000u)
+
+/** @brief TMR0 计数上限（26 位）。 */
+#define KEY_TIMER_MAX_CYCLES 0x03FFFFFFu
+
+/** @brief 等待类型：无。 */
+#define KEY_WAIT_NONE 0
+/** @brief 等待类型：锁定，到期后重新使能引脚中断。 */
+#define KEY_WAIT_LOCK 1
+/** @brief 等待类型：延迟确认，到期时电平已稳定 N ms。 */
+#define KEY_WAIT_DEFER 2
+
 /**
- * @brief 普通按键事件队列（环形缓冲）。
- * @note
- * - Push: ISR
- * - Pop : 主循环
- * - 满时丢弃新事件（Push 直接 return）
+ * @brief 读取 SysTick 64 位计数（RV32 上分两次读，高位变化时重读）。
  */
-static volatile key_event_t s_key_queue[KEY_QUEUE_SIZE];
-/** @brief 普通按键队列写指针。 */
-static volatile uint8_t s_key_wr = 0;
-/** @brief 普通按键队列读指针。 */
-static volatile uint8_t s_key_rd = 0;
+static inline uint64_t ReadSysTick64(void)
+{
+    volatile uint32_t *cnt = (volatile uint32_t *)&SysTick->CNT;
+    uint32_t hi, lo;
+
+    do
+    {
+        hi = cnt[1];
+        lo = cnt[0];
+    } while (hi != cnt[1]);
+
+    return ((uint64_t)hi << 32) | lo;
+}
 
 /**
- * @brief FN 按键事件队列（环形缓冲）。
+ * @brief 当前 SysTick 低 32 位，用于截止时刻比较（约 71s 回绕，差值比较不受影响）。
  */
-static volatile fnkey_event_t s_fn_queue[FNKEY_QUEUE_SIZE];
-/** @brief FN 队列写指针。 */
-static volatile uint8_t s_fn_wr = 0;
-/** @brief FN 队列读指针。 */
-static volatile uint8_t s_fn_rd = 0;
+static inline uint32_t NowCycles(void) { return *(volatile uint32_t *)&SysTick->CNT; }
 
-/* ============================================================================
- * Driver tick (1ms) for timestamps and lockout countdown
- * ============================================================================
+/**
+ * @brief 截止时刻是否已到。
  */
+static inline uint8_t DeadlineDue(uint32_t deadline, uint32_t now)
+{
+    return ((int32_t)(deadline - now) <= 0) ? 1 : 0;
+}
 
 /**
- * @brief 1ms tick 计数（在 TMR0_IRQHandler 中自增）。
- * @details
- * 用途：
- * - 事件时间戳 tick_ms
- * - lockout 倒计时的时间基准（每次中断减 1）
+ * @brief RTC Sleep 累计补偿的 SysTick 周期数。
+ * @note 只在关中断的 idle 钩子中写入，ISR 与主循环读取时不会看到半更新的值。
  */
-static volatile uint32_t s_tick_ms = 0;
+static volatile uint64_t s_sleep_cycles = 0;
 
 /**
- * @brief 获取当前毫秒 tick。
- * @return 自 Key_Init() 起累计的毫秒数。
+ * @brief Key_GetTickMs 的毫秒基准及其对应的累计周期数（含 Sleep 补偿）。
+ * @note 只在关中断时读写。
  */
-static inline uint32_t GetTickMs(void) { return s_tick_ms; }
+static uint32_t s_ms_base = 0;
+static uint64_t s_ms_base_cycles = 0;
+
+/** @brief 长时间未调用时基准单步前移的毫秒数（对应周期数 < 2^32）。 */
+#define KEY_MS_CHUNK (0xFFFFFFFFu / KEY_CYCLES_PER_MS)
+
+/** @brief TMR0 是否已按待处理截止时刻编程（ScheduleTimer 维护）。 */
+static volatile uint8_t s_timer_pending = 0;
+
+/**
+ * @brief 获取当前毫秒 tick（SysTick 换算 + Sleep 补偿，见 key.h）。
+ */
+uint32_t Key_GetTickMs(void)
+{
+    uint32_t irq_status;
+    uint32_t ms;
+
+    /* 基准随每次调用前移，差值通常远小于 2^32，只需 32 位除法（避免 __udivdi3） */
+    SYS_DisableAllIrq(&irq_status);
+    uint64_t delta = ReadSysTick64() + s_sleep_cycles - s_ms_base_cycles;
+    while ((uint32_t)(delta >> 32) != 0)
+    {
+        s_ms_base += KEY_MS_CHUNK;
+        s_ms_base_cycles += (uint64_t)KEY_MS_CHUNK * KEY_CYCLES_PER_MS;
+        delta -= (uint64_t)KEY_MS_CHUNK * KEY_CYCLES_PER_MS;
+    }
+    ms = (uint32_t)delta / KEY_CYCLES_PER_MS;
+    s_ms_base += ms;
+    s_ms_base_cycles += (uint64_t)ms * KEY_CYCLES_PER_MS;
+    ms = s_ms_base;
+    SYS_RecoverIrq(irq_status);
+
+    return ms;
+}
+
+void Key_CompensateSleep(uint32_t rtc_cycles)
+{
+    s_sleep_cycles += (uint64_t)rtc_cycles * FREQ_SYS / CAB_LSIFQ;
+}
+
+uint8_t Key_IsTimerPending(void) { return s_timer_pending; }
 
 /* ============================================================================
  * Contexts
@@ -250,18 +319,24 @@ static inline uint32_t GetTickMs(void) { return s_tick_ms; }
  */
 
 /**
- * @brief 普通按键上下文（边沿 + 锁定去抖）。
+ * @brief 普通按键上下文（边沿 + 截止时刻去抖）。
  */
 typedef struct
 {
-    volatile uint16_t lock_ms; /**< 锁定倒计时（ms）。>0 表示锁定中。 */
-    volatile uint8_t is_down;  /**< 当前是否按下（1=按下，0=松开）。 */
-    volatile uint8_t expect;   /**< 期待的边沿：0=按下(下降沿)，1=松开(上升沿)。 */
+    volatile uint32_t deadline; /**< 锁定 / 确认窗口截止时刻（SysTick 低 32 位）。 */
+    volatile uint8_t wait;      /**< KEY_WAIT_*，非 NONE 时 deadline 有效。 */
+    volatile uint8_t is_down;   /**< 当前是否按下（1=按下，0=松开）。 */
+    volatile uint8_t expect;    /**< 期待的边沿：0=按下(下降沿)，1=松开(上升沿)。 */
 } key_ctx_t;
 
 /** @brief 普通按键上下文数组（每个键一个 ctx）。 */
 static volatile key_ctx_t s_key_ctx[KBD_SCAN_KEY_COUNT];
 
+/** @brief 普通按键去抖算法（key_debounce_mode_t）。 */
+static volatile uint8_t s_debounce_mode = KEY_DEBOUNCE_EAGER;
+/** @brief 普通按键去抖时间（ms）。 */
+static volatile uint8_t s_debounce_ms = KEY_LOCKOUT_MS;
+
 /**
  * @brief FN 按键上下文（边沿 + 锁定去抖 + 按下时间戳）。
  * @details
@@ -269,7 +344,8 @@ static volatile key_ctx_t s_key_ctx[KBD_SCAN_KEY_COUNT];
  */
 typedef struct
 {
-    volatile uint16_t lock_ms;    /**< 锁定倒计时（ms）。 */
+    volatile uint32_t deadline;   /**< 锁定截止时刻（SysTick 低 32 位）。 */
+    volatile uint8_t wait;        /**< KEY_WAIT_NONE / KEY_WAIT_LOCK。 */
     volatile uint8_t is_down;     /**< 当前是否按下（1=按下，0=松开）。 */
     volatile uint8_t expect;      /**< 期待边沿：0=按下(下降沿)，1=松开(上升沿)。 */
     volatile uint32_t press_tick; /**< 按下边沿发生时的 tick（ms）。 */
@@ -387,80 +463,87 @@ static inline uint8_t ReadPinLevel(const kbd_key_pin_t *pin)
  */
 
 /**
- * @brief 向普通按键队列写入一个事件（ISR 内调用）。
+ * @brief 向统一输入队列写入一个普通按键事件（ISR 内调用）。
  * @param key     按键索引
  * @param type    事件类型（KEY_EVT_PRESS/KEY_EVT_RELEASE）
  * @param tick_ms 时间戳
- * @note 队列满时丢弃新事件（不覆盖旧事件）。
+ * @note 队列满时丢弃新事件并计数（不覆盖旧事件）。
  */
 static inline void PushKeyEvent(uint8_t key, uint8_t type, uint32_t tick_ms)
 {
-    uint8_t next = (uint8_t)((s_key_wr + 1) & (KEY_QUEUE_SIZE - 1));
-    if (next == s_key_rd)
-        return;
-    s_key_queue[s_key_wr].key = key;
-    s_key_queue[s_key_wr].type = type;
-    s_key_queue[s_key_wr].tick_ms = tick_ms;
-    s_key_wr = next;
+    (void)KBD_Input_Push(KBD_INPUT_SRC_KEY, key, type, tick_ms);
 }
 
 /**
- * @brief 向 FN 队列写入一个事件（ISR 内调用）。
+ * @brief 向统一输入队列写入一个 FN 事件（ISR 内调用）。
  * @param id      FN 键索引
  * @param type    事件类型（FNKEY_EVT_CLICK/FNKEY_EVT_LONG）
  * @param tick_ms 时间戳
- * @note 队列满时丢弃新事件。
+ * @note 队列满时丢弃新事件并计数。
  */
 static inline void PushFnEvent(uint8_t id, uint8_t type, uint32_t tick_ms)
 {
-    uint8_t next = (uint8_t)((s_fn_wr + 1) & (FNKEY_QUEUE_SIZE - 1));
-    if (next == s_fn_rd)
-        return;
-    s_fn_queue[s_fn_wr].id = id;
-    s_fn_queue[s_fn_wr].type = type;
-    s_fn_queue[s_fn_wr].tick_ms = tick_ms;
-    s_fn_wr = next;
+    (void)KBD_Input_Push(KBD_INPUT_SRC_FN, id, type, tick_ms);
 }
 
 /* ============================================================================
- * Timer (TMR0 1ms)
+ * Timer (TMR0 one-shot)
  * ============================================================================
  */
 
 /**
- * @brief 1ms 定时器是否已启动。
- */
-static volatile uint8_t s_timer_active = 0;
-
-/**
- * @brief 启动 1ms 定时器（TMR0）。
+ * @brief 按最早的待处理截止时刻编程 TMR0 单次定时；无待处理项时停止 TMR0。
  * @details
- * 用于：
- * - 提供 s_tick_ms 时间戳
- * - 驱动 key/fn 的 lock_ms 倒计时并在归零时重新使能引脚中断
+ * GPIO 与 TMR0 中断优先级不同可能互相抢占，编程过程放在临界区内。
+ * TMR0_TimerInit() 会清零计数并重新开始，因此每次调用都是一次新的单次定时。
  */
-static inline void StartTimer1ms(void)
+static void ScheduleTimer(void)
 {
-    if (s_timer_active)
-        return;
+    uint32_t irq_status;
+    uint32_t now;
+    uint32_t earliest = 0xFFFFFFFFu;
+    uint8_t pending = 0;
 
-    TMR0_TimerInit(FREQ_SYS / 1000); /* 1ms */
-    TMR0_ITCfg(ENABLE, TMR0_3_IT_CYC_END);
-    PFIC_SetPriority(TMR0_IRQn, TIMER_IRQ_PRIORITY);
-    PFIC_EnableIRQ(TMR0_IRQn);
+    SYS_DisableAllIrq(&irq_status);
+    now = NowCycles();
 
-    s_timer_active = 1;
-}
+    for (uint8_t i = 0; i < KBD_SCAN_KEY_COUNT; i++)
+    {
+        if (s_key_ctx[i].wait == KEY_WAIT_NONE)
+            continue;
+        uint32_t d = s_key_ctx[i].deadline - now;
+        if ((int32_t)d <= 0)
+            d = KEY_TIMER_MIN_CYCLES;
+        if (d < earliest)
+            earliest = d;
+        pending = 1;
+    }
 
-/**
- * @brief 停止 1ms 定时器（TMR0）。
- */
-static inline void StopTimer1ms(void)
-{
-    TMR0_ITCfg(DISABLE, TMR0_3_IT_CYC_END);
-    PFIC_DisableIRQ(TMR0_IRQn);
+    for (uint8_t id = 0; id < KBD_FN_NUM_KEYS; id++)
+    {
+        if (s_fn_ctx[id].wait == KEY_WAIT_NONE)
+            continue;
+        uint32_t d = s_fn_ctx[id].deadline - now;
+        if ((int32_t)d <= 0)
+            d = KEY_TIMER_MIN_CYCLES;
+        if (d < earliest)
+            earliest = d;
+        pending = 1;
+    }
+
+    TMR0_Disable();
     TMR0_ClearITFlag(TMR0_3_IT_CYC_END);
-    s_timer_active = 0;
+    if (pending)
+    {
+        if (earliest < KEY_TIMER_MIN_CYCLES)
+            earliest = KEY_TIMER_MIN_CYCLES;
+        else if (earliest > KEY_TIMER_MAX_CYCLES)
+            earliest = KEY_TIMER_MAX_CYCLES;
+        TMR0_TimerInit(earliest);
+    }
+    s_timer_pending = pending;
+
+    SYS_RecoverIrq(irq_status);
 }
 
 /* ============================================================================
@@ -469,24 +552,36 @@ static inline void StopTimer1ms(void)
  */
 
 /**
- * @brief 处理普通按键的边沿中断（press/release + lockout）。
+ * @brief 当前算法下该方向的边沿是否需要延迟确认。
+ * @param pressing 1=按下边沿，0=松开边沿
+ */
+static inline uint8_t UseDeferredDebounce(uint8_t pressing)
+{
+    uint8_t mode = s_debounce_mode;
+    return (mode == KEY_DEBOUNCE_DEFER) || (mode == KEY_DEBOUNCE_ASYMMETRIC && !pressing);
+}
+
+/**
+ * @brief 按当前电平配置“离开当前电平”方向的边沿（确认窗口内监听回弹）。
+ * @param pin 引脚描述
+ */
+static inline void ConfigPinEdgeFromLevel(const kbd_key_pin_t *pin)
+{
+    if (ReadPinLevel(pin) == 0)
+        ConfigPinRiseEdge(pin);
+    else
+        ConfigPinFallEdge(pin);
+}
+
+/**
+ * @brief 确认一次普通按键边沿：推送事件并配置下一次期待的边沿。
  * @param idx 扫描按键索引
- * @details
- * - lock_ms>0：忽略（仍处于锁定去抖）
- * - expect==0：认为是按下边沿，推送 PRESS，必要时切换到 rise edge 等 release
- * - expect==1：认为是松开边沿，推送 RELEASE，并切回 fall edge 等下一次 press
- * - 处理结束后：
- *     - lock_ms = KEY_LOCKOUT_MS
- *     - DisablePinIrq()（锁定期间不再响应该引脚中断）
+ * @param now 事件时间戳
  */
-static inline void HandleNormalKeyEdge(uint8_t idx)
+static inline void CommitNormalKeyEdge(uint8_t idx, uint32_t now)
 {
     const kbd_key_pin_t *pin = &g_key_pins[idx];
     uint8_t logical_key = g_key_logical_ids[idx];
-    if (s_key_ctx[idx].lock_ms > 0)
-        return;
-
-    uint32_t now = GetTickMs();
 
     if (s_key_ctx[idx].expect == 0)
     {
@@ -507,9 +602,71 @@ static inline void HandleNormalKeyEdge(uint8_t idx)
         s_key_ctx[idx].expect = 0;
         ConfigPinFallEdge(pin);
     }
+}
 
-    s_key_ctx[idx].lock_ms = KEY_LOCKOUT_MS;
-    DisablePinIrq(pin->port, pin->pin);
+/**
+ * @brief 处理普通按键的边沿中断（press/release + 去抖）。
+ * @param idx 扫描按键索引
+ * @details
+ * - 锁定中：忽略
+ * - 确认窗口中（回弹）：截止时刻推后 N ms，按当前电平重新监听回弹
+ * - 需要延迟确认：进入确认窗口，监听回弹
+ * - 否则立即确认（CommitNormalKeyEdge），锁定 N ms 并 DisablePinIrq()
+ * - 最后按最早截止时刻重新编程 TMR0
+ */
+static inline void HandleNormalKeyEdge(uint8_t idx)
+{
+    const kbd_key_pin_t *pin = &g_key_pins[idx];
+    uint32_t window = (uint32_t)s_debounce_ms * KEY_CYCLES_PER_MS;
+
+    if (s_key_ctx[idx].wait == KEY_WAIT_LOCK)
+        return;
+
+    if (s_key_ctx[idx].wait == KEY_WAIT_DEFER || UseDeferredDebounce(s_key_ctx[idx].expect == 0))
+    {
+        s_key_ctx[idx].wait = KEY_WAIT_DEFER;
+        s_key_ctx[idx].deadline = NowCycles() + window;
+        ConfigPinEdgeFromLevel(pin);
+    }
+    else
+    {
+        CommitNormalKeyEdge(idx, Key_GetTickMs());
+        s_key_ctx[idx].wait = KEY_WAIT_LOCK;
+        s_key_ctx[idx].deadline = NowCycles() + window;
+        DisablePinIrq(pin->port, pin->pin);
+    }
+
+    ScheduleTimer();
+}
+
+/**
+ * @brief 普通按键截止时刻到期（TMR0 中调用）。
+ * @param idx 扫描按键索引
+ * @details
+ * - 锁定到期：重新使能引脚中断
+ * - 确认窗口到期：电平已稳定 N ms，为期待的新状态则确认，否则视为毛刺丢弃，
+ *   并恢复监听期待方向的边沿
+ */
+static inline void ExpireNormalKey(uint8_t idx)
+{
+    const kbd_key_pin_t *pin = &g_key_pins[idx];
+
+    if (s_key_ctx[idx].wait == KEY_WAIT_DEFER)
+    {
+        uint8_t want_down = (s_key_ctx[idx].expect == 0) ? 1 : 0;
+        uint8_t now_down = (ReadPinLevel(pin) == 0) ? 1 : 0;
+
+        if (now_down == want_down)
+            CommitNormalKeyEdge(idx, Key_GetTickMs());
+        else if (s_key_ctx[idx].expect == 0)
+            ConfigPinFallEdge(pin);
+        else
+            ConfigPinRiseEdge(pin);
+    }
+
+    s_key_ctx[idx].wait = KEY_WAIT_NONE;
+    ClearPinItFlag(pin->port, pin->pin);
+    EnablePinIrq(pin->port, pin->pin);
 }
 
 /**
@@ -518,15 +675,15 @@ static inline void HandleNormalKeyEdge(uint8_t idx)
  * @details
  * - 按下沿：记录 press_tick，并配置上升沿等待 release
  * - 松开沿：dur=now-press_tick，dur>=FN_LONG_PRESS_MS -> LONG，否则 CLICK
- * - 每次边沿后都进入 lockout：禁用引脚中断，等待 1ms 定时器解锁
+ * - 每次边沿后都进入 lockout：禁用引脚中断，等待单次定时到期解锁
  */
 static inline void HandleFnKeyEdge(uint8_t id)
 {
     const kbd_key_pin_t *pin = &g_fn_pins[id];
-    if (s_fn_ctx[id].lock_ms > 0)
+    if (s_fn_ctx[id].wait != KEY_WAIT_NONE)
         return;
 
-    uint32_t now = GetTickMs();
+    uint32_t now = Key_GetTickMs();
 
     if (s_fn_ctx[id].expect == 0)
     {
@@ -554,8 +711,10 @@ static inline void HandleFnKeyEdge(uint8_t id)
         }
     }
 
-    s_fn_ctx[id].lock_ms = FN_LOCKOUT_MS;
+    s_fn_ctx[id].wait = KEY_WAIT_LOCK;
+    s_fn_ctx[id].deadline = NowCycles() + (uint32_t)FN_LOCKOUT_MS * KEY_CYCLES_PER_MS;
     DisablePinIrq(pin->port, pin->pin);
+    ScheduleTimer();
 }
 
 /* ============================================================================
@@ -614,72 +773,71 @@ static inline void HandlePortIrq(gpio_port_t port)
     }
 
     Encoder_HandlePortIrq(port);
+    Matrix_HandlePortIrq(port);
+    KBD_Battery_HandlePortIrq(port);
 }
 
 /**
  * @brief GPIOA 端口中断服务函数。
  */
-__INTERRUPT __HIGH_CODE void GPIOA_IRQHandler(void) { HandlePortIrq(GPIO_PORT_A); }
+__INTERRUPT __HIGH_CODE void GPIOA_IRQHandler(void)
+{
+    PROF_ZONE_BEGIN(PROF_ZONE_GPIOA_IRQ);
+    HandlePortIrq(GPIO_PORT_A);
+    PROF_ZONE_END(PROF_ZONE_GPIOA_IRQ);
+}
 
 /**
  * @brief GPIOB 端口中断服务函数。
  */
-__INTERRUPT __HIGH_CODE void GPIOB_IRQHandler(void) { HandlePortIrq(GPIO_PORT_B); }
+__INTERRUPT __HIGH_CODE void GPIOB_IRQHandler(void)
+{
+    PROF_ZONE_BEGIN(PROF_ZONE_GPIOB_IRQ);
+    HandlePortIrq(GPIO_PORT_B);
+    PROF_ZONE_END(PROF_ZONE_GPIOB_IRQ);
+}
 
 /* ============================================================================
- * TMR0 IRQ: tick + unlock
+ * TMR0 IRQ: deadline expiry
  * ============================================================================
  */
 
 /**
- * @brief TMR0 中断服务函数：1ms tick + lockout 倒计时 + 解锁引脚中断。
+ * @brief TMR0 中断服务函数：单次定时到期，处理所有已到期的截止时刻。
  * @details
- * - 每 1ms：
- *   - s_tick_ms++
- *   - 遍历所有普通键 ctx：若 lock_ms>0 则 lock_ms--，到 0 时清 flag 并 EnablePinIrq()
- *   - 遍历所有 FN 键 ctx：同理
+ * - 停止 TMR0（单次）
+ * - 遍历普通键 / FN 键 ctx：截止时刻已到的解锁或完成确认
+ * - 按剩余最早截止时刻重新编程 TMR0（无待处理项则保持停止）
  */
 __INTERRUPT __HIGH_CODE void TMR0_IRQHandler(void)
 {
     if (!TMR0_GetITFlag(TMR0_3_IT_CYC_END))
         return;
     TMR0_ClearITFlag(TMR0_3_IT_CYC_END);
+    TMR0_Disable();
 
-    s_tick_ms++;
+    PROF_ZONE_BEGIN(PROF_ZONE_TMR0_IRQ);
+    uint32_t now = NowCycles();
 
     for (uint8_t i = 0; i < KBD_SCAN_KEY_COUNT; i++)
     {
-        uint16_t lm = s_key_ctx[i].lock_ms;
-        if (lm == 0)
-            continue;
-        lm--;
-        s_key_ctx[i].lock_ms = lm;
-        if (lm == 0)
-        {
-            gpio_port_t port = g_key_pins[i].port;
-            uint32_t pin = g_key_pins[i].pin;
-            ClearPinItFlag(port, pin);
-            EnablePinIrq(port, pin);
-        }
+        if (s_key_ctx[i].wait != KEY_WAIT_NONE && DeadlineDue(s_key_ctx[i].deadline, now))
+            ExpireNormalKey(i);
     }
 
     for (uint8_t id = 0; id < KBD_FN_NUM_KEYS; id++)
     {
-        uint16_t lm = s_fn_ctx[id].lock_ms;
-        if (lm == 0)
+        if (s_fn_ctx[id].wait == KEY_WAIT_NONE || !DeadlineDue(s_fn_ctx[id].deadline, now))
             continue;
-        lm--;
-        s_fn_ctx[id].lock_ms = lm;
-        if (lm == 0)
-        {
-            gpio_port_t port = g_fn_pins[id].port;
-            uint32_t pin = g_fn_pins[id].pin;
-            ClearPinItFlag(port, pin);
-            EnablePinIrq(port, pin);
-        }
+        gpio_port_t port = g_fn_pins[id].port;
+        uint32_t pin = g_fn_pins[id].pin;
+        s_fn_ctx[id].wait = KEY_WAIT_NONE;
+        ClearPinItFlag(port, pin);
+        EnablePinIrq(port, pin);
     }
 
-    Encoder_TimerTick1ms();
+    ScheduleTimer();
+    PROF_ZONE_END(PROF_ZONE_TMR0_IRQ);
 }
 
 /* ============================================================================
@@ -687,38 +845,6 @@ __INTERRUPT __HIGH_CODE void TMR0_IRQHandler(void)
  * ============================================================================
  */
 
-/**
- * @brief 从普通按键队列获取一个事件（出队）。
- * @param[out] evt 事件输出
- * @return 1=成功；0=无事件或参数无效
- */
-uint8_t Key_GetEvent(key_event_t *evt)
-{
-    if (evt == NULL)
-        return 0;
-    if (s_key_rd == s_key_wr)
-        return 0;
-    *evt = s_key_queue[s_key_rd];
-    s_key_rd = (uint8_t)((s_key_rd + 1) & (KEY_QUEUE_SIZE - 1));
-    return 1;
-}
-
-/**
- * @brief 从 FN 队列获取一个事件（出队）。
- * @param[out] evt 事件输出
- * @return 1=成功；0=无事件或参数无效
- */
-uint8_t FnKey_GetEvent(fnkey_event_t *evt)
-{
-    if (evt == NULL)
-        return 0;
-    if (s_fn_rd == s_fn_wr)
-        return 0;
-    *evt = s_fn_queue[s_fn_rd];
-    s_fn_rd = (uint8_t)((s_fn_rd + 1) & (FNKEY_QUEUE_SIZE - 1));
-    return 1;
-}
-
 /**
  * @brief 查询普通按键是否按下。
  * @param key_index 按键索引
@@ -733,7 +859,7 @@ int8_t Key_IsDown(uint8_t key_index)
             return s_key_ctx[i].is_down ? 1 : 0;
         }
     }
-    return -1;
+    return Matrix_IsDown(key_index);
 }
 
 /**
@@ -766,9 +892,7 @@ void Key_Init(void)
     memset((void *)s_key_ctx, 0, sizeof(s_key_ctx));
     memset((void *)s_fn_ctx, 0, sizeof(s_fn_ctx));
 
-    s_key_rd = s_key_wr = 0;
-    s_fn_rd = s_fn_wr = 0;
-    s_tick_ms = 0;
+    KBD_Input_Init();
 
     /* BOOT: input only. */
     ConfigPinInputPullup(&g_boot_pin);
@@ -781,7 +905,7 @@ void Key_Init(void)
 
         uint8_t level = ReadPinLevel(pin);
         s_key_ctx[i].is_down = (level == 0) ? 1 : 0;
-        s_key_ctx[i].lock_ms = 0;
+        s_key_ctx[i].wait = KEY_WAIT_NONE;
 
         /* 若初始化时已按下(level=0)，下一次应期待 release(上升沿)；否则期待 press(下降沿) */
         s_key_ctx[i].expect = (level == 0) ? 1 : 0;
@@ -805,7 +929,7 @@ void Key_Init(void)
         uint8_t level = ReadPinLevel(pin);
 
         s_fn_ctx[id].is_down = (level == 0) ? 1 : 0;
-        s_fn_ctx[id].lock_ms = 0;
+        s_fn_ctx[id].wait = KEY_WAIT_NONE;
 
         /* 关键：强制下一次当成“按下沿” */
         s_fn_ctx[id].expect = 0;
@@ -823,45 +947,66 @@ void Key_Init(void)
     PFIC_EnableIRQ(GPIO_A_IRQn);
     PFIC_EnableIRQ(GPIO_B_IRQn);
 
-    StartTimer1ms();
+    /* TMR0 仅在有截止时刻待处理时由 ScheduleTimer() 启动 */
+    TMR0_Disable();
+    TMR0_ClearITFlag(TMR0_3_IT_CYC_END);
+    TMR0_ITCfg(ENABLE, TMR0_3_IT_CYC_END);
+    PFIC_SetPriority(TMR0_IRQn, TIMER_IRQ_PRIORITY);
+    PFIC_EnableIRQ(TMR0_IRQn);
 }
 
 /**
- * @brief 进入低功耗：停止 1ms 定时器，解除所有 lockout 并重新使能引脚 IRQ。
- * @note 1ms 定时器停止后 lock_ms 无法递减，若不强制解锁会导致处于锁定中的键无法唤醒系统。
+ * @brief 设置普通按键去抖算法与时间（见 key.h 文档）。
+ */
+void Key_SetDebounce(uint8_t mode, uint8_t ms)
+{
+    if (mode >= KEY_DEBOUNCE_COUNT)
+        mode = KEY_DEBOUNCE_EAGER;
+    if (ms == 0)
+        ms = 1;
+    else if (ms > KEY_DEBOUNCE_MAX_MS)
+        ms = KEY_DEBOUNCE_MAX_MS;
+
+    s_debounce_mode = mode;
+    s_debounce_ms = ms;
+    Matrix_SetDebounce(mode, ms);
+}
+
+/**
+ * @brief 进入低功耗：解除所有 lockout / defer 窗口、重新使能引脚 IRQ 并停止 TMR0。
+ * @note 休眠期间不再处理截止时刻，若不强制解锁会导致处于锁定中的键无法唤醒系统。
  *       30s+ 空闲进入休眠时硬件上不存在抖动，可安全强制解锁。
  */
 void Key_EnterSleep(void)
 {
     Encoder_EnterSleep();
+    Matrix_EnterSleep();
 
     for (uint8_t i = 0; i < KBD_SCAN_KEY_COUNT; i++)
     {
         const kbd_key_pin_t *pin = &g_key_pins[i];
-        s_key_ctx[i].lock_ms = 0;
+        s_key_ctx[i].wait = KEY_WAIT_NONE;
         ClearPinItFlag(pin->port, pin->pin);
         EnablePinIrq(pin->port, pin->pin);
     }
     for (uint8_t id = 0; id < KBD_FN_NUM_KEYS; id++)
     {
         const kbd_key_pin_t *pin = &g_fn_pins[id];
-        s_fn_ctx[id].lock_ms = 0;
+        s_fn_ctx[id].wait = KEY_WAIT_NONE;
         ClearPinItFlag(pin->port, pin->pin);
         EnablePinIrq(pin->port, pin->pin);
     }
 
-    if (s_timer_active)
-        StopTimer1ms();
+    ScheduleTimer();
 }
 
 /**
- * @brief 退出低功耗：启动 1ms 定时器。
+ * @brief 退出低功耗：恢复旋钮状态（TMR0 由下一次边沿按需启动）。
  */
 void Key_ExitSleep(void)
 {
     Encoder_ExitSleep();
-    if (!s_timer_active)
-        StartTimer1ms();
+    Matrix_ExitSleep();
 }
 
 /**
@@ -892,5 +1037,7 @@ void Key_ConfigDeepSleepWakeup(void)
         EnablePinIrq(pin->port, pin->pin);
     }
 
+    Matrix_ConfigDeepSleepWakeup();
+
     PWR_PeriphWakeUpCfg(ENABLE, RB_SLP_GPIO_WAKE, Long_Delay);
 }
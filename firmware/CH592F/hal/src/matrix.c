@@ -0,0 +1,355 @@
+#include "matrix.h"
+
+#if defined(KBD_HAS_MATRIX)
+
+#include "kbd_input.h"
+#include "kbd_idle.h"
+#include "ble_config.h"
+
+#include <string.h>
+
+#define STATIC_ASSERT(cond, msg) typedef char static_assert_##msg[(cond) ? 1 : -1]
+STATIC_ASSERT(KBD_MATRIX_COLS <= 32, matrix_cols_fit_row_word);
+STATIC_ASSERT(KBD_MATRIX_KEY_BASE + KBD_MATRIX_ROWS * KBD_MATRIX_COLS <= 255,
+              matrix_keys_fit_uint8_index);
+
+#define MATRIX_SCAN_EVT 0x0001
+
+/* 扫描周期：1 个 TMOS tick (625us) */
+#define MATRIX_SCAN_TICKS 1u
+/* 毫秒 -> 扫描次数：ms / 0.625 = ms * 8 / 5，向上取整 (分子加除数减一) */
+#define MATRIX_MS_TO_SCANS(ms) (((uint16_t)(ms) * 8u + (5u - 1u)) / 5u)
+/* 行切换后等待列线稳定 */
+#define MATRIX_SETTLE_US 1u
+
+static const kbd_key_pin_t g_row_pins[KBD_MATRIX_ROWS] = KBD_MATRIX_ROW_PINS;
+static const kbd_key_pin_t g_col_pins[KBD_MATRIX_COLS] = KBD_MATRIX_COL_PINS;
+
+/* 行 / 列在各端口上的位掩码，用于整口读写 */
+static uint32_t s_row_mask_a = 0;
+static uint32_t s_row_mask_b = 0;
+static uint32_t s_col_mask_a = 0;
+static uint32_t s_col_mask_b = 0;
+
+/* 去抖后的状态，bit c = 第 c 列按下 */
+static uint32_t s_stable[KBD_MATRIX_ROWS];
+/* 正在计数的键 (计数非 0) */
+static uint32_t s_pending[KBD_MATRIX_ROWS];
+/* EAGER 上报后的锁定键 */
+static uint32_t s_locked[KBD_MATRIX_ROWS];
+static uint8_t s_count[KBD_MATRIX_ROWS][KBD_MATRIX_COLS];
+
+static uint8_t s_debounce_mode = KEY_DEBOUNCE_EAGER;
+static uint8_t s_debounce_scans = MATRIX_MS_TO_SCANS(KEY_LOCKOUT_MS);
+
+static volatile uint8_t s_scanning = 0;
+static tmosTaskID s_task_id = TASK_NO_TASK;
+
+static inline void ClearColItFlags(void) {
+  if (s_col_mask_a) {
+    GPIOA_ClearITFlagBit(s_col_mask_a);
+  }
+  if (s_col_mask_b) {
+    GPIOB_ClearITFlagBit(s_col_mask_b);
+  }
+}
+
+static inline void EnableColIrqs(void) {
+  R16_PA_INT_EN |= (uint16_t)s_col_mask_a;
+  R16_PB_INT_EN |= (uint16_t)s_col_mask_b;
+}
+
+static inline void DisableColIrqs(void) {
+  R16_PA_INT_EN &= (uint16_t)~s_col_mask_a;
+  R16_PB_INT_EN &= (uint16_t)~s_col_mask_b;
+}
+
+static inline void DriveAllRows(uint8_t low) {
+  if (low) {
+    GPIOA_ResetBits(s_row_mask_a);
+    GPIOB_ResetBits(s_row_mask_b);
+  } else {
+    GPIOA_SetBits(s_row_mask_a);
+    GPIOB_SetBits(s_row_mask_b);
+  }
+}
+
+static inline void DriveRow(const kbd_key_pin_t *pin, uint8_t low) {
+  if (pin->port == GPIO_PORT_A) {
+    if (low) {
+      GPIOA_ResetBits(pin->pin);
+    } else {
+      GPIOA_SetBits(pin->pin);
+    }
+  } else {
+    if (low) {
+      GPIOB_ResetBits(pin->pin);
+    } else {
+      GPIOB_SetBits(pin->pin);
+    }
+  }
+}
+
+/**
+ * @brief 任意列为低电平 (所有行拉低时即“有键按下”)
+ */
+static inline uint8_t AnyColumnLow(void) {
+  return ((R32_PA_PIN & s_col_mask_a) != s_col_mask_a) ||
+         ((R32_PB_PIN & s_col_mask_b) != s_col_mask_b);
+}
+
+/**
+ * @brief 读取一行：拉低该行，两个端口各读一次，再拼出列位图
+ */
+static uint32_t ReadRow(uint8_t row) {
+  const kbd_key_pin_t *row_pin = &g_row_pins[row];
+  uint32_t pa;
+  uint32_t pb;
+  uint32_t bits = 0;
+
+  DriveRow(row_pin, 1);
+  DelayUs(MATRIX_SETTLE_US);
+  pa = R32_PA_PIN;
+  pb = R32_PB_PIN;
+  DriveRow(row_pin, 0);
+
+  for (uint8_t c = 0; c < KBD_MATRIX_COLS; c++) {
+    uint32_t v = (g_col_pins[c].port == GPIO_PORT_A) ? pa : pb;
+    if ((v & g_col_pins[c].pin) == 0) {
+      bits |= (1u << c);
+    }
+  }
+  return bits;
+}
+
+static inline void PushMatrixEvent(uint8_t row, uint8_t col, uint8_t pressed) {
+  uint8_t key = (uint8_t)(KBD_MATRIX_KEY_BASE + row * KBD_MATRIX_COLS + col);
+  (void)KBD_Input_Push(KBD_INPUT_SRC_KEY, key,
+                       pressed ? KEY_EVT_PRESS : KEY_EVT_RELEASE,
+                       Key_GetTickMs());
+}
+
+/**
+ * @brief 扫描一遍矩阵并去抖
+ * @return 非 0 表示仍有键按下或去抖未完成，需要继续扫描
+ */
+static uint8_t ScanOnce(void) {
+  uint8_t active = 0;
+
+  DriveAllRows(0);
+  for (uint8_t r = 0; r < KBD_MATRIX_ROWS; r++) {
+    uint32_t raw = ReadRow(r);
+
+    /* 整行无变化且无计数：跳过逐列处理 */
+    if (raw == s_stable[r] && s_pending[r] == 0 && s_locked[r] == 0) {
+      active |= (s_stable[r] != 0);
+      continue;
+    }
+
+    for (uint8_t c = 0; c < KBD_MATRIX_COLS; c++) {
+      uint32_t bit = 1u << c;
+      uint8_t *cnt = &s_count[r][c];
+
+      if (s_locked[r] & bit) {
+        if (++(*cnt) >= s_debounce_scans) {
+          *cnt = 0;
+          s_locked[r] &= ~bit;
+        }
+        continue;
+      }
+
+      uint8_t raw_on = (raw & bit) != 0;
+      if (raw_on == ((s_stable[r] & bit) != 0)) {
+        *cnt = 0;
+        s_pending[r] &= ~bit;
+        continue;
+      }
+
+      uint8_t eager = (s_debounce_mode == KEY_DEBOUNCE_EAGER) ||
+                      (s_debounce_mode == KEY_DEBOUNCE_ASYMMETRIC && raw_on);
+      if (!eager && ++(*cnt) < s_debounce_scans) {
+        s_pending[r] |= bit;
+        continue;
+      }
+
+      s_stable[r] ^= bit;
+      s_pending[r] &= ~bit;
+      *cnt = 0;
+      if (eager) {
+        s_locked[r] |= bit;
+      }
+      PushMatrixEvent(r, c, raw_on);
+    }
+
+    active |= (s_stable[r] != 0) || (s_pending[r] != 0) || (s_locked[r] != 0);
+  }
+  return active;
+}
+
+/**
+ * @brief 进入中断待命：所有行拉低，列下降沿中断
+ * @param check 为 1 时检查待命前已按下的键并立即恢复扫描
+ */
+static void ArmIdle(uint8_t check) {
+  s_scanning = 0;
+  DriveAllRows(1);
+  DelayUs(MATRIX_SETTLE_US);
+  ClearColItFlags();
+  EnableColIrqs();
+
+  /* 关扫描与开中断之间按下的键不会产生边沿 */
+  if (check && AnyColumnLow()) {
+    DisableColIrqs();
+    s_scanning = 1;
+    tmos_set_event(s_task_id, MATRIX_SCAN_EVT);
+  }
+}
+
+static uint16_t Matrix_ProcessEvent(uint8_t task_id, uint16_t events) {
+  if (events & MATRIX_SCAN_EVT) {
+    if (ScanOnce() || !KBD_MATRIX_IDLE_IRQ) {
+      tmos_start_task(task_id, MATRIX_SCAN_EVT, MATRIX_SCAN_TICKS);
+    } else {
+      ArmIdle(1);
+    }
+    return (events ^ MATRIX_SCAN_EVT);
+  }
+  return 0;
+}
+
+void Matrix_Init(void) {
+  memset(s_stable, 0, sizeof(s_stable));
+  memset(s_pending, 0, sizeof(s_pending));
+  memset(s_locked, 0, sizeof(s_locked));
+  memset(s_count, 0, sizeof(s_count));
+  s_row_mask_a = s_row_mask_b = 0;
+  s_col_mask_a = s_col_mask_b = 0;
+
+  for (uint8_t r = 0; r < KBD_MATRIX_ROWS; r++) {
+    if (g_row_pins[r].port == GPIO_PORT_A) {
+      s_row_mask_a |= g_row_pins[r].pin;
+    } else {
+      s_row_mask_b |= g_row_pins[r].pin;
+    }
+  }
+  for (uint8_t c = 0; c < KBD_MATRIX_COLS; c++) {
+    if (g_col_pins[c].port == GPIO_PORT_A) {
+      s_col_mask_a |= g_col_pins[c].pin;
+    } else {
+      s_col_mask_b |= g_col_pins[c].pin;
+    }
+  }
+
+  /* 行：推挽输出，默认高；列：上拉输入 + 下降沿 */
+  GPIOA_SetBits(s_row_mask_a);
+  GPIOB_SetBits(s_row_mask_b);
+  if (s_row_mask_a) {
+    GPIOA_ModeCfg(s_row_mask_a, GPIO_ModeOut_PP_5mA);
+  }
+  if (s_row_mask_b) {
+    GPIOB_ModeCfg(s_row_mask_b, GPIO_ModeOut_PP_5mA);
+  }
+  if (s_col_mask_a) {
+    GPIOA_ModeCfg(s_col_mask_a, GPIO_ModeIN_PU);
+    GPIOA_ITModeCfg(s_col_mask_a, GPIO_ITMode_FallEdge);
+  }
+  if (s_col_mask_b) {
+    GPIOB_ModeCfg(s_col_mask_b, GPIO_ModeIN_PU);
+    GPIOB_ITModeCfg(s_col_mask_b, GPIO_ITMode_FallEdge);
+  }
+  DisableColIrqs();
+
+  s_task_id = TMOS_ProcessEventRegister(Matrix_ProcessEvent);
+  if (s_task_id == TASK_NO_TASK) {
+    return;
+  }
+
+  /* 先扫一遍，上电时已按住的键也能上报 */
+  s_scanning = 1;
+  tmos_set_event(s_task_id, MATRIX_SCAN_EVT);
+}
+
+void Matrix_SetDebounce(uint8_t mode, uint8_t ms) {
+  uint16_t scans = MATRIX_MS_TO_SCANS(ms);
+  s_debounce_mode = mode;
+  s_debounce_scans = scans ? (uint8_t)((scans > 255u) ? 255u : scans) : 1u;
+}
+
+void Matrix_HandlePortIrq(gpio_port_t port) {
+  uint32_t mask = (port == GPIO_PORT_A) ? s_col_mask_a : s_col_mask_b;
+  uint32_t flags = (port == GPIO_PORT_A) ? GPIOA_ReadITFlagPort() : GPIOB_ReadITFlagPort();
+
+  if ((flags & mask) == 0) {
+    return;
+  }
+
+  ClearColItFlags();
+  if (s_scanning || s_task_id == TASK_NO_TASK) {
+    return;
+  }
+
+  /* 进入扫描：关列中断，由 TMOS 任务接管 */
+  DisableColIrqs();
+  s_scanning = 1;
+  KBD_Idle_SetEvent(s_task_id, MATRIX_SCAN_EVT);
+}
+
+int8_t Matrix_IsDown(uint8_t key_index) {
+  if (key_index < KBD_MATRIX_KEY_BASE) {
+    return -1;
+  }
+  uint8_t idx = (uint8_t)(key_index - KBD_MATRIX_KEY_BASE);
+  if (idx >= KBD_MATRIX_ROWS * KBD_MATRIX_COLS) {
+    return -1;
+  }
+  return (s_stable[idx / KBD_MATRIX_COLS] & (1u << (idx % KBD_MATRIX_COLS))) ? 1 : 0;
+}
+
+void Matrix_EnterSleep(void) {
+  if (s_task_id == TASK_NO_TASK) {
+    return;
+  }
+  /* 休眠期间不扫描，状态保留，唤醒后补扫一遍 */
+  tmos_stop_task(s_task_id, MATRIX_SCAN_EVT);
+  tmos_clear_event(s_task_id, MATRIX_SCAN_EVT);
+  ArmIdle(0);
+}
+
+void Matrix_ExitSleep(void) {
+  if (s_task_id == TASK_NO_TASK) {
+    return;
+  }
+  DisableColIrqs();
+  s_scanning = 1;
+  tmos_set_event(s_task_id, MATRIX_SCAN_EVT);
+}
+
+void Matrix_ConfigDeepSleepWakeup(void) {
+  DriveAllRows(1);
+  if (s_col_mask_a) {
+    GPIOA_ITModeCfg(s_col_mask_a, GPIO_ITMode_LowLevel);
+  }
+  if (s_col_mask_b) {
+    GPIOB_ITModeCfg(s_col_mask_b, GPIO_ITMode_LowLevel);
+  }
+  ClearColItFlags();
+  EnableColIrqs();
+}
+
+#else
+
+void Matrix_Init(void) {}
+void Matrix_SetDebounce(uint8_t mode, uint8_t ms) {
+  (void)mode;
+  (void)ms;
+}
+void Matrix_HandlePortIrq(gpio_port_t port) { (void)port; }
+int8_t Matrix_IsDown(uint8_t key_index) {
+  (void)key_index;
+  return -1;
+}
+void Matrix_EnterSleep(void) {}
+void Matrix_ExitSleep(void) {}
+void Matrix_ConfigDeepSleepWakeup(void) {}
+
+#endif
@@ -371,3 +371,8 @@ void WS2812_Sleep(void) {
 void WS2812_Wakeup(void) {
   GPIOA_ModeCfg(WS2812_PIN, GPIO_ModeOut_PP_5mA);
 }
+
+/**
+ * @brief LED 是否供电中
+ */
+uint8_t WS2812_IsPowered(void) { return s_rgb_powered; }
@@ -0,0 +1,125 @@
+/**
+ * @file    kbd_blackbox.h
+ * @brief   MeowKeyboard 黑匣子 (post-mortem trace)
+ * @author  MeowKJ
+ * @version V1.0.0
+ * @date    2024-11-07
+ *
+ * @details
+ * 在 RAM 中镜像 KBD_Log_* 的最近 N 条事件（按键 / 层 / 蓝牙 / 模式 / Flash 错误），
+ * 仅在故障、进入休眠或看门狗预警时整页追加写入 DataFlash 专用区域，
+ * 断电重启后可通过 HID 命令批量读出分析。
+ *
+ * - 区域按 256B 页轮转追加，每次 flush 写下一页，自然均衡擦写
+ * - 记录路径只写 RAM，不在按键路径上产生任何 Flash 操作
+ *
+ * @copyright Copyright (c) 2024 MeowKJ. All rights reserved.
+ */
+
+#ifndef __KBD_BLACKBOX_H
+#define __KBD_BLACKBOX_H
+
+#include <stdint.h>
+#include "kbd_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ======================= 配置 ======================= */
+
+#ifndef KBD_BLACKBOX_ENABLE
+#define KBD_BLACKBOX_ENABLE 1
+#endif
+
+#define KBD_BLACKBOX_BASE        0x3000u  /**< DataFlash 区域起始 */
+#define KBD_BLACKBOX_SIZE        0x1000u  /**< 区域大小 (4KB) */
+#define KBD_BLACKBOX_PAGE_SIZE   0x0100u  /**< 单页大小，与 EEPROM_PAGE_SIZE 一致 */
+#define KBD_BLACKBOX_PAGE_COUNT  (KBD_BLACKBOX_SIZE / KBD_BLACKBOX_PAGE_SIZE) /* 16 */
+#define KBD_BLACKBOX_MAGIC       0x42425832u /* 'BBX2'，9 字节条目 (旧 'BBOX' 页忽略) */
+#define KBD_BLACKBOX_ENTRY_COUNT 26       /**< 每页条目数 (16B 头 + 26 × 9B + 6B 填充) */
+
+/* ======================= 类型 ======================= */
+
+/**
+ * @brief flush 原因 (写入页头，便于区分正常休眠与异常)
+ */
+typedef enum {
+    KBD_BLACKBOX_REASON_SLEEP = 0x01,    /**< 进入 LIGHT 休眠 */
+    KBD_BLACKBOX_REASON_SHUTDOWN = 0x02, /**< 进入 DEEP 休眠 (掉电) */
+    KBD_BLACKBOX_REASON_FAULT = 0x03,    /**< HardFault 等异常 */
+    KBD_BLACKBOX_REASON_WDOG = 0x04,     /**< 看门狗预警 */
+} kbd_blackbox_reason_t;
+
+#define KBD_BLACKBOX_ENTRY_DATA 4 /**< 单条记录数据字节数 (按键 / FN 事件最长 4 字节) */
+
+/**
+ * @brief 单条记录 (9 字节)
+ */
+typedef struct __attribute__((packed)) {
+    uint32_t rtc_tick; /**< RTC 32K 计数 (低 32 位) */
+    uint8_t category;  /**< kbd_log_category_t */
+    uint8_t data[KBD_BLACKBOX_ENTRY_DATA]; /**< 日志数据，不足补 0 */
+} kbd_blackbox_entry_t;
+
+/**
+ * @brief 页结构 (256 字节)，RAM 中直接作为环形缓冲使用
+ *
+ * entries[] 按环形顺序存放：最早的一条位于 head (count 满时)，
+ * 上位机按 head / count 还原时间顺序。
+ */
+typedef struct __attribute__((packed)) {
+    uint32_t magic;   /**< KBD_BLACKBOX_MAGIC */
+    uint32_t seq;     /**< 追加序号 (越大越新) */
+    uint8_t head;     /**< 下一条写入位置 */
+    uint8_t count;    /**< 有效条目数 */
+    uint8_t reason;   /**< kbd_blackbox_reason_t */
+    uint8_t reserved;
+    uint32_t crc32;   /**< entries[] 的 CRC32 */
+    kbd_blackbox_entry_t entries[KBD_BLACKBOX_ENTRY_COUNT];
+    uint8_t pad[KBD_BLACKBOX_PAGE_SIZE - 16 -
+                KBD_BLACKBOX_ENTRY_COUNT * sizeof(kbd_blackbox_entry_t)]; /**< 补齐整页 */
+} kbd_blackbox_page_t;
+
+/* ======================= API ======================= */
+
+/**
+ * @brief 初始化黑匣子，扫描区域找到最新页（不加载旧记录）
+ */
+void KBD_BlackBox_Init(void);
+
+/**
+ * @brief 记录一条事件 (仅写 RAM)
+ *
+ * @param category 日志类别 (kbd_log_category_t)
+ * @param data     日志数据
+ * @param len      数据长度 (超过 KBD_BLACKBOX_ENTRY_DATA 截断)
+ */
+void KBD_BlackBox_Record(uint8_t category, const uint8_t *data, uint8_t len);
+
+/**
+ * @brief 将 RAM 记录追加写入 DataFlash 下一页
+ *
+ * @note 仅在故障 / 休眠 / 看门狗预警等非按键路径调用；
+ *       自上次 flush 以来无新记录时直接返回（故障除外）。
+ *
+ * @param reason flush 原因 (kbd_blackbox_reason_t)
+ * @return 0 成功 (含无需写入)
+ * @return -1 擦除失败
+ * @return -2 写入失败
+ */
+int KBD_BlackBox_Flush(uint8_t reason);
+
+/**
+ * @brief 获取最新一页的页号与序号
+ *
+ * @param[out] page 最新页号 (0xFF = 区域为空，可为 NULL)
+ * @param[out] seq  最新页序号 (可为 NULL)
+ */
+void KBD_BlackBox_GetLatest(uint8_t *page, uint32_t *seq);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __KBD_BLACKBOX_H */
@@ -0,0 +1,109 @@
+/**
+ * @file    kbd_boot.h
+ * @brief   MeowKeyboard 启动时间线与延后初始化
+ * @author  MeowKJ
+ * @version V1.0.0
+ * @date    2024-11-07
+ *
+ * @details
+ * main() 中每个初始化阶段结束时打一个时间戳 (RTC 32K 计数)，
+ * 上位机通过 KBD_CMD_BOOT_TIMELINE 读回各阶段相对复位的耗时。
+ *
+ * - 关键路径 (时钟 / BLE 库 / 按键 / 存储 / 协议栈 / 模式) 仍在 main() 中串行完成
+ * - 非关键模块 (日志、RGB 灯效、电池 ADC 校准) 由 TMOS 任务在主循环启动后
+ *   逐个执行，每步之间让出调度，USB 枚举和 BLE 广播不必等待它们
+ * - 记录上电后和 LIGHT 唤醒后第一次按键的时间，用于衡量首键延迟
+ *
+ * @copyright Copyright (c) 2024 MeowKJ. All rights reserved.
+ */
+
+#ifndef __KBD_BOOT_H
+#define __KBD_BOOT_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ======================= 配置 ======================= */
+
+#define KBD_BOOT_TICK_HZ     32768u     /**< 时间戳单位 (RTC 32K) */
+#define KBD_BOOT_TICK_NONE   0xFFFFFFFFu /**< 阶段未到达 */
+
+/* ======================= 类型 ======================= */
+
+/**
+ * @brief 启动阶段 (按发生顺序)
+ */
+typedef enum {
+    KBD_BOOT_STAGE_RESET = 0,      /**< 进入 main() */
+    KBD_BOOT_STAGE_CLOCK,          /**< 系统时钟 / DCDC / 调试串口 */
+    KBD_BOOT_STAGE_BLE_INIT,       /**< CH59x_BLEInit + HAL_Init */
+    KBD_BOOT_STAGE_DRIVERS,        /**< 按键 / 旋钮驱动 */
+    KBD_BOOT_STAGE_STORAGE,        /**< 配置加载 + 黑匣子扫描 */
+    KBD_BOOT_STAGE_PROTOCOL,       /**< GAP / 命令 / RGB 硬件 / 核心 / 宏 */
+    KBD_BOOT_STAGE_READY,          /**< 模式管理器完成，USB 枚举或 BLE 广播已发起 */
+    KBD_BOOT_STAGE_LOOP,           /**< 进入主循环 */
+    KBD_BOOT_STAGE_DEFER_LOG,      /**< 延后: HID 日志 */
+    KBD_BOOT_STAGE_DEFER_RGB,      /**< 延后: RGB 灯效调度 */
+    KBD_BOOT_STAGE_DEFER_BATTERY,  /**< 延后: 电池 ADC 校准 + 首次采样 */
+    KBD_BOOT_STAGE_FIRST_KEY,      /**< 上电后第一次按键事件 */
+    KBD_BOOT_STAGE_COUNT
+} kbd_boot_stage_t;
+
+/* ======================= API ======================= */
+
+/**
+ * @brief 记录阶段时间戳 (每个阶段只记录第一次)
+ *
+ * @param stage 阶段 (kbd_boot_stage_t)
+ */
+void KBD_Boot_Mark(uint8_t stage);
+
+/**
+ * @brief RTC 计数重载前调用 (HAL_Init 之前，SysTick 须已启动)
+ */
+void KBD_Boot_RtcReloadBegin(void);
+
+/**
+ * @brief RTC 计数重载后调用 (HAL_Init 之后)，把后续时间戳平移到重载前的时间轴
+ */
+void KBD_Boot_RtcReloadEnd(void);
+
+/**
+ * @brief 注册延后初始化任务 (main() 末尾、进入主循环前调用)
+ */
+void KBD_Boot_Start(void);
+
+/**
+ * @brief 按键事件通知，用于统计首键时间 (上电 / 唤醒)
+ */
+void KBD_Boot_OnKey(void);
+
+/**
+ * @brief LIGHT 休眠唤醒通知，开始统计唤醒后首键延迟
+ * @note 在唤醒中断 (KBD_Mode_RequestWake) 中调用，早于唤醒键进入核心任务
+ */
+void KBD_Boot_OnWake(void);
+
+/**
+ * @brief 获取阶段相对 RESET 的偏移
+ *
+ * @param stage 阶段 (kbd_boot_stage_t)
+ * @return 偏移 (RTC 32K tick)，未到达返回 KBD_BOOT_TICK_NONE
+ */
+uint32_t KBD_Boot_GetStage(uint8_t stage);
+
+/**
+ * @brief 获取最近一次唤醒到首键的延迟
+ *
+ * @return 延迟 (RTC 32K tick)，尚无记录返回 KBD_BOOT_TICK_NONE
+ */
+uint32_t KBD_Boot_GetWakeLatency(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __KBD_BOOT_H */
@@ -30,6 +30,16 @@ extern "C" {
 
 typedef void (*kbd_command_response_sender_t)(const uint8_t *frame, uint8_t len);
 
+/**
+ * @brief USB 配置端点命令帧队列深度
+ *
+ * USB 中断只把命令帧入队，由命令任务在主循环中处理，与 BLE 配置服务串行执行；
+ * 队列满时在中断中直接回复 BUSY。
+ */
+#ifndef KBD_CMD_USB_RX_FRAMES
+#define KBD_CMD_USB_RX_FRAMES 2
+#endif
+
 /*============================================================================*/
 /**
  * @defgroup KBD_CMD_API 命令处理接口
@@ -38,18 +48,51 @@ typedef void (*kbd_command_response_sender_t)(const uint8_t *frame, uint8_t len)
  */
 
 /**
- * @brief 初始化命令处理器
+ * @brief 初始化命令处理器 (注册命令任务，TMOS 初始化之后调用)
  */
 void KBD_Command_Init(void);
 
+/**
+ * @brief USB 配置端点收到命令帧 (USB 中断中调用)
+ *
+ * 帧被复制进队列，由命令任务经 KBD_Command_Submit 处理，响应走 USB。
+ *
+ * @param[in] frame 命令帧指针
+ */
+void KBD_Command_PostUsb(const kbd_cmd_frame_t *frame);
+
+/**
+ * @brief 从指定通道提交一帧命令 (主循环上下文)
+ *
+ * USB 与 BLE 配置服务的命令都经此串行处理。另一通道的命令仍有延迟响应
+ * 未发出 (配置保存、宏擦写、IAP 页写入) 时回复 KBD_RESP_ERR_BUSY，
+ * 避免延迟响应的通道被覆盖。
+ *
+ * @param[in] frame  命令帧指针
+ * @param[in] sender 响应发送器，NULL 表示 USB HID 配置端点
+ * @return 0 成功
+ * @return -1 未知命令
+ * @return -2 另一通道忙
+ */
+int KBD_Command_Submit(const kbd_cmd_frame_t *frame, kbd_command_response_sender_t sender);
+
 /**
  * @brief 临时覆盖命令响应发送通道
  *
- * 传入 NULL 时恢复默认 USB HID 配置端点。BLE 配置服务在处理一帧
- * 命令前设置发送器，处理完成后恢复 NULL。
+ * 传入 NULL 时恢复默认 USB HID 配置端点。延迟完成的命令在发送响应前
+ * 切换到提交时的发送器，发送后恢复。
  */
 void KBD_Command_SetResponseSender(kbd_command_response_sender_t sender);
 
+/**
+ * @brief 读取当前响应发送器
+ *
+ * 延迟完成的命令 (宏擦写) 在提交时记下发送器，完成后经同一通道回复。
+ *
+ * @return 当前发送器，NULL 表示 USB HID 配置端点
+ */
+kbd_command_response_sender_t KBD_Command_GetResponseSender(void);
+
 /**
  * @brief 处理 HID 配置命令
  *
@@ -35,7 +35,7 @@ extern "C" {
  */
 
 /**
- * @brief 初始化键盘核心模块
+ * @brief 初始化键盘核心模块，注册核心输入任务
  * @note  需要在以下模块初始化之后调用：
  *        - Key_Init()
  *        - KBD_Storage_Init()
@@ -45,12 +45,11 @@ extern "C" {
 void KBD_Core_Init(void);
 
 /**
- * @brief 核心处理函数（主循环调用）
- * @details 内部处理：
+ * @brief 核心处理函数
+ * @details 由核心任务在输入入队、旋钮转动或旋钮上报周期到达时调用，内部处理：
  *          - 普通按键事件
  *          - FN 按键事件
- *          - BOOT 键检测
- *          - RGB 效果更新
+ *          - 旋钮合并上报
  */
 void KBD_Core_Process(void);
 
@@ -0,0 +1,148 @@
+/**
+ * @file    kbd_flash.h
+ * @brief   MeowKeyboard Flash 擦写任务队列
+ * @author  MeowKJ
+ * @version V1.0.0
+ * @date    2024-11-07
+ *
+ * @details
+ * DataFlash 页擦除 / 写入和 Code Flash 写入期间 CPU 停顿，跨过 BLE 连接事件锚点时
+ * 该事件就会丢失。配置槽、runtime 热数据页、宏区与 IAP 页缓冲的擦写统一排进本队列：
+ *
+ * - 每个任务只涉及一页 (擦除 + 写入算一步)；连接事件结束后先执行一步，
+ *   到下一个必须参加的锚点 (连接间隔 × (从机延迟 + 1)) 之前放得下时继续执行
+ * - 蓝牙已连接时经 KBD_Mode_PostAfterRadioEvent 等到下一个连接事件结束再执行；
+ *   从机延迟下连接事件稀疏，等待超过 KBD_FLASH_GAP_WAIT_MS 后直接执行
+ * - USB 模式或未连接时下一轮 TMOS 循环立即执行
+ * - 任务完成 (或失败) 后调用提交时给出的回调；回调里可以继续提交任务
+ * - 复位 / 深睡 / 需要读回结果前用 KBD_Flash_Drain 同步清空队列
+ *
+ * 配置命令已在主循环处理，KBD_Flash_Submit 通常只在主循环调用；队列操作仍关中断，
+ * 兼容命令任务注册前 USB 中断里的同步兜底。KBD_Flash_Drain 会直接擦写 Flash，
+ * 只能在主循环调用。
+ *
+ * 统计通过 KBD_CMD_FLASH_JOBS (0x93) 读取。
+ *
+ * @copyright Copyright (c) 2024 MeowKJ. All rights reserved.
+ */
+
+#ifndef __KBD_FLASH_H
+#define __KBD_FLASH_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ======================= 配置 ======================= */
+
+#ifndef KBD_FLASH_QUEUE_DEPTH
+#define KBD_FLASH_QUEUE_DEPTH 8 /**< 排队任务数 */
+#endif
+
+#ifndef KBD_FLASH_GAP_WAIT_MS
+#define KBD_FLASH_GAP_WAIT_MS 1000u /**< 等连接事件的上限 (空闲档从机延迟约 0.9s) */
+#endif
+
+/* ======================= 类型 ======================= */
+
+/**
+ * @brief 任务类型
+ */
+typedef enum {
+    KBD_FLASH_OP_PAGE = 0, /**< DataFlash 页：读出 → 覆盖 [offset, offset+len) → 擦除 → 写回 */
+    KBD_FLASH_OP_ERASE,    /**< DataFlash：擦除 len 字节 (页对齐) */
+    KBD_FLASH_OP_ROM,      /**< Code Flash：写入已擦除区域 (len 为 4 的倍数) */
+} kbd_flash_op_t;
+
+/**
+ * @brief 任务完成回调 (TMOS 任务上下文)
+ * @param result 0 成功，负值失败
+ * @param ctx    提交时的 ctx
+ */
+typedef void (*kbd_flash_cb_t)(int result, void *ctx);
+
+/**
+ * @brief 擦写任务
+ *
+ * data 指向的数据在回调之前必须保持有效。PAGE 总是经内部暂存页写入：
+ * 先读出原页 (覆盖整页 offset=0, len=256 时省去读取)，合并 data 后擦除再写，
+ * data 无对齐要求。
+ */
+typedef struct {
+    uint32_t addr;       /**< PAGE / ERASE 为页地址 (DataFlash 偏移)，ROM 为写入地址 */
+    const void *data;    /**< 写入数据 (ERASE 不用) */
+    uint16_t offset;     /**< PAGE：页内偏移 */
+    uint16_t len;        /**< 写入 / 擦除长度 */
+    uint8_t op;          /**< kbd_flash_op_t */
+    kbd_flash_cb_t cb;   /**< 完成回调，可为 NULL */
+    void *ctx;           /**< 回调参数 */
+} kbd_flash_job_t;
+
+/**
+ * @brief 队列统计快照
+ */
+typedef struct {
+    uint8_t depth;        /**< 当前排队任务数 */
+    uint8_t depth_max;    /**< 最大排队任务数 */
+    uint16_t interval;    /**< 当前连接间隔 (1.25ms)，0 = 未连接 */
+    uint16_t latency;     /**< 当前从机延迟 */
+    uint32_t step_us_max; /**< 单步最长耗时 (us) */
+    uint32_t step_us_sum; /**< 单步累计耗时 (us) */
+    uint32_t jobs;        /**< 完成的任务 */
+    uint32_t failed;      /**< 失败的任务 */
+    uint32_t rejected;    /**< 队列满被拒的提交 */
+    uint32_t deferred;    /**< 登记等待连接事件的次数 */
+    uint32_t aligned;     /**< 在连接事件结束后的间隙中执行的步骤 */
+    uint32_t timeouts;    /**< 等不到连接事件、超时后执行的步骤 */
+    uint32_t immediate;   /**< 未连接，直接执行的步骤 */
+    uint32_t sync;        /**< KBD_Flash_Drain 同步执行的步骤 */
+    uint32_t missed;      /**< 估计的漏连接事件 (单步耗时跨过的必须参加的锚点数) */
+} kbd_flash_stats_t;
+
+/* ======================= API ======================= */
+
+/**
+ * @brief 注册 TMOS 任务 (在 KBD_Storage_Init 中调用)
+ */
+void KBD_Flash_Init(void);
+
+/**
+ * @brief 提交一个擦写任务
+ *
+ * 在主循环调用 (配置命令经 KBD_Command_Submit 在命令任务中处理)；
+ * 队列操作关中断，命令任务注册前 USB 中断里的同步兜底调用也是安全的。
+ * TMOS 任务尚未注册时同步执行并回调。
+ *
+ * @param job 任务描述 (按值复制)
+ * @return 0 已排队或已执行
+ * @return -1 参数错误
+ * @return -2 队列已满
+ */
+int KBD_Flash_Submit(const kbd_flash_job_t *job);
+
+/**
+ * @brief 当前排队任务数
+ */
+uint8_t KBD_Flash_Pending(void);
+
+/**
+ * @brief 同步执行全部排队任务 (包括回调中新提交的任务)，仅主循环调用
+ * @return 0 全部成功，-1 期间有任务失败
+ */
+int KBD_Flash_Drain(void);
+
+/**
+ * @brief 读取队列统计，可选读取后清零计数
+ *
+ * @param[out] out 统计输出
+ * @param reset    非 0 时清零计数 (当前排队数不变)
+ */
+void KBD_Flash_GetStats(kbd_flash_stats_t *out, uint8_t reset);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __KBD_FLASH_H */
@@ -38,6 +38,13 @@ void KBD_IAP_Init(void);
  */
 int KBD_IAP_Process(const kbd_cmd_frame_t *frame);
 
+/**
+ * @brief 是否有页写入或等待页写完的响应尚未完成
+ *
+ * @return 1 = 忙, 0 = 空闲
+ */
+uint8_t KBD_IAP_IsBusy(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,117 @@
+/**
+ * @file    kbd_idle.h
+ * @brief   MeowKeyboard 主循环空闲低功耗 (tickless idle)
+ * @author  MeowKJ
+ * @version V1.0.0
+ * @date    2024-11-07
+ *
+ * @details
+ * KBD_Idle_Hook 注册为 TMOS idleCB (HAL_SLEEP=TRUE)：TMOS 没有就绪事件时
+ * 以下一个定时器 / 连接事件的 RTC 时刻调用它，在关全局中断的状态下判定：
+ *
+ * - 中断刚投递了 TMOS 事件 (KBD_Idle_SetEvent) → 立即返回，TMOS 继续处理
+ * - USB 模式、按键去抖窗口 (TMR0)、RGB 供电中、UART 日志未发完、或距截止时刻太近
+ *   → CPU 暂停 (WFI)，外设继续运行，RTC 触发或任意中断唤醒
+ * - 以上都不满足 → RTC Sleep (HSE/PLL 关闭，RAM 保持)，
+ *   RTC / GPIO (按键、旋钮、矩阵) / USB 唤醒，唤醒后补偿 SysTick 时间基准
+ *
+ * TMOS 先检查就绪事件再调用 idleCB，两者之间到达的中断若只调用 tmos_set_event，
+ * 事件要等到下一次唤醒才处理。中断里投递事件统一使用 KBD_Idle_SetEvent。
+ *
+ * 各状态停留时间 (RTC 周期) 通过 KBD_CMD_IDLE_STATS 读取。
+ *
+ * @copyright Copyright (c) 2024 MeowKJ. All rights reserved.
+ */
+
+#ifndef __KBD_IDLE_H
+#define __KBD_IDLE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ======================= 配置 ======================= */
+
+#ifndef KBD_IDLE_SLEEP_ENABLE
+#define KBD_IDLE_SLEEP_ENABLE 1 /**< 0 = 只做 CPU 暂停，不进入 RTC Sleep */
+#endif
+
+/** 距截止时刻不足该 RTC 周期数时不暂停 (约 125us)，避免错过触发 */
+#define KBD_IDLE_HALT_MIN_TICKS 4u
+
+/* ======================= 类型 ======================= */
+
+/**
+ * @brief 未进入 Sleep 的原因 (位掩码)
+ *
+ * EVENT 表示有事件待处理，不暂停；其余只降级为 CPU 暂停。
+ */
+typedef enum {
+    KBD_IDLE_BLOCK_EVENT = 0x01, /**< 中断投递的 TMOS 事件尚未处理 */
+    KBD_IDLE_BLOCK_USB   = 0x02, /**< USB 模式或有 USB 主机 (需保持 USB 时钟) */
+    KBD_IDLE_BLOCK_KEY   = 0x04, /**< 按键去抖窗口未结束 (TMR0 运行) */
+    KBD_IDLE_BLOCK_RGB   = 0x08, /**< RGB 供电中 (TMR1 PWM / DMA) */
+    KBD_IDLE_BLOCK_SHORT = 0x10, /**< 距截止时刻太近，Sleep 唤醒开销不划算 */
+    KBD_IDLE_BLOCK_LOG   = 0x20, /**< UART 日志尚未发完 (调试构建，不计入 veto) */
+} kbd_idle_block_t;
+
+/** 降级为 CPU 暂停的原因个数 (USB / KEY / RGB / SHORT) */
+#define KBD_IDLE_VETO_COUNT 4u
+
+/**
+ * @brief 驻留统计快照 (时间单位: RTC 周期)
+ *
+ * 运行时间 = window - halt_ticks - sleep_ticks。
+ */
+typedef struct {
+    uint32_t window;      /**< 统计窗口长度 */
+    uint32_t halt_ticks;  /**< CPU 暂停累计 */
+    uint32_t sleep_ticks; /**< RTC Sleep 累计 */
+    uint32_t halt_count;  /**< 进入暂停次数 */
+    uint32_t sleep_count; /**< 进入 Sleep 次数 */
+    uint32_t busy_count;  /**< 因 EVENT 直接返回次数 */
+    uint32_t veto[KBD_IDLE_VETO_COUNT]; /**< 各原因降级为暂停的次数 (USB/KEY/RGB/SHORT) */
+    uint8_t last_block;   /**< 最近一次未进入 Sleep 的原因 (kbd_idle_block_t) */
+} kbd_idle_stats_t;
+
+/* ======================= API ======================= */
+
+/**
+ * @brief 配置唤醒源 (GPIO / USB / RTC) 并清零统计
+ */
+void KBD_Idle_Init(void);
+
+/**
+ * @brief TMOS idleCB
+ *
+ * @param time 下一个 TMOS 截止时刻 (RTC 绝对值)
+ * @return 0 已暂停或睡眠后返回
+ * @return 2 未进入低功耗
+ */
+uint32_t KBD_Idle_Hook(uint32_t time);
+
+/**
+ * @brief 投递 TMOS 事件，并让正在判定的 idle 钩子放弃本次低功耗
+ *
+ * 中断与主循环上下文均可调用。
+ *
+ * @param task_id TMOS 任务 ID (TASK_NO_TASK 时忽略)
+ * @param event   事件位
+ */
+void KBD_Idle_SetEvent(uint8_t task_id, uint16_t event);
+
+/**
+ * @brief 读取驻留统计，可选读取后清零
+ *
+ * @param[out] out 统计输出
+ * @param reset    非 0 时清零并从当前时刻重新开始统计窗口
+ */
+void KBD_Idle_GetStats(kbd_idle_stats_t *out, uint8_t reset);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __KBD_IDLE_H */
@@ -26,13 +26,13 @@ extern "C" {
 /* ======================= 初始化与主循环 ======================= */
 
 /**
- * @brief 初始化 HID 日志系统，从系统配置加载参数
+ * @brief 初始化 HID 日志系统，从系统配置加载参数并注册日志任务
  */
 void KBD_Log_Init(void);
 
 /**
  * @brief 刷新日志队列，将缓冲的日志通过 EP4 发送
- * @note  在主循环中周期调用
+ * @note  由日志任务在入队后调用，未发完时自动重试
  */
 void KBD_Log_Flush(void);
 
@@ -103,6 +103,13 @@ void KBD_Log_RgbEvent(uint8_t mode, uint8_t brightness);
  */
 void KBD_Log_SystemEvent(uint8_t event);
 
+/**
+ * @brief 记录 DataFlash 擦写失败
+ * @param op   操作类型 (kbd_log_flash_op_t)
+ * @param addr DataFlash 偏移
+ */
+void KBD_Log_FlashEvent(uint8_t op, uint16_t addr);
+
 #ifdef __cplusplus
 }
 #endif
@@ -85,10 +85,18 @@ extern "C"
     /**
      * @brief 初始化 RGB 灯效引擎
      *
-     * 初始化 WS2812 驱动并加载 RGB 配置
+     * 初始化 WS2812 驱动并加载 RGB 配置，不启动周期刷新
      */
     void KBD_RGB_Init(void);
 
+    /**
+     * @brief 启动 RGB 灯效周期刷新
+     *
+     * 由启动流程延后调用（见 kbd_boot.h），在此之前 Flash / SetState
+     * 等接口仍可用，只是灯效动画尚未开始
+     */
+    void KBD_RGB_Start(void);
+
     /**
      * @brief RGB 效果处理函数
      *
@@ -13,6 +13,8 @@
  * - CRC32 校验确保数据完整性
  *
  * @note    DataFlash 总容量 32KB；CH592F 支持 256B/4KB 擦除（配置区使用 256B 页级更新）
+ * @note    配置槽、runtime 热数据与延迟宏操作的擦写经 kbd_flash 队列在 BLE 连接事件
+ *          间隙逐页执行，完成前调用方的数据仍以 RAM 为准
  *
  * @copyright Copyright (c) 2024 MeowKJ. All rights reserved.
  */
@@ -21,6 +23,7 @@
 #define __KBD_STORAGE_H
 
 #include "kbd_types.h"
+#include "kbd_flash.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -46,7 +49,10 @@ int KBD_Storage_Init(void);
 /**
  * @brief 刷新 runtime 热数据（如当前层）到 DataFlash
  *
- * @note 用于睡眠前/模式切换前强制落盘。若无待保存变更则直接返回成功。
+ * 同时同步执行 Flash 队列中排队的配置保存、宏操作与 IAP 页（KBD_Flash_Drain），
+ * 仅主循环调用。
+ *
+ * @note 用于睡眠前/模式切换前/复位前强制落盘。若无待保存变更则直接返回成功。
  *
  * @return 0 成功（含无变更）
  * @return 负数 擦写失败
@@ -100,26 +106,52 @@ void KBD_Storage_PollStatus(kbd_storage_status_t *status);
 int KBD_Config_Load(void);
 
 /**
- * @brief 保存配置到 DataFlash
+ * @brief 请求保存配置到 DataFlash（中断安全，立即返回）
+ *
+ * 存储任务生成槽位镜像后把有变化的页逐页交给 Flash 队列，header 页最后写；
+ * 保存进行中再次请求会在本轮结束后合并为一轮。
  *
  * @note CH592F 下采用冷热分离：配置槽位轮转 + runtime 热数据页环（256B）
  *
- * @return 0 成功
- * @return -1 擦除失败
- * @return -2 写入失败
+ * @return 0 已提交
  */
 int KBD_Config_Save(void);
 
+/**
+ * @brief 请求保存配置，完成后回调
+ *
+ * @param[in] done 完成回调（主循环上下文，result: 0 成功 / 负数 擦写失败），可为 NULL
+ * @param[in] ctx  回调参数
+ * @return 0 已提交
+ * @return -1 已有等待中的回调
+ */
+int KBD_Config_SaveAsync(kbd_flash_cb_t done, void *ctx);
+
+/**
+ * @brief 是否有带完成回调的配置保存尚未结束
+ * @return 1 = 有, 0 = 无
+ */
+uint8_t KBD_Config_IsSavePending(void);
+
 /**
  * @brief 恢复出厂设置
  *
- * 重置所有配置为默认值并保存到 Flash
+ * 立即重置 RAM 配置为默认值，然后请求擦除宏区并保存到 Flash（同 KBD_Config_Save）
  *
- * @return 0 成功
- * @return 负数 保存失败
+ * @return 0 已提交
  */
 int KBD_Config_Reset(void);
 
+/**
+ * @brief 恢复出厂设置，宏区擦除与配置保存完成后回调
+ *
+ * @param[in] done 完成回调，可为 NULL
+ * @param[in] ctx  回调参数
+ * @return 0 已提交
+ * @return -1 已有等待中的回调（配置未改动）
+ */
+int KBD_Config_ResetAsync(kbd_flash_cb_t done, void *ctx);
+
 /** @} */ /* end of KBD_Storage_Config */
 
 /*============================================================================*/
@@ -167,6 +199,26 @@ uint8_t KBD_GetOsMode(void);
  */
 int KBD_SetOsMode(uint8_t mode);
 
+/**
+ * @brief 获取按键去抖配置
+ *
+ * @param[out] mode 去抖算法 (key_debounce_mode_t)
+ * @param[out] ms   去抖时间 (毫秒)
+ */
+void KBD_GetDebounce(uint8_t *mode, uint8_t *ms);
+
+/**
+ * @brief 设置按键去抖配置 (仅更新 RAM 配置，持久化由 KBD_Config_Save 完成)
+ *
+ * @note 不直接作用于按键驱动，调用方需随后调用 Key_SetDebounce()
+ *
+ * @param[in] mode 去抖算法 (key_debounce_mode_t)
+ * @param[in] ms   去抖时间 (1..KEY_DEBOUNCE_MAX_MS)
+ * @return 0 成功
+ * @return -1 参数无效
+ */
+int KBD_SetDebounce(uint8_t mode, uint8_t ms);
+
 /** @} */ /* end of KBD_Storage_Access */
 
 /*============================================================================*/
@@ -196,6 +248,47 @@ uint8_t KBD_GetLastMode(void);
  */
 int KBD_SetLastMode(uint8_t mode);
 
+/**
+ * @brief 读取 BLE 主机槽位（定向广播回连目标与上次协商的连接参数）
+ *
+ * @param[in] idx 槽位 (0 ~ KBD_BLE_HOST_COUNT-1)
+ * @param[out] out 槽位内容（可为 NULL）
+ * @return 0 成功
+ * @return -1 槽位为空或越界
+ */
+int KBD_GetBleHost(uint8_t idx, kbd_ble_host_t *out);
+
+/**
+ * @brief 写入 BLE 主机槽位并异步持久化到 runtime 热数据
+ *
+ * 与 current_layer / last_mode 共享同一页写操作，内容未变化时不写 Flash。
+ *
+ * @param[in] idx 槽位 (0 ~ KBD_BLE_HOST_COUNT-1)
+ * @param[in] host 槽位内容，NULL 或 valid=0 表示清空
+ * @return 0 成功
+ * @return -1 槽位越界
+ */
+int KBD_SetBleHost(uint8_t idx, const kbd_ble_host_t *host);
+
+/**
+ * @brief 获取当前 BLE 主机槽位
+ * @return 槽位 (0 ~ KBD_BLE_HOST_COUNT-1)
+ */
+uint8_t KBD_GetBleHostActive(void);
+
+/**
+ * @brief 设置当前 BLE 主机槽位并异步持久化
+ * @param[in] idx 槽位 (0 ~ KBD_BLE_HOST_COUNT-1)
+ * @return 0 成功
+ * @return -1 槽位越界
+ */
+int KBD_SetBleHostActive(uint8_t idx);
+
+/**
+ * @brief 清空全部 BLE 主机槽位并回到槽位 0（清除绑定时调用）
+ */
+void KBD_ClearBleHosts(void);
+
 /**
  * @brief 获取当前激活层号
  * @return 当前层号 (0 ~ num_layers-1)
@@ -232,7 +325,9 @@ uint8_t KBD_PrevLayer(void);
 /**
  * @brief 获取指定按键在当前层的动作
  *
- * @param[in] key_index 按键索引 (0 ~ KBD_MAX_KEYS-1)
+ * 索引超出 KBD_MAX_KEYS 的矩阵键返回 KBD_MATRIX_DEFAULT_KEYMAP 中的固定映射。
+ *
+ * @param[in] key_index 按键索引 (0 ~ KBD_CORE_MAX_KEYS-1)
  * @return 按键动作指针
  * @return NULL 索引无效
  */
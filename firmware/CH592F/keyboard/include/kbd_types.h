@@ -115,6 +115,8 @@ extern "C"
     KBD_WHEEL_UP = 1,    /**< 向上滚动一格 */
     KBD_WHEEL_DOWN = 2,  /**< 向下滚动一格 */
     KBD_WHEEL_CLICK = 3, /**< 中键点击 */
+    KBD_WHEEL_LEFT = 4,  /**< 向左水平滚动一格 (AC Pan) */
+    KBD_WHEEL_RIGHT = 5, /**< 向右水平滚动一格 (AC Pan) */
   } kbd_wheel_dir_t;
 
   /**
@@ -210,6 +212,8 @@ extern "C"
     KBD_FN_BLE_ADV = 0x02,         /**< 开始蓝牙广播 */
     KBD_FN_BLE_DISCONNECT = 0x03,  /**< 断开蓝牙连接 */
     KBD_FN_BLE_CLEAR_BONDS = 0x04, /**< 清除所有配对信息 */
+    KBD_FN_BLE_HOST = 0x05,        /**< 切换蓝牙主机 (param=槽位 0~2) */
+    KBD_FN_BLE_HOST_NEXT = 0x06,   /**< 切换到下一个蓝牙主机 */
 
     /* RGB 控制 0x10-0x1F */
     KBD_FN_RGB_TOGGLE = 0x10,      /**< RGB 开关 */
@@ -407,7 +411,8 @@ extern "C"
     uint8_t log_enabled;     /**< HID 日志开关 (0=关, 非0=开, 默认1) */
     uint8_t deep_sleep_min;  /**< DEEP 延时 (在 LIGHT 后, 分钟, 0=禁用) */
     uint8_t os_mode;         /**< 系统模式 (0=Win, 1=Mac) */
-    uint8_t reserved[58];    /**< 保留字段 */
+    uint8_t debounce_mode;   /**< 去抖算法 (key_debounce_mode_t, 0=EAGER) */
+    uint8_t reserved[57];    /**< 保留字段 */
   } kbd_system_config_t;
 
   typedef enum
@@ -431,6 +436,22 @@ extern "C"
     uint8_t reserved[16]; /**< 保留字段 */
   } kbd_config_header_t;
 
+/** @brief BLE 主机槽位数 (FN 动作切换) */
+#define KBD_BLE_HOST_COUNT 3
+
+  /**
+   * @brief BLE 主机槽位 (14 字节，保存在 runtime 热数据页)
+   */
+  typedef struct __attribute__((packed))
+  {
+    uint8_t valid;     /**< 1=已记录主机，其他值=空槽 */
+    uint8_t addr_type; /**< 地址类型 (0=public, 1=random) */
+    uint8_t addr[6];   /**< 主机地址 (小端) */
+    uint16_t interval; /**< 上次协商的打字档连接间隔 (1.25ms, 0=未知) */
+    uint16_t latency;  /**< 对应从机延迟 */
+    uint16_t timeout;  /**< 对应监督超时 (10ms) */
+  } kbd_ble_host_t;
+
   /** @} */ /* end of KBD_System */
 
   /*============================================================================*/
@@ -455,6 +476,8 @@ extern "C"
     KBD_CMD_CFG_RESET = 0x12, /**< 恢复出厂设置 */
     KBD_CMD_CFG_OS_GET = 0x13, /**< 获取系统模式 */
     KBD_CMD_CFG_OS_SET = 0x14, /**< 设置系统模式 */
+    KBD_CMD_CFG_DEBOUNCE_GET = 0x15, /**< 获取去抖配置 */
+    KBD_CMD_CFG_DEBOUNCE_SET = 0x16, /**< 设置去抖配置 */
 
     /* 按键映射 0x20-0x2F */
     KBD_CMD_KEYMAP_GET = 0x20, /**< 获取按键映射 */
@@ -488,6 +511,25 @@ extern "C"
     KBD_CMD_DATAFLASH_INFO = 0x90, /**< 获取 DataFlash 布局信息 */
     KBD_CMD_DATAFLASH_READ = 0x91, /**< 读取 DataFlash 原始字节 */
     KBD_CMD_DATAFLASH_WRITE = 0x92, /**< 写入 DataFlash 单字节（危险） */
+    KBD_CMD_FLASH_JOBS = 0x93,      /**< 读取 (并清零) Flash 擦写队列统计 */
+
+    /* 诊断 0xA0-0xAF */
+    KBD_CMD_BBOX_INFO = 0xA0, /**< 获取黑匣子区域信息 */
+    KBD_CMD_BBOX_READ = 0xA1, /**< 批量读取黑匣子区域 */
+    KBD_CMD_PROF_READ = 0xA2, /**< 读取 (并清零) profiling 区段统计 */
+    KBD_CMD_MEM_INFO = 0xA3,  /**< 获取栈 / TMOS 堆高水位 */
+    KBD_CMD_BOOT_TIMELINE = 0xA4, /**< 获取启动时间线 */
+    KBD_CMD_INPUT_STATS = 0xA5,   /**< 读取 (并清零) 输入队列统计 */
+    KBD_CMD_IDLE_STATS = 0xA6,    /**< 读取 (并清零) 空闲低功耗驻留统计 */
+    KBD_CMD_BLE_REPLAY_STATS = 0xA7, /**< 读取 (并清零) BLE 重连补发 / 唤醒延迟统计 */
+    KBD_CMD_USB_RESUME_STATS = 0xA8, /**< 读取 (并清零) USB 挂起缓冲 / 远程唤醒统计 */
+    KBD_CMD_BLE_CONN_STATS = 0xA9,   /**< 读取 (并清零) BLE 连接参数策略统计 */
+    KBD_CMD_BLE_RECONN_STATS = 0xAA, /**< 读取 (并清零) BLE 回连统计 */
+    KBD_CMD_BLE_HOST_STATS = 0xAB,   /**< 读取 (并清零) BLE 多主机槽位与切换统计 */
+    KBD_CMD_BLE_CFG_STATS = 0xAC,    /**< 读取 (并清零) BLE 配置服务链路与吞吐统计 */
+    KBD_CMD_BLE_TX_STATS = 0xAD,     /**< 读取 (并清零) BLE 输入报告发送节奏与突发统计 */
+    KBD_CMD_BLE_LINK_STATS = 0xAE,   /**< 读取 (并清零) BLE 链路遥测，开关自适应发射功率 */
+    KBD_CMD_BAT_STATS = 0xAF,        /**< 读取 (并清零) 电池采样调度与 CHRG 中断统计 */
   } kbd_cmd_t;
 
   /**
@@ -502,6 +544,7 @@ extern "C"
     KBD_LOG_BLE_EVENT = 0x05,    /**< 蓝牙状态变化 */
     KBD_LOG_RGB_EVENT = 0x06,    /**< RGB 模式变化 */
     KBD_LOG_SYSTEM_EVENT = 0x07, /**< 系统事件 */
+    KBD_LOG_FLASH_EVENT = 0x08,  /**< DataFlash 擦写失败 */
   } kbd_log_category_t;
 
   /**
@@ -514,6 +557,16 @@ extern "C"
     KBD_LOG_SYS_WAKEUP = 0x03, /**< 唤醒 */
   } kbd_log_sys_event_t;
 
+  /**
+   * @brief DataFlash 事件操作类型 (KBD_LOG_FLASH_EVENT)
+   */
+  typedef enum
+  {
+    KBD_LOG_FLASH_READ = 0x01,  /**< 读取失败 */
+    KBD_LOG_FLASH_ERASE = 0x02, /**< 擦除失败 */
+    KBD_LOG_FLASH_WRITE = 0x03, /**< 写入失败 */
+  } kbd_log_flash_op_t;
+
   /**
    * @brief HID 响应码
    */
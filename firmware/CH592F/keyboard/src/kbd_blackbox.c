@@ -0,0 +1,158 @@
+/**
+ * @file    kbd_blackbox.c
+ * @brief   MeowKeyboard 黑匣子 (post-mortem trace) 实现
+ * @author  MeowKJ
+ * @version V1.0.0
+ * @date    2024-11-07
+ *
+ * @details
+ * RAM 中的 s_page 同时是环形缓冲和待写入的 Flash 页镜像，
+ * flush 时只需补齐页头和 CRC，然后擦写区域内的下一页。
+ *
+ * @copyright Copyright (c) 2024 MeowKJ. All rights reserved.
+ */
+
+#include "kbd_blackbox.h"
+#include "kbd_storage.h"
+#include "debug.h"
+#include "CH59x_common.h"
+#include <string.h>
+
+#define TAG "BBOX"
+
+#define STATIC_ASSERT(cond, msg) typedef char static_assert_##msg[(cond) ? 1 : -1]
+STATIC_ASSERT(sizeof(kbd_blackbox_page_t) == KBD_BLACKBOX_PAGE_SIZE, blackbox_page_size);
+STATIC_ASSERT(KBD_BLACKBOX_PAGE_SIZE == EEPROM_PAGE_SIZE, blackbox_page_eeprom);
+STATIC_ASSERT(KBD_BLACKBOX_BASE >= KBD_FLASH_MACRO_BASE + KBD_FLASH_MACRO_SIZE, blackbox_after_meowfs);
+
+#define BLACKBOX_INVALID_PAGE 0xFF
+#define BLACKBOX_PAGE_ADDR(page) (KBD_BLACKBOX_BASE + ((uint32_t)(page) * KBD_BLACKBOX_PAGE_SIZE))
+
+#if KBD_BLACKBOX_ENABLE
+
+/*============================================================================*/
+/* 私有变量                                                                    */
+/*============================================================================*/
+
+/** RAM 环形缓冲 + Flash 页镜像 */
+static kbd_blackbox_page_t s_page __attribute__((aligned(4)));
+
+/** 最新已写入页号 */
+static uint8_t s_last_page = BLACKBOX_INVALID_PAGE;
+
+/** 最新已写入页序号 */
+static uint32_t s_last_seq = 0;
+
+/** 自上次 flush 以来是否有新记录 */
+static uint8_t s_dirty = 0;
+
+#endif /* KBD_BLACKBOX_ENABLE */
+
+/*============================================================================*/
+/* 公共函数                                                                    */
+/*============================================================================*/
+
+void KBD_BlackBox_Init(void)
+{
+#if KBD_BLACKBOX_ENABLE
+    uint32_t hdr[2];
+
+    memset(&s_page, 0, sizeof(s_page));
+    s_last_page = BLACKBOX_INVALID_PAGE;
+    s_last_seq = 0;
+    s_dirty = 0;
+
+    /* 只读页头 (magic + seq)，CRC 留给上位机校验 */
+    for (uint8_t i = 0; i < KBD_BLACKBOX_PAGE_COUNT; i++)
+    {
+        EEPROM_READ(BLACKBOX_PAGE_ADDR(i), hdr, sizeof(hdr));
+        if (hdr[0] != KBD_BLACKBOX_MAGIC)
+        {
+            continue;
+        }
+        if (s_last_page == BLACKBOX_INVALID_PAGE || hdr[1] > s_last_seq)
+        {
+            s_last_page = i;
+            s_last_seq = hdr[1];
+        }
+    }
+
+    LOG_I(TAG, "init: last page=%d seq=%lu", s_last_page, (unsigned long)s_last_seq);
+#endif
+}
+
+void KBD_BlackBox_Record(uint8_t category, const uint8_t *data, uint8_t len)
+{
+#if KBD_BLACKBOX_ENABLE
+    kbd_blackbox_entry_t *e = &s_page.entries[s_page.head];
+
+    e->rtc_tick = RTC_GetCycle32k();
+    e->category = category;
+    for (uint8_t i = 0; i < KBD_BLACKBOX_ENTRY_DATA; i++)
+    {
+        e->data[i] = (i < len) ? data[i] : 0;
+    }
+
+    s_page.head = (uint8_t)((s_page.head + 1) % KBD_BLACKBOX_ENTRY_COUNT);
+    if (s_page.count < KBD_BLACKBOX_ENTRY_COUNT)
+    {
+        s_page.count++;
+    }
+    s_dirty = 1;
+#else
+    (void)category;
+    (void)data;
+    (void)len;
+#endif
+}
+
+int KBD_BlackBox_Flush(uint8_t reason)
+{
+#if KBD_BLACKBOX_ENABLE
+    uint8_t target;
+
+    /* 无新记录时不重复写页，故障现场除外 */
+    if (!s_dirty && reason != KBD_BLACKBOX_REASON_FAULT)
+    {
+        return 0;
+    }
+
+    target = (s_last_page == BLACKBOX_INVALID_PAGE)
+                 ? 0
+                 : (uint8_t)((s_last_page + 1) % KBD_BLACKBOX_PAGE_COUNT);
+
+    s_page.magic = KBD_BLACKBOX_MAGIC;
+    s_page.seq = s_last_seq + 1;
+    s_page.reason = reason;
+    s_page.reserved = 0;
+    s_page.crc32 = KBD_CalcCRC32((const uint8_t *)s_page.entries, sizeof(s_page.entries));
+
+    if (EEPROM_ERASE(BLACKBOX_PAGE_ADDR(target), KBD_BLACKBOX_PAGE_SIZE) != 0)
+    {
+        return -1;
+    }
+    if (EEPROM_WRITE(BLACKBOX_PAGE_ADDR(target), &s_page, KBD_BLACKBOX_PAGE_SIZE) != 0)
+    {
+        return -2;
+    }
+
+    s_last_page = target;
+    s_last_seq = s_page.seq;
+    s_dirty = 0;
+    return 0;
+#else
+    (void)reason;
+    return 0;
+#endif
+}
+
+void KBD_BlackBox_GetLatest(uint8_t *page, uint32_t *seq)
+{
+#if KBD_BLACKBOX_ENABLE
+    if (page) *page = s_last_page;
+    if (seq) *seq = s_last_seq;
+#else
+    if (page) *page = BLACKBOX_INVALID_PAGE;
+    if (seq) *seq = 0;
+#endif
+}
@@ -0,0 +1,193 @@
+/**
+ * @file    kbd_boot.c
+ * @brief   MeowKeyboard 启动时间线与延后初始化实现
+ * @author  MeowKJ
+ * @version V1.0.0
+ * @date    2024-11-07
+ *
+ * @details
+ * 时间戳使用 RTC 32K 计数：SysTick 在 CH59x_BLEInit 中才启动，且休眠时停止，
+ * 不能覆盖 RESET / CLOCK 阶段和唤醒首键。
+ *
+ * HAL_Init() 中的 HAL_TimeInit 会用 RTC_InitTime 把 32K 计数重载为 0。
+ * 重载前后由 KBD_Boot_RtcReloadBegin/End 各取一次 RTC 与 SysTick (此时已运行)，
+ * 用 SysTick 测出中间耗时，求出偏移 s_tick_base，之后的时间戳都加上该偏移，
+ * 保持与 RESET 阶段在同一时间轴上。
+ *
+ * @copyright Copyright (c) 2024 MeowKJ. All rights reserved.
+ */
+
+#include "kbd_boot.h"
+#include "kbd_log.h"
+#include "kbd_rgb.h"
+#include "kbd_battery.h"
+#include "ble_config.h"
+#include "ble_hal.h"
+#include "debug.h"
+
+#define TAG "BOOT"
+
+/* TMOS 事件 */
+#define BOOT_DEFER_EVT 0x0001
+
+/*============================================================================*/
+/* 私有变量                                                                    */
+/*============================================================================*/
+
+/** 各阶段时间戳 (RTC 计数 + s_tick_base) */
+static uint32_t s_stage_tick[KBD_BOOT_STAGE_COUNT];
+
+/** RTC 重载后补偿到重载前时间轴的偏移 */
+static uint32_t s_tick_base = 0;
+
+/** KBD_Boot_RtcReloadBegin 时的 RTC / SysTick 计数 */
+static uint32_t s_reload_rtc = 0;
+static uint32_t s_reload_systick = 0;
+
+/** 阶段是否已记录 */
+static uint16_t s_stage_mask = 0;
+
+/** 最近一次唤醒的 RTC 计数 (唤醒中断中写入) */
+static volatile uint32_t s_wake_tick = 0;
+
+/** 唤醒后是否还在等待首键 */
+static volatile uint8_t s_wake_pending = 0;
+
+/** 最近一次唤醒到首键的延迟 */
+static uint32_t s_wake_latency = KBD_BOOT_TICK_NONE;
+
+static tmosTaskID s_task_id = TASK_NO_TASK;
+
+/** 下一个延后初始化步骤 */
+static uint8_t s_defer_step = KBD_BOOT_STAGE_DEFER_LOG;
+
+/*============================================================================*/
+/* 私有函数                                                                    */
+/*============================================================================*/
+
+/**
+ * @brief 执行一个延后初始化步骤
+ * @return 是否还有后续步骤
+ */
+static uint8_t Boot_RunDeferStep(uint8_t step)
+{
+    switch (step)
+    {
+    case KBD_BOOT_STAGE_DEFER_LOG:
+        KBD_Log_Init();
+        KBD_Log_SystemEvent(KBD_LOG_SYS_BOOT);
+        break;
+    case KBD_BOOT_STAGE_DEFER_RGB:
+        KBD_RGB_Start();
+        break;
+    case KBD_BOOT_STAGE_DEFER_BATTERY:
+        KBD_Battery_Init();
+        break;
+    default:
+        return 0;
+    }
+
+    KBD_Boot_Mark(step);
+    return (step < KBD_BOOT_STAGE_DEFER_BATTERY);
+}
+
+static uint16_t KBD_Boot_ProcessEvent(uint8_t task_id, uint16_t events)
+{
+    if (events & BOOT_DEFER_EVT)
+    {
+        /* 每次只做一步，中间让出调度给 USB / BLE 事件 */
+        if (Boot_RunDeferStep(s_defer_step))
+        {
+            s_defer_step++;
+            tmos_set_event(task_id, BOOT_DEFER_EVT);
+        }
+        else
+        {
+            LOG_I(TAG, "ready=%lu deferred=%lu ticks",
+                  (unsigned long)KBD_Boot_GetStage(KBD_BOOT_STAGE_READY),
+                  (unsigned long)KBD_Boot_GetStage(KBD_BOOT_STAGE_DEFER_BATTERY));
+        }
+        return (events ^ BOOT_DEFER_EVT);
+    }
+
+    return 0;
+}
+
+/*============================================================================*/
+/* 公共函数                                                                    */
+/*============================================================================*/
+
+void KBD_Boot_Mark(uint8_t stage)
+{
+    if (stage >= KBD_BOOT_STAGE_COUNT || (s_stage_mask & (1u << stage)))
+    {
+        return;
+    }
+
+    s_stage_tick[stage] = RTC_GetCycle32k() + s_tick_base;
+    s_stage_mask |= (uint16_t)(1u << stage);
+}
+
+void KBD_Boot_RtcReloadBegin(void)
+{
+    s_reload_rtc = RTC_GetCycle32k() + s_tick_base;
+    s_reload_systick = SYS_GetSysTickCnt();
+}
+
+void KBD_Boot_RtcReloadEnd(void)
+{
+    uint32_t sys_per_tick = GetSysClock() / KBD_BOOT_TICK_HZ;
+    uint32_t elapsed = (SYS_GetSysTickCnt() - s_reload_systick) / sys_per_tick;
+
+    /* 重载后的计数从 0 开始，补上重载前的计数和两次采样之间的耗时 */
+    s_tick_base = s_reload_rtc + elapsed - RTC_GetCycle32k();
+}
+
+void KBD_Boot_Start(void)
+{
+    s_task_id = TMOS_ProcessEventRegister(KBD_Boot_ProcessEvent);
+    if (s_task_id == TASK_NO_TASK)
+    {
+        /* 无法注册任务时退化为同步初始化，功能优先 */
+        LOG_W(TAG, "TMOS task register failed, init inline");
+        for (uint8_t step = KBD_BOOT_STAGE_DEFER_LOG; Boot_RunDeferStep(step); step++)
+        {
+        }
+        return;
+    }
+
+    tmos_set_event(s_task_id, BOOT_DEFER_EVT);
+}
+
+void KBD_Boot_OnKey(void)
+{
+    KBD_Boot_Mark(KBD_BOOT_STAGE_FIRST_KEY);
+
+    if (s_wake_pending)
+    {
+        /* RTC 32K 计数在 RTC_MAX_COUNT 处回绕 */
+        s_wake_latency = HAL_SleepDistance(RTC_GetCycle32k(), s_wake_tick);
+        s_wake_pending = 0;
+    }
+}
+
+void KBD_Boot_OnWake(void)
+{
+    s_wake_tick = RTC_GetCycle32k();
+    s_wake_pending = 1;
+}
+
+uint32_t KBD_Boot_GetStage(uint8_t stage)
+{
+    if (stage >= KBD_BOOT_STAGE_COUNT || !(s_stage_mask & (1u << stage)))
+    {
+        return KBD_BOOT_TICK_NONE;
+    }
+
+    return s_stage_tick[stage] - s_stage_tick[KBD_BOOT_STAGE_RESET];
+}
+
+uint32_t KBD_Boot_GetWakeLatency(void)
+{
+    return s_wake_latency;
+}
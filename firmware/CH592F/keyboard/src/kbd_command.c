@@ -14,11 +14,23 @@
  */
 
 #include "kbd_command.h"
+#include "kbd_blackbox.h"
 #include "kbd_iap.h"
 #include "debug.h"
 #include "kbd_config.h"
 #include "kbd_battery.h"
+#include "kbd_prof.h"
+#include "kbd_boot.h"
+#include "kbd_input.h"
+#include "kbd_idle.h"
+#include "key.h"
+#include "hal_utils.h"
+#include "ble_config.h"
 #include "kbd_mode.h"
+#include "ble_hid.h"
+#include "ble_cfg_service.h"
+#include "ble_link.h"
+#include "usb_hid.h"
 #include "kbd_rgb.h"
 #include "kbd_log.h"
 #include "kbd_storage.h"
@@ -31,6 +43,22 @@
 
 static kbd_command_response_sender_t s_response_sender = NULL;
 
+/** @brief 等待配置保存 / 重置完成的命令所用的响应通道 */
+static kbd_command_response_sender_t s_cfg_save_sender = NULL;
+
+/** @brief 最近一次提交命令的通道，有延迟响应未发出时其他通道回复 BUSY */
+static kbd_command_response_sender_t s_owner_sender = NULL;
+
+/* TMOS 事件 */
+#define CMD_USB_RX_EVT 0x0001
+
+static tmosTaskID s_task_id = TASK_NO_TASK;
+
+/** @brief USB 命令帧队列 (生产者为 USB 中断，消费者为命令任务) */
+static kbd_cmd_frame_t s_usb_rx[KBD_CMD_USB_RX_FRAMES];
+static volatile uint8_t s_usb_rx_head = 0;
+static volatile uint8_t s_usb_rx_count = 0;
+
 /*============================================================================*/
 /*                              外部函数声明 */
 /*============================================================================*/
@@ -52,6 +80,9 @@ static void HandleCfgLoad(const kbd_cmd_frame_t *frame);
 static void HandleCfgReset(const kbd_cmd_frame_t *frame);
 static void HandleCfgOsGet(const kbd_cmd_frame_t *frame);
 static void HandleCfgOsSet(const kbd_cmd_frame_t *frame);
+static void HandleCfgDebounceGet(const kbd_cmd_frame_t *frame);
+static void HandleCfgDebounceSet(const kbd_cmd_frame_t *frame);
+static void ApplyDebounceConfig(void);
 static void HandleKeymapGet(const kbd_cmd_frame_t *frame);
 static void HandleKeymapSet(const kbd_cmd_frame_t *frame);
 static void HandleLayerGet(const kbd_cmd_frame_t *frame);
@@ -70,18 +101,138 @@ static void HandleLogSet(const kbd_cmd_frame_t *frame);
 static void HandleDataFlashInfo(const kbd_cmd_frame_t *frame);
 static void HandleDataFlashRead(const kbd_cmd_frame_t *frame);
 static void HandleDataFlashWrite(const kbd_cmd_frame_t *frame);
+static void HandleBlackBoxInfo(const kbd_cmd_frame_t *frame);
+static void HandleBlackBoxRead(const kbd_cmd_frame_t *frame);
+static void HandleProfRead(const kbd_cmd_frame_t *frame);
+static void HandleMemInfo(const kbd_cmd_frame_t *frame);
+static void HandleBootTimeline(const kbd_cmd_frame_t *frame);
+static void HandleInputStats(const kbd_cmd_frame_t *frame);
+static void HandleIdleStats(const kbd_cmd_frame_t *frame);
+static void HandleReplayStats(const kbd_cmd_frame_t *frame);
+static void HandleResumeStats(const kbd_cmd_frame_t *frame);
+static void HandleConnStats(const kbd_cmd_frame_t *frame);
+static void HandleReconnStats(const kbd_cmd_frame_t *frame);
+static void HandleHostStats(const kbd_cmd_frame_t *frame);
+static void HandleCfgServiceStats(const kbd_cmd_frame_t *frame);
+static void HandleTxStats(const kbd_cmd_frame_t *frame);
+static void HandleLinkStats(const kbd_cmd_frame_t *frame);
+static void HandleBatteryStats(const kbd_cmd_frame_t *frame);
+static void HandleFlashJobs(const kbd_cmd_frame_t *frame);
+
+/**
+ * @brief 按小端写入 u32 (统计类响应的字段布局)
+ * @return 写入后的位置
+ */
+static uint8_t *put_u32_le(uint8_t *p, uint32_t v)
+{
+  p[0] = (uint8_t)(v & 0xFF);
+  p[1] = (uint8_t)((v >> 8) & 0xFF);
+  p[2] = (uint8_t)((v >> 16) & 0xFF);
+  p[3] = (uint8_t)((v >> 24) & 0xFF);
+  return p + 4;
+}
 
 /*============================================================================*/
 /*                              公共函数实现 */
 /*============================================================================*/
 
-void KBD_Command_Init(void) { LOG_I(TAG, "Command handler init"); }
+/**
+ * @brief 是否有延迟响应尚未发出
+ */
+static uint8_t Command_DeferredPending(void)
+{
+  return (KBD_Config_IsSavePending() || Kbd_Macro_IsBusy() || KBD_IAP_IsBusy()) ? 1 : 0;
+}
+
+static uint16_t KBD_Command_ProcessEvent(uint8_t task_id, uint16_t events)
+{
+  if (events & CMD_USB_RX_EVT)
+  {
+    if (s_usb_rx_count > 0)
+    {
+      uint32_t irq_status;
+
+      /* 每次只处理一帧，其余留给下一轮调度 */
+      (void)KBD_Command_Submit(&s_usb_rx[s_usb_rx_head], NULL);
+
+      SYS_DisableAllIrq(&irq_status);
+      s_usb_rx_head = (s_usb_rx_head + 1) % KBD_CMD_USB_RX_FRAMES;
+      s_usb_rx_count--;
+      USB_Config_SetRxEnabled(1);
+      if (s_usb_rx_count > 0)
+      {
+        tmos_set_event(task_id, CMD_USB_RX_EVT);
+      }
+      SYS_RecoverIrq(irq_status);
+    }
+    return (events ^ CMD_USB_RX_EVT);
+  }
+
+  return 0;
+}
+
+void KBD_Command_Init(void)
+{
+  s_task_id = TMOS_ProcessEventRegister(KBD_Command_ProcessEvent);
+  LOG_I(TAG, "Command handler init");
+}
+
+void KBD_Command_PostUsb(const kbd_cmd_frame_t *frame)
+{
+  if (s_task_id == TASK_NO_TASK)
+  {
+    /* 兜底：任务未注册时在中断中同步处理 */
+    (void)KBD_Command_Submit(frame, NULL);
+    return;
+  }
+
+  /* 队列满时 OUT 端点已回 NAK，这里只是防御 */
+  if (s_usb_rx_count >= KBD_CMD_USB_RX_FRAMES)
+  {
+    return;
+  }
+
+  memcpy(&s_usb_rx[(s_usb_rx_head + s_usb_rx_count) % KBD_CMD_USB_RX_FRAMES], frame,
+         sizeof(*frame));
+  s_usb_rx_count++;
+  if (s_usb_rx_count >= KBD_CMD_USB_RX_FRAMES)
+  {
+    /* 队列满：主机的下一帧由硬件 NAK 挡住，处理出空位后再放开 */
+    USB_Config_SetRxEnabled(0);
+  }
+  KBD_Idle_SetEvent(s_task_id, CMD_USB_RX_EVT);
+}
+
+int KBD_Command_Submit(const kbd_cmd_frame_t *frame, kbd_command_response_sender_t sender)
+{
+  kbd_command_response_sender_t prev = s_response_sender;
+  int ret;
+
+  s_response_sender = sender;
+  if (sender != s_owner_sender && Command_DeferredPending())
+  {
+    uint8_t resp[1] = {KBD_RESP_ERR_BUSY};
+    KBD_Command_SendResponse(frame->cmd, frame->sub, resp, 1);
+    s_response_sender = prev;
+    return -2;
+  }
+
+  s_owner_sender = sender;
+  ret = KBD_Command_Process(frame);
+  s_response_sender = prev;
+  return ret;
+}
 
 void KBD_Command_SetResponseSender(kbd_command_response_sender_t sender)
 {
   s_response_sender = sender;
 }
 
+kbd_command_response_sender_t KBD_Command_GetResponseSender(void)
+{
+  return s_response_sender;
+}
+
 int KBD_Command_Process(const kbd_cmd_frame_t *frame)
 {
   switch (frame->cmd)
@@ -110,6 +261,12 @@ int KBD_Command_Process(const kbd_cmd_frame_t *frame)
   case KBD_CMD_CFG_OS_SET:
     HandleCfgOsSet(frame);
     break;
+  case KBD_CMD_CFG_DEBOUNCE_GET:
+    HandleCfgDebounceGet(frame);
+    break;
+  case KBD_CMD_CFG_DEBOUNCE_SET:
+    HandleCfgDebounceSet(frame);
+    break;
 
   /* 按键映射 */
   case KBD_CMD_KEYMAP_GET:
@@ -178,6 +335,59 @@ int KBD_Command_Process(const kbd_cmd_frame_t *frame)
   case KBD_CMD_DATAFLASH_WRITE:
     HandleDataFlashWrite(frame);
     break;
+  case KBD_CMD_FLASH_JOBS:
+    HandleFlashJobs(frame);
+    break;
+
+  /* 诊断 */
+  case KBD_CMD_BBOX_INFO:
+    HandleBlackBoxInfo(frame);
+    break;
+  case KBD_CMD_BBOX_READ:
+    HandleBlackBoxRead(frame);
+    break;
+  case KBD_CMD_PROF_READ:
+    HandleProfRead(frame);
+    break;
+  case KBD_CMD_MEM_INFO:
+    HandleMemInfo(frame);
+    break;
+  case KBD_CMD_BOOT_TIMELINE:
+    HandleBootTimeline(frame);
+    break;
+  case KBD_CMD_INPUT_STATS:
+    HandleInputStats(frame);
+    break;
+  case KBD_CMD_IDLE_STATS:
+    HandleIdleStats(frame);
+    break;
+  case KBD_CMD_BLE_REPLAY_STATS:
+    HandleReplayStats(frame);
+    break;
+  case KBD_CMD_USB_RESUME_STATS:
+    HandleResumeStats(frame);
+    break;
+  case KBD_CMD_BLE_CONN_STATS:
+    HandleConnStats(frame);
+    break;
+  case KBD_CMD_BLE_RECONN_STATS:
+    HandleReconnStats(frame);
+    break;
+  case KBD_CMD_BLE_HOST_STATS:
+    HandleHostStats(frame);
+    break;
+  case KBD_CMD_BLE_CFG_STATS:
+    HandleCfgServiceStats(frame);
+    break;
+  case KBD_CMD_BLE_TX_STATS:
+    HandleTxStats(frame);
+    break;
+  case KBD_CMD_BLE_LINK_STATS:
+    HandleLinkStats(frame);
+    break;
+  case KBD_CMD_BAT_STATS:
+    HandleBatteryStats(frame);
+    break;
 
   /* IAP 固件更新 */
   case KBD_CMD_IAP_INFO:
@@ -301,14 +511,35 @@ static void HandleSysStatus(const kbd_cmd_frame_t *frame)
 }
 
 /**
- * @brief 处理配置保存
+ * @brief 配置保存 / 重置写完 Flash 后响应 (存储任务回调，ctx 为命令码)
+ */
+static void CfgSaveDone(int result, void *ctx)
+{
+  uint8_t cmd = (uint8_t)(uintptr_t)ctx;
+  uint8_t resp[1] = {(result == 0) ? KBD_RESP_OK : KBD_RESP_ERR_FLASH};
+  kbd_command_response_sender_t sender = s_response_sender;
+
+  /* 响应回到提交命令的通道 (USB 或 BLE 配置服务) */
+  s_response_sender = s_cfg_save_sender;
+  KBD_Command_SendResponse(cmd, 0, resp, 1);
+  s_response_sender = sender;
+  LOG_I(TAG, "Config %s: %d", (cmd == KBD_CMD_CFG_SAVE) ? "save" : "reset", result);
+}
+
+/**
+ * @brief 处理配置保存 (Flash 队列写完后响应)
  */
 static void HandleCfgSave(const kbd_cmd_frame_t *frame)
 {
-  int ret = KBD_Config_Save();
-  uint8_t resp[1] = {(ret == 0) ? KBD_RESP_OK : KBD_RESP_ERR_FLASH};
-  KBD_Command_SendResponse(KBD_CMD_CFG_SAVE, 0, resp, 1);
-  LOG_I(TAG, "Config save: %d", ret);
+  kbd_command_response_sender_t sender = s_response_sender;
+
+  if (KBD_Config_SaveAsync(CfgSaveDone, (void *)(uintptr_t)KBD_CMD_CFG_SAVE) != 0)
+  {
+    uint8_t resp[1] = {KBD_RESP_ERR_BUSY};
+    KBD_Command_SendResponse(KBD_CMD_CFG_SAVE, 0, resp, 1);
+    return;
+  }
+  s_cfg_save_sender = sender;
 }
 
 /**
@@ -318,19 +549,26 @@ static void HandleCfgLoad(const kbd_cmd_frame_t *frame)
 {
   int ret = KBD_Config_Load();
   uint8_t resp[1] = {(ret == 0) ? KBD_RESP_OK : KBD_RESP_ERR_FLASH};
+  ApplyDebounceConfig();
   KBD_Command_SendResponse(KBD_CMD_CFG_LOAD, 0, resp, 1);
   LOG_I(TAG, "Config load: %d", ret);
 }
 
 /**
- * @brief 处理配置重置
+ * @brief 处理配置重置 (宏区擦除与配置保存写完后响应)
  */
 static void HandleCfgReset(const kbd_cmd_frame_t *frame)
 {
-  int ret = KBD_Config_Reset();
-  uint8_t resp[1] = {(ret == 0) ? KBD_RESP_OK : KBD_RESP_ERR_FLASH};
-  KBD_Command_SendResponse(KBD_CMD_CFG_RESET, 0, resp, 1);
-  LOG_I(TAG, "Config reset: %d", ret);
+  kbd_command_response_sender_t sender = s_response_sender;
+
+  if (KBD_Config_ResetAsync(CfgSaveDone, (void *)(uintptr_t)KBD_CMD_CFG_RESET) != 0)
+  {
+    uint8_t resp[1] = {KBD_RESP_ERR_BUSY};
+    KBD_Command_SendResponse(KBD_CMD_CFG_RESET, 0, resp, 1);
+    return;
+  }
+  s_cfg_save_sender = sender;
+  ApplyDebounceConfig();
 }
 
 static void HandleCfgOsGet(const kbd_cmd_frame_t *frame)
@@ -352,6 +590,53 @@ static void HandleCfgOsSet(const kbd_cmd_frame_t *frame)
   LOG_I(TAG, "OS mode set: %d status=%d", mode, resp[0]);
 }
 
+/**
+ * @brief 将存储中的去抖配置下发到按键驱动
+ */
+static void ApplyDebounceConfig(void)
+{
+  uint8_t mode, ms;
+
+  KBD_GetDebounce(&mode, &ms);
+  Key_SetDebounce(mode, ms);
+}
+
+/**
+ * @brief 处理去抖配置获取
+ *
+ * 响应格式: [OK][mode][ms][mode_count][max_ms]
+ */
+static void HandleCfgDebounceGet(const kbd_cmd_frame_t *frame)
+{
+  uint8_t resp[5];
+
+  resp[0] = KBD_RESP_OK;
+  KBD_GetDebounce(&resp[1], &resp[2]);
+  resp[3] = KEY_DEBOUNCE_COUNT;
+  resp[4] = KEY_DEBOUNCE_MAX_MS;
+  KBD_Command_SendResponse(KBD_CMD_CFG_DEBOUNCE_GET, 0, resp, sizeof(resp));
+}
+
+/**
+ * @brief 处理去抖配置设置 (立即生效，持久化需 CFG_SAVE)
+ *
+ * 请求格式: [mode][ms]
+ */
+static void HandleCfgDebounceSet(const kbd_cmd_frame_t *frame)
+{
+  uint8_t resp[1] = {KBD_RESP_OK};
+
+  if (frame->len < 2 || KBD_SetDebounce(frame->data[0], frame->data[1]) != 0) {
+    resp[0] = KBD_RESP_ERR_PARAM;
+  } else {
+    ApplyDebounceConfig();
+  }
+
+  KBD_Command_SendResponse(KBD_CMD_CFG_DEBOUNCE_SET, 0, resp, 1);
+  LOG_I(TAG, "Debounce set: mode=%d ms=%d status=%d", frame->data[0],
+        frame->data[1], resp[0]);
+}
+
 /**
  * @brief 处理按键映射获取
  */
@@ -906,3 +1191,778 @@ static void HandleDataFlashWrite(const kbd_cmd_frame_t *frame)
   KBD_Command_SendResponse(KBD_CMD_DATAFLASH_WRITE, frame->sub, resp,
                            sizeof(resp));
 }
+
+/**
+ * @brief 获取黑匣子区域信息
+ *
+ * 响应格式 (12 字节):
+ * [0]     OK
+ * [1..2]  区域起始 (DataFlash 偏移)
+ * [3..4]  区域大小
+ * [5]     页数
+ * [6]     每页条目数
+ * [7]     最新页号 (0xFF = 空)
+ * [8..11] 最新页序号 (big-endian)
+ */
+static void HandleBlackBoxInfo(const kbd_cmd_frame_t *frame)
+{
+  uint8_t resp[12];
+  uint8_t page;
+  uint32_t seq;
+
+  KBD_BlackBox_GetLatest(&page, &seq);
+
+  resp[0] = KBD_RESP_OK;
+  resp[1] = (uint8_t)(KBD_BLACKBOX_BASE >> 8);
+  resp[2] = (uint8_t)(KBD_BLACKBOX_BASE & 0xFF);
+  resp[3] = (uint8_t)(KBD_BLACKBOX_SIZE >> 8);
+  resp[4] = (uint8_t)(KBD_BLACKBOX_SIZE & 0xFF);
+  resp[5] = KBD_BLACKBOX_PAGE_COUNT;
+  resp[6] = KBD_BLACKBOX_ENTRY_COUNT;
+  resp[7] = page;
+  resp[8] = (uint8_t)(seq >> 24);
+  resp[9] = (uint8_t)(seq >> 16);
+  resp[10] = (uint8_t)(seq >> 8);
+  resp[11] = (uint8_t)(seq & 0xFF);
+
+  KBD_Command_SendResponse(KBD_CMD_BBOX_INFO, 0, resp, sizeof(resp));
+}
+
+/**
+ * @brief 批量读取黑匣子区域
+ *
+ * 请求格式: [offset_hi][offset_lo][len]  (offset 为区域内偏移)
+ * 响应格式: [OK][read_len][data...]
+ *
+ * @note 上位机按页 (256B) 循环读取，按 magic / seq / CRC32 筛选有效页，
+ *       再用页头 head / count 还原条目时间顺序。
+ */
+static void HandleBlackBoxRead(const kbd_cmd_frame_t *frame)
+{
+  uint8_t resp[61];
+  uint16_t offset;
+  uint8_t req_len;
+
+  if (frame->len < 3)
+  {
+    resp[0] = KBD_RESP_ERR_PARAM;
+    KBD_Command_SendResponse(KBD_CMD_BBOX_READ, frame->sub, resp, 1);
+    return;
+  }
+
+  offset = ((uint16_t)frame->data[0] << 8) | frame->data[1];
+  req_len = frame->data[2];
+  if (req_len > 58)
+  {
+    req_len = 58;
+  }
+
+  if (req_len == 0 || ((uint32_t)offset + req_len) > KBD_BLACKBOX_SIZE)
+  {
+    resp[0] = KBD_RESP_ERR_PARAM;
+    KBD_Command_SendResponse(KBD_CMD_BBOX_READ, frame->sub, resp, 1);
+    return;
+  }
+
+  if (EEPROM_READ(KBD_BLACKBOX_BASE + offset, &resp[2], req_len) != 0)
+  {
+    resp[0] = KBD_RESP_ERR_FLASH;
+    KBD_Command_SendResponse(KBD_CMD_BBOX_READ, frame->sub, resp, 1);
+    return;
+  }
+
+  resp[0] = KBD_RESP_OK;
+  resp[1] = req_len;
+  KBD_Command_SendResponse(KBD_CMD_BBOX_READ, frame->sub, resp,
+                           (uint8_t)(2 + req_len));
+}
+
+/**
+ * @brief 读取 profiling 区段统计
+ *
+ * 请求格式: [first_zone][flags]  (flags bit0 = 读取后清零)
+ * 响应格式:
+ * [0]  OK
+ * [1]  区段总数
+ * [2]  本帧首个区段
+ * [3]  本帧区段数 n (最多 3)
+ * [4]  enabled (KBD_PROF_ENABLE)
+ * [5..8] 每微秒 cycles (little-endian)
+ * [9..] n × 16B: count / total / min / max (little-endian, 单位 cycles)
+ */
+static void HandleProfRead(const kbd_cmd_frame_t *frame)
+{
+  const uint32_t cycles_per_us = FREQ_SYS / 1000000u;
+  uint8_t resp[9 + 3 * 16];
+  uint8_t first = (frame->len >= 1) ? frame->data[0] : 0;
+  uint8_t reset = (frame->len >= 2) ? (frame->data[1] & 0x01) : 0;
+  uint8_t n = 0;
+  uint8_t *p = &resp[9];
+  kbd_prof_stat_t st;
+
+  if (first > PROF_ZONE_COUNT)
+  {
+    resp[0] = KBD_RESP_ERR_PARAM;
+    KBD_Command_SendResponse(KBD_CMD_PROF_READ, frame->sub, resp, 1);
+    return;
+  }
+
+  while (n < 3 && (uint8_t)(first + n) < PROF_ZONE_COUNT)
+  {
+    KBD_Prof_Read((uint8_t)(first + n), &st, reset);
+    const uint32_t v[4] = {st.count, st.total, st.min, st.max};
+    for (uint8_t i = 0; i < 4; i++)
+    {
+      p = put_u32_le(p, v[i]);
+    }
+    n++;
+  }
+
+  resp[0] = KBD_RESP_OK;
+  resp[1] = PROF_ZONE_COUNT;
+  resp[2] = first;
+  resp[3] = n;
+  resp[4] = KBD_PROF_ENABLE;
+  (void)put_u32_le(&resp[5], cycles_per_us);
+
+  KBD_Command_SendResponse(KBD_CMD_PROF_READ, frame->sub, resp,
+                           (uint8_t)(9 + n * 16));
+}
+
+/**
+ * @brief 获取栈 / TMOS 堆高水位
+ *
+ * 响应格式 (9 字节, little-endian):
+ * [0]    OK
+ * [1..2] 栈大小
+ * [3..4] 栈历史峰值
+ * [5..6] TMOS 堆大小 (BLE_MEMHEAP_SIZE)
+ * [7..8] TMOS 堆高水位
+ */
+static void HandleMemInfo(const kbd_cmd_frame_t *frame)
+{
+  uint8_t resp[9];
+  const uint16_t v[4] = {
+      (uint16_t)Hal_Mem_GetStackSize(),
+      (uint16_t)Hal_Mem_GetStackPeak(),
+      (uint16_t)BLE_MEMHEAP_SIZE,
+      (uint16_t)Hal_Mem_GetRegionPeak(MEM_BUF, BLE_MEMHEAP_SIZE),
+  };
+
+  resp[0] = KBD_RESP_OK;
+  for (uint8_t i = 0; i < 4; i++)
+  {
+    resp[1 + i * 2] = (uint8_t)(v[i] & 0xFF);
+    resp[2 + i * 2] = (uint8_t)(v[i] >> 8);
+  }
+
+  KBD_Command_SendResponse(KBD_CMD_MEM_INFO, 0, resp, sizeof(resp));
+}
+
+/**
+ * @brief 获取启动时间线
+ *
+ * 响应格式 (little-endian):
+ * [0]     OK
+ * [1]     阶段数 N (kbd_boot_stage_t)
+ * [2..5]  时间单位 (Hz, RTC 32K)
+ * [6..9]  最近一次唤醒到首键的延迟 (0xFFFFFFFF = 无)
+ * [10..]  N × 4B 各阶段相对 RESET 的偏移 (0xFFFFFFFF = 未到达)
+ */
+static void HandleBootTimeline(const kbd_cmd_frame_t *frame)
+{
+  uint8_t resp[2 + (2 + KBD_BOOT_STAGE_COUNT) * 4];
+  uint32_t v[2 + KBD_BOOT_STAGE_COUNT];
+  uint8_t *p = &resp[2];
+
+  (void)frame;
+
+  v[0] = KBD_BOOT_TICK_HZ;
+  v[1] = KBD_Boot_GetWakeLatency();
+  for (uint8_t i = 0; i < KBD_BOOT_STAGE_COUNT; i++)
+  {
+    v[2 + i] = KBD_Boot_GetStage(i);
+  }
+
+  resp[0] = KBD_RESP_OK;
+  resp[1] = KBD_BOOT_STAGE_COUNT;
+  for (uint8_t i = 0; i < 2 + KBD_BOOT_STAGE_COUNT; i++)
+  {
+    p = put_u32_le(p, v[i]);
+  }
+
+  KBD_Command_SendResponse(KBD_CMD_BOOT_TIMELINE, 0, resp, sizeof(resp));
+}
+
+/**
+ * @brief 读取统一输入队列统计
+ *
+ * 请求: data[0] bit0 = 读取后清零
+ *
+ * 响应格式 (little-endian):
+ * [0]      OK
+ * [1]      队列容量
+ * [2]      当前深度
+ * [3]      高水位
+ * [4..7]   每微秒 cycles
+ * [8..11]  累计入队
+ * [12..15] 丢弃数 (队列满)
+ * [16..19] 已统计出队数
+ * [20..23] 排队延迟累计 cycles
+ * [24..27] 最大排队延迟 cycles
+ */
+static void HandleInputStats(const kbd_cmd_frame_t *frame)
+{
+  uint8_t resp[28];
+  uint8_t reset = (frame->len >= 1) ? (frame->data[0] & 0x01) : 0;
+  uint8_t *p = &resp[4];
+  kbd_input_stats_t st;
+
+  KBD_Input_GetStats(&st, reset);
+
+  const uint32_t v[6] = {
+      FREQ_SYS / 1000000u, st.pushed,    st.dropped,
+      st.lat_count,        st.lat_total, st.lat_max,
+  };
+
+  resp[0] = KBD_RESP_OK;
+  resp[1] = st.size;
+  resp[2] = st.depth;
+  resp[3] = st.high_water;
+  for (uint8_t i = 0; i < 6; i++)
+  {
+    p = put_u32_le(p, v[i]);
+  }
+
+  KBD_Command_SendResponse(KBD_CMD_INPUT_STATS, frame->sub, resp, sizeof(resp));
+}
+
+/**
+ * @brief 读取空闲低功耗驻留统计
+ *
+ * 请求: data[0] bit0 = 读取后清零
+ *
+ * 响应格式 (little-endian，时间单位 RTC 周期):
+ * [0]      OK
+ * [1]      最近一次未进入 Sleep 的原因 (kbd_idle_block_t)
+ * [2..5]   RTC 频率 (Hz)
+ * [6..9]   统计窗口
+ * [10..13] CPU 暂停累计
+ * [14..17] RTC Sleep 累计
+ * [18..21] 暂停次数
+ * [22..25] Sleep 次数
+ * [26..29] 有待处理工作直接返回次数
+ * [30..45] 降级为暂停的次数: USB / 按键去抖 / RGB / 截止时刻太近
+ */
+static void HandleIdleStats(const kbd_cmd_frame_t *frame)
+{
+  uint8_t resp[2 + (7 + KBD_IDLE_VETO_COUNT) * 4];
+  uint8_t reset = (frame->len >= 1) ? (frame->data[0] & 0x01) : 0;
+  uint8_t *p = &resp[2];
+  kbd_idle_stats_t st;
+
+  KBD_Idle_GetStats(&st, reset);
+
+  const uint32_t v[7 + KBD_IDLE_VETO_COUNT] = {
+      CAB_LSIFQ,     st.window,      st.halt_ticks, st.sleep_ticks,
+      st.halt_count, st.sleep_count, st.busy_count, st.veto[0],
+      st.veto[1],    st.veto[2],     st.veto[3],
+  };
+
+  resp[0] = KBD_RESP_OK;
+  resp[1] = st.last_block;
+  for (uint8_t i = 0; i < 7 + KBD_IDLE_VETO_COUNT; i++)
+  {
+    p = put_u32_le(p, v[i]);
+  }
+
+  KBD_Command_SendResponse(KBD_CMD_IDLE_STATS, frame->sub, resp, sizeof(resp));
+}
+
+/**
+ * @brief 读取 BLE 重连补发缓冲与唤醒延迟统计
+ *
+ * 请求: data[0] bit0 = 读取后清零
+ *
+ * 响应格式 (little-endian):
+ * [0]      OK
+ * [1]      当前缓冲条数
+ * [2]      最大缓冲条数
+ * [3]      缓冲容量 (KBD_BLE_REPLAY_DEPTH)
+ * [4..7]   累计进入缓冲
+ * [8..11]  加密后补发
+ * [12..15] 超时丢弃
+ * [16..19] 缓冲满丢弃
+ * [20..23] 唤醒延迟测量次数
+ * [24..27] 最近一次唤醒到首报告 (ms)
+ * [28..31] 最大唤醒到首报告 (ms)
+ */
+static void HandleReplayStats(const kbd_cmd_frame_t *frame)
+{
+  uint8_t resp[4 + 7 * 4];
+  uint8_t reset = (frame->len >= 1) ? (frame->data[0] & 0x01) : 0;
+  uint8_t *p = &resp[4];
+  ble_hid_replay_stats_t st;
+
+  BLE_HID_GetReplayStats(&st, reset);
+
+  const uint32_t v[7] = {
+      st.buffered,   st.replayed,     st.expired,     st.dropped,
+      st.wake_count, st.wake_last_ms, st.wake_max_ms,
+  };
+
+  resp[0] = KBD_RESP_OK;
+  resp[1] = st.depth;
+  resp[2] = st.high_water;
+  resp[3] = KBD_BLE_REPLAY_DEPTH;
+  for (uint8_t i = 0; i < 7; i++)
+  {
+    p = put_u32_le(p, v[i]);
+  }
+
+  KBD_Command_SendResponse(KBD_CMD_BLE_REPLAY_STATS, frame->sub, resp, sizeof(resp));
+}
+
+/**
+ * @brief 读取 USB 挂起缓冲与远程唤醒统计
+ *
+ * 请求: data[0] bit0 = 读取后清零
+ *
+ * 响应格式 (little-endian):
+ * [0]      OK
+ * [1]      当前缓冲条数
+ * [2]      最大缓冲条数
+ * [3]      缓冲容量 (KBD_USB_RESUME_DEPTH)
+ * [4..7]   累计进入缓冲
+ * [8..11]  恢复后发出
+ * [12..15] 超时丢弃
+ * [16..19] 缓冲满丢弃
+ * [20..23] 远程唤醒次数
+ * [24..27] 按键到首报告测量次数
+ * [28..31] 最近一次按键到首报告 (ms)
+ * [32..35] 最大按键到首报告 (ms)
+ */
+static void HandleResumeStats(const kbd_cmd_frame_t *frame)
+{
+  uint8_t resp[4 + 8 * 4];
+  uint8_t reset = (frame->len >= 1) ? (frame->data[0] & 0x01) : 0;
+  uint8_t *p = &resp[4];
+  USB_ResumeStats_t st;
+
+  USB_HID_GetResumeStats(&st, reset);
+
+  const uint32_t v[8] = {
+      st.buffered, st.flushed,   st.expired,     st.dropped,
+      st.wakeups,  st.lat_count, st.lat_last_ms, st.lat_max_ms,
+  };
+
+  resp[0] = KBD_RESP_OK;
+  resp[1] = st.depth;
+  resp[2] = st.high_water;
+  resp[3] = KBD_USB_RESUME_DEPTH;
+  for (uint8_t i = 0; i < 8; i++)
+  {
+    p = put_u32_le(p, v[i]);
+  }
+
+  KBD_Command_SendResponse(KBD_CMD_USB_RESUME_STATS, frame->sub, resp, sizeof(resp));
+}
+
+/**
+ * @brief 读取 BLE 连接参数策略统计
+ *
+ * 请求: data[0] bit0 = 读取后清零
+ *
+ * 响应格式 (little-endian):
+ * [0]      OK
+ * [1]      当前档位 (0=打字, 1=空闲)
+ * [2]      已请求档位 (0xFF=本次连接未请求)
+ * [3..4]   实际连接间隔 (1.25ms)
+ * [5..6]   实际从机延迟
+ * [7..8]   实际监督超时 (10ms)
+ * [9..12]  参数更新请求次数
+ * [13..16] 参数更新次数
+ * [17..20] 打字档时间 (ms)
+ * [21..24] 空闲档时间 (ms)
+ */
+static void HandleConnStats(const kbd_cmd_frame_t *frame)
+{
+  uint8_t resp[9 + 4 * 4];
+  uint8_t reset = (frame->len >= 1) ? (frame->data[0] & 0x01) : 0;
+  uint8_t *p = &resp[9];
+  ble_hid_conn_stats_t st;
+
+  BLE_HID_GetConnStats(&st, reset);
+
+  const uint32_t v[4] = {st.requests, st.updates, st.fast_ms, st.idle_ms};
+
+  resp[0] = KBD_RESP_OK;
+  resp[1] = st.target;
+  resp[2] = st.requested;
+  resp[3] = (uint8_t)(st.interval & 0xFF);
+  resp[4] = (uint8_t)(st.interval >> 8);
+  resp[5] = (uint8_t)(st.latency & 0xFF);
+  resp[6] = (uint8_t)(st.latency >> 8);
+  resp[7] = (uint8_t)(st.timeout & 0xFF);
+  resp[8] = (uint8_t)(st.timeout >> 8);
+  for (uint8_t i = 0; i < 4; i++)
+  {
+    p = put_u32_le(p, v[i]);
+  }
+
+  KBD_Command_SendResponse(KBD_CMD_BLE_CONN_STATS, frame->sub, resp, sizeof(resp));
+}
+
+/**
+ * @brief 读取 BLE 回连统计
+ *
+ * 请求: data[0] bit0 = 读取后清零
+ *
+ * 响应格式 (little-endian):
+ * [0]      OK
+ * [1]      当前阶段 (0=无, 1=高占空比定向, 2=低占空比定向, 3=快速, 4=慢速)
+ * [2]      最近一次连上时的阶段
+ * [3]      回连主机有效
+ * [4]      回连主机地址类型 (0=public, 1=random)
+ * [5..10]  回连主机地址
+ * [11]     定向广播连续未命中次数
+ * [12..15] 回连次数
+ * [16..19] 链路建立次数
+ * [20..23] 链路加密次数
+ * [24..27] 连上前被停止次数
+ * [28..43] 各阶段连上次数 (高占空比定向 / 低占空比定向 / 快速 / 慢速)
+ * [44..47] 最近一次开始到链路建立 (ms)
+ * [48..51] 最近一次开始到链路加密 (ms)
+ * [52..55] 最大开始到链路加密 (ms)
+ * [56..59] 累计开始到链路加密 (ms)
+ */
+static void HandleReconnStats(const kbd_cmd_frame_t *frame)
+{
+  uint8_t resp[12 + 12 * 4];
+  uint8_t reset = (frame->len >= 1) ? (frame->data[0] & 0x01) : 0;
+  uint8_t *p = &resp[12];
+  ble_hid_reconn_stats_t st;
+
+  BLE_HID_GetReconnStats(&st, reset);
+
+  const uint32_t v[12] = {st.attempts,       st.connected,      st.ready,
+                          st.aborted,        st.by_phase[0],    st.by_phase[1],
+                          st.by_phase[2],    st.by_phase[3],    st.last_link_ms,
+                          st.last_ready_ms,  st.max_ready_ms,   st.total_ready_ms};
+
+  resp[0] = KBD_RESP_OK;
+  resp[1] = st.phase;
+  resp[2] = st.last_phase;
+  resp[3] = st.peer_valid;
+  resp[4] = st.peer_type;
+  memcpy(&resp[5], st.peer_addr, sizeof(st.peer_addr));
+  resp[11] = st.direct_miss;
+  for (uint8_t i = 0; i < 12; i++)
+  {
+    p = put_u32_le(p, v[i]);
+  }
+
+  KBD_Command_SendResponse(KBD_CMD_BLE_RECONN_STATS, frame->sub, resp, sizeof(resp));
+}
+
+/**
+ * @brief 读取 BLE 多主机槽位与切换统计
+ *
+ * 请求: data[0] bit0 = 读取后清零 (槽位内容不变)
+ *
+ * 响应格式 (little-endian):
+ * [0]      OK
+ * [1]      当前槽位
+ * [2..5]   切换次数
+ * [6..9]   拒绝的其他槽位主机连接
+ * [10..13] 最近一次切换到链路加密 (ms)
+ * [14..17] 最大切换到链路加密 (ms)
+ * [18..59] 3 个槽位，每个 14 字节:
+ *          valid, 地址类型, 地址[6], 连接间隔 u16 (1.25ms), 从机延迟 u16, 监督超时 u16 (10ms)
+ */
+static void HandleHostStats(const kbd_cmd_frame_t *frame)
+{
+  uint8_t resp[18 + KBD_BLE_HOST_COUNT * 14];
+  uint8_t reset = (frame->len >= 1) ? (frame->data[0] & 0x01) : 0;
+  uint8_t *p = &resp[2];
+  ble_hid_host_stats_t st;
+
+  BLE_HID_GetHostStats(&st, reset);
+
+  const uint32_t v[4] = {st.switches, st.rejected, st.last_switch_ms, st.max_switch_ms};
+
+  resp[0] = KBD_RESP_OK;
+  resp[1] = st.active;
+  for (uint8_t i = 0; i < 4; i++)
+  {
+    p = put_u32_le(p, v[i]);
+  }
+  for (uint8_t i = 0; i < KBD_BLE_HOST_COUNT; i++)
+  {
+    kbd_ble_host_t host;
+
+    BLE_HID_GetHost(i, &host);
+    *p++ = host.valid;
+    *p++ = host.addr_type;
+    memcpy(p, host.addr, sizeof(host.addr));
+    p += sizeof(host.addr);
+    *p++ = (uint8_t)(host.interval & 0xFF);
+    *p++ = (uint8_t)(host.interval >> 8);
+    *p++ = (uint8_t)(host.latency & 0xFF);
+    *p++ = (uint8_t)(host.latency >> 8);
+    *p++ = (uint8_t)(host.timeout & 0xFF);
+    *p++ = (uint8_t)(host.timeout >> 8);
+  }
+
+  KBD_Command_SendResponse(KBD_CMD_BLE_HOST_STATS, frame->sub, resp, sizeof(resp));
+}
+
+/**
+ * @brief 读取 BLE 配置服务链路与吞吐统计
+ *
+ * 请求: data[0] bit0 = 读取后清零计数 (MTU / PHY / 使能状态不变)
+ *
+ * 响应格式 (little-endian):
+ * [0]      OK
+ * [1..2]   当前 ATT MTU
+ * [3]      发送 PHY (1=1M, 2=2M)
+ * [4]      接收 PHY
+ * [5]      TX 通知已使能
+ * [6]      命令队列容量
+ * [7]      命令队列最大深度
+ * [8..9]   发送环容量 (字节)
+ * [10..11] 发送环最大占用 (字节)
+ * [12..43] 8 个 u32: 收到帧, 收到字节, 丢弃收帧, 响应帧, 通知字节, 通知条数,
+ *          丢弃响应帧, 通知重试
+ */
+static void HandleCfgServiceStats(const kbd_cmd_frame_t *frame)
+{
+  uint8_t resp[44];
+  uint8_t reset = (frame->len >= 1) ? (frame->data[0] & 0x01) : 0;
+  uint8_t *p = &resp[12];
+  ble_cfg_stats_t st;
+
+  BLE_Cfg_GetStats(&st, reset);
+
+  const uint32_t v[8] = {st.rx_frames, st.rx_bytes,  st.rx_dropped,  st.tx_frames,
+                         st.tx_bytes,  st.tx_notifies, st.tx_dropped, st.tx_retries};
+
+  resp[0] = KBD_RESP_OK;
+  resp[1] = (uint8_t)(st.mtu & 0xFF);
+  resp[2] = (uint8_t)(st.mtu >> 8);
+  resp[3] = st.tx_phy;
+  resp[4] = st.rx_phy;
+  resp[5] = st.notify;
+  resp[6] = KBD_BLE_CFG_RX_FRAMES;
+  resp[7] = st.rx_high_water;
+  resp[8] = (uint8_t)(KBD_BLE_CFG_TX_RING & 0xFF);
+  resp[9] = (uint8_t)(KBD_BLE_CFG_TX_RING >> 8);
+  resp[10] = (uint8_t)(st.tx_high_water & 0xFF);
+  resp[11] = (uint8_t)(st.tx_high_water >> 8);
+  for (uint8_t i = 0; i < 8; i++)
+  {
+    p = put_u32_le(p, v[i]);
+  }
+
+  KBD_Command_SendResponse(KBD_CMD_BLE_CFG_STATS, frame->sub, resp, sizeof(resp));
+}
+
+/**
+ * @brief 读取 BLE 输入报告发送节奏统计
+ *
+ * 请求: data[0] bit0 = 读取后清零计数 (预算 / 突发状态 / 当前积压不变)
+ *
+ * 响应格式 (little-endian):
+ * [0]      OK
+ * [1]      当前每连接事件预算
+ * [2]      突发预算 (KBD_BLE_TX_BURST_BUDGET)
+ * [3]      当前处于突发
+ * [4]      当前积压
+ * [5]      最大积压
+ * [6]      宏暂停阈值 (KBD_BLE_TX_BACKLOG_MAX)
+ * [7..8]   当前连接间隔 (1.25ms)
+ * [9..36]  7 个 u32: 突发次数, 突发报告数, 突发连接事件数, 突发时长 (ms),
+ *          排队报告, 按连接事件放行, 积压满丢弃
+ */
+static void HandleTxStats(const kbd_cmd_frame_t *frame)
+{
+  uint8_t resp[9 + 7 * 4];
+  uint8_t reset = (frame->len >= 1) ? (frame->data[0] & 0x01) : 0;
+  uint8_t *p = &resp[9];
+  ble_hid_tx_stats_t st;
+
+  BLE_HID_GetTxStats(&st, reset);
+
+  const uint32_t v[7] = {
+      st.bursts,   st.burst_reports, st.burst_events, st.burst_ms,
+      st.deferred, st.paced,         st.dropped,
+  };
+
+  resp[0] = KBD_RESP_OK;
+  resp[1] = st.budget;
+  resp[2] = KBD_BLE_TX_BURST_BUDGET;
+  resp[3] = st.burst;
+  resp[4] = st.backlog;
+  resp[5] = st.backlog_max;
+  resp[6] = KBD_BLE_TX_BACKLOG_MAX;
+  resp[7] = (uint8_t)(st.interval & 0xFF);
+  resp[8] = (uint8_t)(st.interval >> 8);
+  for (uint8_t i = 0; i < 7; i++)
+  {
+    p = put_u32_le(p, v[i]);
+  }
+
+  KBD_Command_SendResponse(KBD_CMD_BLE_TX_STATS, frame->sub, resp, sizeof(resp));
+}
+
+/**
+ * @brief 读取 BLE 链路遥测，可开关自适应发射功率
+ *
+ * 请求: data[0] bit0 = 读取后清零计数, bit1 = 设置自适应发射功率 (bit2 = 打开)，不保存
+ *
+ * 响应格式 (little-endian, RSSI / dBm 为有符号):
+ * [0]      OK
+ * [1..4]   RSSI 最近 / 平均 / 最小 / 最大 (dBm, 127 = 无)
+ * [5]      当前发射功率 (dBm)
+ * [6]      默认发射功率 (dBm)
+ * [7]      自适应发射功率已打开
+ * [8]      最近一次断链原因 (HCI)
+ * [9..10]  当前连接间隔 (1.25ms)
+ * [11..26] 4 个 u32: 连接事件, 漏事件, 重传事件, 发射功率调整次数
+ * [27..30] 断链次数 (饱和到 255): 监督超时, 主机断开, 本机断开, 其他
+ * [31..50] 5 档 (-15 / -10 / -5 / 0 / +4 dBm) 累计连接时间 (ms, u32)
+ * [51..60] 5 档重传事件比例 (‰, u16)
+ */
+static void HandleLinkStats(const kbd_cmd_frame_t *frame)
+{
+  uint8_t resp[61];
+  uint8_t flags = (frame->len >= 1) ? frame->data[0] : 0;
+  uint8_t *p = &resp[11];
+  ble_link_stats_t st;
+
+  if (flags & 0x02)
+  {
+    BLE_Link_SetAdaptive((flags & 0x04) != 0);
+  }
+  BLE_Link_GetStats(&st, flags & 0x01);
+
+  const uint32_t v[4] = {st.events, st.missed, st.retries, st.tx_changes};
+  const uint16_t disc[4] = {st.disc_timeout, st.disc_remote, st.disc_local, st.disc_other};
+
+  resp[0] = KBD_RESP_OK;
+  resp[1] = (uint8_t)st.rssi_last;
+  resp[2] = (uint8_t)st.rssi_avg;
+  resp[3] = (uint8_t)st.rssi_min;
+  resp[4] = (uint8_t)st.rssi_max;
+  resp[5] = (uint8_t)st.tx_dbm;
+  resp[6] = (uint8_t)st.tx_dbm_default;
+  resp[7] = st.adapt;
+  resp[8] = st.last_reason;
+  resp[9] = (uint8_t)(st.interval & 0xFF);
+  resp[10] = (uint8_t)(st.interval >> 8);
+  for (uint8_t i = 0; i < 4; i++)
+  {
+    p = put_u32_le(p, v[i]);
+  }
+  for (uint8_t i = 0; i < 4; i++)
+  {
+    *p++ = (disc[i] > 0xFF) ? 0xFF : (uint8_t)disc[i];
+  }
+  for (uint8_t i = 0; i < BLE_LINK_TX_LEVELS; i++)
+  {
+    p = put_u32_le(p, st.level_ms[i]);
+  }
+  for (uint8_t i = 0; i < BLE_LINK_TX_LEVELS; i++)
+  {
+    *p++ = (uint8_t)(st.level_retry_pm[i] & 0xFF);
+    *p++ = (uint8_t)(st.level_retry_pm[i] >> 8);
+  }
+
+  KBD_Command_SendResponse(KBD_CMD_BLE_LINK_STATS, frame->sub, resp, sizeof(resp));
+}
+
+/**
+ * @brief 读取电池采样调度统计
+ *
+ * 请求: data[0] bit0 = 读取后清零计数 (周期 / 斜率不变)
+ *
+ * 响应格式 (little-endian):
+ * [0]      OK
+ * [1..4]   当前周期采样间隔 (ms)
+ * [5..6]   电压斜率 (mV/min, 有符号, 下降为负)
+ * [7]      CHRG 边沿中断已打开 (0 = 正在轮询去抖)
+ * [8..35]  7 个 u32: 任务唤醒, 接受的采样, 丢弃的采样, 连接事件后转换,
+ *          等连接事件超时, CHRG 中断, CHRG 去抖轮询
+ */
+static void HandleBatteryStats(const kbd_cmd_frame_t *frame)
+{
+  uint8_t resp[8 + 7 * 4];
+  uint8_t reset = (frame->len >= 1) ? (frame->data[0] & 0x01) : 0;
+  uint8_t *p = &resp[8];
+  kbd_battery_stats_t st;
+
+  KBD_Battery_GetStats(&st, reset);
+
+  const uint32_t v[7] = {
+      st.wakeups,        st.samples,     st.rejected,     st.aligned,
+      st.radio_timeouts, st.charge_irqs, st.charge_polls,
+  };
+
+  resp[0] = KBD_RESP_OK;
+  (void)put_u32_le(&resp[1], st.period_ms);
+  resp[5] = (uint8_t)((uint16_t)st.slope_mv_min & 0xFF);
+  resp[6] = (uint8_t)((uint16_t)st.slope_mv_min >> 8);
+  resp[7] = st.charge_irq_armed;
+  for (uint8_t i = 0; i < 7; i++)
+  {
+    p = put_u32_le(p, v[i]);
+  }
+
+  KBD_Command_SendResponse(KBD_CMD_BAT_STATS, frame->sub, resp, sizeof(resp));
+}
+
+/**
+ * @brief 读取 Flash 擦写队列统计
+ *
+ * 请求: data[0] bit0 = 读取后清零计数 (当前排队数不变)
+ *
+ * 响应格式 (little-endian):
+ * [0]      OK
+ * [1]      当前排队任务数
+ * [2]      最大排队任务数
+ * [3..4]   当前连接间隔 (1.25ms, 0 = 未连接)
+ * [5..6]   当前从机延迟
+ * [7..10]  单步最长耗时 (us)
+ * [11..50] 10 个 u32: 单步累计耗时 (us), 完成, 失败, 队列满被拒, 等连接事件,
+ *          连接事件后执行, 等待超时后执行, 未连接直接执行, 同步清空执行,
+ *          估计漏连接事件
+ */
+static void HandleFlashJobs(const kbd_cmd_frame_t *frame)
+{
+  uint8_t resp[11 + 10 * 4];
+  uint8_t reset = (frame->len >= 1) ? (frame->data[0] & 0x01) : 0;
+  uint8_t *p = &resp[11];
+  kbd_flash_stats_t st;
+
+  KBD_Flash_GetStats(&st, reset);
+
+  const uint32_t v[10] = {
+      st.step_us_sum, st.jobs,      st.failed,    st.rejected, st.deferred,
+      st.aligned,     st.timeouts,  st.immediate, st.sync,     st.missed,
+  };
+
+  resp[0] = KBD_RESP_OK;
+  resp[1] = st.depth;
+  resp[2] = st.depth_max;
+  resp[3] = (uint8_t)(st.interval & 0xFF);
+  resp[4] = (uint8_t)(st.interval >> 8);
+  resp[5] = (uint8_t)(st.latency & 0xFF);
+  resp[6] = (uint8_t)(st.latency >> 8);
+  (void)put_u32_le(&resp[7], st.step_us_max);
+  for (uint8_t i = 0; i < 10; i++)
+  {
+    p = put_u32_le(p, v[i]);
+  }
+
+  KBD_Command_SendResponse(KBD_CMD_FLASH_JOBS, frame->sub, resp, sizeof(resp));
+}
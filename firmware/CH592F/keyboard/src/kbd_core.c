@@ -12,31 +12,60 @@
 #include "kbd_rgb.h"
 #include "kbd_mode.h"
 #include "kbd_log.h"
+#include "kbd_boot.h"
 #include "hal_utils.h"
 #include "key.h"
 #include "encoder.h"
+#include "kbd_input.h"
+#include "kbd_idle.h"
+#include "kbd_prof.h"
+#include "ble_config.h"
 #include "debug.h"
 #include <string.h>
 
 #define TAG "CORE"
 
+/** 核心任务事件：输入入队 / 旋钮转动 / 旋钮上报周期到达 */
+#define CORE_INPUT_EVT 0x0001
+
 /*============================================================================*/
 /* 私有变量 */
 /*============================================================================*/
 
-/** 当前按下的按键 (用于多键同时按下，HID 最多 6 键) */
+static uint8_t s_task_id = TASK_NO_TASK;
+
+#define KEY_BITMAP_BYTES ((KBD_CORE_MAX_KEYS + 7u) / 8u)
+
+#define STATIC_ASSERT(cond, msg) typedef char static_assert_##msg[(cond) ? 1 : -1]
+STATIC_ASSERT(KBD_CORE_MAX_KEYS >= KBD_TOTAL_KEYS && KBD_CORE_MAX_KEYS <= 255,
+              core_max_keys_out_of_range);
+
+/** 当前按下的按键 (用于多键同时按下，HID 最多 6 键，按首次按下顺序) */
 static uint8_t s_pressed_keys[6] = {0};
 static uint8_t s_pressed_count = 0;
+/** 已按下但 6 键报告放不下的键码数 */
+static uint8_t s_keycode_overflow = 0;
 static uint8_t s_current_modifier = 0;
 static uint8_t s_current_mouse_buttons = 0;
-static uint8_t s_keycode_slots[KBD_MAX_KEYS] = {0};
-static uint8_t s_keycode_refcount[KBD_MAX_KEYS] = {0};
+/** 按 HID 键码直接索引的引用计数 (多个物理键可映射到同一键码) */
+static uint8_t s_keycode_refcount[256] = {0};
 static uint8_t s_modifier_refcount[8] = {0};
 static uint8_t s_mouse_button_refcount[5] = {0};
-static kbd_action_t s_active_actions[KBD_MAX_KEYS];
-static uint8_t s_active_action_valid[KBD_MAX_KEYS] = {0};
-static uint8_t s_momentary_layer_active[KBD_MAX_KEYS] = {0};
-static uint8_t s_momentary_restore_layer[KBD_MAX_KEYS] = {0};
+static kbd_action_t s_active_actions[KBD_CORE_MAX_KEYS];
+static uint8_t s_active_action_valid[KEY_BITMAP_BYTES] = {0};
+static uint8_t s_momentary_layer_active[KEY_BITMAP_BYTES] = {0};
+static uint8_t s_momentary_restore_layer[KBD_CORE_MAX_KEYS] = {0};
+
+#if defined(KBD_HAS_ENCODER)
+/** 旋钮合并上报状态 (仅主循环访问) */
+static uint32_t s_encoder_emit_ms = 0;   /**< 上一次输出时刻 */
+static uint32_t s_encoder_edge_ms = 0;   /**< 上一批最后一个跳变的时刻 */
+static int8_t s_encoder_dir = 0;         /**< 上一批方向 */
+static uint8_t s_encoder_res = 1;        /**< 上一批分辨率 (每格单位数) */
+static uint8_t s_encoder_residue_q4 = 0; /**< 加速倍率小数部分 (1/16 单位) */
+static uint16_t s_encoder_pending_taps = 0; /**< 超出单周期上限、顺延到后续周期的点击数 */
+static uint8_t s_encoder_pending_key = 0;   /**< 顺延点击对应的旋钮键 */
+#endif
 
 static const uint8_t s_modifier_bits[8] = {
     0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80,
@@ -54,6 +83,8 @@ static const uint8_t s_mouse_button_bits[5] = {
 /* 私有函数声明 */
 /*============================================================================*/
 
+static inline bool BitGet(const uint8_t *map, uint8_t idx);
+static inline void BitSet(uint8_t *map, uint8_t idx, bool on);
 static void ResetInputState(void);
 static void RebuildKeyboardReport(void);
 static void UpdateKeycodeRefcount(uint8_t keycode, bool pressed);
@@ -62,9 +93,12 @@ static void UpdateMouseButtons(uint8_t buttons, bool pressed);
 static void SwitchLayer(uint8_t target_layer);
 static void ExecuteKeyAction(uint8_t key_index, const kbd_action_t *action, bool pressed);
 static void ExecuteFnAction(kbd_fn_action_t action, uint8_t param);
+static void ProcessEncoderMotion(void);
 static void OnModeChange(kbd_work_mode_t new_mode);
 static void OnConnStateChange(kbd_conn_state_t state);
 static void OnLedReport(uint8_t leds);
+static uint16_t KBD_Core_ProcessEvent(uint8_t task_id, uint16_t events);
+PROF_DEFINE_TASK(PROF_ZONE_CORE_TASK, KBD_Core_ProcessEvent)
 
 /*============================================================================*/
 /* 模式管理回调结构 */
@@ -86,34 +120,54 @@ static kbd_mode_callbacks_t s_callbacks = {
 void KBD_Core_Init(void)
 {
     ResetInputState();
+
+    s_task_id = TMOS_ProcessEventRegister(PROF_TASK(KBD_Core_ProcessEvent));
+    KBD_Input_SetNotify(s_task_id, CORE_INPUT_EVT);
+    /* 处理注册前已入队的事件 (如上电时已按住的键) */
+    KBD_Idle_SetEvent(s_task_id, CORE_INPUT_EVT);
+
     LOG_I(TAG, "Core initialized");
 }
 
 /**
- * @brief 核心处理函数（主循环调用）
+ * @brief 核心处理函数（核心任务在输入通知或旋钮上报周期到达时调用）
  */
 void KBD_Core_Process(void)
 {
-    key_event_t key_evt;
-    fnkey_event_t fn_evt;
+    kbd_input_event_t evt;
 
-    /* 处理普通按键事件 */
-    while (Key_GetEvent(&key_evt))
+    /* 普通键 / 旋钮 / FN 键共用一个队列，按发生顺序处理 */
+    while (KBD_Input_Pop(&evt))
     {
-        KBD_Core_HandleKeyEvent(&key_evt);
+        if (evt.src == KBD_INPUT_SRC_FN)
+        {
+            fnkey_event_t fn_evt = {.id = evt.code, .type = evt.type, .tick_ms = evt.tick_ms};
+            KBD_Core_HandleFnEvent(&fn_evt);
+        }
+        else
+        {
+            key_event_t key_evt = {.key = evt.code, .type = evt.type, .tick_ms = evt.tick_ms};
+            KBD_Core_HandleKeyEvent(&key_evt);
+        }
     }
 
-    /* 处理旋钮事件 */
-    while (Encoder_GetEvent(&key_evt))
-    {
-        KBD_Core_HandleKeyEvent(&key_evt);
-    }
+    ProcessEncoderMotion();
+}
 
-    /* 处理 FN 按键事件 */
-    while (FnKey_GetEvent(&fn_evt))
+/**
+ * @brief 核心任务：只在 ISR 投递输入事件或旋钮上报定时到达时运行
+ */
+static uint16_t KBD_Core_ProcessEvent(uint8_t task_id, uint16_t events)
+{
+    (void)task_id;
+
+    if (events & CORE_INPUT_EVT)
     {
-        KBD_Core_HandleFnEvent(&fn_evt);
+        KBD_Core_Process();
+        return (events ^ CORE_INPUT_EVT);
     }
+
+    return 0;
 }
 
 /**
@@ -128,10 +182,11 @@ void KBD_Core_HandleKeyEvent(const key_event_t *evt)
 {
     const kbd_action_t *action = NULL;
 
-    if (evt == NULL || evt->key >= KBD_MAX_KEYS)
+    if (evt == NULL || evt->key >= KBD_CORE_MAX_KEYS)
         return;
 
     KBD_Mode_RecordActivity();
+    KBD_Boot_OnKey();
 
     bool pressed = (evt->type == KEY_EVT_PRESS);
 
@@ -152,24 +207,24 @@ void KBD_Core_HandleKeyEvent(const key_event_t *evt)
             LOG_I(TAG, "BOOT+Key%d -> Layer %d", evt->key, target_layer);
             SwitchLayer(target_layer);
             memset(&s_active_actions[evt->key], 0, sizeof(s_active_actions[evt->key]));
-            s_active_action_valid[evt->key] = 1;
+            BitSet(s_active_action_valid, evt->key, true);
             return; /* 不执行按键原本的动作 */
         }
     }
 
     if (pressed)
     {
-        s_active_action_valid[evt->key] = 0;
+        BitSet(s_active_action_valid, evt->key, false);
         memset(&s_active_actions[evt->key], 0, sizeof(s_active_actions[evt->key]));
         action = KBD_GetKeyAction(evt->key);
         if (action != NULL)
         {
             s_active_actions[evt->key] = *action;
-            s_active_action_valid[evt->key] = 1;
+            BitSet(s_active_action_valid, evt->key, true);
             action = &s_active_actions[evt->key];
         }
     }
-    else if (s_active_action_valid[evt->key])
+    else if (BitGet(s_active_action_valid, evt->key))
     {
         action = &s_active_actions[evt->key];
     }
@@ -187,7 +242,7 @@ void KBD_Core_HandleKeyEvent(const key_event_t *evt)
 
     if (!pressed)
     {
-        s_active_action_valid[evt->key] = 0;
+        BitSet(s_active_action_valid, evt->key, false);
         memset(&s_active_actions[evt->key], 0, sizeof(s_active_actions[evt->key]));
     }
 }
@@ -322,10 +377,26 @@ static void OnLedReport(uint8_t leds)
 /* 私有函数实现 */
 /*============================================================================*/
 
+static inline bool BitGet(const uint8_t *map, uint8_t idx)
+{
+    return (map[idx >> 3] & (uint8_t)(1u << (idx & 7u))) != 0;
+}
+
+static inline void BitSet(uint8_t *map, uint8_t idx, bool on)
+{
+    if (on)
+    {
+        map[idx >> 3] |= (uint8_t)(1u << (idx & 7u));
+    }
+    else
+    {
+        map[idx >> 3] &= (uint8_t)~(1u << (idx & 7u));
+    }
+}
+
 static void ResetInputState(void)
 {
     memset(s_pressed_keys, 0, sizeof(s_pressed_keys));
-    memset(s_keycode_slots, 0, sizeof(s_keycode_slots));
     memset(s_keycode_refcount, 0, sizeof(s_keycode_refcount));
     memset(s_modifier_refcount, 0, sizeof(s_modifier_refcount));
     memset(s_mouse_button_refcount, 0, sizeof(s_mouse_button_refcount));
@@ -334,36 +405,81 @@ static void ResetInputState(void)
     memset(s_momentary_layer_active, 0, sizeof(s_momentary_layer_active));
     memset(s_momentary_restore_layer, 0, sizeof(s_momentary_restore_layer));
     s_pressed_count = 0;
+    s_keycode_overflow = 0;
     s_current_modifier = 0;
     s_current_mouse_buttons = 0;
+#if defined(KBD_HAS_ENCODER)
+    s_encoder_dir = 0;
+    s_encoder_residue_q4 = 0;
+    s_encoder_pending_taps = 0;
+#endif
 }
 
+/**
+ * @brief 发送当前键盘报告 (s_pressed_keys 由 UpdateKeycodeRefcount 增量维护)
+ */
 static void RebuildKeyboardReport(void)
 {
-    s_pressed_count = 0;
-    memset(s_pressed_keys, 0, sizeof(s_pressed_keys));
+    if (s_pressed_count > 0 || s_current_modifier != 0)
+    {
+        KBD_Mode_SendKeyboardReport(s_current_modifier, s_pressed_keys, s_pressed_count);
+    }
+    else
+    {
+        KBD_Mode_ReleaseAllKeys();
+    }
+}
 
-    for (uint8_t i = 0; i < KBD_MAX_KEYS; i++)
+/**
+ * @brief 从 6 键报告中移除键码
+ * @return 是否在报告中
+ */
+static bool RemoveReportKeycode(uint8_t keycode)
+{
+    for (uint8_t i = 0; i < s_pressed_count; i++)
     {
-        if (s_keycode_refcount[i] == 0 || s_keycode_slots[i] == 0)
+        if (s_pressed_keys[i] != keycode)
         {
             continue;
         }
-        if (s_pressed_count >= sizeof(s_pressed_keys))
+        for (; i + 1u < s_pressed_count; i++)
         {
-            break;
+            s_pressed_keys[i] = s_pressed_keys[i + 1u];
         }
-        s_pressed_keys[s_pressed_count++] = s_keycode_slots[i];
+        s_pressed_keys[--s_pressed_count] = 0;
+        return true;
     }
+    return false;
+}
 
-    if (s_pressed_count > 0 || s_current_modifier != 0)
-    {
-        KBD_Mode_SendKeyboardReport(s_current_modifier, s_pressed_keys, s_pressed_count);
-    }
-    else
+/**
+ * @brief 报告腾出空位后，补入一个仍按住但未上报的键码 (仅溢出时执行)
+ */
+static void BackfillReportKeycode(void)
+{
+    for (uint16_t kc = 1; kc < 256u; kc++)
     {
-        KBD_Mode_ReleaseAllKeys();
+        if (s_keycode_refcount[kc] == 0)
+        {
+            continue;
+        }
+        bool listed = false;
+        for (uint8_t i = 0; i < s_pressed_count; i++)
+        {
+            if (s_pressed_keys[i] == (uint8_t)kc)
+            {
+                listed = true;
+                break;
+            }
+        }
+        if (!listed)
+        {
+            s_pressed_keys[s_pressed_count++] = (uint8_t)kc;
+            s_keycode_overflow--;
+            return;
+        }
     }
+    s_keycode_overflow = 0;
 }
 
 static void UpdateKeycodeRefcount(uint8_t keycode, bool pressed)
@@ -373,47 +489,41 @@ static void UpdateKeycodeRefcount(uint8_t keycode, bool pressed)
         return;
     }
 
-    for (uint8_t i = 0; i < KBD_MAX_KEYS; i++)
+    if (pressed)
     {
-        if (s_keycode_slots[i] != keycode)
+        if (s_keycode_refcount[keycode] == 0xFF)
         {
-            continue;
+            return;
         }
-
-        if (pressed)
+        if (s_keycode_refcount[keycode]++ != 0)
         {
-            if (s_keycode_refcount[i] < 0xFF)
-            {
-                s_keycode_refcount[i]++;
-            }
             return;
         }
-
-        if (s_keycode_refcount[i] > 0)
+        if (s_pressed_count < sizeof(s_pressed_keys))
         {
-            s_keycode_refcount[i]--;
-            if (s_keycode_refcount[i] == 0)
-            {
-                s_keycode_slots[i] = 0;
-            }
+            s_pressed_keys[s_pressed_count++] = keycode;
+        }
+        else if (s_keycode_overflow < 0xFF)
+        {
+            s_keycode_overflow++;
         }
         return;
     }
 
-    if (!pressed)
+    if (s_keycode_refcount[keycode] == 0 || --s_keycode_refcount[keycode] != 0)
     {
         return;
     }
-
-    for (uint8_t i = 0; i < KBD_MAX_KEYS; i++)
+    if (!RemoveReportKeycode(keycode))
     {
-        if (s_keycode_refcount[i] != 0)
+        if (s_keycode_overflow > 0)
         {
-            continue;
+            s_keycode_overflow--;
         }
-        s_keycode_slots[i] = keycode;
-        s_keycode_refcount[i] = 1;
-        return;
+    }
+    else if (s_keycode_overflow > 0)
+    {
+        BackfillReportKeycode();
     }
 }
 
@@ -501,6 +611,200 @@ static void SwitchLayer(uint8_t target_layer)
     KBD_RGB_FlashLayer(target_layer);
 }
 
+#if defined(KBD_HAS_ENCODER)
+/**
+ * @brief 按旋转速度计算加速倍率 (1/16 单位)
+ *
+ * @param edges 本批跳变数
+ * @param span  距上一批最后一个跳变的时间 (ms)
+ */
+static uint16_t EncoderAccelQ4(uint16_t edges, uint32_t span)
+{
+    const uint32_t max_q4 = (uint32_t)KBD_ENCODER_ACCEL_MAX_MULT * 16u;
+    uint32_t rate = (uint32_t)edges * 1000u / ((span ? span : 1u) * ENCODER_EDGES_PER_DETENT);
+
+    if (rate <= KBD_ENCODER_ACCEL_MIN_RATE)
+        return 16u;
+
+    uint32_t q4 = 16u + (rate - KBD_ENCODER_ACCEL_MIN_RATE) * KBD_ENCODER_ACCEL_SLOPE_Q4;
+    return (uint16_t)((q4 > max_q4) ? max_q4 : q4);
+}
+
+/**
+ * @brief 滚轮 / 水平滚动动作的方向与轴 (非滚动动作返回 0)
+ *
+ * @param[out] pan 1=水平滚动 (AC Pan)，0=滚轮
+ */
+static int8_t EncoderScrollSign(const kbd_action_t *action, bool *pan)
+{
+    if (action == NULL || action->type != KBD_ACTION_MOUSE_WHEEL)
+        return 0;
+
+    *pan = (action->param1 == KBD_WHEEL_LEFT || action->param1 == KBD_WHEEL_RIGHT);
+    switch (action->param1)
+    {
+    case KBD_WHEEL_UP:
+    case KBD_WHEEL_RIGHT:
+        return 1;
+    case KBD_WHEEL_DOWN:
+    case KBD_WHEEL_LEFT:
+        return -1;
+    default:
+        return 0;
+    }
+}
+
+/**
+ * @brief 旋钮某方向动作在当前主机下的滚动分辨率 (每格单位数，非滚动动作为 1)
+ */
+static uint8_t EncoderScrollResolution(int8_t dir)
+{
+    const kbd_action_t *action = KBD_GetKeyAction((dir > 0) ? KBD_KNOB_CW_IDX : KBD_KNOB_CCW_IDX);
+    bool pan = false;
+    uint8_t wheel_mult, pan_mult;
+
+    if (EncoderScrollSign(action, &pan) == 0)
+        return 1u;
+
+    KBD_Mode_GetScrollResolution(&wheel_mult, &pan_mult);
+    return pan ? pan_mult : wheel_mult;
+}
+
+/**
+ * @brief 合并旋钮转动并按上报周期输出一次
+ *
+ * 滚轮 / 水平滚动: 加速后的量合并为一个鼠标报告 (超出 int8 时分块)；
+ *                  主机启用高分辨率时按跳变 (1/4 格) 计量，否则按定位
+ * 媒体键:          加速后的步数逐次点击
+ * 其他动作:        按净定位数走普通按键路径，不加速
+ * 点击类每周期最多 KBD_ENCODER_MAX_TAPS 次，余下的顺延到后续周期
+ * (积压上限 KBD_ENCODER_PENDING_TAPS_MAX)；换向时丢弃
+ */
+static void EncoderFlushTaps(uint32_t tick_ms)
+{
+    uint16_t taps = s_encoder_pending_taps;
+
+    if (taps == 0)
+        return;
+    if (taps > KBD_ENCODER_MAX_TAPS)
+        taps = KBD_ENCODER_MAX_TAPS;
+    s_encoder_pending_taps -= taps;
+
+    for (uint16_t i = 0; i < taps; i++)
+    {
+        key_event_t key_evt = {.key = s_encoder_pending_key, .type = KEY_EVT_PRESS, .tick_ms = tick_ms};
+        KBD_Core_HandleKeyEvent(&key_evt);
+        key_evt.type = KEY_EVT_RELEASE;
+        KBD_Core_HandleKeyEvent(&key_evt);
+    }
+
+    if (s_encoder_pending_taps != 0)
+        tmos_start_task(s_task_id, CORE_INPUT_EVT, MS1_TO_SYSTEM_TIME(KBD_ENCODER_REPORT_MS));
+}
+
+static void ProcessEncoderMotion(void)
+{
+    encoder_motion_t motion;
+    uint32_t now = Key_GetTickMs();
+    uint32_t since = now - s_encoder_emit_ms;
+
+    if (since < KBD_ENCODER_REPORT_MS)
+    {
+        /* 上报周期未到：到期时再合并输出，期间的跳变继续累加 */
+        if (Encoder_HasMotion() || s_encoder_pending_taps != 0)
+            tmos_start_task(s_task_id, CORE_INPUT_EVT,
+                            MS1_TO_SYSTEM_TIME(KBD_ENCODER_REPORT_MS - since));
+        return;
+    }
+    if (!Encoder_TakeMotion(&motion))
+    {
+        /* 无新转动: 只补发顺延的点击 */
+        if (s_encoder_pending_taps != 0)
+        {
+            s_encoder_emit_ms = now;
+            EncoderFlushTaps(now);
+        }
+        return;
+    }
+
+    s_encoder_emit_ms = now;
+    uint32_t span = motion.last_ms - s_encoder_edge_ms;
+    s_encoder_edge_ms = motion.last_ms;
+
+    /* 高分辨率滚动时不足一格也上报；分辨率按跳变方向对应的动作决定 */
+    uint8_t res = 1u;
+    if (motion.edges != 0)
+        res = EncoderScrollResolution((motion.edges > 0) ? 1 : -1);
+
+    int16_t net = (res > 1u) ? motion.edges : motion.detents;
+    if (net == 0)
+    {
+        EncoderFlushTaps(now);
+        return;
+    }
+
+    int8_t dir = (net > 0) ? 1 : -1;
+    uint16_t amount = (uint16_t)((net > 0) ? net : -net);
+
+    /* 换向、停顿或分辨率切换后重新起转: 不继承上一次的速度与小数部分 */
+    uint16_t accel_q4 = 16u;
+    if (dir != s_encoder_dir || res != s_encoder_res || span > KBD_ENCODER_ACCEL_IDLE_MS)
+    {
+        s_encoder_residue_q4 = 0;
+    }
+    else
+    {
+        accel_q4 = EncoderAccelQ4(motion.count, span);
+    }
+    s_encoder_dir = dir;
+    s_encoder_res = res;
+
+    uint32_t total_q4 = (uint32_t)amount * accel_q4 + s_encoder_residue_q4;
+    uint32_t steps = total_q4 >> 4;
+    s_encoder_residue_q4 = (uint8_t)(total_q4 & 0x0Fu);
+
+    uint8_t key = (dir > 0) ? KBD_KNOB_CW_IDX : KBD_KNOB_CCW_IDX;
+    const kbd_action_t *action = KBD_GetKeyAction(key);
+    bool pan = false;
+    int8_t sign = EncoderScrollSign(action, &pan);
+
+    if (sign != 0)
+    {
+        s_encoder_pending_taps = 0;
+        KBD_Mode_RecordActivity();
+        KBD_Boot_OnKey();
+        KBD_RGB_RegisterKeyPress(key);
+        KBD_Log_KeyEvent(key, 1, action->type, action->param1);
+
+        /* 高分辨率时 1 个跳变 = 1 个主机单位 (KBD_HID_SCROLL_HIRES_MULT = 每格跳变数) */
+        while (steps > 0)
+        {
+            int8_t chunk = (int8_t)((steps > 127u) ? 127u : steps);
+            int8_t units = (int8_t)(chunk * sign);
+            KBD_Mode_SendMouseScroll(s_current_mouse_buttons, pan ? 0 : units, pan ? units : 0);
+            steps -= (uint32_t)chunk;
+        }
+        return;
+    }
+
+    /* 媒体键保留加速；键盘键 / 层等动作每个定位对应一次点击 */
+    uint32_t taps = (action != NULL && action->type == KBD_ACTION_CONSUMER) ? steps : amount;
+
+    /* 换向 (或动作改变) 时不再补发旧方向的点击 */
+    if (key != s_encoder_pending_key)
+        s_encoder_pending_taps = 0;
+    s_encoder_pending_key = key;
+
+    taps += s_encoder_pending_taps;
+    if (taps > KBD_ENCODER_PENDING_TAPS_MAX)
+        taps = KBD_ENCODER_PENDING_TAPS_MAX;
+    s_encoder_pending_taps = (uint16_t)taps;
+    EncoderFlushTaps(motion.last_ms);
+}
+#else
+static void ProcessEncoderMotion(void) {}
+#endif
+
 /**
  * @brief 执行按键动作
  */
@@ -547,6 +851,15 @@ static void ExecuteKeyAction(uint8_t key_index, const kbd_action_t *action, bool
                 mDelaymS(50);
                 KBD_Mode_SendMouseReport(s_current_mouse_buttons, 0, 0, 0);
                 return;
+            case KBD_WHEEL_LEFT:
+            case KBD_WHEEL_RIGHT:
+            {
+                uint8_t wheel_mult, pan_mult;
+                KBD_Mode_GetScrollResolution(&wheel_mult, &pan_mult);
+                KBD_Mode_SendMouseScroll(s_current_mouse_buttons, 0,
+                                         (int8_t)((action->param1 == KBD_WHEEL_RIGHT) ? pan_mult : -(int8_t)pan_mult));
+                return;
+            }
             }
             if (wheel != 0)
             {
@@ -575,7 +888,7 @@ static void ExecuteKeyAction(uint8_t key_index, const kbd_action_t *action, bool
             switch ((kbd_layer_op_t)action->modifier)
             {
             case KBD_LAYER_MOMENTARY:
-                s_momentary_layer_active[key_index] = 1;
+                BitSet(s_momentary_layer_active, key_index, true);
                 s_momentary_restore_layer[key_index] = KBD_GetCurrentLayer();
                 SwitchLayer(action->param1);
                 break;
@@ -597,9 +910,9 @@ static void ExecuteKeyAction(uint8_t key_index, const kbd_action_t *action, bool
             }
         }
         else if ((kbd_layer_op_t)action->modifier == KBD_LAYER_MOMENTARY &&
-                 s_momentary_layer_active[key_index])
+                 BitGet(s_momentary_layer_active, key_index))
         {
-            s_momentary_layer_active[key_index] = 0;
+            BitSet(s_momentary_layer_active, key_index, false);
             SwitchLayer(s_momentary_restore_layer[key_index]);
         }
         break;
@@ -697,6 +1010,34 @@ static void ExecuteFnAction(kbd_fn_action_t action, uint8_t param)
         }
         break;
 
+    case KBD_FN_BLE_HOST:
+    case KBD_FN_BLE_HOST_NEXT:
+    {
+        /* 槽位 0/1/2 分别闪蓝/绿/紫 */
+        static const uint8_t host_color[KBD_BLE_HOST_COUNT][3] = {
+            {0, 120, 255}, {0, 255, 80}, {200, 0, 255}};
+        uint8_t idx = (action == KBD_FN_BLE_HOST)
+                          ? param
+                          : (uint8_t)((KBD_Mode_BLE_GetHost() + 1) % KBD_BLE_HOST_COUNT);
+
+        if (KBD_Mode_Get() != KBD_WORK_MODE_BLE || idx >= KBD_BLE_HOST_COUNT)
+        {
+            break;
+        }
+        LOG_I(TAG, "FN: host %d", idx);
+        ret = KBD_Mode_BLE_SelectHost(idx);
+        if (ret == 0)
+        {
+            KBD_RGB_Flash(host_color[idx][0], host_color[idx][1], host_color[idx][2], 300);
+        }
+        else
+        {
+            LOG_W(TAG, "select host failed: %d", ret);
+            KBD_RGB_Flash(255, 0, 0, 200);
+        }
+        break;
+    }
+
     /* RGB 控制 */
     case KBD_FN_RGB_TOGGLE:
         KBD_RGB_Toggle();
@@ -0,0 +1,402 @@
+/**
+ * @file    kbd_flash.c
+ * @brief   MeowKeyboard Flash 擦写任务队列实现
+ * @author  MeowKJ
+ * @version V1.0.0
+ * @date    2024-11-07
+ *
+ * @details
+ * 连接事件结束后到下一个必须参加的锚点 (连接间隔 × (从机延迟 + 1)) 之间是可用间隙：
+ * 按本间隙内已执行步骤的最长耗时估计下一步，放得下就在同一间隙里继续执行，
+ * 恢复出厂时的宏区逐页擦除不必每页等一个连接事件。
+ *
+ * 调度状态只有一个 s_waiting：已经为队首任务登记过执行时机 (连接事件钩子 + 超时，
+ * 或未连接时的立即事件)，在它被执行或 Drain 取消之前不再重复登记。
+ * 连接事件钩子是一次性的，超时或 Drain 之后它仍可能投递一次 RUN 事件；
+ * 此时 s_waiting 为 0，事件被忽略。
+ *
+ * 执行前先把任务弹出队列再回调，回调里提交的新任务排在队尾。
+ * 配置命令 (USB / BLE) 经 KBD_Command_PostUsb / KBD_Command_Submit 在主循环处理，
+ * 提交一般来自主循环；入队 / 出队仍在关中断区间内完成，只为命令任务注册前
+ * KBD_Command_PostUsb 在 USB 中断里同步处理的兜底路径。
+ * 提交后经 KBD_Idle_SetEvent 投递 KICK 事件，登记时机 (TMOS 定时器、连接事件钩子)
+ * 只在主循环里进行。
+ *
+ * @copyright Copyright (c) 2024 MeowKJ. All rights reserved.
+ */
+
+#include "kbd_flash.h"
+#include "kbd_log.h"
+#include "kbd_idle.h"
+#include "kbd_mode.h"
+#include "ble_hid.h"
+#include "hiddev.h"
+#include "ble_hal.h"
+#include "CH59x_common.h"
+#include "debug.h"
+
+#include <string.h>
+
+#define TAG "FLSH"
+
+/*============================================================================*/
+/* 私有定义                                                                    */
+/*============================================================================*/
+
+#define KBD_FLASH_RUN_EVT     0x0001 /**< 连接事件结束，执行一步 */
+#define KBD_FLASH_TIMEOUT_EVT 0x0002 /**< 等连接事件超时，直接执行一步 */
+#define KBD_FLASH_NOW_EVT     0x0004 /**< 未连接，直接执行一步 */
+#define KBD_FLASH_KICK_EVT    0x0008 /**< 有新任务入队，登记执行时机 */
+
+#define KBD_FLASH_STEP_EVTS (KBD_FLASH_RUN_EVT | KBD_FLASH_TIMEOUT_EVT | KBD_FLASH_NOW_EVT)
+
+#define KBD_FLASH_PAGE_SIZE EEPROM_PAGE_SIZE
+
+#ifndef KBD_FLASH_GAP_GUARD_US
+#define KBD_FLASH_GAP_GUARD_US 2500u /**< 间隙末尾留给协议栈准备下一个连接事件的余量 */
+#endif
+
+/*============================================================================*/
+/* 私有变量                                                                    */
+/*============================================================================*/
+
+static tmosTaskID s_task_id = TASK_NO_TASK;
+
+static kbd_flash_job_t s_queue[KBD_FLASH_QUEUE_DEPTH];
+static uint8_t s_head = 0;
+static uint8_t s_count = 0;
+
+/** 已为队首任务登记执行时机 */
+static uint8_t s_waiting = 0;
+
+/** 页读改写缓冲 (EEPROM_* 要求 RAM 中 4 字节对齐) */
+static __attribute__((aligned(4))) uint8_t s_scratch[KBD_FLASH_PAGE_SIZE];
+
+static kbd_flash_stats_t s_stats;
+
+/*============================================================================*/
+/* 私有函数                                                                    */
+/*============================================================================*/
+
+/**
+ * @brief 当前连接参数
+ * @return 相邻两个必须参加的连接事件的间距 (us)，0 = 未连接
+ */
+static uint32_t Flash_ConnParams(uint16_t *interval, uint16_t *latency)
+{
+    uint16_t timeout = 0;
+
+    *interval = 0;
+    *latency = 0;
+    if (KBD_Mode_Get() != KBD_WORK_MODE_BLE || !BLE_HID_IsConnected())
+    {
+        return 0;
+    }
+    HidDev_GetConnParams(interval, latency, &timeout);
+    return (uint32_t)*interval * 1250u * ((uint32_t)*latency + 1u);
+}
+
+static inline uint32_t Flash_ElapsedUs(uint32_t from)
+{
+    return (uint32_t)(((uint64_t)HAL_SleepDistance(RTC_GetCycle32k(), from) * 1000000u) /
+                      CAB_LSIFQ);
+}
+
+/**
+ * @brief 执行一个任务
+ * @return 0 成功；-1 读失败；-2 擦除失败；-3 写入失败
+ */
+static int Flash_Execute(const kbd_flash_job_t *job)
+{
+    switch (job->op)
+    {
+    case KBD_FLASH_OP_PAGE:
+        if (job->offset != 0 || job->len != KBD_FLASH_PAGE_SIZE)
+        {
+            if (EEPROM_READ(job->addr, s_scratch, KBD_FLASH_PAGE_SIZE) != 0)
+            {
+                KBD_Log_FlashEvent(KBD_LOG_FLASH_READ, (uint16_t)job->addr);
+                return -1;
+            }
+        }
+        memcpy(&s_scratch[job->offset], job->data, job->len);
+        if (EEPROM_ERASE(job->addr, KBD_FLASH_PAGE_SIZE) != 0)
+        {
+            KBD_Log_FlashEvent(KBD_LOG_FLASH_ERASE, (uint16_t)job->addr);
+            return -2;
+        }
+        if (EEPROM_WRITE(job->addr, s_scratch, KBD_FLASH_PAGE_SIZE) != 0)
+        {
+            KBD_Log_FlashEvent(KBD_LOG_FLASH_WRITE, (uint16_t)job->addr);
+            return -3;
+        }
+        return 0;
+
+    case KBD_FLASH_OP_ERASE:
+        if (EEPROM_ERASE(job->addr, job->len) != 0)
+        {
+            KBD_Log_FlashEvent(KBD_LOG_FLASH_ERASE, (uint16_t)job->addr);
+            return -2;
+        }
+        return 0;
+
+    case KBD_FLASH_OP_ROM:
+        if (FLASH_ROM_WRITE(job->addr, (void *)job->data, job->len) != 0)
+        {
+            return -3;
+        }
+        return 0;
+
+    default:
+        return -1;
+    }
+}
+
+/**
+ * @brief 弹出队首任务，执行并回调
+ * @return 本步耗时 (us)，队列为空时为 0
+ */
+static uint32_t Flash_RunOne(void)
+{
+    kbd_flash_job_t job;
+    uint32_t irq_status;
+    uint32_t start;
+    uint32_t us;
+    uint32_t span;
+    uint16_t interval, latency;
+    int ret;
+
+    SYS_DisableAllIrq(&irq_status);
+    if (s_count == 0)
+    {
+        SYS_RecoverIrq(irq_status);
+        return 0;
+    }
+    job = s_queue[s_head];
+    s_head = (uint8_t)((s_head + 1) % KBD_FLASH_QUEUE_DEPTH);
+    s_count--;
+    SYS_RecoverIrq(irq_status);
+
+    span = Flash_ConnParams(&interval, &latency);
+    start = RTC_GetCycle32k();
+    ret = Flash_Execute(&job);
+    us = Flash_ElapsedUs(start);
+
+    if (us > s_stats.step_us_max)
+    {
+        s_stats.step_us_max = us;
+    }
+    s_stats.step_us_sum += us;
+    if (span != 0)
+    {
+        /* 连接中执行：单步跨过的必须参加的锚点数 (估计) */
+        s_stats.missed += us / span;
+    }
+    if (ret == 0)
+    {
+        s_stats.jobs++;
+    }
+    else
+    {
+        s_stats.failed++;
+        LOG_E(TAG, "op %d @0x%lx failed: %d", job.op, (unsigned long)job.addr, ret);
+    }
+
+    if (job.cb != NULL)
+    {
+        job.cb(ret, job.ctx);
+    }
+    return us;
+}
+
+/**
+ * @brief 连接事件刚结束：执行队首任务，间隙剩余时间放得下时继续执行
+ */
+static void Flash_RunGap(void)
+{
+    uint16_t interval, latency;
+    uint32_t span = Flash_ConnParams(&interval, &latency);
+    uint32_t start = RTC_GetCycle32k();
+    uint32_t step_max = 0;
+    uint32_t us;
+
+    do
+    {
+        s_stats.aligned++;
+        us = Flash_RunOne();
+        if (us > step_max)
+        {
+            step_max = us;
+        }
+    } while (s_count != 0 && span != 0 &&
+             Flash_ElapsedUs(start) + step_max + KBD_FLASH_GAP_GUARD_US < span);
+}
+
+/**
+ * @brief 为队首任务登记执行时机
+ */
+static void Flash_Schedule(void)
+{
+    if (s_count == 0 || s_waiting || s_task_id == TASK_NO_TASK)
+    {
+        return;
+    }
+
+    s_waiting = 1;
+    if (KBD_Mode_PostAfterRadioEvent(s_task_id, KBD_FLASH_RUN_EVT))
+    {
+        s_stats.deferred++;
+        tmos_start_task(s_task_id, KBD_FLASH_TIMEOUT_EVT,
+                        MS1_TO_SYSTEM_TIME(KBD_FLASH_GAP_WAIT_MS));
+    }
+    else
+    {
+        tmos_set_event(s_task_id, KBD_FLASH_NOW_EVT);
+    }
+}
+
+static uint16_t KBD_Flash_ProcessEvent(uint8_t task_id, uint16_t events)
+{
+    (void)task_id;
+
+    if (events & KBD_FLASH_KICK_EVT)
+    {
+        Flash_Schedule();
+        return (events ^ KBD_FLASH_KICK_EVT);
+    }
+
+    if (events & KBD_FLASH_STEP_EVTS)
+    {
+        if (s_waiting)
+        {
+            s_waiting = 0;
+            tmos_stop_task(s_task_id, KBD_FLASH_TIMEOUT_EVT);
+
+            if (events & KBD_FLASH_RUN_EVT)
+            {
+                Flash_RunGap();
+            }
+            else
+            {
+                if (events & KBD_FLASH_TIMEOUT_EVT)
+                    s_stats.timeouts++;
+                else
+                    s_stats.immediate++;
+                (void)Flash_RunOne();
+            }
+            Flash_Schedule();
+        }
+        return (uint16_t)(events & ~KBD_FLASH_STEP_EVTS);
+    }
+
+    return 0;
+}
+
+/*============================================================================*/
+/* 公共函数                                                                    */
+/*============================================================================*/
+
+void KBD_Flash_Init(void)
+{
+    if (s_task_id == TASK_NO_TASK)
+    {
+        s_task_id = TMOS_ProcessEventRegister(KBD_Flash_ProcessEvent);
+        if (s_task_id == TASK_NO_TASK)
+        {
+            LOG_W(TAG, "TMOS flash task register failed");
+        }
+    }
+}
+
+int KBD_Flash_Submit(const kbd_flash_job_t *job)
+{
+    uint32_t irq_status;
+    uint8_t tail;
+
+    if (job == NULL || job->op > KBD_FLASH_OP_ROM)
+    {
+        return -1;
+    }
+    if (job->op != KBD_FLASH_OP_ERASE &&
+        (job->data == NULL || job->len == 0))
+    {
+        return -1;
+    }
+    if (job->op == KBD_FLASH_OP_PAGE &&
+        ((uint32_t)job->offset + job->len > KBD_FLASH_PAGE_SIZE ||
+         (job->addr % KBD_FLASH_PAGE_SIZE) != 0))
+    {
+        return -1;
+    }
+
+    SYS_DisableAllIrq(&irq_status);
+    if (s_count >= KBD_FLASH_QUEUE_DEPTH)
+    {
+        s_stats.rejected++;
+        SYS_RecoverIrq(irq_status);
+        return -2;
+    }
+    tail = (uint8_t)((s_head + s_count) % KBD_FLASH_QUEUE_DEPTH);
+    s_queue[tail] = *job;
+    s_count++;
+    if (s_count > s_stats.depth_max)
+    {
+        s_stats.depth_max = s_count;
+    }
+    SYS_RecoverIrq(irq_status);
+
+    if (s_task_id == TASK_NO_TASK)
+    {
+        /* 兜底：TMOS 未就绪时同步执行 */
+        (void)KBD_Flash_Drain();
+        return 0;
+    }
+
+    KBD_Idle_SetEvent(s_task_id, KBD_FLASH_KICK_EVT);
+    return 0;
+}
+
+uint8_t KBD_Flash_Pending(void)
+{
+    return s_count;
+}
+
+int KBD_Flash_Drain(void)
+{
+    uint32_t failed = s_stats.failed;
+
+    if (s_waiting)
+    {
+        s_waiting = 0;
+        if (s_task_id != TASK_NO_TASK)
+        {
+            tmos_stop_task(s_task_id, KBD_FLASH_TIMEOUT_EVT);
+        }
+    }
+
+    while (s_count != 0)
+    {
+        s_stats.sync++;
+        (void)Flash_RunOne();
+    }
+
+    return (s_stats.failed == failed) ? 0 : -1;
+}
+
+void KBD_Flash_GetStats(kbd_flash_stats_t *out, uint8_t reset)
+{
+    if (out == NULL)
+    {
+        return;
+    }
+
+    *out = s_stats;
+    out->depth = s_count;
+    (void)Flash_ConnParams(&out->interval, &out->latency);
+
+    if (reset)
+    {
+        memset(&s_stats, 0, sizeof(s_stats));
+        s_stats.depth_max = s_count;
+    }
+}
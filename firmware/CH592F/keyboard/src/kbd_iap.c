@@ -11,7 +11,10 @@
  *   - seq_hi: 页序号 (0, 1, 2, ...)
  *   - offset: 写入偏移 (相对 Image B 起始)
  *   - data: 最多 56 字节有效载荷
- *   - 以 256 字节页为单位缓冲，满页或 ACTIVATE 前 flush
+ *   - 以 256 字节页为单位缓冲，满页或 VERIFY 前 flush
+ *   - flush 交给 kbd_flash 队列在 BLE 连接事件间隙写入 (双缓冲：一页排队时
+ *     本帧剩余数据写入另一页)；触发 flush 的 WRITE / VERIFY 在写入完成后才响应，
+ *     上位机逐帧等待响应，同一时间最多一页在队列中
  *
  * CRC32 校验:
  *   使用标准 CRC-32 (ISO 3309) 对 Image B 的有效区域计算校验值
@@ -21,6 +24,7 @@
 
 #include "kbd_iap.h"
 #include "kbd_command.h"
+#include "kbd_flash.h"
 #include "iap_config.h"
 #include "hal_utils.h"
 #include "debug.h"
@@ -49,8 +53,27 @@ static iap_state_t s_state = IAP_STATE_IDLE;
 /** 已写入的总字节数 */
 static uint32_t s_written_bytes = 0;
 
-/** 页缓冲 (256 字节，Flash 写入最优单位) */
-__attribute__((aligned(8))) static uint8_t s_page_buf[EEPROM_PAGE_SIZE];
+/** 页缓冲 (256 字节，Flash 写入最优单位)；双缓冲，一页在 Flash 队列中时填充另一页 */
+__attribute__((aligned(8))) static uint8_t s_page_buf[2][EEPROM_PAGE_SIZE];
+
+/** 当前填充的页缓冲 */
+static uint8_t s_page_cur = 0;
+
+/** 已提交、尚未写完的页 */
+static uint8_t s_flush_busy = 0;
+
+/** 有页写入失败 (PREPARE 清除) */
+static uint8_t s_flash_error = 0;
+
+/** 等待页写入完成后发送的响应 */
+static struct
+{
+    uint8_t cmd;                                  /**< 0 = 无 */
+    uint8_t seq;
+    uint32_t fw_size;                             /**< VERIFY 参数 */
+    uint32_t expected_crc;
+    kbd_command_response_sender_t sender;         /**< 提交命令的通道 */
+} s_deferred;
 
 /** 页缓冲当前填充位置 */
 static uint16_t s_page_offset = 0;
@@ -87,31 +110,77 @@ static uint32_t crc32_calc(const uint8_t *data, uint32_t len)
 /*                              内部函数                                       */
 /*============================================================================*/
 
+static void IapDeferredDone(void);
+
+/**
+ * @brief 页写入完成 (Flash 队列回调，主循环上下文)
+ */
+static void FlushPageDone(int result, void *ctx)
+{
+    uint32_t addr = (uint32_t)(uintptr_t)ctx;
+
+    s_flush_busy = 0;
+    if (result != 0)
+    {
+        LOG_E(TAG, "Flash write fail @0x%05X ret=%d", addr, result);
+        s_flash_error = 1;
+    }
+    IapDeferredDone();
+}
+
 /**
- * @brief 将页缓冲写入 Flash 并重置
+ * @brief 将当前页缓冲提交到 Flash 队列并切换到另一页
+ * @return 0 已提交 (或无数据)；-1 失败
  */
 static int FlushPageBuffer(void)
 {
+    kbd_flash_job_t job;
+
     if (s_page_offset == 0)
         return 0;
+    if (s_flush_busy)
+        return -1; /* 另一页仍在队列中：上位机没有等待响应 */
 
     /* 补齐到 4 字节对齐 (Flash 写入最小单位) */
     while (s_page_offset & 0x03)
-        s_page_buf[s_page_offset++] = 0xFF;
-
-    uint32_t ret = FLASH_ROM_WRITE(s_page_flash_addr, s_page_buf, s_page_offset);
-    if (ret != 0)
+        s_page_buf[s_page_cur][s_page_offset++] = 0xFF;
+
+    memset(&job, 0, sizeof(job));
+    job.op = KBD_FLASH_OP_ROM;
+    job.addr = s_page_flash_addr;
+    job.data = s_page_buf[s_page_cur];
+    job.len = s_page_offset;
+    job.cb = FlushPageDone;
+    job.ctx = (void *)(uintptr_t)s_page_flash_addr;
+
+    s_flush_busy = 1;
+    if (KBD_Flash_Submit(&job) != 0)
     {
-        LOG_E(TAG, "Flash write fail @0x%05X len=%d ret=%d",
-              s_page_flash_addr, s_page_offset, ret);
+        s_flush_busy = 0;
+        LOG_E(TAG, "Flash queue full @0x%05X", s_page_flash_addr);
         return -1;
     }
 
+    s_page_cur ^= 1;
     s_page_flash_addr += s_page_offset;
     s_page_offset = 0;
     return 0;
 }
 
+/**
+ * @brief 登记页写入完成后再发送的响应 (页已同步写完时立即发送)
+ */
+static void IapDefer(uint8_t cmd, uint8_t seq)
+{
+    s_deferred.cmd = cmd;
+    s_deferred.seq = seq;
+    s_deferred.sender = KBD_Command_GetResponseSender();
+    if (!s_flush_busy)
+    {
+        IapDeferredDone();
+    }
+}
+
 /*============================================================================*/
 /*                          命令处理: IAP_INFO (0x80)                          */
 /*============================================================================*/
@@ -159,6 +228,13 @@ static void HandleIapPrepare(const kbd_cmd_frame_t *frame)
 {
     uint8_t resp[1];
 
+    if (s_flush_busy)
+    {
+        resp[0] = KBD_RESP_ERR_BUSY;
+        KBD_Command_SendResponse(KBD_CMD_IAP_PREPARE, 0, resp, 1);
+        return;
+    }
+
     LOG_I(TAG, "Preparing: erase Image B (0x%05X, %dKB)",
           IMAGE_B_START_ADD, IMAGE_B_SIZE / 1024);
 
@@ -177,8 +253,10 @@ static void HandleIapPrepare(const kbd_cmd_frame_t *frame)
 
     /* 重置写入状态 */
     s_written_bytes = 0;
+    s_page_cur = 0;
     s_page_offset = 0;
     s_page_flash_addr = IMAGE_B_START_ADD;
+    s_flash_error = 0;
 
     s_state = IAP_STATE_READY;
     resp[0] = KBD_RESP_OK;
@@ -200,13 +278,16 @@ static void HandleIapPrepare(const kbd_cmd_frame_t *frame)
  *   data[2..]: 有效载荷 (最多 56 字节)
  *
  * 响应: [0x82][seq][4][status, written_hi, written_mid, written_lo]
+ *       (本帧填满一页时在该页写入 Flash 后才响应)
  */
 static void HandleIapWrite(const kbd_cmd_frame_t *frame)
 {
     uint8_t resp[4];
     uint8_t seq = frame->sub;
+    bool flushed = false;
 
-    if (s_state != IAP_STATE_READY && s_state != IAP_STATE_WRITING)
+    if ((s_state != IAP_STATE_READY && s_state != IAP_STATE_WRITING) ||
+        s_flush_busy)
     {
         resp[0] = KBD_RESP_ERR_BUSY;
         resp[1] = 0;
@@ -226,6 +307,16 @@ static void HandleIapWrite(const kbd_cmd_frame_t *frame)
         return;
     }
 
+    if (s_flash_error)
+    {
+        resp[0] = KBD_RESP_ERR_FLASH;
+        resp[1] = 0;
+        resp[2] = 0;
+        resp[3] = 0;
+        KBD_Command_SendResponse(KBD_CMD_IAP_WRITE, seq, resp, 4);
+        return;
+    }
+
     s_state = IAP_STATE_WRITING;
 
     /* 解析偏移和载荷 */
@@ -249,6 +340,7 @@ static void HandleIapWrite(const kbd_cmd_frame_t *frame)
     uint32_t target_page_start = IMAGE_B_START_ADD + offset;
     if (target_page_start != s_page_flash_addr)
     {
+        flushed = (s_page_offset > 0);
         if (FlushPageBuffer() != 0)
         {
             resp[0] = KBD_RESP_ERR_FLASH;
@@ -269,7 +361,7 @@ static void HandleIapWrite(const kbd_cmd_frame_t *frame)
         uint16_t space = EEPROM_PAGE_SIZE - s_page_offset;
         uint8_t chunk = (remaining < space) ? remaining : (uint8_t)space;
 
-        memcpy(&s_page_buf[s_page_offset], src, chunk);
+        memcpy(&s_page_buf[s_page_cur][s_page_offset], src, chunk);
         s_page_offset += chunk;
         src += chunk;
         remaining -= chunk;
@@ -277,6 +369,7 @@ static void HandleIapWrite(const kbd_cmd_frame_t *frame)
         /* 页满则 flush */
         if (s_page_offset >= EEPROM_PAGE_SIZE)
         {
+            flushed = true;
             if (FlushPageBuffer() != 0)
             {
                 resp[0] = KBD_RESP_ERR_FLASH;
@@ -292,6 +385,12 @@ static void HandleIapWrite(const kbd_cmd_frame_t *frame)
     /* 同一页会分多帧写入，使用实际页地址和页内偏移累计进度。 */
     s_written_bytes = (s_page_flash_addr - IMAGE_B_START_ADD) + s_page_offset;
 
+    if (flushed)
+    {
+        IapDefer(KBD_CMD_IAP_WRITE, seq);
+        return;
+    }
+
     resp[0] = KBD_RESP_OK;
     resp[1] = (s_written_bytes >> 16) & 0xFF;
     resp[2] = (s_written_bytes >> 8) & 0xFF;
@@ -303,6 +402,46 @@ static void HandleIapWrite(const kbd_cmd_frame_t *frame)
 /*                        命令处理: IAP_VERIFY (0x83)                          */
 /*============================================================================*/
 
+/**
+ * @brief 计算 Image B CRC32 并发送 VERIFY 响应 (所有页已写完)
+ */
+static void IapVerifyImage(uint32_t fw_size, uint32_t expected_crc)
+{
+    uint8_t resp[5];
+
+    if (s_flash_error)
+    {
+        resp[0] = KBD_RESP_ERR_FLASH;
+        memset(&resp[1], 0, 4);
+        KBD_Command_SendResponse(KBD_CMD_IAP_VERIFY, 0, resp, 5);
+        return;
+    }
+
+    LOG_I(TAG, "Verify: size=%d expected_crc=0x%08X", fw_size, expected_crc);
+
+    /* 对 Image B 计算 CRC32 (Flash 是内存映射的，直接读) */
+    uint32_t actual_crc = crc32_calc((const uint8_t *)IMAGE_B_START_ADD, fw_size);
+
+    resp[0] = (actual_crc == expected_crc) ? KBD_RESP_OK : KBD_RESP_ERR_FLASH;
+    resp[1] = (actual_crc >> 0) & 0xFF;
+    resp[2] = (actual_crc >> 8) & 0xFF;
+    resp[3] = (actual_crc >> 16) & 0xFF;
+    resp[4] = (actual_crc >> 24) & 0xFF;
+
+    if (actual_crc == expected_crc)
+    {
+        s_state = IAP_STATE_WRITTEN;
+        LOG_I(TAG, "Verify OK: CRC32=0x%08X", actual_crc);
+    }
+    else
+    {
+        LOG_E(TAG, "Verify FAIL: expected=0x%08X actual=0x%08X",
+              expected_crc, actual_crc);
+    }
+
+    KBD_Command_SendResponse(KBD_CMD_IAP_VERIFY, 0, resp, 5);
+}
+
 /**
  * @brief CRC32 校验 Image B
  *
@@ -311,21 +450,18 @@ static void HandleIapWrite(const kbd_cmd_frame_t *frame)
  *   expected_crc: 上位机预计算的 CRC32
  *
  * 响应: [0x83][0][5][status, actual_crc(4B LE)]
+ *       (残余数据先提交到 Flash 队列，写完后再校验和响应)
  */
 static void HandleIapVerify(const kbd_cmd_frame_t *frame)
 {
     uint8_t resp[5];
 
-    /* Flush 残余数据 */
-    if (s_page_offset > 0)
+    if (s_flush_busy)
     {
-        if (FlushPageBuffer() != 0)
-        {
-            resp[0] = KBD_RESP_ERR_FLASH;
-            memset(&resp[1], 0, 4);
-            KBD_Command_SendResponse(KBD_CMD_IAP_VERIFY, 0, resp, 5);
-            return;
-        }
+        resp[0] = KBD_RESP_ERR_BUSY;
+        memset(&resp[1], 0, 4);
+        KBD_Command_SendResponse(KBD_CMD_IAP_VERIFY, 0, resp, 5);
+        return;
     }
 
     if (frame->len < 8)
@@ -357,29 +493,54 @@ static void HandleIapVerify(const kbd_cmd_frame_t *frame)
         return;
     }
 
-    LOG_I(TAG, "Verify: size=%d expected_crc=0x%08X", fw_size, expected_crc);
+    /* Flush 残余数据，写完后再校验 */
+    if (s_page_offset > 0)
+    {
+        if (FlushPageBuffer() != 0)
+        {
+            resp[0] = KBD_RESP_ERR_FLASH;
+            memset(&resp[1], 0, 4);
+            KBD_Command_SendResponse(KBD_CMD_IAP_VERIFY, 0, resp, 5);
+            return;
+        }
+        s_deferred.fw_size = fw_size;
+        s_deferred.expected_crc = expected_crc;
+        IapDefer(KBD_CMD_IAP_VERIFY, 0);
+        return;
+    }
 
-    /* 对 Image B 计算 CRC32 (Flash 是内存映射的，直接读) */
-    uint32_t actual_crc = crc32_calc((const uint8_t *)IMAGE_B_START_ADD, fw_size);
+    IapVerifyImage(fw_size, expected_crc);
+}
 
-    resp[0] = (actual_crc == expected_crc) ? KBD_RESP_OK : KBD_RESP_ERR_FLASH;
-    resp[1] = (actual_crc >> 0) & 0xFF;
-    resp[2] = (actual_crc >> 8) & 0xFF;
-    resp[3] = (actual_crc >> 16) & 0xFF;
-    resp[4] = (actual_crc >> 24) & 0xFF;
+/**
+ * @brief 页写入完成后发送登记的 WRITE / VERIFY 响应
+ */
+static void IapDeferredDone(void)
+{
+    kbd_command_response_sender_t sender;
+    uint8_t resp[4];
+    uint8_t cmd = s_deferred.cmd;
 
-    if (actual_crc == expected_crc)
+    if (cmd == 0)
+        return;
+    s_deferred.cmd = 0;
+
+    /* 响应回到提交命令的通道 (USB 或 BLE 配置服务) */
+    sender = KBD_Command_GetResponseSender();
+    KBD_Command_SetResponseSender(s_deferred.sender);
+    if (cmd == KBD_CMD_IAP_VERIFY)
     {
-        s_state = IAP_STATE_WRITTEN;
-        LOG_I(TAG, "Verify OK: CRC32=0x%08X", actual_crc);
+        IapVerifyImage(s_deferred.fw_size, s_deferred.expected_crc);
     }
     else
     {
-        LOG_E(TAG, "Verify FAIL: expected=0x%08X actual=0x%08X",
-              expected_crc, actual_crc);
+        resp[0] = s_flash_error ? KBD_RESP_ERR_FLASH : KBD_RESP_OK;
+        resp[1] = (s_written_bytes >> 16) & 0xFF;
+        resp[2] = (s_written_bytes >> 8) & 0xFF;
+        resp[3] = (s_written_bytes >> 0) & 0xFF;
+        KBD_Command_SendResponse(KBD_CMD_IAP_WRITE, s_deferred.seq, resp, 4);
     }
-
-    KBD_Command_SendResponse(KBD_CMD_IAP_VERIFY, 0, resp, 5);
+    KBD_Command_SetResponseSender(sender);
 }
 
 /*============================================================================*/
@@ -431,8 +592,12 @@ void KBD_IAP_Init(void)
 {
     s_state = IAP_STATE_IDLE;
     s_written_bytes = 0;
+    s_page_cur = 0;
     s_page_offset = 0;
     s_page_flash_addr = IMAGE_B_START_ADD;
+    s_flush_busy = 0;
+    s_flash_error = 0;
+    s_deferred.cmd = 0;
     LOG_I(TAG, "IAP module init (B=0x%05X, size=%dKB)",
           IMAGE_B_START_ADD, IMAGE_B_SIZE / 1024);
 }
@@ -461,3 +626,8 @@ int KBD_IAP_Process(const kbd_cmd_frame_t *frame)
     }
     return 0;
 }
+
+uint8_t KBD_IAP_IsBusy(void)
+{
+    return (s_flush_busy || s_deferred.cmd != 0) ? 1 : 0;
+}
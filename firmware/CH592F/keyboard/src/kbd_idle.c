@@ -0,0 +1,178 @@
+/**
+ * @file    kbd_idle.c
+ * @brief   MeowKeyboard 主循环空闲低功耗实现
+ * @author  MeowKJ
+ * @version V1.0.0
+ * @date    2024-11-07
+ *
+ * @details
+ * 判定与进入低功耗在同一个关全局中断 (mstatus.MIE) 区间内完成：检查之后到达的
+ * 中断保持挂起并立即结束 WFI，恢复中断后才进入服务函数，不会出现
+ * "TMOS 检查时无事件、调用钩子前 ISR 投递事件、事件等到下一次唤醒才处理" 的窗口：
+ * ISR 经 KBD_Idle_SetEvent 投递时置位标志，钩子看到标志即返回。
+ * 注意不能用 SYS_DisableAllIrq：它屏蔽的是 PFIC 使能位，被屏蔽的中断无法唤醒 WFI。
+ *
+ * 钩子与统计读取都在主循环上下文执行，统计变量无需额外加锁。
+ *
+ * @copyright Copyright (c) 2024 MeowKJ. All rights reserved.
+ */
+
+#include "kbd_idle.h"
+#include "kbd_mode.h"
+#include "key.h"
+#include "usb_device.h"
+#include "ws2812.h"
+#include "debug.h"
+#include "ble_hal.h"
+
+#include <string.h>
+
+/*============================================================================*/
+/* 私有变量                                                                    */
+/*============================================================================*/
+
+static kbd_idle_stats_t s_stats;
+
+/** 统计窗口上一次推进时的 RTC 计数 */
+static uint32_t s_window_rtc = 0;
+
+/** ISR 投递事件后置位，钩子取走后清零 */
+static volatile uint8_t s_event_posted = 0;
+
+/*============================================================================*/
+/* 私有函数                                                                    */
+/*============================================================================*/
+
+__HIGH_CODE
+static inline uint32_t SatAdd(uint32_t a, uint32_t b)
+{
+    return (a > 0xFFFFFFFFu - b) ? 0xFFFFFFFFu : a + b;
+}
+
+/**
+ * @brief 把统计窗口推进到 now (TMOS 至少每 BLE_CALIBRATION_PERIOD 唤醒一次，
+ *        单次距离远小于 RTC 回绕周期)
+ */
+__HIGH_CODE
+static void Idle_AdvanceWindow(uint32_t now)
+{
+    s_stats.window = SatAdd(s_stats.window, HAL_SleepDistance(now, s_window_rtc));
+    s_window_rtc = now;
+}
+
+/**
+ * @brief 收集阻止 Sleep 的原因 (关中断状态下调用)
+ */
+__HIGH_CODE
+static uint8_t Idle_CollectBlockers(void)
+{
+    uint8_t block = 0;
+
+    if (s_event_posted)
+        block |= KBD_IDLE_BLOCK_EVENT;
+    /* BLE 模式下 USB 也已初始化，主机在线时同样要保持 USB 时钟 */
+    if (KBD_Mode_Get() == KBD_WORK_MODE_USB || USB_Device_HasHost())
+        block |= KBD_IDLE_BLOCK_USB;
+    if (Key_IsTimerPending())
+        block |= KBD_IDLE_BLOCK_KEY;
+    if (WS2812_IsPowered())
+        block |= KBD_IDLE_BLOCK_RGB;
+    if (Debug_TxBusy())
+        block |= KBD_IDLE_BLOCK_LOG;
+
+    return block;
+}
+
+/*============================================================================*/
+/* 公共接口                                                                    */
+/*============================================================================*/
+
+void KBD_Idle_Init(void)
+{
+    /* RTC 唤醒与触发模式由 HAL_SleepInit 配置；这里追加按键 / 旋钮 / 矩阵与 USB */
+    PWR_PeriphWakeUpCfg(ENABLE, RB_SLP_GPIO_WAKE | RB_SLP_USB_WAKE | RB_SLP_RTC_WAKE,
+                        Long_Delay);
+
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_window_rtc = RTC_GetCycle32k();
+}
+
+__HIGH_CODE
+uint32_t KBD_Idle_Hook(uint32_t time)
+{
+    uint32_t mie = __risc_v_disable_irq();
+    uint32_t now = RTC_GetCycle32k();
+    uint32_t remain = HAL_SleepDistance(time, now);
+    uint8_t block;
+
+    Idle_AdvanceWindow(now);
+
+    block = Idle_CollectBlockers();
+    if (block & KBD_IDLE_BLOCK_EVENT)
+    {
+        /* 事件已在 TMOS 中就绪，返回后下一轮调度即处理 */
+        s_event_posted = 0;
+        s_stats.busy_count = SatAdd(s_stats.busy_count, 1u);
+        s_stats.last_block = block;
+        __risc_v_enable_irq(mie);
+        return 2;
+    }
+
+    /* 截止时刻已过 (回绕后表现为超大距离) 或太近时不暂停 */
+    if ((remain < KBD_IDLE_HALT_MIN_TICKS) || (remain > SLEEP_RTC_MAX_TIME))
+    {
+        __risc_v_enable_irq(mie);
+        return 2;
+    }
+
+    if (remain < SLEEP_RTC_MIN_TIME + WAKE_UP_RTC_MAX_TIME)
+        block |= KBD_IDLE_BLOCK_SHORT;
+
+    if ((block == 0) && KBD_IDLE_SLEEP_ENABLE)
+    {
+        uint32_t slept = HAL_SleepUntil(time);
+        Key_CompensateSleep(slept);
+        s_stats.sleep_ticks = SatAdd(s_stats.sleep_ticks, slept);
+        s_stats.sleep_count = SatAdd(s_stats.sleep_count, 1u);
+    }
+    else
+    {
+        HAL_SleepIdle(time);
+        s_stats.halt_ticks =
+            SatAdd(s_stats.halt_ticks, HAL_SleepDistance(RTC_GetCycle32k(), now));
+        s_stats.halt_count = SatAdd(s_stats.halt_count, 1u);
+        for (uint8_t i = 0; i < KBD_IDLE_VETO_COUNT; i++)
+        {
+            if (block & (KBD_IDLE_BLOCK_USB << i))
+                s_stats.veto[i] = SatAdd(s_stats.veto[i], 1u);
+        }
+        if (block)
+            s_stats.last_block = block;
+    }
+
+    __risc_v_enable_irq(mie);
+    return 0;
+}
+
+__HIGH_CODE
+void KBD_Idle_SetEvent(uint8_t task_id, uint16_t event)
+{
+    if (task_id == TASK_NO_TASK)
+        return;
+
+    tmos_set_event(task_id, event);
+    s_event_posted = 1;
+}
+
+void KBD_Idle_GetStats(kbd_idle_stats_t *out, uint8_t reset)
+{
+    if (out == NULL)
+        return;
+
+    Idle_AdvanceWindow(RTC_GetCycle32k());
+    *out = s_stats;
+    if (reset)
+    {
+        memset(&s_stats, 0, sizeof(s_stats));
+    }
+}
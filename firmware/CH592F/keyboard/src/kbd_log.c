@@ -7,7 +7,8 @@
  *
  * @details
  * 使用环形队列缓冲日志帧，避免在按键 ISR / 回调中直接操作 USB。
- * 主循环调用 KBD_Log_Flush() 逐条通过 EP4 发送。
+ * 入队后触发日志任务，由 KBD_Log_Flush() 逐条通过 EP4 发送；
+ * 一次发不完或 EP4 被宏操作占用时隔一个 TMOS 节拍重试。
  * 固件端只控制总开关，类别过滤由上位机 UI 完成。
  *
  * @copyright Copyright (c) 2024 MeowKJ. All rights reserved.
@@ -16,6 +17,9 @@
 #include "kbd_log.h"
 #include "kbd_storage.h"
 #include "kbd_mode.h"
+#include "kbd_blackbox.h"
+#include "kbd_idle.h"
+#include "ble_config.h"
 #include "debug.h"
 #include <string.h>
 
@@ -43,6 +47,12 @@ static uint8_t s_enabled = KBD_LOG_DEFAULT_ENABLED;  /**< 日志总开关 */
 /** 每次 flush 最大条数 */
 #define LOG_FLUSH_COUNT 2
 
+/** 未发完时的重试间隔 */
+#define LOG_FLUSH_RETRY_MS 1
+
+/** 日志任务事件 */
+#define LOG_FLUSH_EVT 0x0001
+
 /** 队列深度 (2 的幂便于取模) */
 #define LOG_QUEUE_SIZE 8
 #define LOG_QUEUE_MASK (LOG_QUEUE_SIZE - 1)
@@ -58,6 +68,8 @@ typedef struct {
 } log_entry_t;
 
 #if KBD_USB_LOG_ENABLE
+static uint8_t s_task_id = TASK_NO_TASK;
+
 static log_entry_t s_queue[LOG_QUEUE_SIZE];
 static volatile uint8_t s_head = 0;  /**< 写入位置 */
 static volatile uint8_t s_tail = 0;  /**< 读取位置 */
@@ -102,6 +114,34 @@ static uint8_t usb_log_record_allowed(void)
 }
 #endif
 
+/**
+ * @brief 记录一条日志：黑匣子始终镜像 (仅 RAM)，HID 队列受开关与模式约束
+ */
+static void log_record(uint8_t category, const uint8_t *data, uint8_t len)
+{
+    KBD_BlackBox_Record(category, data, len);
+#if KBD_USB_LOG_ENABLE
+    if (usb_log_record_allowed()) {
+        queue_push(category, data, len);
+        KBD_Idle_SetEvent(s_task_id, LOG_FLUSH_EVT);
+    }
+#endif
+}
+
+#if KBD_USB_LOG_ENABLE
+static uint16_t KBD_Log_ProcessEvent(uint8_t task_id, uint16_t events)
+{
+    if (events & LOG_FLUSH_EVT) {
+        KBD_Log_Flush();
+        if (!queue_empty()) {
+            tmos_start_task(task_id, LOG_FLUSH_EVT, MS1_TO_SYSTEM_TIME(LOG_FLUSH_RETRY_MS));
+        }
+        return (events ^ LOG_FLUSH_EVT);
+    }
+    return 0;
+}
+#endif
+
 /*============================================================================*/
 /* 公共函数                                                                    */
 /*============================================================================*/
@@ -113,6 +153,9 @@ void KBD_Log_Init(void)
     s_tail = 0;
     kbd_system_config_t *sys = KBD_GetSystemConfig();
     s_enabled = sys->log_enabled ? 1 : 0;
+    if (s_task_id == TASK_NO_TASK) {
+        s_task_id = TMOS_ProcessEventRegister(KBD_Log_ProcessEvent);
+    }
 #else
     s_enabled = 0;
 #endif
@@ -178,63 +221,48 @@ uint8_t KBD_Log_IsEnabled(void)
 
 void KBD_Log_KeyEvent(uint8_t key_index, uint8_t pressed, uint8_t action_type, uint8_t param)
 {
-#if KBD_USB_LOG_ENABLE
-    if (!usb_log_record_allowed()) return;
     uint8_t data[4] = { key_index, pressed, action_type, param };
-    queue_push(KBD_LOG_KEY_EVENT, data, 4);
-#endif
+    log_record(KBD_LOG_KEY_EVENT, data, 4);
 }
 
 void KBD_Log_FnEvent(uint8_t fn_id, uint8_t is_long, uint8_t action, uint8_t param)
 {
-#if KBD_USB_LOG_ENABLE
-    if (!usb_log_record_allowed()) return;
     uint8_t data[4] = { fn_id, is_long, action, param };
-    queue_push(KBD_LOG_FN_EVENT, data, 4);
-#endif
+    log_record(KBD_LOG_FN_EVENT, data, 4);
 }
 
 void KBD_Log_LayerEvent(uint8_t old_layer, uint8_t new_layer)
 {
-#if KBD_USB_LOG_ENABLE
-    if (!usb_log_record_allowed()) return;
     uint8_t data[2] = { old_layer, new_layer };
-    queue_push(KBD_LOG_LAYER_EVENT, data, 2);
-#endif
+    log_record(KBD_LOG_LAYER_EVENT, data, 2);
 }
 
 void KBD_Log_ModeEvent(uint8_t old_mode, uint8_t new_mode)
 {
-#if KBD_USB_LOG_ENABLE
-    if (!usb_log_record_allowed()) return;
     uint8_t data[2] = { old_mode, new_mode };
-    queue_push(KBD_LOG_MODE_EVENT, data, 2);
-#endif
+    log_record(KBD_LOG_MODE_EVENT, data, 2);
 }
 
 void KBD_Log_BleEvent(uint8_t state)
 {
-#if KBD_USB_LOG_ENABLE
-    if (!usb_log_record_allowed()) return;
     uint8_t data[1] = { state };
-    queue_push(KBD_LOG_BLE_EVENT, data, 1);
-#endif
+    log_record(KBD_LOG_BLE_EVENT, data, 1);
 }
 
 void KBD_Log_RgbEvent(uint8_t mode, uint8_t brightness)
 {
-#if KBD_USB_LOG_ENABLE
-    if (!usb_log_record_allowed()) return;
     uint8_t data[2] = { mode, brightness };
-    queue_push(KBD_LOG_RGB_EVENT, data, 2);
-#endif
+    log_record(KBD_LOG_RGB_EVENT, data, 2);
 }
 
 void KBD_Log_SystemEvent(uint8_t event)
 {
-#if KBD_USB_LOG_ENABLE
-    if (!usb_log_record_allowed()) return;
     uint8_t data[1] = { event };
-    queue_push(KBD_LOG_SYSTEM_EVENT, data, 1);
-#endif
+    log_record(KBD_LOG_SYSTEM_EVENT, data, 1);
+}
+
+void KBD_Log_FlashEvent(uint8_t op, uint16_t addr)
+{
+    uint8_t data[3] = { op, (uint8_t)(addr >> 8), (uint8_t)(addr & 0xFF) };
+    log_record(KBD_LOG_FLASH_EVENT, data, 3);
 }
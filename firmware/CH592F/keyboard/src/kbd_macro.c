@@ -15,6 +15,7 @@
 #include "CH59x_common.h"
 #include "ble_config.h"
 #include "debug.h"
+#include "kbd_prof.h"
 
 #define TAG "MACRO"
 
@@ -24,6 +25,9 @@
 
 #define MACRO_STEP_EVT 0x0001
 
+/** 蓝牙发送积压已满时的等待间隔（毫秒），约一个打字档连接间隔 */
+#define MACRO_TX_WAIT_MS 10
+
 /*============================================================================*/
 /* 状态定义                                                                    */
 /*============================================================================*/
@@ -62,6 +66,7 @@ static bool s_consumer_release_pending;
 /*============================================================================*/
 
 static uint16_t KBD_Macro_ProcessEvent(uint8_t task_id, uint16_t events);
+PROF_DEFINE_TASK(PROF_ZONE_MACRO_TASK, KBD_Macro_ProcessEvent)
 static void MacroStepActions(void);
 static bool ShouldLoop(void);
 static void MacroAddKey(uint8_t keycode);
@@ -75,7 +80,7 @@ static void MacroReleaseAll(void);
 
 void KBD_Macro_Init(void)
 {
-    s_task_id = TMOS_ProcessEventRegister(KBD_Macro_ProcessEvent);
+    s_task_id = TMOS_ProcessEventRegister(PROF_TASK(KBD_Macro_ProcessEvent));
     s_state = MACRO_IDLE;
     s_mouse_buttons = 0;
     s_consumer_release_pending = false;
@@ -116,6 +121,7 @@ int KBD_Macro_Execute(uint8_t slot, kbd_macro_trigger_t trigger)
     }
 
     s_state = MACRO_RUNNING;
+    KBD_Mode_SetTxBurst(true);
     LOG_I(TAG, "Execute slot %d, trigger %d, %d actions",
           slot, trigger, s_header.action_count);
 
@@ -146,6 +152,7 @@ void KBD_Macro_Cancel(void)
     tmos_stop_task(s_task_id, MACRO_STEP_EVT);
     MacroReleaseAll();
     s_state = MACRO_IDLE;
+    KBD_Mode_SetTxBurst(false);
     LOG_D(TAG, "Cancelled");
 }
 
@@ -182,6 +189,13 @@ static void MacroStepActions(void)
     }
 
     while (s_action_idx < s_header.action_count) {
+        /* 蓝牙积压已满：不再产生报告，等连接事件放行后继续，避免丢报告卡键 */
+        if (KBD_Mode_TxBusy()) {
+            tmos_start_task(s_task_id, MACRO_STEP_EVT,
+                            MS1_TO_SYSTEM_TIME(MACRO_TX_WAIT_MS));
+            return;
+        }
+
         kbd_macro_action_t action;
         uint16_t offset = s_action_idx * sizeof(kbd_macro_action_t);
 
@@ -268,6 +282,7 @@ macro_round_done:
     } else {
         MacroReleaseAll();
         s_state = MACRO_IDLE;
+        KBD_Mode_SetTxBurst(false);
         LOG_D(TAG, "Slot %d done", s_slot);
     }
 }
@@ -20,6 +20,7 @@
 #include "kbd_storage.h"
 #include "ws2812.h"
 #include "debug.h"
+#include "kbd_prof.h"
 #include "CH59x_common.h"
 #include "ble_config.h"
 #include "kbd_config.h"
@@ -298,6 +299,9 @@ static void ProcessPressEffects(kbd_rgb_config_t *cfg)
 /**
  * @brief TMOS 事件处理
  */
+static uint16_t KBD_RGB_ProcessEvent(uint8_t task_id, uint16_t events);
+PROF_DEFINE_TASK(PROF_ZONE_RGB_TASK, KBD_RGB_ProcessEvent)
+
 static uint16_t KBD_RGB_ProcessEvent(uint8_t task_id, uint16_t events)
 {
     (void)task_id;
@@ -644,7 +648,17 @@ void KBD_RGB_Init(void)
     s_layer_flash_active = false;
     ClearPressEffects();
 
-    s_rgb_task_id = TMOS_ProcessEventRegister(KBD_RGB_ProcessEvent);
+    s_rgb_task_id = TMOS_ProcessEventRegister(PROF_TASK(KBD_RGB_ProcessEvent));
+}
+
+void KBD_RGB_Start(void)
+{
+    /* 启动前已进入休眠时保持暂停，由唤醒流程恢复 */
+    if (!s_scheduler_enabled)
+    {
+        return;
+    }
+
     tmos_start_task(s_rgb_task_id, RGB_UPDATE_EVT, MS1_TO_SYSTEM_TIME(RGB_UPDATE_INTERVAL_MS));
 }
 
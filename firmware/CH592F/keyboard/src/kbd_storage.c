@@ -24,10 +24,15 @@
 
 #include "kbd_storage.h"
 #include "kbd_command.h"
+#include "kbd_log.h"
+#include "kbd_flash.h"
+#include "kbd_idle.h"
 #include "CH59x_common.h"
 #include "ble_config.h"
 #include "debug.h"
+#include "kbd_prof.h"
 #include "kbd_config.h"
+#include "key.h"
 #include <string.h>
 
 /** @brief 模块日志标签 */
@@ -62,9 +67,14 @@
 #define KBD_STORAGE_RUNTIME_SAVE_RETRY_MS 100u
 #endif
 
-/* TMOS 延迟宏写入（从 USB ISR 延迟到主循环，避免 ISR 中操作 Flash） */
+/* TMOS 延迟宏写入（分段经 Flash 队列执行，不阻塞命令处理） */
 #define KBD_STORAGE_MACRO_WRITE_EVT 0x0002u
 
+/* TMOS 配置保存（分页擦写在主循环经 Flash 队列执行） */
+#define KBD_STORAGE_CONFIG_SAVE_EVT 0x0004u
+
+#define KBD_MACRO_PAGE_COUNT (KBD_FLASH_MACRO_SIZE / KBD_FLASH_MACRO_PAGE)
+
 /* 宏操作类型 */
 #define MACRO_OP_IDLE       0
 #define MACRO_OP_WRITE      1
@@ -74,10 +84,6 @@
 /* 最大单包写入长度（与 Studio 的 CH592_MEOWFS_WRITE_CHUNK 一致） */
 #define MACRO_WRITE_BUF_SIZE 58
 
-/* 前向声明（在 TMOS 事件处理中使用） */
-static int MeowFs_WriteRawInternal(uint16_t offset, const uint8_t *buf,
-                                   uint16_t len);
-
 /*============================================================================*/
 /*                              私有变量 */
 /*============================================================================*/
@@ -124,6 +130,18 @@ static uint8_t s_runtime_pending_mode = 0xFF;
 /** @brief runtime 最近一次成功持久化的工作模式（0xFF=未知） */
 static uint8_t s_runtime_last_saved_mode = 0xFF;
 
+/** @brief runtime 待保存 BLE 主机槽位（定向广播回连目标） */
+static kbd_ble_host_t s_runtime_pending_hosts[KBD_BLE_HOST_COUNT];
+
+/** @brief runtime 最近一次成功持久化的 BLE 主机槽位 */
+static kbd_ble_host_t s_runtime_last_saved_hosts[KBD_BLE_HOST_COUNT];
+
+/** @brief runtime 待保存当前 BLE 主机槽位 */
+static uint8_t s_runtime_pending_host_active = 0;
+
+/** @brief runtime 最近一次成功持久化的当前 BLE 主机槽位 */
+static uint8_t s_runtime_last_saved_host_active = 0;
+
 /** @brief 待延迟执行的宏操作（ISR → TMOS 主循环） */
 static struct {
   uint8_t  type;       /**< MACRO_OP_* 操作类型 */
@@ -131,9 +149,29 @@ static struct {
   uint16_t offset;     /**< 写入偏移 */
   uint16_t len;        /**< 写入长度 */
   uint8_t  erase_page; /**< 擦除页索引 */
+  uint16_t progress;   /**< 已提交到 Flash 队列的字节数（写）/ 页数（擦除） */
+  kbd_command_response_sender_t sender; /**< 提交时的响应通道 */
   uint8_t  data[MACRO_WRITE_BUF_SIZE]; /**< 写入数据缓冲 */
 } s_macro_pending;
 
+/** @brief 进行中的配置保存（Flash 队列逐页执行） */
+static struct {
+  volatile uint8_t requested;    /**< 有新的保存请求（ISR 可置位） */
+  volatile uint8_t erase_macros; /**< 保存前擦除宏区（恢复出厂） */
+  uint8_t busy;                  /**< 保存进行中 */
+  uint8_t commit;                /**< 完成后切换到新槽位 */
+  uint8_t slot;                  /**< 目标槽位 */
+  uint8_t dirty;                 /**< 待写页位图（bit0 = header 页） */
+  uint8_t macro_page;            /**< 宏区擦除进度 */
+  int result;                    /**< 本次保存结果 */
+  kbd_config_header_t header;    /**< 新头部 */
+  kbd_flash_cb_t done;           /**< 本次保存的完成回调 */
+  void *done_ctx;
+  kbd_flash_cb_t waiter;         /**< 下一次保存的完成回调（ISR 可写入） */
+  void *waiter_ctx;
+  __attribute__((aligned(4))) uint8_t image[KBD_CFG_SLOT_SIZE]; /**< 槽位镜像 */
+} s_cfg_save;
+
 /*============================================================================*/
 /*                              默认配置 */
 /*============================================================================*/
@@ -259,6 +297,7 @@ static const kbd_system_config_t s_default_system = {
     .log_enabled = KBD_LOG_DEFAULT_ENABLED, /* HID 日志默认开关由构建类型决定 */
     .deep_sleep_min = 1,        /* DEEP 默认在 LIGHT 后 1 分钟 */
     .os_mode = KBD_OS_MODE_WIN, /* 默认 Win 模式 */
+    .debounce_mode = KEY_DEBOUNCE_EAGER, /* 边沿立即上报 + 锁定 */
 };
 
 /*============================================================================*/
@@ -331,6 +370,10 @@ static void LoadDefaults(void) {
   s_runtime_last_saved_layer = 0xFF;
   s_runtime_pending_mode = 0xFF;
   s_runtime_last_saved_mode = 0xFF;
+  memset(s_runtime_pending_hosts, 0, sizeof(s_runtime_pending_hosts));
+  memset(s_runtime_last_saved_hosts, 0, sizeof(s_runtime_last_saved_hosts));
+  s_runtime_pending_host_active = 0;
+  s_runtime_last_saved_host_active = 0;
 
   memcpy(&s_system_config, &s_default_system, sizeof(kbd_system_config_t));
   memcpy(&s_keymap_config, &s_default_keymap, sizeof(kbd_keymap_t));
@@ -354,10 +397,16 @@ typedef struct __attribute__((packed)) {
   uint32_t seq;
   uint8_t current_layer;
   uint8_t last_mode;     /**< 工作模式 (0=USB, 1=BLE, 0xFF=未知) */
-  uint8_t reserved[238];
+  kbd_ble_host_t ble_host[KBD_BLE_HOST_COUNT]; /**< 旧版本页中为 0xFF，按空槽处理 */
+  uint8_t ble_host_active;                     /**< 当前 BLE 主机槽位 (0xFF 按 0 处理) */
+  uint8_t reserved[195];
   uint32_t crc32;
 } kbd_runtime_page_t;
 
+/* 热数据页按整页擦写，新增字段须从 reserved 中扣除，否则会越过页边界写进 MeowFS 区 */
+#define STATIC_ASSERT(cond, msg) typedef char static_assert_##msg[(cond) ? 1 : -1]
+STATIC_ASSERT(sizeof(kbd_runtime_page_t) == KBD_CFG_PAGE_SIZE, runtime_page_size);
+
 static uint32_t CalcConfigCRC(const kbd_system_config_t *system,
                               const kbd_keymap_t *keymap,
                               const kbd_fnkey_config_t *fnkey,
@@ -374,13 +423,20 @@ static uint32_t CalcRuntimeCRC(const kbd_runtime_page_t *page) {
   return KBD_CalcCRC32((const uint8_t *)page, sizeof(*page) - sizeof(page->crc32));
 }
 
+/** @brief runtime 页写入缓冲（Flash 队列执行前保持有效） */
+static __attribute__((aligned(4))) kbd_runtime_page_t s_runtime_page;
+
+/** @brief runtime 页写入进行中（目标页号） */
+static uint8_t s_runtime_inflight_page = KBD_RUNTIME_INVALID_PAGE;
+
 static uint16_t KBD_Storage_ProcessEvent(uint8_t task_id, uint16_t events);
+PROF_DEFINE_TASK(PROF_ZONE_STORAGE_TASK, KBD_Storage_ProcessEvent)
 
 static void KBD_Storage_InitTMOSTask(void) {
   if (s_storage_task_id != TASK_NO_TASK) {
     return;
   }
-  s_storage_task_id = TMOS_ProcessEventRegister(KBD_Storage_ProcessEvent);
+  s_storage_task_id = TMOS_ProcessEventRegister(PROF_TASK(KBD_Storage_ProcessEvent));
   if (s_storage_task_id == TASK_NO_TASK) {
     LOG_W(TAG, "TMOS storage task register failed");
   }
@@ -415,6 +471,10 @@ static void ApplyRuntimeLayerIfValid(void) {
     s_runtime_last_saved_layer = 0xFF;
     s_runtime_pending_mode = 0xFF;
     s_runtime_last_saved_mode = 0xFF;
+    memset(s_runtime_pending_hosts, 0, sizeof(s_runtime_pending_hosts));
+    memset(s_runtime_last_saved_hosts, 0, sizeof(s_runtime_last_saved_hosts));
+    s_runtime_pending_host_active = 0;
+    s_runtime_last_saved_host_active = 0;
     return;
   }
 
@@ -424,6 +484,24 @@ static void ApplyRuntimeLayerIfValid(void) {
   s_runtime_last_saved_layer = best.current_layer;
   s_runtime_pending_mode = best.last_mode;
   s_runtime_last_saved_mode = best.last_mode;
+  for (uint8_t i = 0; i < KBD_BLE_HOST_COUNT; i++) {
+    kbd_ble_host_t *host = &best.ble_host[i];
+    if (host->valid != 1) {
+      memset(host, 0, sizeof(*host));
+    } else if (host->interval == 0xFFFF) {
+      /* 只记录了地址的旧页：连接参数未知 */
+      host->interval = 0;
+      host->latency = 0;
+      host->timeout = 0;
+    }
+  }
+  if (best.ble_host_active >= KBD_BLE_HOST_COUNT) {
+    best.ble_host_active = 0;
+  }
+  memcpy(s_runtime_pending_hosts, best.ble_host, sizeof(s_runtime_pending_hosts));
+  memcpy(s_runtime_last_saved_hosts, best.ble_host, sizeof(s_runtime_last_saved_hosts));
+  s_runtime_pending_host_active = best.ble_host_active;
+  s_runtime_last_saved_host_active = best.ble_host_active;
   s_runtime_dirty = 0;
 
   if (best.current_layer < s_keymap_config.num_layers) {
@@ -431,18 +509,58 @@ static void ApplyRuntimeLayerIfValid(void) {
   }
 }
 
+static void KBD_Storage_RequestRuntimeSave(void);
+
+/**
+ * @brief runtime 页写入完成：按写入的内容更新"已保存"状态，
+ *        写入期间又有变化时重新排一次保存
+ */
+static void RuntimeSaveDone(int result, void *ctx) {
+  uint8_t target_page = s_runtime_inflight_page;
+  (void)ctx;
+
+  s_runtime_inflight_page = KBD_RUNTIME_INVALID_PAGE;
+  if (result != 0) {
+    LOG_W(TAG, "Runtime save failed (page %d), retry", target_page);
+    if (s_storage_task_id != TASK_NO_TASK) {
+      (void)tmos_start_task(s_storage_task_id, KBD_STORAGE_RUNTIME_SAVE_EVT,
+                            MS1_TO_SYSTEM_TIME(KBD_STORAGE_RUNTIME_SAVE_RETRY_MS));
+    }
+    return;
+  }
+
+  s_runtime_active_page = target_page;
+  s_runtime_seq = s_runtime_page.seq;
+  s_runtime_last_saved_layer = s_runtime_page.current_layer;
+  s_runtime_last_saved_mode = s_runtime_page.last_mode;
+  memcpy(s_runtime_last_saved_hosts, s_runtime_page.ble_host, sizeof(s_runtime_last_saved_hosts));
+  s_runtime_last_saved_host_active = s_runtime_page.ble_host_active;
+  KBD_Storage_RequestRuntimeSave();
+}
+
+/**
+ * @brief 把 runtime 热数据页提交到 Flash 队列（完成见 RuntimeSaveDone）
+ *
+ * 上一页仍在队列中时直接返回，它完成后会重新检查变化。
+ */
 static int SaveRuntimeState(void) {
-  __attribute__((aligned(4))) kbd_runtime_page_t page;
+  kbd_flash_job_t job;
   uint8_t target_page;
 
-  memset(&page, 0xFF, sizeof(page));
-  page.magic = KBD_RUNTIME_MAGIC;
-  page.version = KBD_RUNTIME_VERSION;
-  page.flags = 0;
-  page.seq = s_runtime_seq + 1;
-  page.current_layer = s_runtime_pending_layer;
-  page.last_mode = s_runtime_pending_mode;
-  page.crc32 = CalcRuntimeCRC(&page);
+  if (s_runtime_inflight_page != KBD_RUNTIME_INVALID_PAGE) {
+    return 0;
+  }
+
+  memset(&s_runtime_page, 0xFF, sizeof(s_runtime_page));
+  s_runtime_page.magic = KBD_RUNTIME_MAGIC;
+  s_runtime_page.version = KBD_RUNTIME_VERSION;
+  s_runtime_page.flags = 0;
+  s_runtime_page.seq = s_runtime_seq + 1;
+  s_runtime_page.current_layer = s_runtime_pending_layer;
+  s_runtime_page.last_mode = s_runtime_pending_mode;
+  memcpy(s_runtime_page.ble_host, s_runtime_pending_hosts, sizeof(s_runtime_page.ble_host));
+  s_runtime_page.ble_host_active = s_runtime_pending_host_active;
+  s_runtime_page.crc32 = CalcRuntimeCRC(&s_runtime_page);
 
   if (s_runtime_active_page == KBD_RUNTIME_INVALID_PAGE) {
     target_page = 0;
@@ -450,21 +568,20 @@ static int SaveRuntimeState(void) {
     target_page = (uint8_t)((s_runtime_active_page + 1) % KBD_RUNTIME_PAGE_COUNT);
   }
 
-  if (EEPROM_ERASE(KBD_RUNTIME_PAGE_ADDR(target_page), KBD_CFG_PAGE_SIZE) != 0) {
-    LOG_E(TAG, "Erase runtime page failed: %d", target_page);
+  memset(&job, 0, sizeof(job));
+  job.op = KBD_FLASH_OP_PAGE;
+  job.addr = KBD_RUNTIME_PAGE_ADDR(target_page);
+  job.data = &s_runtime_page;
+  job.len = KBD_CFG_PAGE_SIZE;
+  job.cb = RuntimeSaveDone;
+
+  /* 先标记再提交：TMOS 未就绪时 Submit 会同步执行并回调 */
+  s_runtime_inflight_page = target_page;
+  if (KBD_Flash_Submit(&job) != 0) {
+    s_runtime_inflight_page = KBD_RUNTIME_INVALID_PAGE;
+    LOG_E(TAG, "Queue runtime page failed: %d", target_page);
     return -1;
   }
-  if (EEPROM_WRITE(KBD_RUNTIME_PAGE_ADDR(target_page), &page, KBD_CFG_PAGE_SIZE) !=
-      0) {
-    LOG_E(TAG, "Write runtime page failed: %d", target_page);
-    return -2;
-  }
-
-  s_runtime_active_page = target_page;
-  s_runtime_seq = page.seq;
-  s_runtime_last_saved_layer = s_runtime_pending_layer;
-  s_runtime_last_saved_mode = s_runtime_pending_mode;
-  s_runtime_dirty = 0;
   return 0;
 }
 
@@ -472,8 +589,11 @@ static void KBD_Storage_RequestRuntimeSave(void) {
   bool layer_changed = (s_runtime_pending_layer != s_runtime_last_saved_layer);
   bool mode_changed  = (s_runtime_pending_mode != 0xFF) &&
                        (s_runtime_pending_mode != s_runtime_last_saved_mode);
+  bool host_changed  = (s_runtime_pending_host_active != s_runtime_last_saved_host_active) ||
+                       (memcmp(s_runtime_pending_hosts, s_runtime_last_saved_hosts,
+                               sizeof(s_runtime_pending_hosts)) != 0);
 
-  if (!layer_changed && !mode_changed) {
+  if (!layer_changed && !mode_changed && !host_changed) {
     s_runtime_dirty = 0;
     if (s_storage_task_id != TASK_NO_TASK) {
       (void)tmos_stop_task(s_storage_task_id, KBD_STORAGE_RUNTIME_SAVE_EVT);
@@ -489,12 +609,278 @@ static void KBD_Storage_RequestRuntimeSave(void) {
     return;
   }
 
-  /* 防抖合并：layer/mode 快速变化只保存最后一次 */
+  /* 防抖合并：layer/mode/host 快速变化只保存最后一次 */
   (void)tmos_stop_task(s_storage_task_id, KBD_STORAGE_RUNTIME_SAVE_EVT);
   (void)tmos_start_task(s_storage_task_id, KBD_STORAGE_RUNTIME_SAVE_EVT,
                         MS1_TO_SYSTEM_TIME(KBD_STORAGE_RUNTIME_SAVE_DELAY_MS));
 }
 
+static void BuildConfigImage(uint8_t *image, const kbd_config_header_t *header,
+                             const kbd_system_config_t *system,
+                             const kbd_keymap_t *keymap,
+                             const kbd_fnkey_config_t *fnkey,
+                             const kbd_rgb_config_t *rgb) {
+  memset(image, 0xFF, KBD_CFG_SLOT_SIZE);
+  memcpy(image + KBD_FLASH_HEADER, header, sizeof(*header));
+  memcpy(image + KBD_FLASH_SYSTEM, system, sizeof(*system));
+  memcpy(image + KBD_FLASH_KEYMAP, keymap, sizeof(*keymap));
+  memcpy(image + KBD_FLASH_FNKEY, fnkey, sizeof(*fnkey));
+  memcpy(image + KBD_FLASH_RGB, rgb, sizeof(*rgb));
+}
+
+/**
+ * @brief 延迟宏操作结束：回到提交命令的通道 (USB 或 BLE 配置服务) 发送响应
+ */
+static void MacroOp_Finish(int ret) {
+  uint8_t sub = s_macro_pending.sub;
+  uint8_t resp = (ret == 0) ? KBD_RESP_OK : KBD_RESP_ERR_FLASH;
+  kbd_command_response_sender_t sender = KBD_Command_GetResponseSender();
+
+  s_macro_pending.type = MACRO_OP_IDLE; /* 先清标志，再发响应 */
+
+  KBD_Command_SetResponseSender(s_macro_pending.sender);
+  KBD_Command_SendResponse(KBD_CMD_MACRO_SET, sub, &resp, 1);
+  KBD_Command_SetResponseSender(sender);
+
+  if (ret != 0) {
+    LOG_W(TAG, "Deferred macro op failed: %d", ret);
+  }
+}
+
+static void MacroOp_Next(void);
+
+static void MacroOp_OnJob(int result, void *ctx) {
+  (void)ctx;
+  if (result != 0) {
+    MacroOp_Finish(result);
+    return;
+  }
+  MacroOp_Next();
+}
+
+/**
+ * @brief 把延迟宏操作的下一页提交到 Flash 队列，全部完成后发送响应
+ *
+ * 写入按页拆分（读改写一页算一步），擦除全部逐页擦除。
+ */
+static void MacroOp_Next(void) {
+  kbd_flash_job_t job;
+
+  memset(&job, 0, sizeof(job));
+  job.cb = MacroOp_OnJob;
+
+  switch (s_macro_pending.type) {
+  case MACRO_OP_WRITE: {
+    uint16_t offset = (uint16_t)(s_macro_pending.offset + s_macro_pending.progress);
+    uint16_t page_offset = offset & (KBD_FLASH_MACRO_PAGE - 1u);
+    uint16_t chunk = (uint16_t)(KBD_FLASH_MACRO_PAGE - page_offset);
+
+    if (s_macro_pending.progress >= s_macro_pending.len) {
+      MacroOp_Finish(0);
+      return;
+    }
+    if (chunk > s_macro_pending.len - s_macro_pending.progress) {
+      chunk = (uint16_t)(s_macro_pending.len - s_macro_pending.progress);
+    }
+    job.op = KBD_FLASH_OP_PAGE;
+    job.addr = KBD_FLASH_MACRO_BASE + (offset & ~(KBD_FLASH_MACRO_PAGE - 1u));
+    job.data = &s_macro_pending.data[s_macro_pending.progress];
+    job.offset = page_offset;
+    job.len = chunk;
+    s_macro_pending.progress = (uint16_t)(s_macro_pending.progress + chunk);
+    break;
+  }
+  case MACRO_OP_ERASE_PAGE:
+    if (s_macro_pending.progress > 0) {
+      MacroOp_Finish(0);
+      return;
+    }
+    if (s_macro_pending.erase_page >= KBD_MACRO_PAGE_COUNT) {
+      MacroOp_Finish(-1);
+      return;
+    }
+    job.op = KBD_FLASH_OP_ERASE;
+    job.addr = KBD_FLASH_MACRO_BASE +
+               ((uint32_t)s_macro_pending.erase_page * KBD_FLASH_MACRO_PAGE);
+    job.len = KBD_FLASH_MACRO_PAGE;
+    s_macro_pending.progress = 1;
+    break;
+  case MACRO_OP_ERASE_ALL:
+    if (s_macro_pending.progress >= KBD_MACRO_PAGE_COUNT) {
+      MacroOp_Finish(0);
+      return;
+    }
+    job.op = KBD_FLASH_OP_ERASE;
+    job.addr = KBD_FLASH_MACRO_BASE +
+               ((uint32_t)s_macro_pending.progress * KBD_FLASH_MACRO_PAGE);
+    job.len = KBD_FLASH_MACRO_PAGE;
+    s_macro_pending.progress++;
+    break;
+  default:
+    return;
+  }
+
+  if (KBD_Flash_Submit(&job) != 0) {
+    MacroOp_Finish(-4);
+  }
+}
+
+static void ConfigSave_Next(void);
+
+static void ConfigSave_OnJob(int result, void *ctx) {
+  (void)ctx;
+  if (result != 0 && s_cfg_save.result == 0) {
+    s_cfg_save.result = result;
+  }
+  ConfigSave_Next();
+}
+
+/**
+ * @brief 配置保存结束：提交新槽位、同步 runtime 热数据并通知等待方；
+ *        期间又有保存请求时开始下一轮
+ */
+static void ConfigSave_Finish(void) {
+  kbd_flash_cb_t done = s_cfg_save.done;
+  void *done_ctx = s_cfg_save.done_ctx;
+  int ret = s_cfg_save.result;
+
+  s_cfg_save.busy = 0;
+  s_cfg_save.done = NULL;
+
+  if (ret == 0 && s_cfg_save.commit) {
+    memcpy(&s_config_header, &s_cfg_save.header, sizeof(s_config_header));
+    s_config_active_slot = s_cfg_save.slot;
+    LOG_I(TAG, "Config saved: slot=%d count=%d", s_config_active_slot,
+          s_config_header.save_count);
+  } else if (ret != 0) {
+    LOG_E(TAG, "Config save failed: slot=%d ret=%d", s_cfg_save.slot, ret);
+  }
+
+  /* 同步 runtime 热数据（当前层） */
+  if (s_runtime_dirty) {
+    (void)SaveRuntimeState();
+  }
+
+  if (done != NULL) {
+    done(ret, done_ctx);
+  }
+
+  if (s_cfg_save.requested && s_storage_task_id != TASK_NO_TASK) {
+    tmos_set_event(s_storage_task_id, KBD_STORAGE_CONFIG_SAVE_EVT);
+  }
+}
+
+/**
+ * @brief 提交配置保存的下一步：宏区擦除（恢复出厂）→ payload 页 → header 页（page0）
+ *
+ * header 页最后写，确保掉电时老槽位仍可回退；任一步失败即放弃后续页。
+ */
+static void ConfigSave_Next(void) {
+  kbd_flash_job_t job;
+
+  if (s_cfg_save.result != 0) {
+    ConfigSave_Finish();
+    return;
+  }
+
+  memset(&job, 0, sizeof(job));
+  job.cb = ConfigSave_OnJob;
+
+  if (s_cfg_save.macro_page < KBD_MACRO_PAGE_COUNT) {
+    job.op = KBD_FLASH_OP_ERASE;
+    job.addr = KBD_FLASH_MACRO_BASE +
+               ((uint32_t)s_cfg_save.macro_page * KBD_FLASH_MACRO_PAGE);
+    job.len = KBD_FLASH_MACRO_PAGE;
+    s_cfg_save.macro_page++;
+  } else if (s_cfg_save.dirty != 0) {
+    uint8_t page = 0;
+    for (uint8_t i = 1; i < KBD_CFG_PAGE_COUNT; i++) {
+      if (s_cfg_save.dirty & (1u << i)) {
+        page = i;
+        break;
+      }
+    }
+    s_cfg_save.dirty &= (uint8_t)~(1u << page);
+    job.op = KBD_FLASH_OP_PAGE;
+    job.addr = KBD_CFG_SLOT_ADDR(s_cfg_save.slot) + (uint32_t)page * KBD_CFG_PAGE_SIZE;
+    job.data = &s_cfg_save.image[(uint32_t)page * KBD_CFG_PAGE_SIZE];
+    job.len = KBD_CFG_PAGE_SIZE;
+  } else {
+    ConfigSave_Finish();
+    return;
+  }
+
+  if (KBD_Flash_Submit(&job) != 0) {
+    s_cfg_save.result = -3;
+    ConfigSave_Finish();
+  }
+}
+
+/**
+ * @brief 开始一轮配置保存：生成槽位镜像，只提交与 Flash 内容不同的页
+ */
+static void ConfigSave_Start(void) {
+  __attribute__((aligned(4))) uint8_t old_page[KBD_CFG_PAGE_SIZE];
+  kbd_config_header_t *header = &s_cfg_save.header;
+  uint32_t irq_status;
+  uint8_t dirty_count = 0;
+
+  /* 等待方由 ISR 写入：取走与清零放在同一个关中断区间 */
+  SYS_DisableAllIrq(&irq_status);
+  s_cfg_save.requested = 0;
+  s_cfg_save.done = s_cfg_save.waiter;
+  s_cfg_save.done_ctx = s_cfg_save.waiter_ctx;
+  s_cfg_save.waiter = NULL;
+  s_cfg_save.macro_page = s_cfg_save.erase_macros ? 0 : KBD_MACRO_PAGE_COUNT;
+  s_cfg_save.erase_macros = 0;
+  SYS_RecoverIrq(irq_status);
+
+  LOG_I(TAG, "Saving config...");
+
+  s_cfg_save.busy = 1;
+  s_cfg_save.result = 0;
+  s_cfg_save.dirty = 0;
+
+  /* 更新头部 */
+  *header = s_config_header;
+  header->magic = KBD_CONFIG_MAGIC;
+  header->version = KBD_CONFIG_VERSION;
+  header->save_count = s_config_header.save_count + 1;
+  header->crc32 =
+      CalcConfigCRC(&s_system_config, &s_keymap_config, &s_fnkey_config, &s_rgb_config);
+
+  s_cfg_save.commit = !(s_config_active_slot != KBD_CFG_INVALID_SLOT &&
+                        s_config_header.version == KBD_CONFIG_VERSION &&
+                        s_config_header.crc32 == header->crc32);
+  if (!s_cfg_save.commit) {
+    LOG_I(TAG, "Config unchanged, skip slot write");
+    ConfigSave_Next();
+    return;
+  }
+
+  BuildConfigImage(s_cfg_save.image, header, &s_system_config, &s_keymap_config,
+                   &s_fnkey_config, &s_rgb_config);
+
+  if (s_config_active_slot == KBD_CFG_INVALID_SLOT) {
+    s_cfg_save.slot = 0;
+  } else {
+    s_cfg_save.slot = (uint8_t)((s_config_active_slot + 1) % KBD_CFG_SLOT_COUNT);
+  }
+
+  for (uint8_t page = 0; page < KBD_CFG_PAGE_COUNT; page++) {
+    const uint32_t off = (uint32_t)page * KBD_CFG_PAGE_SIZE;
+    EEPROM_READ(KBD_CFG_SLOT_ADDR(s_cfg_save.slot) + off, old_page, KBD_CFG_PAGE_SIZE);
+    if (memcmp(old_page, s_cfg_save.image + off, KBD_CFG_PAGE_SIZE) != 0) {
+      s_cfg_save.dirty |= (uint8_t)(1u << page);
+      dirty_count++;
+    }
+  }
+  LOG_D(TAG, "Config slot %d: %d/%d pages dirty", s_cfg_save.slot, dirty_count,
+        KBD_CFG_PAGE_COUNT);
+
+  ConfigSave_Next();
+}
+
 static uint16_t KBD_Storage_ProcessEvent(uint8_t task_id, uint16_t events) {
   (void)task_id;
 
@@ -514,48 +900,20 @@ static uint16_t KBD_Storage_ProcessEvent(uint8_t task_id, uint16_t events) {
 
   if (events & KBD_STORAGE_MACRO_WRITE_EVT) {
     if (s_macro_pending.type != MACRO_OP_IDLE) {
-      int ret = -1;
-      switch (s_macro_pending.type) {
-      case MACRO_OP_WRITE:
-        ret = MeowFs_WriteRawInternal(s_macro_pending.offset,
-                                      s_macro_pending.data,
-                                      s_macro_pending.len);
-        break;
-      case MACRO_OP_ERASE_PAGE:
-        ret = Kbd_Macro_ErasePage(s_macro_pending.erase_page);
-        break;
-      case MACRO_OP_ERASE_ALL:
-        ret = Kbd_Macro_EraseAll();
-        break;
-      }
-
-      uint8_t sub = s_macro_pending.sub;
-      s_macro_pending.type = MACRO_OP_IDLE; /* 先清标志，再发响应 */
-
-      uint8_t resp = (ret == 0) ? KBD_RESP_OK : KBD_RESP_ERR_FLASH;
-      KBD_Command_SendResponse(KBD_CMD_MACRO_SET, sub, &resp, 1);
-
-      if (ret != 0) {
-        LOG_W(TAG, "Deferred macro op failed: %d", ret);
-      }
+      MacroOp_Next();
     }
     return (events ^ KBD_STORAGE_MACRO_WRITE_EVT);
   }
 
-  return 0;
-}
+  if (events & KBD_STORAGE_CONFIG_SAVE_EVT) {
+    /* 进行中的保存结束时会重新投递 */
+    if (s_cfg_save.requested && !s_cfg_save.busy) {
+      ConfigSave_Start();
+    }
+    return (events ^ KBD_STORAGE_CONFIG_SAVE_EVT);
+  }
 
-static void BuildConfigImage(uint8_t *image, const kbd_config_header_t *header,
-                             const kbd_system_config_t *system,
-                             const kbd_keymap_t *keymap,
-                             const kbd_fnkey_config_t *fnkey,
-                             const kbd_rgb_config_t *rgb) {
-  memset(image, 0xFF, KBD_CFG_SLOT_SIZE);
-  memcpy(image + KBD_FLASH_HEADER, header, sizeof(*header));
-  memcpy(image + KBD_FLASH_SYSTEM, system, sizeof(*system));
-  memcpy(image + KBD_FLASH_KEYMAP, keymap, sizeof(*keymap));
-  memcpy(image + KBD_FLASH_FNKEY, fnkey, sizeof(*fnkey));
-  memcpy(image + KBD_FLASH_RGB, rgb, sizeof(*rgb));
+  return 0;
 }
 
 static void ReadConfigPayloadFromSlot(uint32_t base_addr,
@@ -600,55 +958,17 @@ static void ApplyLoadedConfig(const kbd_config_slot_cache_t *cfg) {
   if (s_system_config.os_mode > KBD_OS_MODE_MAC) {
     s_system_config.os_mode = KBD_OS_MODE_WIN;
   }
+  if (KBD_SetDebounce(s_system_config.debounce_mode,
+                      s_system_config.debounce_ms) != 0) {
+    s_system_config.debounce_mode = KEY_DEBOUNCE_EAGER;
+    s_system_config.debounce_ms = s_default_system.debounce_ms;
+  }
   memcpy(&s_keymap_config, &cfg->keymap, sizeof(s_keymap_config));
   memcpy(&s_fnkey_config, &cfg->fnkey, sizeof(s_fnkey_config));
   memcpy(&s_rgb_config, &cfg->rgb, sizeof(s_rgb_config));
   s_config_active_slot = cfg->slot;
 }
 
-static int SaveConfigImageToSlot(uint8_t slot, const uint8_t *image) {
-  const uint32_t base_addr = KBD_CFG_SLOT_ADDR(slot);
-  __attribute__((aligned(4))) uint8_t old_page[KBD_CFG_PAGE_SIZE];
-  bool page_dirty[KBD_CFG_PAGE_COUNT] = {false};
-  uint8_t dirty_count = 0;
-
-  for (uint8_t page = 0; page < KBD_CFG_PAGE_COUNT; page++) {
-    const uint32_t off = (uint32_t)page * KBD_CFG_PAGE_SIZE;
-    EEPROM_READ(base_addr + off, old_page, KBD_CFG_PAGE_SIZE);
-    if (memcmp(old_page, image + off, KBD_CFG_PAGE_SIZE) != 0) {
-      page_dirty[page] = true;
-      dirty_count++;
-    }
-  }
-
-  if (dirty_count == 0) {
-    return 0;
-  }
-
-  /* 先写 payload 页，最后写 header 页（page0），确保掉电时老槽位仍可回退 */
-  for (uint8_t pass = 0; pass < 2; pass++) {
-    uint8_t begin = (pass == 0) ? 1 : 0;
-    uint8_t end = (pass == 0) ? KBD_CFG_PAGE_COUNT : 1;
-    for (uint8_t page = begin; page < end; page++) {
-      if (!page_dirty[page]) continue;
-      const uint32_t off = (uint32_t)page * KBD_CFG_PAGE_SIZE;
-      if (EEPROM_ERASE(base_addr + off, KBD_CFG_PAGE_SIZE) != 0) {
-        LOG_E(TAG, "Erase cfg page failed: slot=%d page=%d", slot, page);
-        return -1;
-      }
-      if (EEPROM_WRITE(base_addr + off, (void *)(image + off), KBD_CFG_PAGE_SIZE) !=
-          0) {
-        LOG_E(TAG, "Write cfg page failed: slot=%d page=%d", slot, page);
-        return -2;
-      }
-    }
-  }
-
-  LOG_D(TAG, "Config slot %d updated (%d/%d pages)", slot, dirty_count,
-        KBD_CFG_PAGE_COUNT);
-  return 0;
-}
-
 /*============================================================================*/
 /*                              公共函数实现 */
 /*============================================================================*/
@@ -672,15 +992,25 @@ void KBD_Storage_DeferRuntimeSave(uint32_t delay_ms) {
 }
 
 int KBD_Storage_FlushRuntime(void) {
+  int ret;
+
   if (s_storage_task_id != TASK_NO_TASK) {
     (void)tmos_stop_task(s_storage_task_id, KBD_STORAGE_RUNTIME_SAVE_EVT);
   }
 
-  if (!s_runtime_dirty) {
-    return 0;
+  /* 排队中的配置保存、宏操作与 IAP 页一并完成 */
+  if (s_cfg_save.requested && !s_cfg_save.busy) {
+    ConfigSave_Start();
   }
+  ret = KBD_Flash_Drain();
 
-  return SaveRuntimeState();
+  if (s_runtime_dirty) {
+    if (SaveRuntimeState() != 0 || KBD_Flash_Drain() != 0) {
+      ret = -1;
+    }
+  }
+
+  return (ret == 0 && !s_runtime_dirty) ? 0 : -1;
 }
 
 void KBD_Storage_PollStatus(kbd_storage_status_t *status) {
@@ -698,6 +1028,7 @@ void KBD_Storage_PollStatus(kbd_storage_status_t *status) {
 
 int KBD_Storage_Init(void) {
   LOG_I(TAG, "Storage init");
+  KBD_Flash_Init();
   KBD_Storage_InitTMOSTask();
 
   int ret = KBD_Config_Load();
@@ -746,64 +1077,57 @@ int KBD_Config_Load(void) {
   return 0;
 }
 
-int KBD_Config_Save(void) {
-  __attribute__((aligned(4))) uint8_t image[KBD_CFG_SLOT_SIZE];
-  kbd_config_header_t new_header = s_config_header;
-  uint8_t target_slot;
-  int ret;
+int KBD_Config_SaveAsync(kbd_flash_cb_t done, void *ctx) {
+  uint32_t irq_status;
 
-  LOG_I(TAG, "Saving config...");
-
-  /* 更新头部 */
-  new_header.magic = KBD_CONFIG_MAGIC;
-  new_header.version = KBD_CONFIG_VERSION;
-  new_header.save_count = s_config_header.save_count + 1;
-  new_header.crc32 =
-      CalcConfigCRC(&s_system_config, &s_keymap_config, &s_fnkey_config, &s_rgb_config);
-
-  if (s_config_active_slot != KBD_CFG_INVALID_SLOT &&
-      s_config_header.version == KBD_CONFIG_VERSION &&
-      s_config_header.crc32 == new_header.crc32) {
-    LOG_I(TAG, "Config unchanged, skip slot write");
-    (void)KBD_Storage_FlushRuntime();
-    return 0;
-  }
-
-  BuildConfigImage(image, &new_header, &s_system_config, &s_keymap_config,
-                   &s_fnkey_config, &s_rgb_config);
-
-  if (s_config_active_slot == KBD_CFG_INVALID_SLOT) {
-    target_slot = 0;
-  } else {
-    target_slot = (uint8_t)((s_config_active_slot + 1) % KBD_CFG_SLOT_COUNT);
+  SYS_DisableAllIrq(&irq_status);
+  if (done != NULL) {
+    if (s_cfg_save.waiter != NULL) {
+      SYS_RecoverIrq(irq_status);
+      return -1;
+    }
+    s_cfg_save.waiter = done;
+    s_cfg_save.waiter_ctx = ctx;
   }
+  s_cfg_save.requested = 1;
+  SYS_RecoverIrq(irq_status);
 
-  ret = SaveConfigImageToSlot(target_slot, image);
-  if (ret != 0) {
-    return ret;
+  if (s_storage_task_id == TASK_NO_TASK) {
+    /* 兜底：TMOS 未就绪时同步保存 */
+    if (!s_cfg_save.busy) {
+      ConfigSave_Start();
+    }
+    (void)KBD_Flash_Drain();
+    return 0;
   }
 
-  memcpy(&s_config_header, &new_header, sizeof(s_config_header));
-  s_config_active_slot = target_slot;
-  /* 同步 runtime 热数据（当前层） */
-  (void)KBD_Storage_FlushRuntime();
-
-  LOG_I(TAG, "Config saved: slot=%d count=%d", s_config_active_slot,
-        s_config_header.save_count);
+  KBD_Idle_SetEvent(s_storage_task_id, KBD_STORAGE_CONFIG_SAVE_EVT);
   return 0;
 }
 
-int KBD_Config_Reset(void) {
+uint8_t KBD_Config_IsSavePending(void) {
+  return (s_cfg_save.done != NULL || s_cfg_save.waiter != NULL) ? 1 : 0;
+}
+
+int KBD_Config_Save(void) { return KBD_Config_SaveAsync(NULL, NULL); }
+
+int KBD_Config_ResetAsync(kbd_flash_cb_t done, void *ctx) {
   LOG_I(TAG, "Factory reset");
 
+  if (done != NULL && s_cfg_save.waiter != NULL) {
+    return -1;
+  }
+
   LoadDefaults();
 
-  /* 清除整个 MeowFS 宏区 */
-  Kbd_Macro_EraseAll();
+  /* 清除整个 MeowFS 宏区（在配置页之前逐页擦除） */
+  s_cfg_save.erase_macros = 1;
 
-  return KBD_Config_Save();
+  return KBD_Config_SaveAsync(done, ctx);
 }
 
+int KBD_Config_Reset(void) { return KBD_Config_ResetAsync(NULL, NULL); }
+
 /*============================================================================*/
 /*                              配置访问函数 */
 /*============================================================================*/
@@ -829,6 +1153,20 @@ int KBD_SetOsMode(uint8_t mode) {
   return 0;
 }
 
+void KBD_GetDebounce(uint8_t *mode, uint8_t *ms) {
+  *mode = s_system_config.debounce_mode;
+  *ms = s_system_config.debounce_ms;
+}
+
+int KBD_SetDebounce(uint8_t mode, uint8_t ms) {
+  if (mode >= KEY_DEBOUNCE_COUNT || ms == 0 || ms > KEY_DEBOUNCE_MAX_MS) {
+    return -1;
+  }
+  s_system_config.debounce_mode = mode;
+  s_system_config.debounce_ms = ms;
+  return 0;
+}
+
 /*============================================================================*/
 /*                              层操作函数 */
 /*============================================================================*/
@@ -844,6 +1182,55 @@ int KBD_SetLastMode(uint8_t mode) {
   return 0;
 }
 
+int KBD_GetBleHost(uint8_t idx, kbd_ble_host_t *out) {
+  if (idx >= KBD_BLE_HOST_COUNT || !s_runtime_pending_hosts[idx].valid) {
+    return -1;
+  }
+  if (out) {
+    memcpy(out, &s_runtime_pending_hosts[idx], sizeof(*out));
+  }
+  return 0;
+}
+
+int KBD_SetBleHost(uint8_t idx, const kbd_ble_host_t *host) {
+  kbd_ble_host_t slot;
+
+  if (idx >= KBD_BLE_HOST_COUNT) {
+    return -1;
+  }
+  memset(&slot, 0, sizeof(slot));
+  if (host && host->valid) {
+    memcpy(&slot, host, sizeof(slot));
+    slot.valid = 1;
+  }
+  if (memcmp(&slot, &s_runtime_pending_hosts[idx], sizeof(slot)) == 0) {
+    return 0;
+  }
+  memcpy(&s_runtime_pending_hosts[idx], &slot, sizeof(slot));
+  KBD_Storage_RequestRuntimeSave();
+  return 0;
+}
+
+uint8_t KBD_GetBleHostActive(void) { return s_runtime_pending_host_active; }
+
+int KBD_SetBleHostActive(uint8_t idx) {
+  if (idx >= KBD_BLE_HOST_COUNT) {
+    return -1;
+  }
+  if (idx == s_runtime_pending_host_active) {
+    return 0;
+  }
+  s_runtime_pending_host_active = idx;
+  KBD_Storage_RequestRuntimeSave();
+  return 0;
+}
+
+void KBD_ClearBleHosts(void) {
+  memset(s_runtime_pending_hosts, 0, sizeof(s_runtime_pending_hosts));
+  s_runtime_pending_host_active = 0;
+  KBD_Storage_RequestRuntimeSave();
+}
+
 uint8_t KBD_GetCurrentLayer(void) { return s_keymap_config.current_layer; }
 
 int KBD_SetCurrentLayer(uint8_t layer) {
@@ -875,8 +1262,19 @@ uint8_t KBD_PrevLayer(void) {
   return prev;
 }
 
+#if defined(KBD_HAS_MATRIX) && (KBD_CORE_MAX_KEYS > KBD_MAX_KEYS)
+/** 超出存储映射的矩阵键的固定映射 (按矩阵位置排列) */
+static const kbd_action_t s_matrix_default_keymap[KBD_MATRIX_ROWS * KBD_MATRIX_COLS] =
+    KBD_MATRIX_DEFAULT_KEYMAP;
+#endif
+
 const kbd_action_t *KBD_GetKeyAction(uint8_t key_index) {
   if (key_index >= KBD_MAX_KEYS) {
+#if defined(KBD_HAS_MATRIX) && (KBD_CORE_MAX_KEYS > KBD_MAX_KEYS)
+    if (key_index >= KBD_MATRIX_KEY_BASE && key_index < KBD_CORE_MAX_KEYS) {
+      return &s_matrix_default_keymap[key_index - KBD_MATRIX_KEY_BASE];
+    }
+#endif
     return NULL;
   }
   uint8_t layer = s_keymap_config.current_layer;
@@ -977,13 +1375,16 @@ static int MeowFs_WriteRawInternal(uint16_t offset, const uint8_t *buf,
     }
 
     if (EEPROM_READ(page_addr, page, sizeof(page)) != 0) {
+      KBD_Log_FlashEvent(KBD_LOG_FLASH_READ, (uint16_t)page_addr);
       return -1;
     }
     memcpy(page + page_offset, buf, chunk);
     if (EEPROM_ERASE(page_addr, KBD_FLASH_MACRO_PAGE) != 0) {
+      KBD_Log_FlashEvent(KBD_LOG_FLASH_ERASE, (uint16_t)page_addr);
       return -2;
     }
     if (EEPROM_WRITE(page_addr, page, sizeof(page)) != 0) {
+      KBD_Log_FlashEvent(KBD_LOG_FLASH_WRITE, (uint16_t)page_addr);
       return -3;
     }
 
@@ -1057,8 +1458,10 @@ int Kbd_Macro_WriteRawDeferred(uint16_t offset, const uint8_t *buf,
   }
 
   s_macro_pending.sub = sub;
+  s_macro_pending.sender = KBD_Command_GetResponseSender();
   s_macro_pending.offset = offset;
   s_macro_pending.len = len;
+  s_macro_pending.progress = 0;
   memcpy(s_macro_pending.data, buf, len);
   s_macro_pending.type = MACRO_OP_WRITE;
 
@@ -1080,7 +1483,9 @@ int Kbd_Macro_EraseDeferred(uint8_t page, uint8_t sub) {
   }
 
   s_macro_pending.sub = sub;
+  s_macro_pending.sender = KBD_Command_GetResponseSender();
   s_macro_pending.erase_page = page;
+  s_macro_pending.progress = 0;
   s_macro_pending.type = (page == 0xFF) ? MACRO_OP_ERASE_ALL
                                         : MACRO_OP_ERASE_PAGE;
 
@@ -1104,6 +1509,9 @@ int Kbd_Macro_ErasePage(uint8_t page_index) {
   if (EEPROM_ERASE(KBD_FLASH_MACRO_BASE +
                        ((uint32_t)page_index * KBD_FLASH_MACRO_PAGE),
                    KBD_FLASH_MACRO_PAGE) != 0) {
+    KBD_Log_FlashEvent(KBD_LOG_FLASH_ERASE,
+                       (uint16_t)(KBD_FLASH_MACRO_BASE +
+                                  ((uint32_t)page_index * KBD_FLASH_MACRO_PAGE)));
     return -2;
   }
   return 0;
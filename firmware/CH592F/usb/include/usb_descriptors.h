@@ -10,36 +10,37 @@
 #define __USB_DESCRIPTORS_H__
 
 #include "CH59x_common.h"
+#include "kbd_hid_report.h"
 
 /* USB 设备配置 */
 #define DevEP0SIZE              0x40
 #define USB_VID                 0x413D  // Vendor ID
 #define USB_PID                 0x2107  // Product ID
 
-/* 接口编号定义 */
-#define INTF_KEYBOARD           0
-#define INTF_MOUSE              1
-#define INTF_CONSUMER           2
-#define INTF_CONFIG             3
-#define INTF_COUNT              4
+/* 接口编号定义 (输入报告接口来自 kbd_hid_report.h 报告表，配置接口排在最后) */
+#define INTF_KEYBOARD           KBD_HID_INTF_KEYBOARD
+#define INTF_MOUSE              KBD_HID_INTF_MOUSE
+#define INTF_CONSUMER           KBD_HID_INTF_CONSUMER
+#define INTF_CONFIG             KBD_HID_REPORT_COUNT
+#define INTF_COUNT              (KBD_HID_REPORT_COUNT + 1)
 
 /* 端点地址定义 */
-#define EP_KEYBOARD_IN          0x81    // EP1 IN - 键盘
-#define EP_MOUSE_IN             0x82    // EP2 IN - 鼠标
-#define EP_CONSUMER_IN          0x83    // EP3 IN - 多媒体
+#define EP_KEYBOARD_IN          KBD_HID_EP_KEYBOARD     // EP1 IN - 键盘
+#define EP_MOUSE_IN             KBD_HID_EP_MOUSE        // EP2 IN - 鼠标
+#define EP_CONSUMER_IN          KBD_HID_EP_CONSUMER     // EP3 IN - 多媒体
 #define EP_CONFIG_IN            0x84    // EP4 IN - 配置
 #define EP_CONFIG_OUT           0x04    // EP4 OUT - 配置
 
 /* HID 报告长度定义 */
-#define HID_KEYBOARD_REPORT_SIZE    8
-#define HID_MOUSE_REPORT_SIZE       4
-#define HID_CONSUMER_REPORT_SIZE    2
+#define HID_KEYBOARD_REPORT_SIZE    KBD_HID_LEN_KEYBOARD
+#define HID_MOUSE_REPORT_SIZE       KBD_HID_LEN_MOUSE
+#define HID_CONSUMER_REPORT_SIZE    KBD_HID_LEN_CONSUMER
 #define HID_CONFIG_REPORT_SIZE      64
 
-/* HID 报告描述符长度 */
-#define HID_KEYBOARD_REPORT_DESC_SIZE   64
-#define HID_MOUSE_REPORT_DESC_SIZE      52
-#define HID_CONSUMER_REPORT_DESC_SIZE   23
+/* HID 报告描述符长度 (输入报告由 kbd_hid_report.h 的描述符宏在编译期计算) */
+#define HID_KEYBOARD_REPORT_DESC_SIZE   KBD_HID_DESC_SIZE(KEYBOARD, KBD_HID_ITEM_NONE)
+#define HID_MOUSE_REPORT_DESC_SIZE      KBD_HID_DESC_SIZE(MOUSE, KBD_HID_ITEM_NONE)
+#define HID_CONSUMER_REPORT_DESC_SIZE   KBD_HID_DESC_SIZE(CONSUMER, KBD_HID_ITEM_NONE)
 #define HID_CONFIG_REPORT_DESC_SIZE     34
 
 
@@ -51,11 +52,9 @@
 #define HID_ConsumerReportDescSize      HID_CONSUMER_REPORT_DESC_SIZE
 #define HID_ConfigReportDescSize        HID_CONFIG_REPORT_DESC_SIZE
 
-/* 配置描述符总长度 */
+/* 配置描述符总长度：配置 + 每个输入报告接口 (接口 + HID + IN 端点) + 配置接口 (IN + OUT) */
 #define USB_CONFIG_DESC_SIZE    (9 + \
-                                 9 + 9 + 7 + \
-                                 9 + 9 + 7 + \
-                                 9 + 9 + 7 + \
+                                 KBD_HID_REPORT_COUNT * (9 + 9 + 7) + \
                                  9 + 9 + 7 + 7)
 
 /* 外部声明 */
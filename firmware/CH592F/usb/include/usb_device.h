@@ -13,6 +13,7 @@
 #include "CH59x_usbdev.h"
 #include "usb_descriptors.h"
 #include "usb_hid.h"
+#include <stdbool.h>
 
 /* ==================== USB Device State ==================== */
 typedef enum {
@@ -61,7 +62,19 @@ void USB_Device_Deinit(void);
 void USB_Device_TransferProcess(void);
 
 /**
- * @brief USB 设备唤醒主机
+ * @brief 是否已完成枚举（总线挂起期间保持挂起前的结果）
+ */
+bool USB_Device_IsConfigured(void);
+
+/**
+ * @brief 是否有主机在总线上 (已收到总线复位，正在枚举或已完成枚举)
+ *
+ * BLE 模式同样初始化 USB，主机可以枚举并使用配置接口，此时不能进入 RTC Sleep。
+ */
+bool USB_Device_HasHost(void);
+
+/**
+ * @brief USB 设备唤醒主机（驱动约 2ms K 状态，主机须已使能远程唤醒）
  */
 void USB_Device_Wakeup(void);
 
@@ -116,6 +116,11 @@
 #define MOUSE_BTN_RIGHT     0x02
 #define MOUSE_BTN_MIDDLE    0x04
 
+/* HID 报告类型 (GET_REPORT / SET_REPORT wValue 高字节) */
+#define USB_HID_REPORT_TYPE_INPUT   0x01
+#define USB_HID_REPORT_TYPE_OUTPUT  0x02
+#define USB_HID_REPORT_TYPE_FEATURE 0x03
+
 /* ==================== Consumer Control Definitions ==================== */
 /* Consumer Control Keys (多媒体按键) */
 // #define CONSUMER_PLAY_PAUSE     0xCD
@@ -143,25 +148,10 @@
 
 /* ==================== Structures ==================== */
 
-/* Keyboard Report Structure */
-typedef struct __attribute__((packed)) {
-    uint8_t modifier;       // 修饰键
-    uint8_t reserved;       // 保留字节
-    uint8_t keycode[6];     // 最多6个按键
-} USB_KeyboardReport_t;
-
-/* Mouse Report Structure */
-typedef struct __attribute__((packed)) {
-    uint8_t buttons;        // 按键状态
-    int8_t  x;              // X轴移动
-    int8_t  y;              // Y轴移动
-    int8_t  wheel;          // 滚轮
-} USB_MouseReport_t;
-
-/* Consumer Report Structure */
-typedef struct __attribute__((packed)) {
-    uint16_t key;           // 多媒体键值
-} USB_ConsumerReport_t;
+/* 输入报告结构由 kbd_hid_report.h 报告表展开，与 BLE 共用 */
+typedef kbd_hid_keyboard_report_t USB_KeyboardReport_t;  // modifier / reserved / keycode[6]
+typedef kbd_hid_mouse_report_t    USB_MouseReport_t;     // buttons / x / y / wheel / pan
+typedef kbd_hid_consumer_report_t USB_ConsumerReport_t;  // key
 
 /* Config Report Structure */
 typedef struct __attribute__((packed)) {
@@ -169,6 +159,20 @@ typedef struct __attribute__((packed)) {
     uint8_t data[63];       // 数据
 } USB_ConfigReport_t;
 
+/* Suspend Buffer Statistics */
+typedef struct {
+    uint8_t  depth;         // 当前缓冲条数
+    uint8_t  high_water;    // 历史最大条数
+    uint32_t buffered;      // 累计进入缓冲
+    uint32_t flushed;       // 恢复后发出
+    uint32_t expired;       // 超过 KBD_USB_RESUME_EXPIRE_MS 丢弃
+    uint32_t dropped;       // 缓冲满丢弃（最旧）
+    uint32_t wakeups;       // 发出远程唤醒次数
+    uint32_t lat_count;     // 已测量的按键到首报告次数
+    uint32_t lat_last_ms;   // 最近一次按键到首报告
+    uint32_t lat_max_ms;    // 最大按键到首报告
+} USB_ResumeStats_t;
+
 /* ==================== Global Variables ==================== */
 extern USB_KeyboardReport_t g_KeyboardReport;
 extern USB_MouseReport_t    g_MouseReport;
@@ -176,6 +180,7 @@ extern USB_ConsumerReport_t g_ConsumerReport;
 extern USB_ConfigReport_t   g_ConfigReport;
 
 extern uint8_t g_KeyboardLEDs;  // 键盘LED状态
+extern uint8_t g_MouseFeature;  // 鼠标 Resolution Multiplier 特性报告 (KBD_HID_SCROLL_FEATURE_*)
 
 /* ==================== Function Prototypes ==================== */
 
@@ -189,7 +194,7 @@ void USB_Keyboard_SetLEDs(uint8_t leds);
 
 /* === Mouse Functions === */
 void USB_Mouse_Init(void);
-void USB_Mouse_Move(int8_t x, int8_t y, int8_t wheel);
+void USB_Mouse_Move(int8_t x, int8_t y, int8_t wheel, int8_t pan);
 void USB_Mouse_Click(uint8_t buttons);
 void USB_Mouse_Press(uint8_t buttons);
 void USB_Mouse_Release(void);
@@ -205,6 +210,11 @@ void USB_Consumer_SendReport(void);
 void USB_Config_Init(void);
 void USB_Config_SendResponse(uint8_t cmd, uint8_t *data, uint8_t len);
 void USB_Config_ProcessCommand(USB_ConfigReport_t *report);
+void USB_Config_SetRxEnabled(uint8_t enable);
+
+/* === Suspend / Resume === */
+void USB_HID_FlushPending(void);
+void USB_HID_GetResumeStats(USB_ResumeStats_t *out, uint8_t reset);
 
 /* === USB Device Callbacks === */
 void USB_DevEP1_IN_Callback(void);   // Keyboard
@@ -31,101 +31,49 @@ const uint8_t USB_DeviceDescriptor[] = {
     0x01                            // bNumConfigurations
 };
 
+/*
+ * 输入报告接口：接口描述符 + HID 描述符 + 中断 IN 端点描述符 (9 + 9 + 7 字节)，
+ * 接口号、端点、子类 / 协议与报告描述符长度均来自 kbd_hid_report.h 报告表
+ */
+#define USB_HID_INTERFACE_DESC(NAME, name, rid, intf, ep, sub, proto)         \
+    0x09,                           /* bLength */                              \
+    0x04,                           /* bDescriptorType (Interface) */          \
+    (intf),                         /* bInterfaceNumber */                     \
+    0x00,                           /* bAlternateSetting */                    \
+    0x01,                           /* bNumEndpoints */                        \
+    0x03,                           /* bInterfaceClass (HID) */                \
+    (sub),                          /* bInterfaceSubClass (0x01 = Boot) */     \
+    (proto),                        /* bInterfaceProtocol (1 键盘 / 2 鼠标) */ \
+    0x00,                           /* iInterface */                           \
+    0x09,                           /* bLength */                              \
+    0x21,                           /* bDescriptorType (HID) */                \
+    0x11, 0x01,                     /* bcdHID (1.11) */                        \
+    0x00,                           /* bCountryCode */                         \
+    0x01,                           /* bNumDescriptors */                      \
+    0x22,                           /* bDescriptorType (Report) */             \
+    (KBD_HID_DESC_SIZE(NAME, KBD_HID_ITEM_NONE) & 0xFF),                       \
+    (KBD_HID_DESC_SIZE(NAME, KBD_HID_ITEM_NONE) >> 8),                         \
+    0x07,                           /* bLength */                              \
+    0x05,                           /* bDescriptorType (Endpoint) */           \
+    (ep),                           /* bEndpointAddress */                     \
+    0x03,                           /* bmAttributes (Interrupt) */             \
+    KBD_HID_LEN_##NAME, 0x00,       /* wMaxPacketSize */                       \
+    0x0A,                           /* bInterval (10ms) */
+
 /* USB 配置描述符 */
 const uint8_t USB_ConfigDescriptor[] = {
     /* Configuration Descriptor */
     0x09,                           // bLength
     0x02,                           // bDescriptorType (Configuration)
     (USB_CONFIG_DESC_SIZE & 0xFF), (USB_CONFIG_DESC_SIZE >> 8),
-    INTF_COUNT,                     // bNumInterfaces (4个接口)
+    INTF_COUNT,                     // bNumInterfaces
     0x01,                           // bConfigurationValue
     0x00,                           // iConfiguration
     0xA0,                           // bmAttributes (Bus Powered, Remote Wakeup)
     0x32,                           // bMaxPower (100mA)
 
-    /* ================ Interface 0: Keyboard ================ */
-    0x09,                           // bLength
-    0x04,                           // bDescriptorType (Interface)
-    INTF_KEYBOARD,                  // bInterfaceNumber
-    0x00,                           // bAlternateSetting
-    0x01,                           // bNumEndpoints
-    0x03,                           // bInterfaceClass (HID)
-    0x01,                           // bInterfaceSubClass (Boot Interface)
-    0x01,                           // bInterfaceProtocol (Keyboard)
-    0x00,                           // iInterface
-
-    /* HID Descriptor */
-    0x09,                           // bLength
-    0x21,                           // bDescriptorType (HID)
-    0x11, 0x01,                     // bcdHID (1.11)
-    0x00,                           // bCountryCode
-    0x01,                           // bNumDescriptors
-    0x22,                           // bDescriptorType (Report)
-    (HID_KEYBOARD_REPORT_DESC_SIZE & 0xFF), (HID_KEYBOARD_REPORT_DESC_SIZE >> 8),
-
-    /* Endpoint Descriptor */
-    0x07,                           // bLength
-    0x05,                           // bDescriptorType (Endpoint)
-    EP_KEYBOARD_IN,                 // bEndpointAddress
-    0x03,                           // bmAttributes (Interrupt)
-    HID_KEYBOARD_REPORT_SIZE, 0x00, // wMaxPacketSize
-    0x0A,                           // bInterval (10ms)
-
-    /* ================ Interface 1: Mouse ================ */
-    0x09,                           // bLength
-    0x04,                           // bDescriptorType (Interface)
-    INTF_MOUSE,                     // bInterfaceNumber
-    0x00,                           // bAlternateSetting
-    0x01,                           // bNumEndpoints
-    0x03,                           // bInterfaceClass (HID)
-    0x01,                           // bInterfaceSubClass (Boot Interface)
-    0x02,                           // bInterfaceProtocol (Mouse)
-    0x00,                           // iInterface
-
-    /* HID Descriptor */
-    0x09,                           // bLength
-    0x21,                           // bDescriptorType (HID)
-    0x11, 0x01,                     // bcdHID (1.11)
-    0x00,                           // bCountryCode
-    0x01,                           // bNumDescriptors
-    0x22,                           // bDescriptorType (Report)
-    (HID_MOUSE_REPORT_DESC_SIZE & 0xFF), (HID_MOUSE_REPORT_DESC_SIZE >> 8),
-
-    /* Endpoint Descriptor */
-    0x07,                           // bLength
-    0x05,                           // bDescriptorType (Endpoint)
-    EP_MOUSE_IN,                    // bEndpointAddress
-    0x03,                           // bmAttributes (Interrupt)
-    HID_MOUSE_REPORT_SIZE, 0x00,    // wMaxPacketSize
-    0x0A,                           // bInterval (10ms)
-
-    /* ================ Interface 2: Consumer Control ================ */
-    0x09,                           // bLength
-    0x04,                           // bDescriptorType (Interface)
-    INTF_CONSUMER,                  // bInterfaceNumber
-    0x00,                           // bAlternateSetting
-    0x01,                           // bNumEndpoints
-    0x03,                           // bInterfaceClass (HID)
-    0x00,                           // bInterfaceSubClass
-    0x00,                           // bInterfaceProtocol
-    0x00,                           // iInterface
-
-    /* HID Descriptor */
-    0x09,                           // bLength
-    0x21,                           // bDescriptorType (HID)
-    0x11, 0x01,                     // bcdHID (1.11)
-    0x00,                           // bCountryCode
-    0x01,                           // bNumDescriptors
-    0x22,                           // bDescriptorType (Report)
-    (HID_CONSUMER_REPORT_DESC_SIZE & 0xFF), (HID_CONSUMER_REPORT_DESC_SIZE >> 8),
-
-    /* Endpoint Descriptor */
-    0x07,                           // bLength
-    0x05,                           // bDescriptorType (Endpoint)
-    EP_CONSUMER_IN,                 // bEndpointAddress
-    0x03,                           // bmAttributes (Interrupt)
-    HID_CONSUMER_REPORT_SIZE, 0x00, // wMaxPacketSize
-    0x0A,                           // bInterval (10ms)
+    /* ================ 输入报告接口 (键盘 / 鼠标 / 多媒体，按报告表展开) ================ */
+    KBD_HID_REPORTS(USB_HID_INTERFACE_DESC)
 
     /* ================ Interface 3: Config (Vendor) ================ */
     0x09,                           // bLength
@@ -208,106 +156,21 @@ void USB_Descriptors_Init(void)
 
 /* ==================== HID Report Descriptors ==================== */
 
+/* 输入报告描述符：与 BLE 报告映射共用 kbd_hid_report.h 中的定义，USB 各接口不带 Report ID */
+
 /* Keyboard Report Descriptor (Boot Protocol) */
 const uint8_t HID_KeyboardReportDescriptor[] = {
-    0x05, 0x01,        // Usage Page (Generic Desktop)
-    0x09, 0x06,        // Usage (Keyboard)
-    0xA1, 0x01,        // Collection (Application)
-    
-    // Modifier keys
-    0x05, 0x07,        //   Usage Page (Key Codes)
-    0x19, 0xE0,        //   Usage Minimum (224)
-    0x29, 0xE7,        //   Usage Maximum (231)
-    0x15, 0x00,        //   Logical Minimum (0)
-    0x25, 0x01,        //   Logical Maximum (1)
-    0x75, 0x01,        //   Report Size (1)
-    0x95, 0x08,        //   Report Count (8)
-    0x81, 0x02,        //   Input (Data, Variable, Absolute)
-    
-    // Reserved byte
-    0x95, 0x01,        //   Report Count (1)
-    0x75, 0x08,        //   Report Size (8)
-    0x81, 0x01,        //   Input (Constant)
-    
-    // LED output report
-    0x95, 0x05,        //   Report Count (5)
-    0x75, 0x01,        //   Report Size (1)
-    0x05, 0x08,        //   Usage Page (LEDs)
-    0x19, 0x01,        //   Usage Minimum (1)
-    0x29, 0x05,        //   Usage Maximum (5)
-    0x91, 0x02,        //   Output (Data, Variable, Absolute)
-    
-    // LED padding
-    0x95, 0x01,        //   Report Count (1)
-    0x75, 0x03,        //   Report Size (3)
-    0x91, 0x01,        //   Output (Constant)
-    
-    // Key arrays (6 keys)
-    0x95, 0x06,        //   Report Count (6)
-    0x75, 0x08,        //   Report Size (8)
-    0x15, 0x00,        //   Logical Minimum (0)
-    0x26, 0xFF, 0x00,  //   Logical Maximum (255)
-    0x05, 0x07,        //   Usage Page (Key Codes)
-    0x19, 0x00,        //   Usage Minimum (0)
-    0x29, 0xFF,        //   Usage Maximum (255)
-    0x81, 0x00,        //   Input (Data, Array)
-    
-    0xC0               // End Collection
+    KBD_HID_DESC_KEYBOARD(KBD_HID_ITEM_NONE)
 };
 
-/* Mouse Report Descriptor (Boot Protocol) */
+/* Mouse Report Descriptor (前 3 字节兼容 Boot Protocol) */
 const uint8_t HID_MouseReportDescriptor[] = {
-    0x05, 0x01,        // Usage Page (Generic Desktop)
-    0x09, 0x02,        // Usage (Mouse)
-    0xA1, 0x01,        // Collection (Application)
-    0x09, 0x01,        //   Usage (Pointer)
-    0xA1, 0x00,        //   Collection (Physical)
-    
-    // Buttons
-    0x05, 0x09,        //     Usage Page (Buttons)
-    0x19, 0x01,        //     Usage Minimum (1)
-    0x29, 0x03,        //     Usage Maximum (3)
-    0x15, 0x00,        //     Logical Minimum (0)
-    0x25, 0x01,        //     Logical Maximum (1)
-    0x75, 0x01,        //     Report Size (1)
-    0x95, 0x03,        //     Report Count (3)
-    0x81, 0x02,        //     Input (Data, Variable, Absolute)
-    
-    // Padding
-    0x75, 0x05,        //     Report Size (5)
-    0x95, 0x01,        //     Report Count (1)
-    0x81, 0x01,        //     Input (Constant)
-    
-    // X, Y, Wheel
-    0x05, 0x01,        //     Usage Page (Generic Desktop)
-    0x09, 0x30,        //     Usage (X)
-    0x09, 0x31,        //     Usage (Y)
-    0x09, 0x38,        //     Usage (Wheel)
-    0x15, 0x81,        //     Logical Minimum (-127)
-    0x25, 0x7F,        //     Logical Maximum (127)
-    0x75, 0x08,        //     Report Size (8)
-    0x95, 0x03,        //     Report Count (3)
-    0x81, 0x06,        //     Input (Data, Variable, Relative)
-    
-    0xC0,              //   End Collection
-    0xC0               // End Collection
+    KBD_HID_DESC_MOUSE(KBD_HID_ITEM_NONE)
 };
 
 /* Consumer Control Report Descriptor */
 const uint8_t HID_ConsumerReportDescriptor[] = {
-    0x05, 0x0C,        // Usage Page (Consumer)
-    0x09, 0x01,        // Usage (Consumer Control)
-    0xA1, 0x01,        // Collection (Application)
-    
-    0x15, 0x00,        //   Logical Minimum (0)
-    0x26, 0xFF, 0x03,  //   Logical Maximum (1023)
-    0x19, 0x00,        //   Usage Minimum (0)
-    0x2A, 0xFF, 0x03,  //   Usage Maximum (1023)
-    0x75, 0x10,        //   Report Size (16)
-    0x95, 0x01,        //   Report Count (1)
-    0x81, 0x00,        //   Input (Data, Array)
-    
-    0xC0               // End Collection
+    KBD_HID_DESC_CONSUMER(KBD_HID_ITEM_NONE)
 };
 
 /* Config Report Descriptor (Vendor Defined) - 无 Report ID，通过独立接口区分 */
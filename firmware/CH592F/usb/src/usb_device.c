@@ -23,6 +23,8 @@ uint8_t g_SetupReqCode = 0;
 uint16_t g_SetupReqLen = 0;
 const uint8_t *g_pDescriptor = NULL;
 static uint8_t g_SetupReqInterface = 0; // 保存当前请求的接口号
+static uint8_t g_SetupReqReportType = 0; // SET_REPORT 的报告类型 (wValue 高字节)
+static USB_DeviceState_t g_ResumeState = USB_STATE_DETACHED; // 挂起前的状态，恢复时还原
 
 uint8_t g_IdleValue[4] = {0};
 uint8_t g_ProtocolValue[4] = {0};
@@ -87,13 +89,23 @@ static void USB_HandleSetupPacket(void)
                 break;
 
             case DEF_USB_SET_REPORT: /* 0x09 */
-                // 保存接口号，在 OUT 阶段处理数据
+                // 保存接口号与报告类型，在 OUT 阶段处理数据
                 g_SetupReqInterface = pSetupReqPak->wIndex & 0xFF;
+                g_SetupReqReportType = pSetupReqPak->wValue >> 8;
                 break;
 
             case DEF_USB_GET_REPORT: /* 0x01 */
-                // 可根据接口返回当前报告
-                errflag = 0xFF;
+                // 仅支持读取鼠标 Resolution Multiplier 特性报告
+                if (interface == INTF_MOUSE && (pSetupReqPak->wValue >> 8) == USB_HID_REPORT_TYPE_FEATURE)
+                {
+                    pEP0_DataBuf[0] = g_MouseFeature;
+                    if (g_SetupReqLen > 1)
+                        g_SetupReqLen = 1;
+                }
+                else
+                {
+                    errflag = 0xFF;
+                }
                 break;
 
             default:
@@ -283,7 +295,9 @@ static void USB_HandleSetupPacket(void)
             break;
 
         case USB_GET_STATUS:
-            pEP0_DataBuf[0] = 0x00;
+            // 设备状态 bit1 = 远程唤醒已由主机使能
+            pEP0_DataBuf[0] = ((chtype & USB_REQ_RECIP_MASK) == USB_REQ_RECIP_DEVICE &&
+                               (g_USB_SleepStatus & 0x01)) ? 0x02 : 0x00;
             pEP0_DataBuf[1] = 0x00;
             if (g_SetupReqLen >= 2)
                 g_SetupReqLen = 2;
@@ -406,6 +420,13 @@ void USB_Device_TransferProcess(void)
                         USB_ConfigReport_t *report = (USB_ConfigReport_t *)pEP0_DataBuf;
                         USB_Config_ProcessCommand(report);
                     }
+                    else if (g_SetupReqInterface == INTF_MOUSE && len > 0 &&
+                             g_SetupReqReportType == USB_HID_REPORT_TYPE_FEATURE)
+                    {
+                        // 主机启用 / 关闭高分辨率滚动
+                        g_MouseFeature = pEP0_DataBuf[0] &
+                                         (KBD_HID_SCROLL_FEATURE_WHEEL | KBD_HID_SCROLL_FEATURE_PAN);
+                    }
                 }
                 R8_UEP0_CTRL = UEP_R_RES_ACK | UEP_T_RES_NAK;
                 break;
@@ -462,6 +483,7 @@ void USB_Device_TransferProcess(void)
     else if (intflag & RB_UIF_BUS_RST)
     {
         R8_USB_DEV_AD = 0;
+        g_MouseFeature = 0;
         R8_UEP0_CTRL = UEP_R_RES_ACK | UEP_T_RES_NAK;
         R8_UEP1_CTRL = UEP_R_RES_ACK | UEP_T_RES_NAK;
         R8_UEP2_CTRL = UEP_R_RES_ACK | UEP_T_RES_NAK;
@@ -476,8 +498,21 @@ void USB_Device_TransferProcess(void)
     }
     else if (intflag & RB_UIF_SUSPEND)
     {
+        // 挂起和恢复共用一个中断，由 MIS_ST 区分
         R8_USB_INT_FG = RB_UIF_SUSPEND;
-        g_USB_DeviceState = USB_STATE_SUSPENDED;
+        if (R8_USB_MIS_ST & RB_UMS_SUSPEND)
+        {
+            if (g_USB_DeviceState != USB_STATE_SUSPENDED)
+            {
+                g_ResumeState = g_USB_DeviceState;
+                g_USB_DeviceState = USB_STATE_SUSPENDED;
+            }
+        }
+        else if (g_USB_DeviceState == USB_STATE_SUSPENDED)
+        {
+            g_USB_DeviceState = g_ResumeState;
+            KBD_Mode_USB_NotifyResume();
+        }
     }
     else
     {
@@ -485,6 +520,25 @@ void USB_Device_TransferProcess(void)
     }
 }
 
+/**
+ * @brief 是否已完成枚举（挂起期间保持挂起前的结果）
+ */
+bool USB_Device_IsConfigured(void)
+{
+    return (g_USB_DeviceState == USB_STATE_CONFIGURED) ||
+           (g_USB_DeviceState == USB_STATE_SUSPENDED && g_ResumeState == USB_STATE_CONFIGURED);
+}
+
+/**
+ * @brief 是否有主机在总线上（总线复位后即视为有主机）
+ */
+bool USB_Device_HasHost(void)
+{
+    return (g_USB_DeviceState == USB_STATE_DEFAULT) ||
+           (g_USB_DeviceState == USB_STATE_ADDRESS) ||
+           USB_Device_IsConfigured();
+}
+
 /**
  * @brief USB 设备唤醒主机
  */
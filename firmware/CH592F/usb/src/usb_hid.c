@@ -7,10 +7,13 @@
  *******************************************************************************/
 
 #include "usb_hid.h"
+#include "usb_device.h"
 #include "CH59x_usbdev.h"
+#include "kbd_mode_config.h"
 #include "kbd_command.h"
 #include "kbd_types.h"
 #include "debug.h"
+#include "ble_hal.h"
 #include <stdbool.h>
 #include <string.h>
 
@@ -20,6 +23,9 @@
  * 轮询周期，避免 KBD_Log_Flush 占用 EP4 IN 时 MACRO_SET 响应被丢弃。 */
 #define USB_EP_READY_TIMEOUT 200000U
 
+/* 挂起缓冲单条报告最大长度（报告表中最长的输入报告） */
+#define USB_PENDING_MAX_LEN KBD_HID_REPORT_MAX_LEN
+
 /* ==================== Global Variables ==================== */
 USB_KeyboardReport_t g_KeyboardReport = {0};
 USB_MouseReport_t    g_MouseReport = {0};
@@ -27,6 +33,23 @@ USB_ConsumerReport_t g_ConsumerReport = {0};
 USB_ConfigReport_t   g_ConfigReport = {0};
 
 uint8_t g_KeyboardLEDs = 0;
+uint8_t g_MouseFeature = 0;
+
+/* 主机挂起期间的报告缓冲（FIFO），只在 TMOS 任务上下文访问 */
+typedef struct {
+    uint8_t  ep;
+    uint8_t  len;
+    uint8_t  data[USB_PENDING_MAX_LEN];
+    uint32_t rtc;           // 进入缓冲的 RTC 时刻
+} USB_PendingReport_t;
+
+static USB_PendingReport_t s_pending[KBD_USB_RESUME_DEPTH];
+static uint8_t s_pending_head = 0;
+static uint8_t s_pending_count = 0;
+static bool s_wakeup_sent = false;   // 本次挂起已发出远程唤醒
+static bool s_press_pending = false; // 挂起期间第一个报告尚未发出
+static uint32_t s_press_rtc = 0;     // 挂起期间第一个报告的时刻
+static USB_ResumeStats_t s_resume_stats;
 
 static bool USB_WaitEPInReady(uint8_t ep)
 {
@@ -55,6 +78,172 @@ static bool USB_WaitEPInReady(uint8_t ep)
     return false;
 }
 
+/* ==================== Suspend / Resume ==================== */
+
+static uint32_t USB_HID_ElapsedMs(uint32_t from)
+{
+    uint32_t ticks = HAL_SleepDistance(RTC_GetCycle32k(), from);
+
+    return (uint32_t)(((uint64_t)ticks * 1000u) / CAB_LSIFQ);
+}
+
+/**
+ * @brief 等待端点空闲后写入一个报告
+ */
+static bool USB_HID_Transmit(uint8_t ep, const void *data, uint8_t len)
+{
+    // 等待上一次传输完成（带超时，避免异常状态卡死）
+    if (!USB_WaitEPInReady(ep)) {
+        return false;
+    }
+
+    switch (ep) {
+    case 1:
+        memcpy(pEP1_IN_DataBuf, data, len);
+        DevEP1_IN_Deal(len);
+        break;
+    case 2:
+        memcpy(pEP2_IN_DataBuf, data, len);
+        DevEP2_IN_Deal(len);
+        break;
+    case 3:
+        memcpy(pEP3_IN_DataBuf, data, len);
+        DevEP3_IN_Deal(len);
+        break;
+    default:
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 丢弃超过有效期的缓冲报告（缓冲按时间排序，只需检查队头）
+ */
+static void USB_HID_ExpirePending(void)
+{
+    while (s_pending_count > 0 &&
+           USB_HID_ElapsedMs(s_pending[s_pending_head].rtc) > KBD_USB_RESUME_EXPIRE_MS) {
+        s_pending_head = (s_pending_head + 1) % KBD_USB_RESUME_DEPTH;
+        s_pending_count--;
+        s_resume_stats.expired++;
+    }
+
+    if (s_pending_count == 0) {
+        // 主机一直没有恢复：下一次按键重新计时、重新发出远程唤醒
+        s_press_pending = false;
+        s_wakeup_sent = false;
+    }
+}
+
+/**
+ * @brief 报告进入挂起缓冲，必要时发出远程唤醒
+ */
+static void USB_HID_Defer(uint8_t ep, const void *data, uint8_t len)
+{
+    USB_HID_ExpirePending();
+
+    if (s_pending_count == KBD_USB_RESUME_DEPTH) {
+        s_pending_head = (s_pending_head + 1) % KBD_USB_RESUME_DEPTH;
+        s_pending_count--;
+        s_resume_stats.dropped++;
+    }
+
+    USB_PendingReport_t *p = &s_pending[(s_pending_head + s_pending_count) % KBD_USB_RESUME_DEPTH];
+    p->ep = ep;
+    p->len = (len > USB_PENDING_MAX_LEN) ? USB_PENDING_MAX_LEN : len;
+    memcpy(p->data, data, p->len);
+    p->rtc = RTC_GetCycle32k();
+    s_pending_count++;
+
+    s_resume_stats.buffered++;
+    if (s_pending_count > s_resume_stats.high_water) {
+        s_resume_stats.high_water = s_pending_count;
+    }
+
+    if (!s_press_pending) {
+        s_press_pending = true;
+        s_press_rtc = p->rtc;
+    }
+
+    // 主机通过 SET_FEATURE(DEVICE_REMOTE_WAKEUP) 使能后才允许唤醒
+    if (g_USB_DeviceState == USB_STATE_SUSPENDED && !s_wakeup_sent &&
+        (g_USB_SleepStatus & 0x01)) {
+        s_wakeup_sent = true;
+        s_resume_stats.wakeups++;
+        USB_Device_Wakeup();
+        LOG_D(TAG, "Remote wakeup");
+    }
+}
+
+/**
+ * @brief 发送报告：主机挂起或缓冲未清空时排队，保持顺序
+ */
+static void USB_HID_Submit(uint8_t ep, const void *data, uint8_t len)
+{
+    if (g_USB_DeviceState != USB_STATE_SUSPENDED && s_pending_count == 0) {
+        USB_HID_Transmit(ep, data, len);
+        return;
+    }
+
+    USB_HID_Defer(ep, data, len);
+    USB_HID_FlushPending();
+}
+
+/**
+ * @brief 总线恢复后按顺序发出缓冲报告（TMOS 任务上下文调用）
+ */
+void USB_HID_FlushPending(void)
+{
+    if (g_USB_DeviceState != USB_STATE_CONFIGURED) {
+        return;
+    }
+
+    s_wakeup_sent = false;
+    USB_HID_ExpirePending();
+
+    while (s_pending_count > 0) {
+        USB_PendingReport_t *p = &s_pending[s_pending_head];
+
+        // 端点忙超时：保留剩余报告，等下一次触发
+        if (!USB_HID_Transmit(p->ep, p->data, p->len)) {
+            return;
+        }
+
+        s_pending_head = (s_pending_head + 1) % KBD_USB_RESUME_DEPTH;
+        s_pending_count--;
+        s_resume_stats.flushed++;
+
+        if (s_press_pending) {
+            uint32_t ms = USB_HID_ElapsedMs(s_press_rtc);
+            s_press_pending = false;
+            s_resume_stats.lat_count++;
+            s_resume_stats.lat_last_ms = ms;
+            if (ms > s_resume_stats.lat_max_ms) {
+                s_resume_stats.lat_max_ms = ms;
+            }
+            LOG_D(TAG, "Resume, first report after %lu ms", (unsigned long)ms);
+        }
+    }
+}
+
+/**
+ * @brief 读取挂起缓冲统计，可选读取后清零（当前缓冲条数不变，TMOS 任务上下文调用）
+ */
+void USB_HID_GetResumeStats(USB_ResumeStats_t *out, uint8_t reset)
+{
+    if (out == NULL) {
+        return;
+    }
+
+    // 只读：过期条目留给下一次缓冲 / 恢复发送时丢弃，不在这里改动队列
+    *out = s_resume_stats;
+    out->depth = s_pending_count;
+    if (reset) {
+        memset(&s_resume_stats, 0, sizeof(s_resume_stats));
+        s_resume_stats.high_water = s_pending_count;
+    }
+}
+
 /* ==================== Keyboard Functions ==================== */
 
 /**
@@ -71,16 +260,7 @@ void USB_Keyboard_Init(void)
  */
 void USB_Keyboard_Press(uint8_t modifier, uint8_t *keys, uint8_t num_keys)
 {
-    g_KeyboardReport.modifier = modifier;
-    
-    uint8_t count = (num_keys > 6) ? 6 : num_keys;
-    for(uint8_t i = 0; i < count; i++) {
-        g_KeyboardReport.keycode[i] = keys[i];
-    }
-    for(uint8_t i = count; i < 6; i++) {
-        g_KeyboardReport.keycode[i] = 0;
-    }
-    
+    KBD_HID_PackKeyboard(&g_KeyboardReport, modifier, keys, keys ? num_keys : 0);
     USB_Keyboard_SendReport();
 }
 
@@ -110,13 +290,7 @@ void USB_Keyboard_Type(uint8_t modifier, uint8_t key)
  */
 void USB_Keyboard_SendReport(void)
 {
-    // 等待上一次传输完成（带超时，避免异常状态卡死）
-    if (!USB_WaitEPInReady(1)) {
-        return;
-    }
-    
-    memcpy(pEP1_IN_DataBuf, &g_KeyboardReport, sizeof(USB_KeyboardReport_t));
-    DevEP1_IN_Deal(sizeof(USB_KeyboardReport_t));
+    USB_HID_Submit(EP_KEYBOARD_IN & 0x0F, &g_KeyboardReport, KBD_HID_LEN_KEYBOARD);
 }
 
 /**
@@ -140,27 +314,22 @@ void USB_Keyboard_SetLEDs(uint8_t leds)
 void USB_Mouse_Init(void)
 {
     memset(&g_MouseReport, 0, sizeof(USB_MouseReport_t));
+    g_MouseFeature = 0;
 }
 
 /**
  * @brief 移动鼠标
  */
-void USB_Mouse_Move(int8_t x, int8_t y, int8_t wheel)
+void USB_Mouse_Move(int8_t x, int8_t y, int8_t wheel, int8_t pan)
 {
-    // 等待上一次传输完成（带超时，避免异常状态卡死）
-    if (!USB_WaitEPInReady(2)) {
-        return;
-    }
-    
-    g_MouseReport.x = x;
-    g_MouseReport.y = y;
-    g_MouseReport.wheel = wheel;
+    KBD_HID_PackMouse(&g_MouseReport, g_MouseReport.buttons, x, y, wheel, pan);
     USB_Mouse_SendReport();
     
     // 发送后清除移动量，保留按键状态
     g_MouseReport.x = 0;
     g_MouseReport.y = 0;
     g_MouseReport.wheel = 0;
+    g_MouseReport.pan = 0;
 }
 
 /**
@@ -178,11 +347,6 @@ void USB_Mouse_Click(uint8_t buttons)
  */
 void USB_Mouse_Press(uint8_t buttons)
 {
-    // 等待上一次传输完成（带超时，避免异常状态卡死）
-    if (!USB_WaitEPInReady(2)) {
-        return;
-    }
-    
     g_MouseReport.buttons = buttons;
     USB_Mouse_SendReport();
 }
@@ -192,11 +356,6 @@ void USB_Mouse_Press(uint8_t buttons)
  */
 void USB_Mouse_Release(void)
 {
-    // 等待上一次传输完成（带超时，避免异常状态卡死）
-    if (!USB_WaitEPInReady(2)) {
-        return;
-    }
-    
     g_MouseReport.buttons = 0;
     USB_Mouse_SendReport();
 }
@@ -206,8 +365,7 @@ void USB_Mouse_Release(void)
  */
 void USB_Mouse_SendReport(void)
 {
-    memcpy(pEP2_IN_DataBuf, &g_MouseReport, sizeof(USB_MouseReport_t));
-    DevEP2_IN_Deal(sizeof(USB_MouseReport_t));
+    USB_HID_Submit(EP_MOUSE_IN & 0x0F, &g_MouseReport, KBD_HID_LEN_MOUSE);
 }
 
 /* ==================== Consumer Control Functions ==================== */
@@ -225,12 +383,7 @@ void USB_Consumer_Init(void)
  */
 void USB_Consumer_Press(uint16_t key)
 {
-    // 等待上一次传输完成（带超时，避免异常状态卡死）
-    if (!USB_WaitEPInReady(3)) {
-        return;
-    }
-    
-    g_ConsumerReport.key = key;
+    KBD_HID_PackConsumer(&g_ConsumerReport, key);
     USB_Consumer_SendReport();
 }
 
@@ -239,11 +392,6 @@ void USB_Consumer_Press(uint16_t key)
  */
 void USB_Consumer_Release(void)
 {
-    // 等待上一次传输完成（带超时，避免异常状态卡死）
-    if (!USB_WaitEPInReady(3)) {
-        return;
-    }
-    
     g_ConsumerReport.key = 0;
     USB_Consumer_SendReport();
 }
@@ -253,8 +401,7 @@ void USB_Consumer_Release(void)
  */
 void USB_Consumer_SendReport(void)
 {
-    memcpy(pEP3_IN_DataBuf, &g_ConsumerReport, sizeof(USB_ConsumerReport_t));
-    DevEP3_IN_Deal(sizeof(USB_ConsumerReport_t));
+    USB_HID_Submit(EP_CONSUMER_IN & 0x0F, &g_ConsumerReport, KBD_HID_LEN_CONSUMER);
 }
 
 /* ==================== Config Functions ==================== */
@@ -307,7 +454,21 @@ void USB_Config_ProcessCommand(USB_ConfigReport_t *report)
     frame.len = report->data[1];  /* 使用包中的实际长度 */
     memcpy(frame.data, &report->data[2], sizeof(frame.data));  /* 跳过 SUB 和 LEN，复制完整 DATA (61B) */
 
-    KBD_Command_Process(&frame);
+    /* 入队后由命令任务与 BLE 配置服务串行处理，响应走 USB */
+    KBD_Command_PostUsb(&frame);
+}
+
+/**
+ * @brief 允许 / 暂停接收配置命令 (命令队列满时 OUT 端点回 NAK)
+ */
+void USB_Config_SetRxEnabled(uint8_t enable)
+{
+    uint32_t irq_status;
+
+    SYS_DisableAllIrq(&irq_status);
+    R8_UEP4_CTRL = (R8_UEP4_CTRL & ~MASK_UEP_R_RES) |
+                   (enable ? UEP_R_RES_ACK : UEP_R_RES_NAK);
+    SYS_RecoverIrq(irq_status);
 }
 
 /* ==================== USB Device Callbacks ==================== */
@@ -7,6 +7,7 @@ from __future__ import annotations
 
 import re
 from dataclasses import dataclass
+from pathlib import Path
 from typing import Callable, Iterable
 
 
@@ -22,6 +23,14 @@ class UsageRow:
     pct: float
 
 
+@dataclass(frozen=True)
+class StackUsageRow:
+    func: str
+    where: str
+    size: int
+    qualifier: str
+
+
 def strip_ansi(s: str) -> str:
     return re.sub(r"\033\[[^m]*m", "", s)
 
@@ -113,3 +122,88 @@ def render_usage_report(
         print(brow("  " + detail_line))
 
     print(hline("└", "┘"))
+
+
+_SU_LINE_RE = re.compile(r"^(?P<where>.+?):(?P<line>\d+):(?:\d+:)?(?P<func>[^\t]+)\t(?P<size>\d+)\t(?P<qual>\S+)")
+
+
+def collect_stack_usage(build_dir: Path) -> list[StackUsageRow]:
+    """Parse every GCC `-fstack-usage` (.su) file under build_dir, largest frame first."""
+    rows: list[StackUsageRow] = []
+    for su in build_dir.rglob("*.su"):
+        try:
+            text = su.read_text(errors="ignore")
+        except OSError:
+            continue
+        for line in text.splitlines():
+            m = _SU_LINE_RE.match(line)
+            if not m:
+                continue
+            where = f"{Path(m.group('where')).name}:{m.group('line')}"
+            rows.append(StackUsageRow(m.group("func"), where, int(m.group("size")), m.group("qual")))
+    rows.sort(key=lambda r: r.size, reverse=True)
+    return rows
+
+
+def read_linker_symbol(linker_script: Path, name: str) -> int | None:
+    """Read a plain `name = <number>;` assignment from a linker script."""
+    if not linker_script.is_file():
+        return None
+    m = re.search(rf"\b{re.escape(name)}\s*=\s*(0x[0-9A-Fa-f]+|\d+)\s*;", linker_script.read_text(errors="ignore"))
+    return int(m.group(1), 0) if m else None
+
+
+def render_stack_report(
+    *,
+    rows: Iterable[StackUsageRow],
+    stack_size: int | None,
+    colorize: ColorizeFn,
+    use_color: bool,
+    top: int = 8,
+    width: int = 72,
+    accent_code: str = "1;35",
+) -> None:
+    rows = list(rows)
+    if not rows:
+        return
+
+    def hline(left: str, right: str, fill: str = "─") -> str:
+        line = left + fill * width + right
+        return colorize(accent_code, line) if use_color else line
+
+    def brow(cells: str) -> str:
+        inner = rpad(cells, width)
+        if use_color:
+            return colorize(accent_code, "│") + inner + colorize(accent_code, "│")
+        return "│" + inner + "│"
+
+    dynamic = sum(1 for r in rows if r.qualifier != "static")
+    subtitle = f"{len(rows)} functions"
+    if stack_size:
+        subtitle += f"  ·  stack {fmt_bytes(stack_size)}"
+
+    print(hline("┌", "┐"))
+    print(brow("  " + colorize("1", "◆ Stack Frames (-fstack-usage)") + colorize("2", f"  ·  {subtitle}")))
+    print(hline("├", "┤"))
+
+    header = "  " + rpad(colorize("2", "Function"), 30)
+    header += rpad(colorize("2", "Source"), 22)
+    header += colorize("2", "Frame")
+    print(brow(header))
+    print(hline("├", "┤"))
+
+    for row in rows[:top]:
+        pct = (row.size / stack_size * 100) if stack_size else 0.0
+        cc = pct_color_code(pct * 4) if stack_size else "0"
+        func = row.func if len(row.func) <= 28 else row.func[:27] + "…"
+        where = row.where if len(row.where) <= 20 else "…" + row.where[-19:]
+        frame = colorize(cc, f"{row.size:>5} B")
+        if row.qualifier != "static":
+            frame += colorize("33", " dyn")
+        print(brow("  " + rpad(colorize("1", func), 30) + rpad(where, 22) + frame))
+
+    if dynamic:
+        print(hline("├", "┤"))
+        print(brow("  " + colorize("33", f"{dynamic} function(s) with dynamic frames (dyn), sizes are lower bounds")))
+
+    print(hline("└", "┘"))
@@ -153,9 +153,31 @@ def _ensure_windows_isp_assets_ready(python_exe: Path) -> None:
         )
 
 
+def _run_diag(argv: list[str]) -> None:
+    python_exe = _venv_python()
+    if not python_exe.is_file():
+        _create_venv()
+        python_exe = _venv_python()
+    if not _check_dependency(python_exe, "hid") or not _check_dependency(python_exe, "bleak"):
+        _install_requirements(python_exe)
+    if not _same_python(python_exe):
+        _reexec_in_venv(python_exe)
+
+    from kbd_diag import run
+
+    raise SystemExit(run(argv))
+
+
 def main() -> None:
     if len(sys.argv) > 1:
-        raise SystemExit("Legacy console flags were removed. Run `python tools/scripts/console.py` without arguments.")
+        from kbd_diag import SUBCOMMANDS
+
+        if sys.argv[1] in SUBCOMMANDS:
+            _run_diag(sys.argv[1:])
+        raise SystemExit(
+            "Legacy console flags were removed. Run `python tools/scripts/console.py` without arguments, "
+            f"or one of: {', '.join(SUBCOMMANDS)}."
+        )
 
     _ensure_venv_ready()
     python_exe = _venv_python()
@@ -0,0 +1,224 @@
+#!/usr/bin/env python3
+"""
+Host-side model of the CH592F key debounce engines (firmware/CH592F/hal/src/key.c).
+
+Feeds synthetic bounce waveforms through EAGER / DEFER / ASYMMETRIC and reports,
+per algorithm, the latency added to real transitions, how much contact chatter
+and EMI glitching is rejected, and how many transitions are lost outright.
+
+The model follows the firmware structure: an edge interrupt armed for one
+direction at a time, and a one-shot deadline timer. EAGER locks the pin out
+until the deadline; DEFER listens for bounce edges and pushes the deadline out
+on each one, confirming the new level once it has been quiet for N ms.
+
+  python tools/scripts/debounce_sim.py
+  python tools/scripts/debounce_sim.py --debounce-ms 5 --bounce-ms 8 --presses 2000
+"""
+
+from __future__ import annotations
+
+import argparse
+import random
+import statistics
+from dataclasses import dataclass, field
+from typing import List, Tuple
+
+EAGER, DEFER, ASYMMETRIC = 0, 1, 2
+MODE_NAMES = {EAGER: "eager", DEFER: "defer", ASYMMETRIC: "asymmetric"}
+
+WAIT_NONE, WAIT_LOCK, WAIT_DEFER = 0, 1, 2
+
+
+@dataclass
+class Waveform:
+    # (time_us, pressed) pin transitions, time-ordered
+    edges: List[Tuple[int, bool]]
+    # (time_us, pressed) true transitions the debouncer should report
+    truth: List[Tuple[int, bool]]
+    # pin edges caused by bounce or glitches rather than a real transition
+    spurious_edges: int
+    end_us: int
+
+
+def _bounce(rng: random.Random, t: int, final: bool, bounce_us: int, edges: List[Tuple[int, bool]]) -> int:
+    """Contact chatter: alternating edges with shrinking gaps, settling on `final`."""
+    level = final
+    edges.append((t, level))
+    n = 0
+    while bounce_us > 0:
+        gap = rng.randint(50, max(60, bounce_us // 3))
+        if t + gap * 2 > t + bounce_us:
+            break
+        t += gap
+        level = not level
+        edges.append((t, level))
+        t += rng.randint(20, gap)
+        level = not level
+        edges.append((t, level))
+        n += 2
+        bounce_us -= gap * 2
+    return n
+
+
+def make_waveform(rng: random.Random, presses: int, bounce_ms: float, hold_ms: Tuple[int, int],
+                  gap_ms: Tuple[int, int], glitch_rate: float, glitch_us: int) -> Waveform:
+    edges: List[Tuple[int, bool]] = []
+    truth: List[Tuple[int, bool]] = []
+    spurious = 0
+    t = 20_000
+    bounce_us = int(bounce_ms * 1000)
+
+    for _ in range(presses):
+        truth.append((t, True))
+        spurious += _bounce(rng, t, True, rng.randint(0, bounce_us), edges)
+        hold = rng.randint(*hold_ms) * 1000
+        spurious += _glitches(rng, t + bounce_us, t + hold, False, glitch_rate, glitch_us, edges)
+        t += hold
+        truth.append((t, False))
+        spurious += _bounce(rng, t, False, rng.randint(0, bounce_us), edges)
+        gap = rng.randint(*gap_ms) * 1000
+        spurious += _glitches(rng, t + bounce_us, t + gap, True, glitch_rate, glitch_us, edges)
+        t += gap
+
+    edges.sort(key=lambda e: e[0])
+    return Waveform(edges, truth, spurious, t + 100_000)
+
+
+def _glitches(rng: random.Random, start: int, end: int, pressed: bool, rate: float, width_us: int,
+              edges: List[Tuple[int, bool]]) -> int:
+    """EMI spikes: short pulses to the opposite level while the key is stable."""
+    n = 0
+    if end - start <= width_us * 2:
+        return 0
+    for _ in range(int(rate * (end - start) / 1_000_000 + rng.random())):
+        at = rng.randint(start, end - width_us * 2)
+        edges.append((at, pressed))
+        edges.append((at + rng.randint(10, width_us), not pressed))
+        n += 2
+    return n
+
+
+@dataclass
+class KeyModel:
+    mode: int
+    debounce_ms: int
+    is_down: bool = False
+    expect_press: bool = True
+    irq_enabled: bool = True
+    wait: int = WAIT_NONE
+    deadline: int = 0
+    events: List[Tuple[int, bool]] = field(default_factory=list)
+
+    def _commit(self, now: int) -> None:
+        self.is_down = self.expect_press
+        self.events.append((now, self.is_down))
+        self.expect_press = not self.expect_press
+
+    def on_edge(self, now: int, level_pressed: bool) -> None:
+        if self.wait == WAIT_LOCK or not self.irq_enabled:
+            return
+        window = self.debounce_ms * 1000
+        if self.wait == WAIT_DEFER:
+            # Bounce inside the confirm window: any edge pushes the deadline out
+            self.deadline = now + window
+            return
+        # Edge IRQ armed for one direction only (fall for press, rise for release)
+        if level_pressed != self.expect_press:
+            return
+        if self.mode == DEFER or (self.mode == ASYMMETRIC and not self.expect_press):
+            self.wait = WAIT_DEFER
+            self.deadline = now + window
+            return
+        self._commit(now)
+        self.wait = WAIT_LOCK
+        self.deadline = now + window
+        self.irq_enabled = False
+
+    def on_deadline(self, now: int, level_pressed: bool) -> None:
+        if self.wait == WAIT_DEFER and level_pressed == self.expect_press:
+            self._commit(now)
+        self.wait = WAIT_NONE
+        self.irq_enabled = True  # pending flag is cleared before re-enable
+
+
+@dataclass
+class Result:
+    mode: int
+    press_latency_us: List[int]
+    release_latency_us: List[int]
+    reported: int
+    expected: int
+    spurious_events: int
+    missed: int
+
+
+def simulate(wave: Waveform, mode: int, debounce_ms: int) -> Result:
+    key = KeyModel(mode, debounce_ms)
+    level = False
+    for at, level_next in wave.edges:
+        # One-shot timer fires before any edge that arrives after the deadline
+        if key.wait != WAIT_NONE and key.deadline <= at:
+            key.on_deadline(key.deadline, level)
+        level = level_next
+        key.on_edge(at, level)
+    if key.wait != WAIT_NONE:
+        key.on_deadline(key.deadline, level)
+
+    # Match each true transition to the first report of the same direction after it
+    press_lat: List[int] = []
+    release_lat: List[int] = []
+    used = 0
+    missed = 0
+    events = key.events
+    for n, (t, pressed) in enumerate(wave.truth):
+        limit = wave.truth[n + 1][0] if n + 1 < len(wave.truth) else wave.end_us
+        j = used
+        while j < len(events) and events[j][0] < t:
+            j += 1
+        if j < len(events) and events[j][0] < limit and events[j][1] == pressed:
+            (press_lat if pressed else release_lat).append(events[j][0] - t)
+            used = j + 1
+        else:
+            missed += 1
+
+    matched = len(press_lat) + len(release_lat)
+    return Result(mode, press_lat, release_lat, len(events), len(wave.truth),
+                  max(0, len(events) - matched), missed)
+
+
+def _fmt_lat(values: List[int]) -> str:
+    if not values:
+        return f"{'-':>7}{'-':>7}"
+    return f"{statistics.mean(values) / 1000:7.2f}{max(values) / 1000:7.2f}"
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="CH592F key debounce engine simulator")
+    parser.add_argument("--debounce-ms", type=int, default=10, help="kbd_system_config_t.debounce_ms (default 10)")
+    parser.add_argument("--bounce-ms", type=float, default=5.0, help="max contact bounce per transition")
+    parser.add_argument("--presses", type=int, default=1000)
+    parser.add_argument("--hold-ms", type=int, nargs=2, default=(30, 200), metavar=("MIN", "MAX"))
+    parser.add_argument("--gap-ms", type=int, nargs=2, default=(25, 300), metavar=("MIN", "MAX"))
+    parser.add_argument("--glitch-rate", type=float, default=2.0, help="EMI glitches per second of stable level")
+    parser.add_argument("--glitch-us", type=int, default=300, help="max glitch width")
+    parser.add_argument("--seed", type=int, default=1)
+    args = parser.parse_args()
+
+    rng = random.Random(args.seed)
+    wave = make_waveform(rng, args.presses, args.bounce_ms, tuple(args.hold_ms), tuple(args.gap_ms),
+                         args.glitch_rate, args.glitch_us)
+
+    print(f"{args.presses} keystrokes, bounce <= {args.bounce_ms} ms, {wave.spurious_edges} spurious pin edges, "
+          f"debounce {args.debounce_ms} ms")
+    print(f"{'algorithm':<12}{'press avg/max ms':>16}{'release avg/max ms':>20}"
+          f"{'chatter':>10}{'rejected':>10}{'missed':>8}")
+    for mode in (EAGER, DEFER, ASYMMETRIC):
+        r = simulate(wave, mode, args.debounce_ms)
+        rejected = 1.0 - (r.spurious_events / wave.spurious_edges) if wave.spurious_edges else 1.0
+        print(f"{MODE_NAMES[mode]:<12}  {_fmt_lat(r.press_latency_us)}  {_fmt_lat(r.release_latency_us)}    "
+              f"{r.spurious_events:>8}{rejected * 100:9.1f}%{r.missed:>8}")
+    return 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
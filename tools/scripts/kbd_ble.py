@@ -0,0 +1,172 @@
+#!/usr/bin/env python3
+"""
+Host transport for the CH592F BLE configuration service.
+
+The vendor GATT service tunnels the same command frames as the USB config
+interface. Both directions are byte streams of compact frames
+[CMD][SUB][LEN][DATA:LEN]: one write or notification may carry several frames
+and a frame may span packets, so the negotiated ATT MTU only changes how many
+frames fit per packet. Writes go to the RX characteristic without response;
+answers arrive as notifications on TX.
+
+The firmware queues KBD_BLE_CFG_RX_FRAMES frames, so `transact_many` keeps at
+most that many requests in flight and matches answers by CMD/SUB.
+"""
+
+from __future__ import annotations
+
+import asyncio
+import time
+from collections import deque
+from typing import Deque, List, Optional, Sequence, Tuple
+
+from kbd_hid import FRAME_SIZE, HidError
+
+SERVICE_UUID = "4d656f77-0001-4b62-8c6b-42696e4b6264"
+RX_UUID = "4d656f77-0002-4b62-8c6b-42696e4b6264"
+TX_UUID = "4d656f77-0003-4b62-8c6b-42696e4b6264"
+
+FRAME_DATA_MAX = FRAME_SIZE - 3
+# Must follow KBD_BLE_CFG_RX_FRAMES in firmware/CH592F/ble/hid/include/kbd_mode_config.h
+RX_QUEUE_FRAMES = 4
+
+Request = Tuple[int, int, bytes]
+
+
+class BleError(HidError):
+    pass
+
+
+def _import_bleak():
+    try:
+        import bleak  # type: ignore
+    except ImportError as exc:
+        raise BleError("Python package `bleak` is required (pip install bleak)") from exc
+    return bleak
+
+
+def pack_frame(cmd: int, sub: int, data: bytes = b"") -> bytes:
+    if len(data) > FRAME_DATA_MAX:
+        raise ValueError("payload too large")
+    return bytes([cmd & 0xFF, sub & 0xFF, len(data)]) + bytes(data)
+
+
+class BleConfigDevice:
+    def __init__(self, address: Optional[str] = None, name: Optional[str] = None,
+                 scan_timeout: float = 10.0) -> None:
+        self._bleak = _import_bleak()
+        self._loop = asyncio.new_event_loop()
+        self._rx = bytearray()
+        self._frames: Deque[Tuple[int, int, bytes]] = deque()
+        self._event: Optional[asyncio.Event] = None
+        self._client = None
+        try:
+            self._run(self._connect(address, name, scan_timeout))
+        except Exception:
+            self._loop.close()
+            raise
+
+    def _run(self, coro):
+        return self._loop.run_until_complete(coro)
+
+    async def _connect(self, address: Optional[str], name: Optional[str], scan_timeout: float) -> None:
+        self._event = asyncio.Event()
+        target = address
+        if target is None:
+            # A bonded keyboard that is already connected to this host does not
+            # advertise; in that case pass its address explicitly.
+            def match(dev, adv) -> bool:
+                if name is not None:
+                    return (dev.name or adv.local_name or "") == name
+                return SERVICE_UUID in [u.lower() for u in adv.service_uuids]
+
+            target = await self._bleak.BleakScanner.find_device_by_filter(match, timeout=scan_timeout)
+            if target is None:
+                raise BleError("BinaryKeyboard BLE config service not found (pass --address)")
+        self._client = self._bleak.BleakClient(target)
+        await self._client.connect()
+        if self._client.services.get_characteristic(RX_UUID) is None:
+            await self._client.disconnect()
+            raise BleError("config service missing; the host may cache an old GATT table, re-pair the keyboard")
+        await self._client.start_notify(TX_UUID, self._on_notify)
+
+    def _on_notify(self, _char, data: bytearray) -> None:
+        self._rx += data
+        while len(self._rx) >= 3 and len(self._rx) >= 3 + self._rx[2]:
+            n = 3 + self._rx[2]
+            self._frames.append((self._rx[0], self._rx[1], bytes(self._rx[3:n])))
+            del self._rx[:n]
+        if self._frames and self._event is not None:
+            self._event.set()
+
+    @property
+    def mtu(self) -> int:
+        return int(getattr(self._client, "mtu_size", 23) or 23)
+
+    def close(self) -> None:
+        if self._client is not None:
+            try:
+                self._run(self._client.disconnect())
+            finally:
+                self._client = None
+        self._loop.close()
+
+    def __enter__(self) -> "BleConfigDevice":
+        return self
+
+    def __exit__(self, *exc) -> None:
+        self.close()
+
+    async def _write(self, stream: bytes) -> None:
+        chunk = max(20, self.mtu - 3)
+        for off in range(0, len(stream), chunk):
+            await self._client.write_gatt_char(RX_UUID, stream[off:off + chunk], response=False)
+
+    async def _pop(self, deadline: float) -> Tuple[int, int, bytes]:
+        while not self._frames:
+            remain = deadline - time.monotonic()
+            if remain <= 0:
+                raise BleError("BLE config response timeout")
+            self._event.clear()
+            try:
+                await asyncio.wait_for(self._event.wait(), remain)
+            except asyncio.TimeoutError:
+                pass
+        return self._frames.popleft()
+
+    async def _transact_many(self, reqs: Sequence[Request], window: int, timeout_ms: int) -> List[bytes]:
+        out: List[bytes] = []
+        pending: Deque[Tuple[int, int]] = deque()
+        it = iter(reqs)
+        done = False
+        while True:
+            batch = b""
+            while not done and len(pending) < window:
+                try:
+                    cmd, sub, data = next(it)
+                except StopIteration:
+                    done = True
+                    break
+                batch += pack_frame(cmd, sub, data)
+                pending.append((cmd & 0xFF, sub & 0xFF))
+            if batch:
+                # Several frames per write: the firmware reassembles the stream
+                await self._write(batch)
+            if not pending:
+                return out
+            deadline = time.monotonic() + timeout_ms / 1000.0
+            while True:
+                cmd, sub, data = await self._pop(deadline)
+                if (cmd, sub) == pending[0]:
+                    pending.popleft()
+                    out.append(data)
+                    break
+
+    def transact(self, cmd: int, sub: int = 0, data: bytes = b"", timeout_ms: int = 1000) -> bytes:
+        """Send one command frame and return the response DATA field."""
+        return self._run(self._transact_many([(cmd, sub, data)], 1, timeout_ms))[0]
+
+    def transact_many(self, reqs: Sequence[Request], window: int = RX_QUEUE_FRAMES,
+                      timeout_ms: int = 1000) -> List[bytes]:
+        """Pipeline requests (at most `window` in flight) and return their DATA fields in order."""
+        return self._run(self._transact_many(reqs, max(1, min(window, RX_QUEUE_FRAMES)), timeout_ms))
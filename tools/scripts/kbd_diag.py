@@ -0,0 +1,713 @@
+#!/usr/bin/env python3
+"""
+Diagnostic subcommands for CH592F firmware, reached via `console.py <command>`.
+
+  prof   profiling zone table (cycles, needs -DKBD_PROF_ENABLE=ON)
+  mem    stack / TMOS heap high-water marks
+  boot   boot timeline (per-stage offsets, deferred init, first keystroke)
+  input  unified input queue (high-water, drops, ISR-to-drain latency)
+  idle   tickless idle residency (run / CPU halt / RTC sleep) and sleep vetoes
+  replay BLE reconnect replay buffer and wake-to-first-report latency
+  resume USB suspend buffer, remote wakeups and keypress-to-first-report latency
+  conn   BLE connection-parameter policy (typing / idle profile, granted params)
+  reconn BLE reconnect schedule (directed advertising, time to usable link)
+  hosts  BLE host slots (stored peers, remembered params, switch time)
+  blecfg BLE config service link (MTU, PHY) and frame / notification counters
+  tx     BLE report pacing (per-event budget, bursts, achieved reports/s vs interval)
+  link   BLE link telemetry (RSSI, missed events, retries, disconnect reasons, adaptive TX power)
+  bat    battery sampling schedule (adaptive period, radio-aligned ADC, charge pin interrupts)
+  flash  flash job queue (erase / program steps placed between BLE connection events)
+  bench  config channel throughput (DataFlash read, macro read / upload) over USB or BLE
+"""
+
+from __future__ import annotations
+
+import argparse
+import math
+import struct
+import time
+from typing import Callable, Dict, List, Sequence
+
+from kbd_hid import RESP_OK, ConfigDevice, HidError
+
+
+CMD_PROF_READ = 0xA2
+CMD_MEM_INFO = 0xA3
+CMD_BOOT_TIMELINE = 0xA4
+CMD_INPUT_STATS = 0xA5
+CMD_IDLE_STATS = 0xA6
+CMD_BLE_REPLAY_STATS = 0xA7
+CMD_USB_RESUME_STATS = 0xA8
+CMD_BLE_CONN_STATS = 0xA9
+CMD_BLE_RECONN_STATS = 0xAA
+CMD_BLE_HOST_STATS = 0xAB
+CMD_BLE_CFG_STATS = 0xAC
+CMD_BLE_TX_STATS = 0xAD
+CMD_BLE_LINK_STATS = 0xAE
+CMD_BAT_STATS = 0xAF
+
+CMD_MACRO_INFO = 0x40
+CMD_MACRO_GET = 0x41
+CMD_MACRO_SET = 0x42
+CMD_DATAFLASH_INFO = 0x90
+CMD_DATAFLASH_READ = 0x91
+CMD_FLASH_JOBS = 0x93
+
+PHY_NAMES = {1: "1M", 2: "2M", 3: "coded"}
+
+# Must follow linkTxLevels in firmware/CH592F/ble/hid/src/ble_link.c
+TX_LEVELS_DBM = (-15, -10, -5, 0, 4)
+DISCONNECT_NAMES = {0x08: "supervision timeout", 0x13: "remote user", 0x16: "local host",
+                    0x3D: "MIC failure", 0x3E: "failed to establish"}
+
+# Must follow ble_hid_conn_profile_t in firmware/CH592F/ble/hid/include/ble_hid.h
+CONN_PROFILE_NAMES = ["fast", "idle"]
+
+# Must follow ble_hid_reconn_phase_t in firmware/CH592F/ble/hid/include/ble_hid.h
+RECONN_PHASE_NAMES = ["-", "direct_high", "direct_low", "fast", "slow"]
+
+# Must follow kbd_prof_zone_t in firmware/CH592F/hal/include/kbd_prof.h
+PROF_ZONE_NAMES = [
+    "KBD_RGB_ProcessEvent",
+    "KBD_Macro_ProcessEvent",
+    "KBD_Storage_ProcessEvent",
+    "KBD_Battery_ProcessEvent",
+    "GPIOA_IRQHandler",
+    "GPIOB_IRQHandler",
+    "TMR0_IRQHandler",
+    "KBD_Core_ProcessEvent",
+]
+
+# Must follow kbd_boot_stage_t in firmware/CH592F/keyboard/include/kbd_boot.h
+BOOT_STAGE_NAMES = [
+    "reset",
+    "clock",
+    "ble_init",
+    "drivers",
+    "storage",
+    "protocol",
+    "ready",
+    "main_loop",
+    "defer_log",
+    "defer_rgb",
+    "defer_battery",
+    "first_key",
+]
+
+# Must follow kbd_idle_block_t in firmware/CH592F/keyboard/include/kbd_idle.h
+IDLE_BLOCK_NAMES = ["event", "usb", "debounce", "rgb", "short", "uart-log"]
+# Veto counters cover KBD_IDLE_BLOCK_USB .. KBD_IDLE_BLOCK_SHORT
+IDLE_VETO_NAMES = IDLE_BLOCK_NAMES[1:5]
+
+TICK_NONE = 0xFFFFFFFF
+
+
+def _fmt_us(cycles: float, cycles_per_us: int) -> str:
+    return f"{cycles / cycles_per_us:10.1f}"
+
+
+def cmd_prof(args: argparse.Namespace) -> int:
+    rows: List[tuple] = []
+    enabled = 0
+    cycles_per_us = 60
+    with ConfigDevice() as dev:
+        first = 0
+        while True:
+            resp = dev.transact(CMD_PROF_READ, 0, bytes([first, 1 if args.reset else 0]))
+            if not resp or resp[0] != RESP_OK:
+                raise HidError(f"PROF_READ failed: {resp[:1].hex() if resp else 'empty'}")
+            total, start, n, enabled = resp[1], resp[2], resp[3], resp[4]
+            cycles_per_us = struct.unpack_from("<I", resp, 5)[0] or 1
+            for i in range(n):
+                count, tot, mn, mx = struct.unpack_from("<4I", resp, 9 + i * 16)
+                rows.append((start + i, count, tot, mn, mx))
+            first = start + n
+            if n == 0 or first >= total:
+                break
+
+    if not enabled:
+        print("profiling disabled in firmware (build with -DKBD_PROF_ENABLE=ON)")
+        return 1
+
+    print(f"{'zone':<26}{'count':>10}{'avg us':>11}{'min us':>11}{'max us':>11}{'total ms':>11}")
+    for idx, count, tot, mn, mx in rows:
+        name = PROF_ZONE_NAMES[idx] if idx < len(PROF_ZONE_NAMES) else f"zone{idx}"
+        if count == 0:
+            print(f"{name:<26}{0:>10}{'-':>11}{'-':>11}{'-':>11}{'-':>11}")
+            continue
+        sat = "+" if tot == 0xFFFFFFFF else " "
+        print(
+            f"{name:<26}{count:>10} {_fmt_us(tot / count, cycles_per_us)} "
+            f"{_fmt_us(mn, cycles_per_us)} {_fmt_us(mx, cycles_per_us)} "
+            f"{tot / cycles_per_us / 1000:9.2f}{sat}"
+        )
+    if args.reset:
+        print("(counters reset)")
+    return 0
+
+
+def _add_prof(sub) -> None:
+    p = sub.add_parser("prof", help="read profiling zone statistics")
+    p.add_argument("--reset", action="store_true", help="clear counters after reading")
+    p.set_defaults(func=cmd_prof)
+
+
+def cmd_mem(args: argparse.Namespace) -> int:
+    with ConfigDevice() as dev:
+        resp = dev.transact(CMD_MEM_INFO)
+    if len(resp) < 9 or resp[0] != RESP_OK:
+        raise HidError(f"MEM_INFO failed: {resp[:1].hex() if resp else 'empty'}")
+    stack_size, stack_peak, heap_size, heap_peak = struct.unpack_from("<4H", resp, 1)
+    for name, size, peak in (("stack", stack_size, stack_peak), ("tmos heap", heap_size, heap_peak)):
+        pct = peak / size * 100 if size else 0.0
+        print(f"{name:<10}{peak:>6} / {size:<6} B  {pct:5.1f}%  (free {size - peak} B)")
+    return 0
+
+
+def _add_mem(sub) -> None:
+    p = sub.add_parser("mem", help="read stack / TMOS heap high-water marks")
+    p.set_defaults(func=cmd_mem)
+
+
+def cmd_boot(args: argparse.Namespace) -> int:
+    with ConfigDevice() as dev:
+        resp = dev.transact(CMD_BOOT_TIMELINE)
+    if len(resp) < 10 or resp[0] != RESP_OK:
+        raise HidError(f"BOOT_TIMELINE failed: {resp[:1].hex() if resp else 'empty'}")
+    count = resp[1]
+    tick_hz, wake = struct.unpack_from("<2I", resp, 2)
+    stages = struct.unpack_from(f"<{count}I", resp, 10)
+
+    def ms(ticks: int) -> float:
+        return ticks * 1000.0 / tick_hz
+
+    print(f"{'stage':<16}{'at ms':>10}{'delta ms':>10}")
+    prev = 0
+    for idx, ticks in enumerate(stages):
+        name = BOOT_STAGE_NAMES[idx] if idx < len(BOOT_STAGE_NAMES) else f"stage{idx}"
+        if ticks == TICK_NONE:
+            print(f"{name:<16}{'-':>10}{'-':>10}")
+            continue
+        print(f"{name:<16}{ms(ticks):10.2f}{ms(ticks - prev):10.2f}")
+        prev = ticks
+    if wake != TICK_NONE:
+        print(f"last wake -> first key: {ms(wake):.2f} ms")
+    return 0
+
+
+def _add_boot(sub) -> None:
+    p = sub.add_parser("boot", help="read boot timeline")
+    p.set_defaults(func=cmd_boot)
+
+
+def cmd_input(args: argparse.Namespace) -> int:
+    with ConfigDevice() as dev:
+        resp = dev.transact(CMD_INPUT_STATS, 0, bytes([1 if args.reset else 0]))
+    if len(resp) < 28 or resp[0] != RESP_OK:
+        raise HidError(f"INPUT_STATS failed: {resp[:1].hex() if resp else 'empty'}")
+    size, depth, high_water = resp[1], resp[2], resp[3]
+    cycles_per_us, pushed, dropped, lat_count, lat_total, lat_max = struct.unpack_from("<6I", resp, 4)
+    cycles_per_us = cycles_per_us or 1
+
+    print(f"queue      depth {depth} / {size - 1}, high-water {high_water}")
+    print(f"events     pushed {pushed}, dropped {dropped}")
+    if lat_count:
+        sat = "+" if lat_total == 0xFFFFFFFF else ""
+        print(f"latency    avg {lat_total / lat_count / cycles_per_us:.1f}{sat} us, "
+              f"max {lat_max / cycles_per_us:.1f} us over {lat_count} events")
+    else:
+        print("latency    no events drained yet")
+    if args.reset:
+        print("(counters reset)")
+    return 0
+
+
+def _add_input(sub) -> None:
+    p = sub.add_parser("input", help="read unified input queue statistics")
+    p.add_argument("--reset", action="store_true", help="clear counters after reading")
+    p.set_defaults(func=cmd_input)
+
+
+def cmd_idle(args: argparse.Namespace) -> int:
+    with ConfigDevice() as dev:
+        resp = dev.transact(CMD_IDLE_STATS, 0, bytes([1 if args.reset else 0]))
+    n_veto = len(IDLE_VETO_NAMES)
+    if len(resp) < 2 + (7 + n_veto) * 4 or resp[0] != RESP_OK:
+        raise HidError(f"IDLE_STATS failed: {resp[:1].hex() if resp else 'empty'}")
+    last_block = resp[1]
+    tick_hz, window, halt, sleep, halt_n, sleep_n, busy = struct.unpack_from("<7I", resp, 2)
+    vetoes = struct.unpack_from(f"<{n_veto}I", resp, 30)
+    tick_hz = tick_hz or 1
+    run = max(window - halt - sleep, 0)
+
+    def row(name: str, ticks: int, count: str = "") -> None:
+        pct = ticks / window * 100 if window else 0.0
+        print(f"{name:<8}{ticks * 1000.0 / tick_hz:12.1f} ms {pct:6.1f}%  {count}")
+
+    print(f"window  {window * 1000.0 / tick_hz:12.1f} ms")
+    row("run", run, f"(busy returns {busy})")
+    row("halt", halt, f"({halt_n} entries)")
+    row("sleep", sleep, f"({sleep_n} entries)")
+    print("halt instead of sleep: " + ", ".join(f"{n} {c}" for n, c in zip(IDLE_VETO_NAMES, vetoes)))
+    names = [n for i, n in enumerate(IDLE_BLOCK_NAMES) if last_block & (1 << i)]
+    print(f"last blocker: {', '.join(names) if names else '-'}")
+    if args.reset:
+        print("(counters reset)")
+    return 0
+
+
+def _add_idle(sub) -> None:
+    p = sub.add_parser("idle", help="read tickless idle residency statistics")
+    p.add_argument("--reset", action="store_true", help="clear counters after reading")
+    p.set_defaults(func=cmd_idle)
+
+
+def cmd_replay(args: argparse.Namespace) -> int:
+    with ConfigDevice() as dev:
+        resp = dev.transact(CMD_BLE_REPLAY_STATS, 0, bytes([1 if args.reset else 0]))
+    if len(resp) < 32 or resp[0] != RESP_OK:
+        raise HidError(f"BLE_REPLAY_STATS failed: {resp[:1].hex() if resp else 'empty'}")
+    depth, high_water, capacity = resp[1], resp[2], resp[3]
+    buffered, replayed, expired, dropped, wake_n, wake_last, wake_max = struct.unpack_from("<7I", resp, 4)
+
+    print(f"buffer     depth {depth} / {capacity}, high-water {high_water}")
+    print(f"reports    buffered {buffered}, replayed {replayed}, expired {expired}, dropped {dropped}")
+    if wake_n:
+        print(f"wake       last {wake_last} ms, max {wake_max} ms to first report over {wake_n} wakes")
+    else:
+        print("wake       no wake-to-report measured yet")
+    if args.reset:
+        print("(counters reset)")
+    return 0
+
+
+def _add_replay(sub) -> None:
+    p = sub.add_parser("replay", help="read BLE reconnect replay statistics")
+    p.add_argument("--reset", action="store_true", help="clear counters after reading")
+    p.set_defaults(func=cmd_replay)
+
+
+def cmd_resume(args: argparse.Namespace) -> int:
+    with ConfigDevice() as dev:
+        resp = dev.transact(CMD_USB_RESUME_STATS, 0, bytes([1 if args.reset else 0]))
+    if len(resp) < 36 or resp[0] != RESP_OK:
+        raise HidError(f"USB_RESUME_STATS failed: {resp[:1].hex() if resp else 'empty'}")
+    depth, high_water, capacity = resp[1], resp[2], resp[3]
+    buffered, flushed, expired, dropped, wakeups, lat_n, lat_last, lat_max = struct.unpack_from("<8I", resp, 4)
+
+    print(f"buffer     depth {depth} / {capacity}, high-water {high_water}")
+    print(f"reports    buffered {buffered}, flushed {flushed}, expired {expired}, dropped {dropped}")
+    print(f"wakeup     {wakeups} remote wakeups signalled")
+    if lat_n:
+        print(f"latency    last {lat_last} ms, max {lat_max} ms keypress to first report over {lat_n} resumes")
+    else:
+        print("latency    no resume measured yet")
+    if args.reset:
+        print("(counters reset)")
+    return 0
+
+
+def _add_resume(sub) -> None:
+    p = sub.add_parser("resume", help="read USB suspend/resume buffer statistics")
+    p.add_argument("--reset", action="store_true", help="clear counters after reading")
+    p.set_defaults(func=cmd_resume)
+
+
+def cmd_conn(args: argparse.Namespace) -> int:
+    with ConfigDevice() as dev:
+        resp = dev.transact(CMD_BLE_CONN_STATS, 0, bytes([1 if args.reset else 0]))
+    if len(resp) < 25 or resp[0] != RESP_OK:
+        raise HidError(f"BLE_CONN_STATS failed: {resp[:1].hex() if resp else 'empty'}")
+    target, requested = resp[1], resp[2]
+    interval, latency, timeout = struct.unpack_from("<3H", resp, 3)
+    requests, updates, fast_ms, idle_ms = struct.unpack_from("<4I", resp, 9)
+
+    def name(profile: int) -> str:
+        return CONN_PROFILE_NAMES[profile] if profile < len(CONN_PROFILE_NAMES) else "-"
+
+    total = fast_ms + idle_ms
+    print(f"profile    {name(target)} (requested {name(requested)})")
+    print(f"granted    interval {interval * 1.25:.2f} ms, latency {latency}, timeout {timeout * 10} ms")
+    print(f"requests   {requests} sent, {updates} updates from host")
+    for label, ms in (("fast", fast_ms), ("idle", idle_ms)):
+        pct = ms / total * 100 if total else 0.0
+        print(f"{label:<11}{ms / 1000.0:10.1f} s {pct:6.1f}%")
+    if args.reset:
+        print("(counters reset)")
+    return 0
+
+
+def _add_conn(sub) -> None:
+    p = sub.add_parser("conn", help="read BLE connection-parameter policy statistics")
+    p.add_argument("--reset", action="store_true", help="clear counters after reading")
+    p.set_defaults(func=cmd_conn)
+
+
+def cmd_reconn(args: argparse.Namespace) -> int:
+    with ConfigDevice() as dev:
+        resp = dev.transact(CMD_BLE_RECONN_STATS, 0, bytes([1 if args.reset else 0]))
+    if len(resp) < 60 or resp[0] != RESP_OK:
+        raise HidError(f"BLE_RECONN_STATS failed: {resp[:1].hex() if resp else 'empty'}")
+    phase, last_phase, peer_valid, peer_type = resp[1], resp[2], resp[3], resp[4]
+    peer_addr, direct_miss = resp[5:11], resp[11]
+    (attempts, connected, ready, aborted, *by_phase) = struct.unpack_from("<8I", resp, 12)
+    last_link_ms, last_ready_ms, max_ready_ms, total_ready_ms = struct.unpack_from("<4I", resp, 44)
+
+    def name(p: int) -> str:
+        return RECONN_PHASE_NAMES[p] if p < len(RECONN_PHASE_NAMES) else "?"
+
+    if peer_valid:
+        addr = ":".join(f"{b:02X}" for b in reversed(peer_addr))
+        peer = f"{addr} ({'random' if peer_type else 'public'})"
+    else:
+        peer = "none"
+    print(f"phase      {name(phase)} (last connect in {name(last_phase)})")
+    print(f"peer       {peer}, directed misses {direct_miss}")
+    print(f"attempts   {attempts}, {connected} linked, {ready} encrypted, {aborted} aborted")
+    print("by phase   " + ", ".join(f"{name(i + 1)} {n}" for i, n in enumerate(by_phase)))
+    avg = total_ready_ms / ready if ready else 0.0
+    print(f"last       link {last_link_ms} ms, ready {last_ready_ms} ms")
+    print(f"ready      avg {avg:.0f} ms, max {max_ready_ms} ms")
+    if args.reset:
+        print("(counters reset)")
+    return 0
+
+
+def _add_reconn(sub) -> None:
+    p = sub.add_parser("reconn", help="read BLE reconnect statistics")
+    p.add_argument("--reset", action="store_true", help="clear counters after reading")
+    p.set_defaults(func=cmd_reconn)
+
+
+def cmd_hosts(args: argparse.Namespace) -> int:
+    with ConfigDevice() as dev:
+        resp = dev.transact(CMD_BLE_HOST_STATS, 0, bytes([1 if args.reset else 0]))
+    if len(resp) < 60 or resp[0] != RESP_OK:
+        raise HidError(f"BLE_HOST_STATS failed: {resp[:1].hex() if resp else 'empty'}")
+    active = resp[1]
+    switches, rejected, last_switch_ms, max_switch_ms = struct.unpack_from("<4I", resp, 2)
+
+    for i in range(3):
+        off = 18 + i * 14
+        valid, addr_type = resp[off], resp[off + 1]
+        interval, latency, timeout = struct.unpack_from("<3H", resp, off + 8)
+        mark = "*" if i == active else " "
+        if not valid:
+            print(f"{mark} slot {i}  empty")
+            continue
+        addr = ":".join(f"{b:02X}" for b in reversed(resp[off + 2:off + 8]))
+        kind = "random" if addr_type else "public"
+        if interval:
+            params = f"{interval * 1.25:.2f} ms / lat {latency} / to {timeout * 10} ms"
+        else:
+            params = "params not learned"
+        print(f"{mark} slot {i}  {addr} ({kind}), {params}")
+    print(f"switches   {switches}, {rejected} other-slot connections rejected")
+    print(f"switch     last {last_switch_ms} ms, max {max_switch_ms} ms")
+    if args.reset:
+        print("(counters reset)")
+    return 0
+
+
+def _add_hosts(sub) -> None:
+    p = sub.add_parser("hosts", help="read BLE host slots and switch statistics")
+    p.add_argument("--reset", action="store_true", help="clear counters after reading")
+    p.set_defaults(func=cmd_hosts)
+
+
+def _open(args: argparse.Namespace):
+    """USB config interface by default, BLE config service with --address."""
+    if getattr(args, "address", None):
+        from kbd_ble import BleConfigDevice
+
+        return BleConfigDevice(args.address)
+    return ConfigDevice()
+
+
+def _pipeline(dev, reqs: Sequence[tuple]) -> List[bytes]:
+    # The USB transport is strictly request / response
+    if hasattr(dev, "transact_many"):
+        return dev.transact_many(reqs)
+    return [dev.transact(cmd, sub, data) for cmd, sub, data in reqs]
+
+
+def cmd_blecfg(args: argparse.Namespace) -> int:
+    with _open(args) as dev:
+        resp = dev.transact(CMD_BLE_CFG_STATS, 0, bytes([1 if args.reset else 0]))
+    if len(resp) < 44 or resp[0] != RESP_OK:
+        raise HidError(f"BLE_CFG_STATS failed: {resp[:1].hex() if resp else 'empty'}")
+    mtu, tx_phy, rx_phy, notify, rx_size, rx_hw, tx_size, tx_hw = struct.unpack_from("<H4B3H", resp, 1)
+    (rx_frames, rx_bytes, rx_dropped, tx_frames,
+     tx_bytes, notifies, tx_dropped, retries) = struct.unpack_from("<8I", resp, 12)
+
+    print(f"link       mtu {mtu}, phy tx {PHY_NAMES.get(tx_phy, tx_phy)} / rx {PHY_NAMES.get(rx_phy, rx_phy)}, "
+          f"notify {'on' if notify else 'off'}")
+    print(f"rx         {rx_frames} frames / {rx_bytes} B, {rx_dropped} dropped, queue {rx_hw}/{rx_size}")
+    per = f", {tx_bytes / notifies:.1f} B/notify" if notifies else ""
+    print(f"tx         {tx_frames} frames / {tx_bytes} B in {notifies} notifies{per}")
+    print(f"tx ring    {tx_hw}/{tx_size} B, {tx_dropped} dropped, {retries} retries")
+    if args.reset:
+        print("(counters reset)")
+    return 0
+
+
+def _add_blecfg(sub) -> None:
+    p = sub.add_parser("blecfg", help="read BLE config service link and throughput counters")
+    p.add_argument("--address", help="read over the BLE config service of this device (default: USB)")
+    p.add_argument("--reset", action="store_true", help="clear counters after reading")
+    p.set_defaults(func=cmd_blecfg)
+
+
+def cmd_tx(args: argparse.Namespace) -> int:
+    with _open(args) as dev:
+        resp = dev.transact(CMD_BLE_TX_STATS, 0, bytes([1 if args.reset else 0]))
+    if len(resp) < 37 or resp[0] != RESP_OK:
+        raise HidError(f"BLE_TX_STATS failed: {resp[:1].hex() if resp else 'empty'}")
+    budget, burst_budget, burst, backlog, backlog_max, backlog_limit, interval = struct.unpack_from("<6BH", resp, 1)
+    bursts, reports, events, burst_ms, deferred, paced, dropped = struct.unpack_from("<7I", resp, 9)
+
+    state = "burst" if burst else "normal"
+    print(f"budget     {budget}/event ({state}), burst budget {burst_budget}/event")
+    print(f"backlog    {backlog} now, max {backlog_max}, macro pauses at {backlog_limit}")
+    print(f"queued     {deferred} deferred, {paced} paced out, {dropped} dropped")
+    print(f"bursts     {bursts}, {reports} reports over {events} conn events in {burst_ms} ms")
+    if interval:
+        # Ceiling: burst budget reports in every connection event
+        ceiling = burst_budget * 1000.0 / (interval * 1.25)
+        line = f"interval {interval * 1.25:.2f} ms, ceiling {ceiling:.0f} reports/s"
+        if burst_ms:
+            achieved = reports * 1000.0 / burst_ms
+            line += f", achieved {achieved:.0f} reports/s ({achieved / ceiling * 100:.0f}%)"
+        print(f"rate       {line}")
+    if events:
+        print(f"per event  {reports / events:.2f} reports (budget {burst_budget})")
+    if args.reset:
+        print("(counters reset)")
+    return 0
+
+
+def _add_tx(sub) -> None:
+    p = sub.add_parser("tx", help="read BLE report pacing and burst throughput")
+    p.add_argument("--address", help="read over the BLE config service of this device (default: USB)")
+    p.add_argument("--reset", action="store_true", help="clear counters after reading")
+    p.set_defaults(func=cmd_tx)
+
+
+def cmd_link(args: argparse.Namespace) -> int:
+    flags = 1 if args.reset else 0
+    if args.adapt is not None:
+        flags |= 0x02 | (0x04 if args.adapt == "on" else 0)
+    with _open(args) as dev:
+        resp = dev.transact(CMD_BLE_LINK_STATS, 0, bytes([flags]))
+    if len(resp) < 61 or resp[0] != RESP_OK:
+        raise HidError(f"BLE_LINK_STATS failed: {resp[:1].hex() if resp else 'empty'}")
+    rssi_last, rssi_avg, rssi_min, rssi_max, tx_dbm, tx_default = struct.unpack_from("<6b", resp, 1)
+    adapt, reason, interval = struct.unpack_from("<2BH", resp, 7)
+    events, missed, retries, changes = struct.unpack_from("<4I", resp, 11)
+    disc = resp[27:31]
+    level_ms = struct.unpack_from("<5I", resp, 31)
+    level_pm = struct.unpack_from("<5H", resp, 51)
+
+    def dbm(v: int) -> str:
+        return "n/a" if v == 127 else f"{v} dBm"
+
+    if rssi_min == 127:
+        rssi_max = 127  # no sample since the counters were cleared
+    print(f"rssi       last {dbm(rssi_last)}, avg {dbm(rssi_avg)}, min {dbm(rssi_min)}, max {dbm(rssi_max)}")
+    print(f"tx power   {tx_dbm} dBm (default {tx_default}), adaptive {'on' if adapt else 'off'}, {changes} changes")
+    rate = f" ({missed / (events + missed) * 100:.2f}% missed)" if events + missed else ""
+    print(f"events     {events}, {missed} missed{rate}, {retries} retry events")
+    last = DISCONNECT_NAMES.get(reason, "none" if reason == 0 else "other")
+    print(f"disconnect timeout {disc[0]}, remote {disc[1]}, local {disc[2]}, other {disc[3]}; "
+          f"last 0x{reason:02X} ({last})")
+
+    total = sum(level_ms)
+    if total:
+        # Radiated power relative to the default level, time-weighted
+        mw = sum(ms * 10 ** (d / 10) for ms, d in zip(level_ms, TX_LEVELS_DBM)) / total
+        saving = (1 - mw / 10 ** (tx_default / 10)) * 100
+        print(f"tx time    mean {10 * math.log10(mw):.1f} dBm, "
+              f"{saving:.0f}% less radiated power than {tx_default} dBm")
+    ival_ms = interval * 1.25
+    for d, ms, pm in zip(TX_LEVELS_DBM, level_ms, level_pm):
+        if not ms:
+            continue
+        # Each retransmission delays that packet by one connection interval
+        extra = f", +{pm / 1000 * ival_ms:.2f} ms/report" if interval else ""
+        print(f"  {d:+3d} dBm {ms / 1000:9.1f} s, retry {pm / 10:.1f}%{extra}")
+    if args.reset:
+        print("(counters reset)")
+    return 0
+
+
+def _add_link(sub) -> None:
+    p = sub.add_parser("link", help="read BLE link telemetry and adaptive TX power state")
+    p.add_argument("--address", help="read over the BLE config service of this device (default: USB)")
+    p.add_argument("--adapt", choices=("on", "off"), help="switch adaptive TX power until reboot")
+    p.add_argument("--reset", action="store_true", help="clear counters after reading")
+    p.set_defaults(func=cmd_link)
+
+
+def cmd_bat(args: argparse.Namespace) -> int:
+    with _open(args) as dev:
+        resp = dev.transact(CMD_BAT_STATS, 0, bytes([1 if args.reset else 0]))
+    if len(resp) < 36 or resp[0] != RESP_OK:
+        raise HidError(f"BAT_STATS failed: {resp[:1].hex() if resp else 'empty'}")
+    period_ms, slope, armed = struct.unpack_from("<IhB", resp, 1)
+    wakeups, samples, rejected, aligned, timeouts, irqs, polls = struct.unpack_from("<7I", resp, 8)
+
+    print(f"period     {period_ms / 1000:.0f} s, slope {slope:+d} mV/min")
+    immediate = samples + rejected - aligned - timeouts
+    print(f"samples    {samples} accepted, {rejected} rejected; "
+          f"{aligned} after a conn event, {timeouts} wait timeouts, {max(immediate, 0)} not connected")
+    print(f"charge pin {'edge irq armed' if armed else 'debouncing'}, {irqs} irqs, {polls} polls")
+    if samples:
+        print(f"wakeups    {wakeups} ({wakeups / samples:.1f} per sample)")
+    else:
+        print(f"wakeups    {wakeups}")
+    if args.reset:
+        print("(counters reset)")
+    return 0
+
+
+def _add_bat(sub) -> None:
+    p = sub.add_parser("bat", help="read battery sampling schedule and charge pin counters")
+    p.add_argument("--address", help="read over the BLE config service of this device (default: USB)")
+    p.add_argument("--reset", action="store_true", help="clear counters after reading")
+    p.set_defaults(func=cmd_bat)
+
+
+def cmd_flash(args: argparse.Namespace) -> int:
+    with _open(args) as dev:
+        resp = dev.transact(CMD_FLASH_JOBS, 0, bytes([1 if args.reset else 0]))
+    if len(resp) < 51 or resp[0] != RESP_OK:
+        raise HidError(f"FLASH_JOBS failed: {resp[:1].hex() if resp else 'empty'}")
+    depth, depth_max, interval, latency, step_max = struct.unpack_from("<BBHHI", resp, 1)
+    (step_sum, jobs, failed, rejected, deferred,
+     aligned, timeouts, immediate, sync, missed) = struct.unpack_from("<10I", resp, 11)
+
+    steps = aligned + timeouts + immediate + sync
+    print(f"queue      {depth} pending, high-water {depth_max}")
+    print(f"jobs       {jobs} done, {failed} failed, {rejected} rejected (queue full)")
+    print(f"steps      {aligned} after a conn event, {timeouts} wait timeouts, "
+          f"{immediate} not connected, {sync} drained synchronously ({deferred} deferrals)")
+    if steps:
+        print(f"step time  max {step_max} us, mean {step_sum / steps:.0f} us")
+    else:
+        print(f"step time  max {step_max} us")
+    link = f"interval {interval * 1.25:.2f} ms, latency {latency}" if interval else "not connected"
+    print(f"missed     {missed} conn events (estimated), {link}")
+    if args.reset:
+        print("(counters reset)")
+    return 0
+
+
+def _add_flash(sub) -> None:
+    p = sub.add_parser("flash", help="read flash job queue counters (deferrals, missed connection events)")
+    p.add_argument("--address", help="read over the BLE config service of this device (default: USB)")
+    p.add_argument("--reset", action="store_true", help="clear counters after reading")
+    p.set_defaults(func=cmd_flash)
+
+
+def _read_area(dev, cmd: int, base: int, size: int, step: int) -> bytes:
+    reqs = []
+    for i, off in enumerate(range(base, base + size, step)):
+        n = min(step, base + size - off)
+        reqs.append((cmd, i & 0xFF, bytes([off >> 8, off & 0xFF, n])))
+    out = bytearray()
+    for resp in _pipeline(dev, reqs):
+        if len(resp) < 2 or resp[0] != RESP_OK:
+            raise HidError(f"read 0x{cmd:02X} failed: {resp[:1].hex() if resp else 'empty'}")
+        out += resp[2:2 + resp[1]]
+    return bytes(out)
+
+
+def _rate(label: str, nbytes: int, seconds: float) -> None:
+    print(f"{label:<16}{nbytes:>7} B {seconds * 1000:9.0f} ms {nbytes / 1024 / seconds:8.2f} KB/s")
+
+
+def cmd_bench(args: argparse.Namespace) -> int:
+    with _open(args) as dev:
+        transport = f"BLE {args.address}, mtu {dev.mtu}" if args.address else "USB"
+        print(f"transport  {transport}")
+
+        resp = dev.transact(CMD_DATAFLASH_INFO)
+        if len(resp) < 17 or resp[0] != RESP_OK:
+            raise HidError("DATAFLASH_INFO failed")
+        total = struct.unpack_from(">H", resp, 1)[0] or 0x10000
+        size = min(args.bytes, total)
+        t0 = time.monotonic()
+        _read_area(dev, CMD_DATAFLASH_READ, 0, size, 58)
+        _rate("dataflash read", size, time.monotonic() - t0)
+
+        resp = dev.transact(CMD_MACRO_INFO)
+        if len(resp) < 8 or resp[0] != RESP_OK:
+            raise HidError("MACRO_INFO failed")
+        macro_size = struct.unpack_from(">H", resp, 1)[0]
+        t0 = time.monotonic()
+        image = _read_area(dev, CMD_MACRO_GET, 0, macro_size, 58)
+        _rate("macro read", macro_size, time.monotonic() - t0)
+
+        if not args.write:
+            print("(macro upload skipped, pass --write to erase and rewrite the macro area)")
+            return 0
+
+        # Upload the image just read back: erase all, then one deferred write per frame
+        t0 = time.monotonic()
+        resp = dev.transact(CMD_MACRO_SET, 0, bytes([0xFF]), timeout_ms=5000)
+        if not resp or resp[0] != RESP_OK:
+            raise HidError("macro erase failed")
+        for off in range(0, len(image), 58):
+            chunk = image[off:off + 58]
+            resp = dev.transact(CMD_MACRO_SET, 1, bytes([off >> 8, off & 0xFF, len(chunk)]) + chunk,
+                                timeout_ms=2000)
+            if not resp or resp[0] != RESP_OK:
+                raise HidError(f"macro write failed at 0x{off:04X}")
+        _rate("macro upload", len(image), time.monotonic() - t0)
+
+        if _read_area(dev, CMD_MACRO_GET, 0, len(image), 58) != image:
+            raise HidError("macro verify failed")
+        print("macro image verified")
+    return 0
+
+
+def _add_bench(sub) -> None:
+    p = sub.add_parser("bench", help="measure config channel throughput in KB/s")
+    p.add_argument("--address", help="run over the BLE config service of this device (default: USB)")
+    p.add_argument("--bytes", type=lambda v: int(v, 0), default=0x8000,
+                   help="DataFlash bytes to read (default: whole DataFlash)")
+    p.add_argument("--write", action="store_true", help="also erase and rewrite the macro area with its own contents")
+    p.set_defaults(func=cmd_bench)
+
+
+SUBCOMMANDS: Dict[str, Callable] = {
+    "prof": _add_prof,
+    "mem": _add_mem,
+    "boot": _add_boot,
+    "input": _add_input,
+    "idle": _add_idle,
+    "replay": _add_replay,
+    "resume": _add_resume,
+    "conn": _add_conn,
+    "reconn": _add_reconn,
+    "hosts": _add_hosts,
+    "blecfg": _add_blecfg,
+    "tx": _add_tx,
+    "link": _add_link,
+    "bat": _add_bat,
+    "flash": _add_flash,
+    "bench": _add_bench,
+}
+
+
+def run(argv: List[str]) -> int:
+    parser = argparse.ArgumentParser(prog="tools/scripts/console.py", description="CH592F diagnostics")
+    sub = parser.add_subparsers(dest="command", required=True)
+    for add in SUBCOMMANDS.values():
+        add(sub)
+    args = parser.parse_args(argv)
+    try:
+        return args.func(args)
+    except HidError as exc:
+        print(f"[console] {exc}")
+        return 2
@@ -0,0 +1,72 @@
+#!/usr/bin/env python3
+"""
+Minimal host transport for the CH592F USB HID config interface.
+
+Frames are 64 bytes: [CMD][SUB][LEN][DATA:61], sent as an unnumbered output
+report on the vendor interface (usage page 0xFF00) and answered with an input
+report carrying the same CMD/SUB. Asynchronous log pushes (0x70) are skipped.
+"""
+
+from __future__ import annotations
+
+from typing import Optional
+
+CH592_VENDOR_ID = 0x413D
+CH592_PRODUCT_ID = 0x2107
+CONFIG_USAGE_PAGE = 0xFF00
+
+FRAME_SIZE = 64
+RESP_OK = 0x00
+
+
+class HidError(RuntimeError):
+    pass
+
+
+def _import_hid():
+    try:
+        import hid  # type: ignore
+    except ImportError as exc:
+        raise HidError("Python package `hidapi` is required (pip install hidapi)") from exc
+    return hid
+
+
+class ConfigDevice:
+    def __init__(self, path: Optional[bytes] = None) -> None:
+        hid = _import_hid()
+        if path is None:
+            path = self._find_path(hid)
+        self._dev = hid.device()
+        self._dev.open_path(path)
+
+    @staticmethod
+    def _find_path(hid) -> bytes:
+        for info in hid.enumerate(CH592_VENDOR_ID, CH592_PRODUCT_ID):
+            if info.get("usage_page") == CONFIG_USAGE_PAGE:
+                return info["path"]
+        raise HidError("BinaryKeyboard CH592F config interface not found (USB mode required)")
+
+    def close(self) -> None:
+        self._dev.close()
+
+    def __enter__(self) -> "ConfigDevice":
+        return self
+
+    def __exit__(self, *exc) -> None:
+        self.close()
+
+    def transact(self, cmd: int, sub: int = 0, data: bytes = b"", timeout_ms: int = 1000) -> bytes:
+        """Send one command frame and return the response DATA field."""
+        if len(data) > FRAME_SIZE - 3:
+            raise ValueError("payload too large")
+        frame = bytes([cmd & 0xFF, sub & 0xFF, len(data)]) + bytes(data)
+        frame = frame.ljust(FRAME_SIZE, b"\x00")
+        self._dev.write(b"\x00" + frame)
+
+        for _ in range(16):
+            resp = bytes(self._dev.read(FRAME_SIZE, timeout_ms))
+            if not resp:
+                break
+            if resp[0] == cmd and resp[1] == (sub & 0xFF):
+                return resp[3:3 + resp[2]]
+        raise HidError(f"no response for command 0x{cmd:02X}")
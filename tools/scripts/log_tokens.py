@@ -0,0 +1,249 @@
+#!/usr/bin/env python3
+"""
+Tokenized UART log support for CH592F firmware (KBD_LOG_TOKENIZED=1).
+
+Firmware places every LOG_x format string into the non-loaded ELF section
+``.kbd_logstr`` and only transmits ``[0xA5][token LE16][nargs][args LE32...][crc8]``
+over UART1, where token is the string's offset inside that section and crc8
+(poly 0x07, init 0) covers everything after the sync byte. Plain text
+(Log_Output / printf) shares the stream; a 0xA5 in text is only taken as a
+frame when nargs and the CRC check out.
+
+  extract  ELF -> JSON dictionary (run automatically as a CMake post-build step)
+  decode   dictionary + raw UART stream (file / stdin / serial port) -> text
+"""
+
+from __future__ import annotations
+
+import argparse
+import json
+import re
+import struct
+import sys
+from pathlib import Path
+from typing import BinaryIO, Dict, Iterator
+
+
+SECTION_NAME = ".kbd_logstr"
+FRAME_SYNC = 0xA5
+MAX_ARGS = 6
+
+_CONV_RE = re.compile(r"%([-+ #0]*)(\d*)(?:\.(\d+))?(hh|h|ll|l|z)?([diuxXcspo%])")
+
+
+# ---------------------------------------------------------------------------
+# extract
+# ---------------------------------------------------------------------------
+
+def read_elf_section(elf_path: Path, name: str) -> bytes:
+    data = elf_path.read_bytes()
+    if data[:4] != b"\x7fELF" or data[4] != 1 or data[5] != 1:
+        raise ValueError(f"{elf_path}: not a little-endian ELF32 file")
+
+    e_shoff, = struct.unpack_from("<I", data, 0x20)
+    e_shentsize, e_shnum, e_shstrndx = struct.unpack_from("<HHH", data, 0x2E)
+
+    def section(idx: int) -> tuple[int, int, int]:
+        off = e_shoff + idx * e_shentsize
+        sh_name, _, _, _, sh_offset, sh_size = struct.unpack_from("<IIIIII", data, off)
+        return sh_name, sh_offset, sh_size
+
+    _, str_off, _ = section(e_shstrndx)
+    for i in range(e_shnum):
+        sh_name, sh_offset, sh_size = section(i)
+        end = data.index(b"\x00", str_off + sh_name)
+        if data[str_off + sh_name:end].decode("ascii") == name:
+            return data[sh_offset:sh_offset + sh_size]
+    raise KeyError(f"{elf_path}: section {name} not found (built without KBD_LOG_TOKENIZED?)")
+
+
+def build_dictionary(blob: bytes) -> Dict[int, str]:
+    entries: Dict[int, str] = {}
+    pos = 0
+    while pos < len(blob):
+        end = blob.find(b"\x00", pos)
+        if end < 0:
+            end = len(blob)
+        if end > pos:
+            entries[pos] = blob[pos:end].decode("utf-8", errors="replace")
+        pos = end + 1
+    return entries
+
+
+def cmd_extract(args: argparse.Namespace) -> int:
+    entries = build_dictionary(read_elf_section(args.elf, SECTION_NAME))
+    out = {
+        "section": SECTION_NAME,
+        "entries": {str(k): v for k, v in sorted(entries.items())},
+    }
+    args.output.write_text(json.dumps(out, ensure_ascii=False, indent=1) + "\n", encoding="utf-8")
+    print(f"[log_tokens] {len(entries)} format strings -> {args.output}")
+    return 0
+
+
+# ---------------------------------------------------------------------------
+# decode
+# ---------------------------------------------------------------------------
+
+def load_dictionary(path: Path) -> Dict[int, str]:
+    raw = json.loads(path.read_text(encoding="utf-8"))
+    return {int(k): v for k, v in raw["entries"].items()}
+
+
+def format_c(fmt: str, values: list[int]) -> str:
+    it = iter(values)
+
+    def repl(m: re.Match) -> str:
+        flags, width, prec, _length, conv = m.groups()
+        if conv == "%":
+            return "%"
+        try:
+            v = next(it)
+        except StopIteration:
+            return "<?>"
+        if conv in "di":
+            v = v - (1 << 32) if v & 0x80000000 else v
+            conv = "d"
+        elif conv == "u":
+            conv = "d"
+        elif conv in "sp":
+            # 设备端只发送了指针值
+            return f"<0x{v:08X}>"
+        spec = "%" + flags + width + (f".{prec}" if prec else "") + conv
+        try:
+            return spec % v
+        except (TypeError, ValueError, OverflowError):
+            return f"<{v}>"
+
+    return _CONV_RE.sub(repl, fmt)
+
+
+def crc8(data: bytes) -> int:
+    crc = 0
+    for b in data:
+        crc ^= b
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+
+def format_frame(token: int, values: list[int], entries: Dict[int, str]) -> str:
+    entry = entries.get(token)
+    if entry is None:
+        return f"[?/LOG] unknown token {token} args={values}"
+    level, tag, fmt = (entry.split("|", 2) + ["", ""])[:3]
+    return f"[{level}/{tag}] {format_c(fmt, values)}"
+
+
+def decode_stream(stream: Iterator[int], entries: Dict[int, str]) -> Iterator[str]:
+    """Yield decoded lines; plain text (Log_Output / printf) passes through.
+
+    A sync byte starts a frame only if nargs <= MAX_ARGS and the trailing CRC
+    matches; otherwise it is treated as a text byte and decoding resumes at
+    the next byte.
+    """
+    text = bytearray()
+    pending = bytearray()
+
+    def take_text(b: int) -> Iterator[str]:
+        if b == 0x0A:
+            yield text.decode("utf-8", errors="replace")
+            text.clear()
+        elif b != 0x0D:
+            text.append(b)
+
+    for b in stream:
+        pending.append(b)
+        while pending:
+            if pending[0] != FRAME_SYNC:
+                yield from take_text(pending.pop(0))
+                continue
+            if len(pending) < 4:
+                break
+            nargs = pending[3]
+            if nargs > MAX_ARGS:
+                yield from take_text(pending.pop(0))
+                continue
+            size = 4 + nargs * 4 + 1
+            if len(pending) < size:
+                break
+            if crc8(bytes(pending[1:size - 1])) != pending[size - 1]:
+                yield from take_text(pending.pop(0))
+                continue
+
+            if text:
+                yield text.decode("utf-8", errors="replace")
+                text.clear()
+            token = pending[1] | (pending[2] << 8)
+            values = list(struct.unpack_from(f"<{nargs}I", pending, 4))
+            del pending[:size]
+            yield format_frame(token, values, entries)
+
+    for b in pending:
+        yield from take_text(b)
+    if text:
+        yield text.decode("utf-8", errors="replace")
+
+
+def _iter_file(f: BinaryIO) -> Iterator[int]:
+    while True:
+        chunk = f.read(256)
+        if not chunk:
+            return
+        yield from chunk
+
+
+def _iter_serial(port: str, baud: int) -> Iterator[int]:
+    try:
+        import serial  # type: ignore
+    except ImportError:
+        raise SystemExit("pyserial is required for --port (pip install pyserial)")
+    with serial.Serial(port, baud, timeout=0.1) as ser:
+        while True:
+            chunk = ser.read(256)
+            if chunk:
+                yield from chunk
+
+
+def cmd_decode(args: argparse.Namespace) -> int:
+    entries = load_dictionary(args.dict)
+    if args.port:
+        stream = _iter_serial(args.port, args.baud)
+    elif args.input and str(args.input) != "-":
+        stream = _iter_file(args.input.open("rb"))
+    else:
+        stream = _iter_file(sys.stdin.buffer)
+
+    try:
+        for line in decode_stream(iter(stream), entries):
+            print(line, flush=True)
+    except KeyboardInterrupt:
+        pass
+    return 0
+
+
+def build_parser() -> argparse.ArgumentParser:
+    parser = argparse.ArgumentParser(description="BinaryKeyboard tokenized log tool")
+    sub = parser.add_subparsers(dest="command", required=True)
+
+    p = sub.add_parser("extract", help="extract format-string dictionary from ELF")
+    p.add_argument("elf", type=Path)
+    p.add_argument("-o", "--output", type=Path, required=True)
+    p.set_defaults(func=cmd_extract)
+
+    p = sub.add_parser("decode", help="decode a tokenized UART stream")
+    p.add_argument("--dict", type=Path, required=True, help="dictionary JSON from 'extract'")
+    p.add_argument("--port", help="serial port (requires pyserial)")
+    p.add_argument("--baud", type=int, default=115200)
+    p.add_argument("input", nargs="?", type=Path, help="raw capture file, '-' for stdin")
+    p.set_defaults(func=cmd_decode)
+    return parser
+
+
+def main() -> None:
+    args = build_parser().parse_args()
+    sys.exit(args.func(args))
+
+
+if __name__ == "__main__":
+    main()
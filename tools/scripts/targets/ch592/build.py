@@ -17,7 +17,14 @@ import sys
 from pathlib import Path
 from typing import Optional
 
-from build_report import UsageRow, fmt_bytes, render_usage_report
+from build_report import (
+    UsageRow,
+    collect_stack_usage,
+    fmt_bytes,
+    read_linker_symbol,
+    render_stack_report,
+    render_usage_report,
+)
 from common import (
     PROJECT_ROOT,
     colorize as _c,
@@ -393,6 +400,12 @@ def _build_report(lines: list[str], preset: str, build_dir: Path, elapsed: float
         colorize=_c,
         use_color=use_color(),
     )
+    render_stack_report(
+        rows=collect_stack_usage(build_dir),
+        stack_size=read_linker_symbol(LINKER_SCRIPT, "__stack_size"),
+        colorize=_c,
+        use_color=use_color(),
+    )
 
 
 def configure(keyboard: str, profile: str) -> Path:
@@ -475,6 +475,7 @@ export class Ch552Codec implements DeviceCodec<Uint8Array> {
       osMode: false,
       macroActions: version >= FW_VERSION_RGB,
       wheelClickAction: false,
+      wheelPanAction: false,
       battery: false,
       logs: false,
       reset: false,
@@ -33,6 +33,7 @@ export const useDeviceStore = defineStore("device", () => {
     osMode: false,
     macroActions: false,
     wheelClickAction: false,
+    wheelPanAction: false,
     battery: false,
     logs: false,
     reset: false,
@@ -152,6 +153,9 @@ export const useDeviceStore = defineStore("device", () => {
   const supportsWheelClickAction = computed(
     () => capabilities.value.wheelClickAction,
   );
+  const supportsWheelPanAction = computed(
+    () => capabilities.value.wheelPanAction,
+  );
   const supportsBattery = computed(() => capabilities.value.battery);
   const supportsLogs = computed(() => capabilities.value.logs);
   const supportsFactoryReset = computed(() => capabilities.value.reset);
@@ -655,6 +659,7 @@ export const useDeviceStore = defineStore("device", () => {
     supportsOsMode,
     supportsMacroActions,
     supportsWheelClickAction,
+    supportsWheelPanAction,
     supportsBattery,
     supportsLogs,
     supportsFactoryReset,
@@ -59,6 +59,7 @@ export interface DeviceCapabilities {
   osMode: boolean;
   macroActions: boolean;
   wheelClickAction: boolean;
+  wheelPanAction: boolean;
   battery: boolean;
   logs: boolean;
   reset: boolean;
@@ -79,6 +80,7 @@ export function createDeviceCapabilities(
     osMode: true,
     macroActions: true,
     wheelClickAction: true,
+    wheelPanAction: true,
     battery: true,
     logs: true,
     reset: true,
@@ -99,6 +101,7 @@ export const CH552_CAPABILITIES = createDeviceCapabilities({
   osMode: false,
   macroActions: true,
   wheelClickAction: false,
+  wheelPanAction: false,
   battery: false,
   logs: false,
   reset: true,
@@ -122,6 +125,8 @@ export enum Command {
   CFG_RESET = 0x12,
   CFG_OS_GET = 0x13,
   CFG_OS_SET = 0x14,
+  CFG_DEBOUNCE_GET = 0x15,
+  CFG_DEBOUNCE_SET = 0x16,
 
   // 按键映射 0x20-0x2F
   KEYMAP_GET = 0x20,
@@ -294,6 +299,8 @@ export enum WheelDirection {
   UP = 1,
   DOWN = 2,
   CLICK = 3,
+  LEFT = 4,
+  RIGHT = 5,
 }
 
 // ============================================================================
@@ -316,6 +323,8 @@ export enum FnAction {
   BLE_ADV = 0x02,
   BLE_DISCONNECT = 0x03,
   BLE_CLEAR_BONDS = 0x04,
+  BLE_HOST = 0x05,
+  BLE_HOST_NEXT = 0x06,
   RGB_TOGGLE = 0x10,
   RGB_MODE_NEXT = 0x11,
   RGB_MODE_PREV = 0x12,
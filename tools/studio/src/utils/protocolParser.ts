@@ -32,6 +32,8 @@ const COMMAND_NAMES: Record<number, string> = {
   [Command.CFG_RESET]: "CFG_RESET",
   [Command.CFG_OS_GET]: "CFG_OS_GET",
   [Command.CFG_OS_SET]: "CFG_OS_SET",
+  [Command.CFG_DEBOUNCE_GET]: "CFG_DEBOUNCE_GET",
+  [Command.CFG_DEBOUNCE_SET]: "CFG_DEBOUNCE_SET",
   [Command.KEYMAP_GET]: "KEYMAP_GET",
   [Command.KEYMAP_SET]: "KEYMAP_SET",
   [Command.LAYER_GET]: "LAYER_GET",
@@ -61,6 +63,8 @@ const COMMAND_LABELS: Record<number, string> = {
   [Command.CFG_RESET]: "恢复出厂设置",
   [Command.CFG_OS_GET]: "获取系统模式",
   [Command.CFG_OS_SET]: "设置系统模式",
+  [Command.CFG_DEBOUNCE_GET]: "获取去抖配置",
+  [Command.CFG_DEBOUNCE_SET]: "设置去抖配置",
   [Command.KEYMAP_GET]: "获取按键映射",
   [Command.KEYMAP_SET]: "设置按键映射",
   [Command.LAYER_GET]: "获取当前层",
@@ -141,6 +145,8 @@ const FN_ACTION_NAMES: Record<number, string> = {
   [FnAction.BLE_ADV]: "蓝牙广播",
   [FnAction.BLE_DISCONNECT]: "蓝牙断开",
   [FnAction.BLE_CLEAR_BONDS]: "清除配对",
+  [FnAction.BLE_HOST]: "蓝牙主机",
+  [FnAction.BLE_HOST_NEXT]: "切换蓝牙主机",
   [FnAction.RGB_TOGGLE]: "RGB 开关",
   [FnAction.RGB_MODE_NEXT]: "RGB 下一模式",
   [FnAction.RGB_MODE_PREV]: "RGB 上一模式",
@@ -210,7 +216,11 @@ function formatKeyAction(
             ? "下"
             : param1 === WheelDirection.CLICK
               ? "点击"
-              : `未知(${param1})`;
+              : param1 === WheelDirection.LEFT
+                ? "左"
+                : param1 === WheelDirection.RIGHT
+                  ? "右"
+                  : `未知(${param1})`;
       return `鼠标滚轮: ${dir}`;
     }
     case ActionType.CONSUMER: {